@@ -42,9 +42,9 @@ void hide_action_option (void);
 static void clear_entries (void);
 static void expand_row_from_iter (GtkTreeIter *local_iter);
 void action_option_insert (gchar *origin);
-static gboolean check_for_menus (GtkTreeModel *filter_model, GtkTreePath G_GNUC_UNUSED *filter_path, 
-				 GtkTreeIter *filter_iter);
+static void collect_menu_ids_of_subtree (GtkTreeIter *row_iter, GHashTable *removed_menu_ids);
 void remove_menu_id (gchar *menu_id);
+static void remove_menu_ids (GHashTable *removed_menu_ids);
 void remove_all_children (void);
 void remove_rows (gchar *origin);
 
@@ -889,29 +889,38 @@ void action_option_insert (gchar *origin)
 
 /* 
 
-   Deletes menu IDs of menus or pipe menus that are descendants of the currently processed row.
+   Collects the menu IDs of a row that is going to be removed and of all menus and pipe menus below it. 
+   Only menus can contain other menus, so the children of other rows don't have to be checked.
 
 */
 
-static gboolean check_for_menus (GtkTreeModel              *filter_model, 
-				 GtkTreePath G_GNUC_UNUSED *filter_path, 
-				 GtkTreeIter               *filter_iter)
+static void collect_menu_ids_of_subtree (GtkTreeIter *row_iter, 
+					 GHashTable  *removed_menu_ids)
 {
-  gchar *type_txt_filter, *menu_id_txt_filter;
+  GtkTreeIter child_iter;
+  gchar *type_txt, *menu_id_txt;
+  gboolean valid;
 
-  gtk_tree_model_get (filter_model, filter_iter, 
-		      TS_TYPE, &type_txt_filter, 
-		      TS_MENU_ID, &menu_id_txt_filter, 
+  gtk_tree_model_get (model, row_iter, 
+		      TS_TYPE, &type_txt, 
+		      TS_MENU_ID, &menu_id_txt, 
 		      -1);
 
-  if (streq_any (type_txt_filter, "menu", "pipe menu", NULL))
-    remove_menu_id (menu_id_txt_filter);
+  if (menu_id_txt && streq_any (type_txt, "menu", "pipe menu", NULL))
+    g_hash_table_add (removed_menu_ids, menu_id_txt); // The hash table takes over the string.
+  else
+    g_free (menu_id_txt);
 
-  // Cleanup
-  g_free (type_txt_filter);
-  g_free (menu_id_txt_filter);
+  if (streq (type_txt, "menu")) {
+    valid = gtk_tree_model_iter_children (model, &child_iter, row_iter);
+    while (valid) {
+      collect_menu_ids_of_subtree (&child_iter, removed_menu_ids);
+      valid = gtk_tree_model_iter_next (model, &child_iter);
+    }
+  }
 
-  return FALSE;
+  // Cleanup
+  g_free (type_txt);
 }
 
 /* 
@@ -930,108 +939,122 @@ void remove_menu_id (gchar *menu_id)
 
 /* 
 
-   Removes all children of a node.
-   Children are removed from bottom to top so the paths of the other children and nodes are kept.
-   After the removal of the children, the function checks for the existence of each parent
-   before it reselects them, because if subnodes of the selected nodes had also been selected,
-   they can't be reselected again since they got removed.
+   Removes the menu IDs of removed menus and pipe menus from the menu IDs list in one pass.
+
+*/
+
+static void remove_menu_ids (GHashTable *removed_menu_ids)
+{
+  GSList *remaining_menu_ids = NULL;
+  GSList *menu_ids_loop;
+
+  if (!g_hash_table_size (removed_menu_ids))
+    return;
+
+  for (menu_ids_loop = menu_ids; menu_ids_loop; menu_ids_loop = menu_ids_loop->next) {
+    if (g_hash_table_contains (removed_menu_ids, menu_ids_loop->data))
+      g_free (menu_ids_loop->data);
+    else
+      remaining_menu_ids = g_slist_prepend (remaining_menu_ids, menu_ids_loop->data);
+  }
+  g_slist_free (menu_ids);
+  menu_ids = g_slist_reverse (remaining_menu_ids);
+}
+
+/* 
+
+   Removes all children of the selected nodes. 
+   The children are removed directly without selecting them first; the menu IDs of all removed menus 
+   are collected and removed from the menu IDs list at once afterwards. 
+   Selected nodes that are descendants of other selected nodes are removed together with the children of the latter.
 
 */
 
 void remove_all_children (void)
 {
   GtkTreeSelection *selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview));
-  /* The list of rows is reverted, since only with a bottom to top direction the paths of selected 
-     rows will stay the same after one of them has been deleted and selected subrows of rows that 
-     have also been selected will be removed properly. */
-  GList *selected_rows = g_list_reverse (gtk_tree_selection_get_selected_rows (selection, &model));
+  GList *selected_rows = gtk_tree_selection_get_selected_rows (selection, &model);
+  GHashTable *removed_menu_ids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  GtkTreePath *processed_path = NULL;
 
   GList *g_list_loop;
-  GtkTreeIter iter_loop;
-  GtkTreePath *path_loop;
+  GtkTreeIter iter_loop, child_iter_loop;
+  gboolean valid;
 
   // Prevents that the default check for change of selection(s) gets in the way.
   g_signal_handler_block (selection, handler_id_row_selected); 
 
+  // (Note: The selected rows are sorted in tree order, so the descendants of a processed row follow directly after it.)
   for (g_list_loop = selected_rows; g_list_loop; g_list_loop = g_list_loop->next) {
-    path_loop = g_list_loop->data;
-    // (Note: Rows are not selected if they are not visible.)
-    gtk_tree_view_expand_row (GTK_TREE_VIEW (treeview), path_loop, FALSE);
-    gtk_tree_selection_unselect_path (selection, path_loop);
-    gtk_tree_path_down (path_loop);
-    gtk_tree_model_get_iter (model, &iter_loop, path_loop);
-    do {
-      gtk_tree_selection_select_iter (selection, &iter_loop);
-    } while (gtk_tree_model_iter_next (model, &iter_loop));
-    gtk_tree_path_up (path_loop);
+    if (processed_path && gtk_tree_path_is_descendant (g_list_loop->data, processed_path))
+      continue;
+    processed_path = g_list_loop->data;
+    gtk_tree_model_get_iter (model, &iter_loop, processed_path);
+
+    valid = gtk_tree_model_iter_children (model, &child_iter_loop, &iter_loop);
+    while (valid) {
+      collect_menu_ids_of_subtree (&child_iter_loop, removed_menu_ids);
+      valid = gtk_tree_model_iter_next (model, &child_iter_loop);
+    }
+    // (Note: gtk_tree_store_remove sets the iter to the next child, if there is one.)
+    if (gtk_tree_model_iter_children (model, &child_iter_loop, &iter_loop)) {
+      while (gtk_tree_store_remove (treestore, &child_iter_loop));
+    }
   }
 
-  remove_rows ("remove all children");
+  remove_menu_ids (removed_menu_ids);
 
   g_signal_handler_unblock (selection, handler_id_row_selected);
 
-  for (g_list_loop = selected_rows; g_list_loop; g_list_loop = g_list_loop->next) {
-    path_loop = g_list_loop->data;
-    // Might be a former subnode that was selected and got removed.
-    if (gtk_tree_model_get_iter (model, &iter_loop, path_loop))
-      gtk_tree_selection_select_path (selection, path_loop);
-  }
-  
   // Cleanup
+  g_hash_table_destroy (removed_menu_ids);
   g_list_free_full (selected_rows, (GDestroyNotify) gtk_tree_path_free);
+
+  row_selected ();
+  activate_change_done ();
 }
 
 /* 
 
-   Removes all currently selected rows.
+   Removes all currently selected rows. 
+   A row is removed with all its descendants in one go, so selected descendants of selected rows are skipped. 
+   The menu IDs of all removed menus are collected and removed from the menu IDs list at once afterwards.
 
 */
 
 void remove_rows (gchar *origin)
 {
   GtkTreeIter iter_remove;
-  GtkTreeModel *filter_model;
   GtkTreeSelection *selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview));
-  // The list of rows is reverted, since only with a bottom to top direction the paths will stay the same.
-  GList *selected_rows = g_list_reverse (gtk_tree_selection_get_selected_rows (selection, &model));
-
-  gchar *type_txt_to_be_deleted;
-  gchar *menu_id_txt_to_be_deleted;
+  GList *selected_rows = gtk_tree_selection_get_selected_rows (selection, &model);
+  GHashTable *removed_menu_ids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  // Paths of the rows to be removed from bottom to top, since only in this direction the paths stay the same.
+  GList *removed_paths = NULL;
 
   GList *g_list_loop;
-  GtkTreePath *path_loop;
-
-  // Prevents that the default check for change of selection(s) gets in the way.
-  g_signal_handler_block (selection, handler_id_row_selected); 
+  GtkTreePath *path_loop = NULL;
 
+  // (Note: The selected rows are sorted in tree order, so the descendants of a row follow directly after it.)
   for (g_list_loop = selected_rows; g_list_loop; g_list_loop = g_list_loop->next) {
+    if (path_loop && gtk_tree_path_is_descendant (g_list_loop->data, path_loop))
+      continue;
     path_loop = g_list_loop->data;
+    removed_paths = g_list_prepend (removed_paths, path_loop);
     gtk_tree_model_get_iter (model, &iter_remove, path_loop);
+    collect_menu_ids_of_subtree (&iter_remove, removed_menu_ids);
+  }
 
-    gtk_tree_model_get (model, &iter_remove, 
-			TS_TYPE, &type_txt_to_be_deleted, 
-			TS_MENU_ID, &menu_id_txt_to_be_deleted, 
-			-1);
-
-    if (!streq (origin, "dnd") && streq_any (type_txt_to_be_deleted, "menu", "pipe menu", NULL)) {
-      // Keep menu IDs in the GSList equal to the menu IDs of the treestore.
-      remove_menu_id (menu_id_txt_to_be_deleted);
-
-      /* If the row to be deleted is a menu and one or more children are not selected 
-	 and of menu or pipe menu type, then their menu IDs have to be deleted, too. */
-      if (streq (type_txt_to_be_deleted, "menu") && gtk_tree_model_iter_has_child (model, &iter_remove)) {
-	filter_model = gtk_tree_model_filter_new (model, path_loop);
-	gtk_tree_model_foreach (filter_model, (GtkTreeModelForeachFunc) check_for_menus, NULL);
-      }
-    }
-
-    gtk_tree_store_remove (GTK_TREE_STORE (model), &iter_remove);
+  // Prevents that the default check for change of selection(s) gets in the way.
+  g_signal_handler_block (selection, handler_id_row_selected); 
 
-    // Cleanup
-    g_free (type_txt_to_be_deleted);
-    g_free (menu_id_txt_to_be_deleted);
+  for (g_list_loop = removed_paths; g_list_loop; g_list_loop = g_list_loop->next) {
+    gtk_tree_model_get_iter (model, &iter_remove, g_list_loop->data);
+    gtk_tree_store_remove (treestore, &iter_remove);
   }
 
+  // Keep menu IDs in the GSList equal to the menu IDs of the treestore.
+  remove_menu_ids (removed_menu_ids);
+
   // If all rows have been deleted and the search functionality had been activated before, deactivate the latter.
   if (!gtk_tree_model_get_iter_first (model, &iter_remove) && gtk_widget_get_visible (find_grid))
     show_or_hide_find_grid ();
@@ -1039,11 +1062,11 @@ void remove_rows (gchar *origin)
   g_signal_handler_unblock (selection, handler_id_row_selected);
 
   // Cleanup
+  g_hash_table_destroy (removed_menu_ids);
+  g_list_free (removed_paths);
   g_list_free_full (selected_rows, (GDestroyNotify) gtk_tree_path_free);
 
-  if (!streq (origin, "dnd")) {
-    if (!streq (origin, "load menu"))
-      row_selected ();
-    activate_change_done ();
-  }
+  if (!streq (origin, "load menu"))
+    row_selected ();
+  activate_change_done ();
 }
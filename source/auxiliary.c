@@ -18,19 +18,69 @@
 */
 
 #include <gtk/gtk.h>
-#include <stdlib.h>
+#include <string.h>
 
+#include "general_header_files/enum__ts_elements.h"
 #include "auxiliary.h"
 
+void append_int_to_buffer (GString *buffer, gint32 value);
+void append_row_values_to_buffer (GString *buffer, GtkTreeModel *local_model, GtkTreeIter *local_iter);
 void create_file_dialog (GtkWidget **dialog, gchar *dialog_title);
 gchar *extract_substring_via_regex (gchar *string, gchar *regex_str);
 void free_elements_of_static_string_array (gchar **string_array, gint8 number_of_fields, gboolean set_to_NULL);
 guint get_font_size (void);
+gboolean read_int_from_buffer (const gchar **position, const gchar *end, gint32 *value);
+gboolean read_row_values_from_buffer (const gchar **position, const gchar *end, guint *icon_img_status, 
+				      gchar **txt_values);
 void set_filename_and_window_title (gchar *new_filename);
 void show_msg_in_statusbar (gchar *message);
 gboolean streq_any (const gchar *string, ...);
 void unref_icon (GdkPixbuf **icon, gboolean set_to_NULL);
 
+/* 
+
+   Appends a number to a buffer of rows, which is used by the clipboard and the journal.
+
+*/
+
+void append_int_to_buffer (GString *buffer, 
+			   gint32   value)
+{
+  g_string_append_len (buffer, (gchar *) &value, sizeof (gint32));
+}
+
+/* 
+
+   Appends all values of a row to a buffer of rows except the icon image, which is recreated from the icon path. 
+   Strings are stored with their length in front of them, NULL is stored as a length of -1.
+
+*/
+
+void append_row_values_to_buffer (GString      *buffer, 
+				  GtkTreeModel *local_model, 
+				  GtkTreeIter  *local_iter)
+{
+  guint icon_img_status;
+  gchar *txt_value;
+  guint8 ts_elements_cnt;
+
+  gtk_tree_model_get (local_model, local_iter, TS_ICON_IMG_STATUS, &icon_img_status, -1);
+  append_int_to_buffer (buffer, icon_img_status);
+
+  for (ts_elements_cnt = TS_ICON_MODIFIED; ts_elements_cnt < NUMBER_OF_TS_ELEMENTS; ts_elements_cnt++) {
+    gtk_tree_model_get (local_model, local_iter, ts_elements_cnt, &txt_value, -1);
+    if (txt_value) {
+      append_int_to_buffer (buffer, strlen (txt_value));
+      g_string_append (buffer, txt_value);
+    }
+    else
+      append_int_to_buffer (buffer, -1);
+
+    // Cleanup
+    g_free (txt_value);
+  }
+}
+
 /* 
 
    Creates a file dialog for opening a new and saving an existing menu.
@@ -113,19 +163,85 @@ void free_elements_of_static_string_array (gchar    **string_array,
 guint get_font_size (void)
 {
   gchar *font_str;
-  gchar *font_substr;
+  PangoFontDescription *font_desc;
   guint font_size;
+  gdouble resolution;
 
   g_object_get (gtk_settings_get_default (), "gtk-font-name", &font_str, NULL);
-  font_size = atoi (font_substr = extract_substring_via_regex (font_str, "[0-9]+$"));
+  font_desc = pango_font_description_from_string (font_str);
+  font_size = pango_font_description_get_size (font_desc) / PANGO_SCALE;
+
+  // An absolute size is given in pixels; it is converted to points by using the resolution of the screen.
+  if (pango_font_description_get_size_is_absolute (font_desc)) {
+    resolution = gdk_screen_get_resolution (gdk_screen_get_default ());
+    if (resolution <= 0) // No resolution has been set.
+      resolution = 96;
+    font_size = font_size * 72 / resolution + 0.5;
+  }
 
   // Cleanup
   g_free (font_str);
-  g_free (font_substr);
+  pango_font_description_free (font_desc);
 
   return font_size;
 }
 
+/* 
+
+   Reads a number of a buffer of rows, returns FALSE if the data ends before.
+
+*/
+
+gboolean read_int_from_buffer (const gchar **position, 
+			       const gchar  *end, 
+			       gint32       *value)
+{
+  if (end - *position < (gssize) sizeof (gint32))
+    return FALSE;
+
+  memcpy (value, *position, sizeof (gint32));
+  *position += sizeof (gint32);
+
+  return TRUE;
+}
+
+/* 
+
+   Reads the values of a row that have been written by append_row_values_to_buffer (). 
+   The strings are stored inside txt_values from TS_ICON_MODIFIED on, NULL is stored for a length of -1.
+   Returns FALSE if the data ends before, in this case no strings are left inside txt_values.
+
+*/
+
+gboolean read_row_values_from_buffer (const gchar **position, 
+				      const gchar  *end, 
+				      guint        *icon_img_status, 
+				      gchar       **txt_values)
+{
+  gint32 read_icon_img_status, txt_length;
+  guint8 ts_elements_cnt;
+
+  if (!read_int_from_buffer (position, end, &read_icon_img_status))
+    return FALSE;
+  *icon_img_status = read_icon_img_status;
+
+  for (ts_elements_cnt = TS_ICON_MODIFIED; ts_elements_cnt < NUMBER_OF_TS_ELEMENTS; ts_elements_cnt++) {
+    if (!read_int_from_buffer (position, end, &txt_length) || txt_length > end - *position) {
+      // Cleanup
+      free_elements_of_static_string_array (txt_values + TS_ICON_MODIFIED, ts_elements_cnt - TS_ICON_MODIFIED, TRUE);
+
+      return FALSE;
+    }
+    txt_values[ts_elements_cnt] = NULL;
+    if (txt_length >= 0) {
+      txt_values[ts_elements_cnt] = g_strndup (*position, txt_length);
+      *position += txt_length;
+    }
+  }
+
+  return TRUE;
+}
+
 /* 
 
    Replaces the filename and window title.
@@ -141,6 +257,7 @@ void set_filename_and_window_title (gchar *new_filename)
   basename = g_path_get_basename (filename);
   window_title = g_strconcat ("Kickshaw - ", basename, NULL);
   gtk_window_set_title (GTK_WINDOW (window), window_title);
+  start_menu_file_monitoring ();
 
   // Cleanup
   g_free (basename);
@@ -150,14 +267,18 @@ void set_filename_and_window_title (gchar *new_filename)
 /* 
 
    Shows a message in the statusbar at the botton for information.
+   The message replaces the previous one instead of being stacked on top of it, 
+   since messages are never popped.
 
 */
 
 void show_msg_in_statusbar (gchar *message)
 {
+  guint context_id = gtk_statusbar_get_context_id (GTK_STATUSBAR (statusbar), "messages");
+
   message = g_strdup_printf (" %s", message);
-  gtk_statusbar_push (GTK_STATUSBAR (statusbar), gtk_statusbar_get_context_id (GTK_STATUSBAR (statusbar), message), 
-		      message);
+  gtk_statusbar_remove_all (GTK_STATUSBAR (statusbar), context_id);
+  gtk_statusbar_push (GTK_STATUSBAR (statusbar), context_id, message);
 
   // Cleanup
   g_free (message);
@@ -29,4 +29,6 @@ extern GtkWidget *statusbar;
 
 extern gchar *filename;
 
+extern void start_menu_file_monitoring (void);
+
 #endif
@@ -0,0 +1,586 @@
+/*
+   Kickshaw - A Menu Editor for Openbox
+
+   Copyright (c) 2010-2013        Marcus Schaetzle
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along 
+   with Kickshaw. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <gtk/gtk.h>
+#include <string.h>
+
+#include "general_header_files/enum__invalid_icon_imgs.h"
+#include "general_header_files/enum__invalid_icon_imgs_status.h"
+#include "general_header_files/enum__ts_elements.h"
+#include "clipboard.h"
+
+/* 
+   Copied rows are offered in two forms: in the format of the menu file, so they can be pasted into 
+   any Openbox menu opened in another program, and in a compact binary form for pasting them inside Kickshaw. 
+   The latter starts with an identifier, followed by all copied rows including their descendants 
+   in the order of the tree view. Each row consists of its depth relative to the copied row it belongs to, 
+   the status of its icon and all its text values, stored with their length in front of them (-1 for NULL).
+*/
+#define CLIPBOARD_ROWS_MAGIC "KSC1"
+#define CLIPBOARD_ROWS_TARGET "application/x-kickshaw-menu-rows"
+
+enum { CLIPBOARD_ROWS, CLIPBOARD_MENU_TXT };
+
+struct pasted_row {
+  gint32 depth;
+  guint icon_img_status;
+  gchar *txt_values[NUMBER_OF_TS_ELEMENTS]; // Only the text columns from TS_ICON_MODIFIED on are used.
+};
+
+// Contents of the clipboard as long as they are owned by this program.
+static GString *copied_rows = NULL;
+static gchar *copied_menu_txt = NULL;
+
+static void append_rows (GString *rows_buffer, GtkTreeIter *row_iter, gint32 depth);
+static void get_clipboard_content (GtkClipboard G_GNUC_UNUSED *clipboard, GtkSelectionData *selection_data, 
+				   guint info, gpointer G_GNUC_UNUSED user_data);
+static void clear_clipboard_content (GtkClipboard G_GNUC_UNUSED *clipboard, gpointer G_GNUC_UNUSED user_data);
+gboolean copy_rows (void);
+void cut_rows (void);
+static GArray *read_rows (const gchar *rows_data, gsize rows_data_length);
+static void free_pasted_rows (GArray *pasted_rows);
+static GdkPixbuf *get_pasted_icon (GHashTable *loaded_icons, const gchar *icon_path, guint *icon_img_status);
+static gchar *get_unique_menu_id (GHashTable *existing_menu_ids, const gchar *menu_id);
+static void insert_rows (const gchar *rows_data, gsize rows_data_length);
+static void clipboard_rows_received (GtkClipboard G_GNUC_UNUSED *clipboard, GtkSelectionData *selection_data, 
+				    gpointer G_GNUC_UNUSED user_data);
+void paste_rows (void);
+
+/* 
+
+   Appends a row and all its descendants to the copied rows.
+
+*/
+
+static void append_rows (GString     *rows_buffer, 
+			 GtkTreeIter *row_iter, 
+			 gint32       depth)
+{
+  GtkTreeIter child_iter;
+  gboolean valid;
+
+  append_int_to_buffer (rows_buffer, depth);
+  append_row_values_to_buffer (rows_buffer, model, row_iter);
+
+  valid = gtk_tree_model_iter_children (model, &child_iter, row_iter);
+  while (valid) {
+    append_rows (rows_buffer, &child_iter, depth + 1);
+    valid = gtk_tree_model_iter_next (model, &child_iter);
+  }
+}
+
+/* 
+
+   Hands the copied rows over to the program that requested them, in the requested form.
+
+*/
+
+static void get_clipboard_content (GtkClipboard G_GNUC_UNUSED *clipboard, 
+				   GtkSelectionData            *selection_data, 
+				   guint                        info, 
+				   gpointer G_GNUC_UNUSED       user_data)
+{
+  if (info == CLIPBOARD_ROWS)
+    gtk_selection_data_set (selection_data, gdk_atom_intern_static_string (CLIPBOARD_ROWS_TARGET), 8, 
+			    (guchar *) copied_rows->str, copied_rows->len);
+  else
+    gtk_selection_data_set_text (selection_data, copied_menu_txt, -1);
+}
+
+/* 
+
+   Frees the copied rows after another program or another copy has taken over the clipboard.
+
+*/
+
+static void clear_clipboard_content (GtkClipboard G_GNUC_UNUSED *clipboard, 
+				     gpointer G_GNUC_UNUSED       user_data)
+{
+  if (copied_rows) {
+    g_string_free (copied_rows, TRUE);
+    copied_rows = NULL;
+  }
+  g_free (copied_menu_txt);
+  copied_menu_txt = NULL;
+}
+
+/* 
+
+   Copies the selected rows including their descendants to the clipboard. 
+   Either menus, pipe menus, items and separators or actions can be copied, since they are pasted next to 
+   or into rows of the same kind. Selected descendants of selected rows are copied as part of the latter. 
+   Returns if the rows have been copied.
+
+*/
+
+gboolean copy_rows (void)
+{
+  GtkTreeSelection *selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview));
+  GList *selected_rows = gtk_tree_selection_get_selected_rows (selection, &model);
+  GList *copied_paths = NULL;
+  GString *new_copied_rows;
+  gchar *new_copied_menu_txt;
+  GtkTargetList *target_list;
+  GtkTargetEntry *targets;
+  gint number_of_targets;
+  // Defaults
+  gboolean menu_element_copied = FALSE, action_copied = FALSE, option_copied = FALSE;
+
+  GList *selected_rows_loop;
+  GtkTreePath *copied_path_loop = NULL;
+  GtkTreeIter iter_loop;
+  gchar *type_txt_loop;
+
+  if (!selected_rows)
+    return FALSE;
+
+  /* (Note: The selected rows are sorted in tree order, so the descendants of a copied row follow directly after it
+     and can be skipped by comparing them with the last copied row.) */
+  for (selected_rows_loop = selected_rows; selected_rows_loop; selected_rows_loop = selected_rows_loop->next) {
+    if (copied_path_loop && gtk_tree_path_is_descendant (selected_rows_loop->data, copied_path_loop))
+      continue;
+    copied_path_loop = selected_rows_loop->data;
+    copied_paths = g_list_prepend (copied_paths, copied_path_loop);
+
+    gtk_tree_model_get_iter (model, &iter_loop, copied_path_loop);
+    gtk_tree_model_get (model, &iter_loop, TS_TYPE, &type_txt_loop, -1);
+    if (streq_any (type_txt_loop, "menu", "pipe menu", "item", "separator", NULL))
+      menu_element_copied = TRUE;
+    else if (streq (type_txt_loop, "action"))
+      action_copied = TRUE;
+    else
+      option_copied = TRUE;
+
+    // Cleanup
+    g_free (type_txt_loop);
+  }
+  copied_paths = g_list_reverse (copied_paths);
+
+  if (option_copied || (menu_element_copied && action_copied)) {
+    show_msg_in_statusbar ((option_copied) ? "Options can't be copied, only their actions" : 
+			   "Menus, pipe menus, items and separators can't be copied together with actions");
+
+    // Cleanup
+    g_list_free (copied_paths);
+    g_list_free_full (selected_rows, (GDestroyNotify) gtk_tree_path_free);
+
+    return FALSE;
+  }
+
+  new_copied_rows = g_string_new (CLIPBOARD_ROWS_MAGIC);
+  for (selected_rows_loop = copied_paths; selected_rows_loop; selected_rows_loop = selected_rows_loop->next) {
+    gtk_tree_model_get_iter (model, &iter_loop, selected_rows_loop->data);
+    append_rows (new_copied_rows, &iter_loop, 0);
+  }
+  new_copied_menu_txt = write_rows_as_menu_fragment (copied_paths);
+
+  target_list = gtk_target_list_new (NULL, 0);
+  gtk_target_list_add (target_list, gdk_atom_intern_static_string (CLIPBOARD_ROWS_TARGET), 0, CLIPBOARD_ROWS);
+  gtk_target_list_add_text_targets (target_list, CLIPBOARD_MENU_TXT);
+  targets = gtk_target_table_new_from_list (target_list, &number_of_targets);
+
+  // (Note: If this program already owns the clipboard, the previously copied rows are freed by this call.)
+  gtk_clipboard_set_with_data (gtk_clipboard_get (GDK_SELECTION_CLIPBOARD), targets, number_of_targets, 
+			       (GtkClipboardGetFunc) get_clipboard_content, 
+			       (GtkClipboardClearFunc) clear_clipboard_content, NULL);
+  copied_rows = new_copied_rows;
+  copied_menu_txt = new_copied_menu_txt;
+
+  // Cleanup
+  gtk_target_table_free (targets, number_of_targets);
+  gtk_target_list_unref (target_list);
+  g_list_free (copied_paths);
+  g_list_free_full (selected_rows, (GDestroyNotify) gtk_tree_path_free);
+
+  return TRUE;
+}
+
+/* 
+
+   Copies the selected rows to the clipboard and removes them afterwards.
+
+*/
+
+void cut_rows (void)
+{
+  if (copy_rows ())
+    remove_rows ("cut");
+}
+
+/* 
+
+   Reads the rows of the clipboard. Returns NULL if the data is incomplete or not of this program.
+
+*/
+
+static GArray *read_rows (const gchar *rows_data, 
+			  gsize        rows_data_length)
+{
+  const gchar *position = rows_data + strlen (CLIPBOARD_ROWS_MAGIC);
+  const gchar *end = rows_data + rows_data_length;
+  GArray *pasted_rows;
+  struct pasted_row pasted_row;
+  gint32 previous_depth = -1;
+
+  if (rows_data_length <= strlen (CLIPBOARD_ROWS_MAGIC) || 
+      memcmp (rows_data, CLIPBOARD_ROWS_MAGIC, strlen (CLIPBOARD_ROWS_MAGIC)) != 0)
+    return NULL;
+
+  pasted_rows = g_array_new (FALSE, FALSE, sizeof (struct pasted_row));
+
+  while (position < end) {
+    memset (&pasted_row, 0, sizeof (struct pasted_row));
+    // A row can be at most one level deeper than the previous one.
+    if (!read_int_from_buffer (&position, end, &pasted_row.depth) || 
+	pasted_row.depth < 0 || pasted_row.depth > previous_depth + 1 || 
+	!read_row_values_from_buffer (&position, end, &pasted_row.icon_img_status, pasted_row.txt_values))
+      goto incomplete_data;
+    previous_depth = pasted_row.depth;
+    g_array_append_val (pasted_rows, pasted_row);
+  }
+
+  return pasted_rows;
+
+ incomplete_data: 
+  free_pasted_rows (pasted_rows);
+
+  return NULL;
+}
+
+/* 
+
+   Frees the rows read from the clipboard.
+
+*/
+
+static void free_pasted_rows (GArray *pasted_rows)
+{
+  struct pasted_row *pasted_row;
+
+  for (guint rows_cnt = 0; rows_cnt < pasted_rows->len; rows_cnt++) {
+    pasted_row = &g_array_index (pasted_rows, struct pasted_row, rows_cnt);
+    for (guint8 ts_elements_cnt = TS_ICON_MODIFIED; ts_elements_cnt < NUMBER_OF_TS_ELEMENTS; ts_elements_cnt++)
+      g_free (pasted_row->txt_values[ts_elements_cnt]);
+  }
+  g_array_free (pasted_rows, TRUE);
+}
+
+/* 
+
+   Returns the image of an icon of a pasted row and adjusts the status of the icon, if it can't be loaded. 
+   Pasted menus often use the same icons several times, so every icon file is loaded only once per paste; 
+   icons that couldn't be loaded are stored as NULL.
+
+*/
+
+static GdkPixbuf *get_pasted_icon (GHashTable  *loaded_icons, 
+				   const gchar *icon_path, 
+				   guint       *icon_img_status)
+{
+  GdkPixbuf *icon = NULL;
+  GdkPixbuf *icon_in_original_size;
+
+  if (*icon_img_status == NONE_OR_NORMAL) {
+    if (!g_hash_table_lookup_extended (loaded_icons, icon_path, NULL, (gpointer *) &icon)) {
+      if ((icon_in_original_size = gdk_pixbuf_new_from_file (icon_path, NULL))) {
+	icon = gdk_pixbuf_scale_simple (icon_in_original_size, font_size + 10, font_size + 10, GDK_INTERP_BILINEAR);
+	store_original_icon (icon_path, icon_in_original_size);
+
+	// Cleanup
+	g_object_unref (icon_in_original_size);
+      }
+      g_hash_table_insert (loaded_icons, g_strdup (icon_path), icon);
+    }
+    if (icon)
+      return icon;
+  }
+
+  *icon_img_status = (g_file_test (icon_path, G_FILE_TEST_EXISTS)) ? INVALID_FILE : INVALID_PATH;
+
+  return invalid_icon_imgs[(*icon_img_status == INVALID_PATH) ? INVALID_PATH_ICON : INVALID_FILE_ICON];
+}
+
+/* 
+
+   Returns a menu ID for a pasted menu that isn't used yet; if the original one is already used, 
+   a number is appended to it.
+
+*/
+
+static gchar *get_unique_menu_id (GHashTable  *existing_menu_ids, 
+				  const gchar *menu_id)
+{
+  gchar *unique_menu_id = g_strdup (menu_id);
+  guint menu_id_index = 2;
+
+  while (g_hash_table_contains (existing_menu_ids, unique_menu_id)) {
+    g_free (unique_menu_id);
+    unique_menu_id = g_strdup_printf ("%s (%i)", menu_id, menu_id_index++);
+  }
+
+  g_hash_table_add (existing_menu_ids, g_strdup (unique_menu_id));
+  menu_ids = g_slist_prepend (menu_ids, g_strdup (unique_menu_id));
+
+  return unique_menu_id;
+}
+
+/* 
+
+   Inserts the rows of the clipboard behind the last selected row, or at the end of the toplevel if no row is selected. 
+   Actions are pasted into a selected item or behind a selected action. 
+   Every row is inserted with all its values set at once, so only one signal is emitted for each row, 
+   and the pasted rows stay collapsed, so the tree view doesn't have to lay them out. 
+   Element visibilities are adjusted to the new position and menu IDs that are already used are replaced.
+
+*/
+
+static void insert_rows (const gchar *rows_data, 
+			 gsize        rows_data_length)
+{
+  GtkTreeSelection *selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview));
+  GList *selected_rows = gtk_tree_selection_get_selected_rows (selection, &model);
+  GArray *pasted_rows = read_rows (rows_data, rows_data_length);
+  GtkTreeIter selected_iter, dest_parent_iter, new_iter;
+  GtkTreeIter *dest_parent = NULL;
+  gint position = -1; // Default
+  gchar *type_selected_txt = NULL, *element_visibility_parent_txt = NULL;
+  gboolean actions_pasted;
+  const gchar *errmsg_txt = NULL;
+
+  if (!pasted_rows || !pasted_rows->len) {
+    show_msg_in_statusbar ("The clipboard doesn't contain any menu elements");
+
+    // Cleanup
+    if (pasted_rows)
+      free_pasted_rows (pasted_rows);
+    g_list_free_full (selected_rows, (GDestroyNotify) gtk_tree_path_free);
+
+    return;
+  }
+
+  actions_pasted = streq (g_array_index (pasted_rows, struct pasted_row, 0).txt_values[TS_TYPE], "action");
+
+
+  // --- Find the position of the pasted rows. ---
+
+
+  if (selected_rows) {
+    GtkTreePath *selected_path = g_list_last (selected_rows)->data;
+
+    gtk_tree_model_get_iter (model, &selected_iter, selected_path);
+    gtk_tree_model_get (model, &selected_iter, TS_TYPE, &type_selected_txt, -1);
+
+    if (actions_pasted && streq (type_selected_txt, "item"))
+      dest_parent = &selected_iter;
+    else if ((actions_pasted && streq (type_selected_txt, "action")) || 
+	     (!actions_pasted && streq_any (type_selected_txt, "menu", "pipe menu", "item", "separator", NULL))) {
+      if (gtk_tree_model_iter_parent (model, &dest_parent_iter, &selected_iter))
+	dest_parent = &dest_parent_iter;
+      position = gtk_tree_path_get_indices (selected_path)[gtk_tree_path_get_depth (selected_path) - 1] + 1;
+    }
+    else
+      errmsg_txt = (actions_pasted) ? "Actions can only be pasted into items or next to other actions" : 
+	"Menus, pipe menus, items and separators can only be pasted next to each other or at the toplevel";
+  }
+  else if (actions_pasted)
+    errmsg_txt = "Actions can only be pasted into items or next to other actions";
+
+  if (errmsg_txt) {
+    show_msg_in_statusbar ((gchar *) errmsg_txt);
+
+    // Cleanup
+    g_free (type_selected_txt);
+    free_pasted_rows (pasted_rows);
+    g_list_free_full (selected_rows, (GDestroyNotify) gtk_tree_path_free);
+
+    return;
+  }
+
+  if (dest_parent)
+    gtk_tree_model_get (model, dest_parent, TS_ELEMENT_VISIBILITY, &element_visibility_parent_txt, -1);
+
+
+  // --- Insert the rows. ---
+
+
+  GHashTable *loaded_icons = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  GHashTableIter loaded_icons_iter;
+  GdkPixbuf *loaded_icon;
+  GHashTable *existing_menu_ids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  // The parents of the next row for every depth of the pasted rows.
+  GArray *parents = g_array_new (FALSE, FALSE, sizeof (GtkTreeIter));
+  /* The nearest invisible menu or item above a pasted descendant for every depth;
+     the element visibilities of descendants depend on it and on the one of the pasted row they belong to. */
+  GPtrArray *invisible_ancestors = g_ptr_array_new ();
+  GList *new_rows = NULL;
+  const gchar *element_visibility_root_txt = NULL;
+
+  G_GNUC_EXTENSION GValue values[NUMBER_OF_TS_ELEMENTS] = { [0 ... NUMBER_OF_TS_ELEMENTS - 1] = G_VALUE_INIT };
+  gint ts_columns[NUMBER_OF_TS_ELEMENTS];
+
+  struct pasted_row *pasted_row_loop;
+  const gchar *element_visibility_txt_loop;
+  gchar *menu_id_txt_loop;
+  GSList *menu_ids_loop;
+  GList *new_rows_loop;
+  guint rows_cnt;
+  guint8 ts_elements_cnt;
+
+  for (menu_ids_loop = menu_ids; menu_ids_loop; menu_ids_loop = menu_ids_loop->next)
+    g_hash_table_add (existing_menu_ids, g_strdup (menu_ids_loop->data));
+
+  for (ts_elements_cnt = 0; ts_elements_cnt < NUMBER_OF_TS_ELEMENTS; ts_elements_cnt++)
+    ts_columns[ts_elements_cnt] = ts_elements_cnt;
+
+  for (rows_cnt = 0; rows_cnt < pasted_rows->len; rows_cnt++) {
+    pasted_row_loop = &g_array_index (pasted_rows, struct pasted_row, rows_cnt);
+    element_visibility_txt_loop = pasted_row_loop->txt_values[TS_ELEMENT_VISIBILITY];
+
+    // Element visibility
+    if (element_visibility_txt_loop) {
+      if (pasted_row_loop->depth == 0) {
+	element_visibility_txt_loop = element_visibility_root_txt = 
+	  get_element_visibility_of_moved_row (element_visibility_parent_txt, element_visibility_txt_loop, 
+					       pasted_row_loop->txt_values[TS_MENU_ELEMENT], 
+					       pasted_row_loop->txt_values[TS_TYPE]);
+      }
+      else {
+	element_visibility_txt_loop = 
+	  get_element_visibility_of_descendant (element_visibility_root_txt, 
+						g_ptr_array_index (invisible_ancestors, pasted_row_loop->depth - 1), 
+						pasted_row_loop->txt_values[TS_MENU_ELEMENT], 
+						pasted_row_loop->txt_values[TS_TYPE]);
+      }
+    }
+    g_ptr_array_set_size (invisible_ancestors, pasted_row_loop->depth + 1);
+    if (pasted_row_loop->depth > 0) {
+      g_ptr_array_index (invisible_ancestors, pasted_row_loop->depth) = 
+	(element_visibility_txt_loop && g_str_has_prefix (element_visibility_txt_loop, "invisible")) ? 
+	(gpointer) element_visibility_txt_loop : g_ptr_array_index (invisible_ancestors, pasted_row_loop->depth - 1);
+    }
+
+    // Menu ID
+    menu_id_txt_loop = (pasted_row_loop->txt_values[TS_MENU_ID]) ? 
+      get_unique_menu_id (existing_menu_ids, pasted_row_loop->txt_values[TS_MENU_ID]) : NULL;
+
+    g_value_init (&values[TS_ICON_IMG], GDK_TYPE_PIXBUF);
+    if (pasted_row_loop->txt_values[TS_ICON_PATH]) {
+      g_value_set_object (&values[TS_ICON_IMG], 
+			  get_pasted_icon (loaded_icons, pasted_row_loop->txt_values[TS_ICON_PATH], 
+					   &pasted_row_loop->icon_img_status));
+    }
+    g_value_init (&values[TS_ICON_IMG_STATUS], G_TYPE_UINT);
+    g_value_set_uint (&values[TS_ICON_IMG_STATUS], pasted_row_loop->icon_img_status);
+    for (ts_elements_cnt = TS_ICON_MODIFIED; ts_elements_cnt < NUMBER_OF_TS_ELEMENTS; ts_elements_cnt++) {
+      g_value_init (&values[ts_elements_cnt], G_TYPE_STRING);
+      if (ts_elements_cnt == TS_ELEMENT_VISIBILITY)
+	g_value_set_static_string (&values[ts_elements_cnt], element_visibility_txt_loop);
+      else if (ts_elements_cnt == TS_MENU_ID)
+	g_value_take_string (&values[ts_elements_cnt], menu_id_txt_loop);
+      else
+	g_value_set_static_string (&values[ts_elements_cnt], pasted_row_loop->txt_values[ts_elements_cnt]);
+    }
+
+    gtk_tree_store_insert_with_valuesv (treestore, &new_iter, 
+					(pasted_row_loop->depth == 0) ? dest_parent : 
+					&g_array_index (parents, GtkTreeIter, pasted_row_loop->depth - 1), 
+					(pasted_row_loop->depth > 0 || position == -1) ? -1 : position++, 
+					ts_columns, values, NUMBER_OF_TS_ELEMENTS);
+
+    g_array_set_size (parents, pasted_row_loop->depth + 1);
+    g_array_index (parents, GtkTreeIter, pasted_row_loop->depth) = new_iter;
+    if (pasted_row_loop->depth == 0)
+      new_rows = g_list_prepend (new_rows, gtk_tree_model_get_path (model, &new_iter));
+
+    // Cleanup
+    for (ts_elements_cnt = 0; ts_elements_cnt < NUMBER_OF_TS_ELEMENTS; ts_elements_cnt++)
+      g_value_unset (&values[ts_elements_cnt]);
+  }
+
+  // Cleanup
+  g_hash_table_iter_init (&loaded_icons_iter, loaded_icons);
+  while (g_hash_table_iter_next (&loaded_icons_iter, NULL, (gpointer *) &loaded_icon)) {
+    if (loaded_icon)
+      g_object_unref (loaded_icon);
+  }
+  g_hash_table_destroy (loaded_icons);
+  g_hash_table_destroy (existing_menu_ids);
+  g_array_free (parents, TRUE);
+  g_ptr_array_free (invisible_ancestors, TRUE);
+  free_pasted_rows (pasted_rows);
+  g_free (type_selected_txt);
+  g_free (element_visibility_parent_txt);
+  g_list_free_full (selected_rows, (GDestroyNotify) gtk_tree_path_free);
+
+  // Show the pasted rows, which are selected afterwards.
+  if (dest_parent) {
+    GtkTreePath *dest_parent_path = gtk_tree_model_get_path (model, dest_parent);
+
+    gtk_tree_view_expand_to_path (GTK_TREE_VIEW (treeview), dest_parent_path);
+
+    // Cleanup
+    gtk_tree_path_free (dest_parent_path);
+  }
+  new_rows = g_list_reverse (new_rows);
+  gtk_tree_selection_unselect_all (selection);
+  for (new_rows_loop = new_rows; new_rows_loop; new_rows_loop = new_rows_loop->next)
+    gtk_tree_selection_select_path (selection, new_rows_loop->data);
+  gtk_tree_view_scroll_to_cell (GTK_TREE_VIEW (treeview), new_rows->data, NULL, FALSE, 0, 0);
+
+  // Cleanup
+  g_list_free_full (new_rows, (GDestroyNotify) gtk_tree_path_free);
+
+  row_selected ();
+  activate_change_done ();
+}
+
+/* 
+
+   Inserts the rows received from another instance of this program.
+
+*/
+
+static void clipboard_rows_received (GtkClipboard G_GNUC_UNUSED *clipboard, 
+				     GtkSelectionData            *selection_data, 
+				     gpointer G_GNUC_UNUSED       user_data)
+{
+  gint rows_data_length = gtk_selection_data_get_length (selection_data);
+
+  if (rows_data_length > 0)
+    insert_rows ((const gchar *) gtk_selection_data_get_data (selection_data), rows_data_length);
+  else
+    show_msg_in_statusbar ("The clipboard doesn't contain any menu elements");
+}
+
+/* 
+
+   Pastes the rows of the clipboard. Rows that have been copied inside this program are inserted directly, 
+   otherwise they are requested from the program that owns the clipboard.
+
+*/
+
+void paste_rows (void)
+{
+  if (copied_rows)
+    insert_rows (copied_rows->str, copied_rows->len);
+  else
+    gtk_clipboard_request_contents (gtk_clipboard_get (GDK_SELECTION_CLIPBOARD), 
+				    gdk_atom_intern_static_string (CLIPBOARD_ROWS_TARGET), 
+				    (GtkClipboardReceivedFunc) clipboard_rows_received, NULL);
+}
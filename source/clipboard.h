@@ -0,0 +1,54 @@
+/*
+   Kickshaw - A Menu Editor for Openbox
+
+   Copyright (c) 2010-2013        Marcus Schaetzle
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along 
+   with Kickshaw. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef __clipboard_h
+#define __clipboard_h
+
+#define streq(string1, string2) (g_strcmp0 ((string1), (string2)) == 0)
+
+extern GtkTreeStore *treestore;
+extern GtkTreeModel *model;
+extern GtkWidget *treeview;
+
+extern GdkPixbuf *invalid_icon_imgs[];
+
+extern GSList *menu_ids;
+
+extern guint font_size;
+
+extern void activate_change_done (void);
+extern void append_int_to_buffer (GString *buffer, gint32 value);
+extern void append_row_values_to_buffer (GString *buffer, GtkTreeModel *local_model, GtkTreeIter *local_iter);
+extern const gchar *get_element_visibility_of_descendant (const gchar *element_visibility_root_txt, 
+							  const gchar *element_visibility_ancestor_txt, 
+							  const gchar *menu_element_txt, const gchar *type_txt);
+extern const gchar *get_element_visibility_of_moved_row (const gchar *element_visibility_parent_txt, 
+							 const gchar *element_visibility_source_txt, 
+							 const gchar *menu_element_txt, const gchar *type_txt);
+extern gboolean read_int_from_buffer (const gchar **position, const gchar *end, gint32 *value);
+extern gboolean read_row_values_from_buffer (const gchar **position, const gchar *end, guint *icon_img_status, 
+					     gchar **txt_values);
+extern void remove_rows (gchar *origin);
+extern void row_selected (void);
+extern void show_msg_in_statusbar (gchar *message);
+extern void store_original_icon (const gchar *icon_path, GdkPixbuf *icon_in_original_size);
+G_GNUC_NULL_TERMINATED extern gboolean streq_any (const gchar *string, ...);
+extern gchar *write_rows_as_menu_fragment (GList *paths);
+
+#endif
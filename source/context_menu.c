@@ -107,19 +107,29 @@ static void expand_or_collapse_selected_rows (gpointer action_pointer)
   GtkTreeSelection *selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview));
   GList *selected_rows = gtk_tree_selection_get_selected_rows (selection, &model);
   GtkTreePath *path;
+  GtkTreePath *last_processed_path = NULL;
   
   GList *g_list_loop;
 
+  begin_batch_expansion ();
+
   for (g_list_loop = selected_rows; g_list_loop; g_list_loop = g_list_loop->next) {
     path = g_list_loop->data;
+    /* A selected descendant of a row that has been expanded recursively or collapsed already has its final status. 
+       (Note: The selected rows are sorted in tree order.) */
+    if (action != IMMEDIATE && last_processed_path && gtk_tree_path_is_descendant (path, last_processed_path))
+      continue;
     /* If the nodes are already expanded recursively and only the immediate children shall be expanded now, 
        it is the fastest way to collapse all nodes first. */
     gtk_tree_view_collapse_row (GTK_TREE_VIEW (treeview), path);
-    if (action == COLLAPSE)
-      gtk_tree_view_columns_autosize (GTK_TREE_VIEW (treeview));
-    else
+    if (action != COLLAPSE)
       gtk_tree_view_expand_row (GTK_TREE_VIEW (treeview), path, (action == RECURSIVELY));
+    last_processed_path = path;
   }
+  if (action == COLLAPSE)
+    gtk_tree_view_columns_autosize (GTK_TREE_VIEW (treeview));
+
+  end_batch_expansion ();
   
   // Cleanup
   g_list_free_full (selected_rows, (GDestroyNotify) gtk_tree_path_free);
@@ -236,6 +246,8 @@ void create_context_menu (GdkEventButton *event)
     if (number_of_selected_rows < 2) {
       gtk_tree_selection_unselect_all (selection);
       gtk_tree_selection_select_path (selection, path);
+      // Changes of the selection are processed later inside an idle callback, but txt_fields is needed now.
+      row_selected ();
       selected_rows = gtk_tree_selection_get_selected_rows (selection, &model);
       number_of_selected_rows = 1; // if there had not been a selection before.
 
@@ -371,6 +383,7 @@ void create_context_menu (GdkEventButton *event)
 
     if (!path) {
       gtk_tree_selection_unselect_all (selection);
+      row_selected ();
       create_cm_headline (context_menu, " Add at toplevel");
     }
     for (basic_menu_elements_cnt = 0; 
@@ -387,6 +400,12 @@ void create_context_menu (GdkEventButton *event)
     }
     if (path)
       gtk_menu_shell_append (GTK_MENU_SHELL (context_menu), gtk_separator_menu_item_new ());
+    else {
+      gtk_menu_shell_append (GTK_MENU_SHELL (context_menu), gtk_separator_menu_item_new ());
+      menu_item = gtk_menu_item_new_with_label ("Paste");
+      g_signal_connect (menu_item, "activate", G_CALLBACK (paste_rows), NULL);
+      gtk_menu_shell_append (GTK_MENU_SHELL (context_menu), menu_item);
+    }
   }
 
   if (path) {
@@ -440,6 +459,18 @@ void create_context_menu (GdkEventButton *event)
       gtk_menu_shell_append (GTK_MENU_SHELL (context_menu), gtk_separator_menu_item_new ());
     }
 
+    // Cut, copy and paste
+    menu_item = gtk_menu_item_new_with_label ("Cut");
+    g_signal_connect (menu_item, "activate", G_CALLBACK (cut_rows), NULL);
+    gtk_menu_shell_append (GTK_MENU_SHELL (context_menu), menu_item);
+    menu_item = gtk_menu_item_new_with_label ("Copy");
+    g_signal_connect (menu_item, "activate", G_CALLBACK (copy_rows), NULL);
+    gtk_menu_shell_append (GTK_MENU_SHELL (context_menu), menu_item);
+    menu_item = gtk_menu_item_new_with_label ("Paste");
+    g_signal_connect (menu_item, "activate", G_CALLBACK (paste_rows), NULL);
+    gtk_menu_shell_append (GTK_MENU_SHELL (context_menu), menu_item);
+    gtk_menu_shell_append (GTK_MENU_SHELL (context_menu), gtk_separator_menu_item_new ());
+
     // Remove
     menu_item = gtk_menu_item_new_with_label ("Remove");
     gtk_menu_shell_append (GTK_MENU_SHELL (context_menu), menu_item);
@@ -471,6 +502,16 @@ void create_context_menu (GdkEventButton *event)
       g_signal_connect (menu_item, "activate", G_CALLBACK (remove_all_children), NULL);
       gtk_menu_shell_append (GTK_MENU_SHELL (context_menu), menu_item);
 
+      // Sort children
+      if (children_of_selection_can_be_sorted ()) {
+	menu_item = gtk_menu_item_new_with_label ("Sort children");
+	g_signal_connect_swapped (menu_item, "activate", G_CALLBACK (sort_children), GUINT_TO_POINTER (FALSE));
+	gtk_menu_shell_append (GTK_MENU_SHELL (context_menu), menu_item);
+	menu_item = gtk_menu_item_new_with_label ("Sort children recursively");
+	g_signal_connect_swapped (menu_item, "activate", G_CALLBACK (sort_children), GUINT_TO_POINTER (TRUE));
+	gtk_menu_shell_append (GTK_MENU_SHELL (context_menu), menu_item);
+      }
+
       // Expand or collapse node(s)
       gtk_menu_shell_append (GTK_MENU_SHELL (context_menu), gtk_separator_menu_item_new ());
 
@@ -41,17 +41,25 @@ extern gchar *startupnotify_options[];
 
 extern void action_option_insert (gchar *cm_choice);
 extern void add_new (gchar *new_element_type);
+extern void begin_batch_expansion (void);
 extern void check_for_existing_options (GtkTreeIter *parent, guint8 number_of_opts, 
 					gchar **options_array, gboolean *opts_exist);
 extern gboolean check_if_invisible_descendant_exists (GtkTreeModel *filter_model,
 						      GtkTreePath G_GNUC_UNUSED *filter_path,
 						      GtkTreeIter *filter_iter, 
 						      gboolean *at_least_one_descendant_is_invisible);
+extern gboolean children_of_selection_can_be_sorted (void);
+extern gboolean copy_rows (void);
+extern void end_batch_expansion (void);
+extern void cut_rows (void);
 extern void generate_action_option_combo_box (gchar *preset_choice);
 extern void icon_choosing_by_button_or_context_menu (void);
+extern void paste_rows (void);
 extern void remove_all_children (void);
 extern void remove_icons_from_menus_or_items (void);
 extern void remove_rows (gchar *origin);
+extern void row_selected (void);
+extern void sort_children (gpointer recursively_pointer);
 G_GNUC_NULL_TERMINATED extern gboolean streq_any (const gchar *string, ...);
 extern void visualise_menus_items_and_separators (gpointer recursively_pointer);
 
@@ -22,178 +22,297 @@
 #include "general_header_files/enum__ts_elements.h"
 #include "drag_and_drop.h"
 
-enum { SUBROWS_ICON_IMG, SUBROWS_ICON_IMG_STATUS, SUBROWS_ICON_MODIFIED, SUBROWS_ICON_PATH, SUBROWS_MENU_ELEMENT, 
-       SUBROWS_TYPE, SUBROWS_VALUE, SUBROWS_MENU_ID, SUBROWS_EXECUTE, SUBROWS_ELEMENT_VISIBILITY, 
-       SUBROWS_EXPANSION_STATUS, SUBROWS_CURRENT_PATH_DEPTH, SUBROWS_MAX_PATH_DEPTH, SUBROWS_PARENT_VISIBILITY, 
-       NUMBER_OF_SUBROW_ELEMENTS };
-
+struct drag_source {
+  GtkTreePath *path, *parent_path;
+  gchar *menu_element, *type, *value, *element_visibility;
+};
+
+/* Attributes of the dragged rows, extracted once when the drag begins. 
+   (Note: The treestore doesn't change while a row is dragged, so they stay valid until the drag ends.) */
+static GArray *drag_sources = NULL;
+// Key: destination parent and drop position, value: statusbar message or NULL if a drop is possible there.
+static GHashTable *drop_verdicts = NULL;
+static const gchar *shown_drag_msg = NULL;
+
+static void clear_drag_source (struct drag_source *source);
+void drag_begin_handler (void);
+void drag_end_handler (void);
+static const gchar *get_drop_verdict (GtkTreeIter *dest_parent_iter, GtkTreePath *dest_parent_path, 
+				      gboolean dropped_onto_row);
 gboolean drag_motion_handler (GtkWidget G_GNUC_UNUSED *widget, GdkDragContext *drag_context, gint x, gint y, guint time);
-static gboolean subrows_creation_auxiliary (GtkTreeModel *filter_model, GtkTreePath *filter_path,
-					    GtkTreeIter *filter_iter, GPtrArray **ts_subrows);
+static void get_row_values (GtkTreeIter *local_iter, GValue *values);
+static void insert_row_values (GtkTreeIter *new_iter, GtkTreeIter *parent, gint position, GValue *values);
+const gchar *get_element_visibility_of_moved_row (const gchar *element_visibility_parent_txt, 
+						 const gchar *element_visibility_source_txt, 
+						 const gchar *menu_element_txt, const gchar *type_txt);
+const gchar *get_element_visibility_of_descendant (const gchar *element_visibility_root_txt, 
+						   const gchar *element_visibility_ancestor_txt, 
+						   const gchar *menu_element_txt, const gchar *type_txt);
+static void copy_children (GtkTreeIter *source_parent_iter, GtkTreeIter *new_parent_iter, 
+			   const gchar *element_visibility_root_txt, const gchar *element_visibility_ancestor_txt);
 void drag_data_received_handler (GtkWidget G_GNUC_UNUSED *widget, GdkDragContext G_GNUC_UNUSED *context, gint x, gint y);
 
 /* 
 
-   Allows a drop only under conditions which make sense.
+   Frees the extracted attributes of a dragged row.
 
 */
 
-gboolean drag_motion_handler (GtkWidget G_GNUC_UNUSED *widget, 
-			      GdkDragContext          *drag_context, 
-			      gint                     x, 
-			      gint                     y, 
-			      guint                    time)
+static void clear_drag_source (struct drag_source *source)
 {
-  GtkTreeViewDropPosition position;
-  gboolean dropped_onto_row = FALSE; // Default
+  gtk_tree_path_free (source->path);
+  gtk_tree_path_free (source->parent_path);
+  g_free (source->menu_element);
+  g_free (source->type);
+  g_free (source->value);
+  g_free (source->element_visibility);
+}
 
-  gint dest_path_depth;
-  GtkTreeIter dest_parent_iter;
-  gchar *menu_element_dest_parent_txt = NULL;
-  gchar *type_dest_parent_txt = NULL;
-  GtkTreePath *dest_path_drag_motion, *source_parent_path, *dest_parent_path = NULL; // Default
+/* 
+
+   Extracts the attributes of all dragged rows that are needed to check a drop, 
+   so this isn't done again for every motion of the pointer.
 
+*/
+
+void drag_begin_handler (void)
+{
+  struct drag_source source;
   GtkTreeIter iter_loop;
-  GtkTreeIter action_iter_loop; // Loop inside iter_loop.
-  GtkTreePath *source_path_loop;
-  gchar *menu_element_txt_loop, *type_txt_loop, *value_txt_loop, *element_visibility_txt_loop;
-  gchar *menu_element_action_txt_loop; // Loop text for action_iter_loop.
   GSList *g_slist_loop;
 
-  gchar *statusbar_txt = NULL;
+  drag_end_handler (); // Clears the data of a previous drag, if there is any left.
+
+  drag_sources = g_array_new (FALSE, FALSE, sizeof (struct drag_source));
+  g_array_set_clear_func (drag_sources, (GDestroyNotify) clear_drag_source);
+  drop_verdicts = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  for (g_slist_loop = source_paths; g_slist_loop; g_slist_loop = g_slist_loop->next) {
+    source.path = gtk_tree_row_reference_get_path (g_slist_loop->data);
+    gtk_tree_model_get_iter (model, &iter_loop, source.path);
+    gtk_tree_model_get (model, &iter_loop, 
+			TS_MENU_ELEMENT, &source.menu_element, 
+			TS_TYPE, &source.type, 
+			TS_VALUE, &source.value,
+			TS_ELEMENT_VISIBILITY, &source.element_visibility, 
+			-1);
+
+    source.parent_path = gtk_tree_path_copy (source.path);
+    gtk_tree_path_up (source.parent_path);
 
-  gint ch_cnt;
+    g_array_append_val (drag_sources, source);
+  }
 
   show_msg_in_statusbar (""); // Reset
+  shown_drag_msg = NULL;
+}
 
-  gtk_tree_view_get_dest_row_at_pos (GTK_TREE_VIEW (treeview), x, y, &dest_path_drag_motion, &position);
-  /* if the result is NULL, not TRUE (unsucessful) is returned here, since the result indicates that the 
-     row has been dragged after the last row of the menu. */ 
+/* 
 
-  if (dest_path_drag_motion) {
-    dest_path_depth = gtk_tree_path_get_depth (dest_path_drag_motion);
-    if (position == GTK_TREE_VIEW_DROP_INTO_OR_BEFORE || position == GTK_TREE_VIEW_DROP_INTO_OR_AFTER) {
-      gtk_tree_model_get_iter (model, &dest_parent_iter, dest_path_drag_motion);
-      dropped_onto_row = TRUE;
-    } 
-    else if (dest_path_depth > 1) {
-      GtkTreeIter dest_iter;
+   Frees the extracted attributes of the dragged rows and the checked drops after the drag has ended.
 
-      gtk_tree_model_get_iter (model, &dest_iter, dest_path_drag_motion);
-      gtk_tree_model_iter_parent (model, &dest_parent_iter, &dest_iter);
-    }
+*/
 
-    if (dest_path_depth > 1 || dropped_onto_row) {
-      gtk_tree_model_get (model, &dest_parent_iter, 
-			  TS_MENU_ELEMENT, &menu_element_dest_parent_txt, 
-			  TS_TYPE, &type_dest_parent_txt, 
-			  -1);
-      if (dest_path_depth > 1)
-	dest_parent_path = gtk_tree_model_get_path (model, &dest_parent_iter);
-    }
+void drag_end_handler (void)
+{
+  if (drag_sources) {
+    g_array_free (drag_sources, TRUE);
+    drag_sources = NULL;
   }
-  else // Dragged after the last row of the menu.
-    dest_path_depth = 1;
+  if (drop_verdicts) {
+    g_hash_table_destroy (drop_verdicts);
+    drop_verdicts = NULL;
+  }
+  // A message about an impossible drop is outdated after the drag has been cancelled.
+  if (shown_drag_msg) {
+    show_msg_in_statusbar ("");
+    shown_drag_msg = NULL;
+  }
+}
 
-  for (g_slist_loop = source_paths; g_slist_loop; g_slist_loop = g_slist_loop->next) {
-    source_path_loop = gtk_tree_row_reference_get_path (g_slist_loop->data);
-    gtk_tree_model_get_iter (model, &iter_loop, source_path_loop);
-    gtk_tree_model_get (model, &iter_loop, 
-			TS_MENU_ELEMENT, &menu_element_txt_loop, 
-			TS_TYPE, &type_txt_loop, 
-			TS_VALUE, &value_txt_loop,
-			TS_ELEMENT_VISIBILITY, &element_visibility_txt_loop, 
+/* 
+
+   Checks whether all dragged rows can be dropped under the destination parent (NULL for toplevel). 
+   Returns the message that explains why the drop is not possible or NULL if it is.
+
+*/
+
+static const gchar *get_drop_verdict (GtkTreeIter *dest_parent_iter, 
+				      GtkTreePath *dest_parent_path, 
+				      gboolean     dropped_onto_row)
+{
+  const gchar *statusbar_txt = NULL;
+  gchar *menu_element_dest_parent_txt = NULL;
+  gchar *type_dest_parent_txt = NULL;
+  // Key: label of an option inside the destination parent; created on demand.
+  GHashTable *options_of_dest_parent = NULL;
+
+  struct drag_source *source_loop;
+  GtkTreeIter action_iter_loop;
+  gchar *menu_element_action_txt_loop;
+  gboolean valid;
+
+  if (dest_parent_iter) {
+    gtk_tree_model_get (model, dest_parent_iter, 
+			TS_MENU_ELEMENT, &menu_element_dest_parent_txt, 
+			TS_TYPE, &type_dest_parent_txt, 
 			-1);
+  }
 
-    source_parent_path = gtk_tree_path_copy (source_path_loop);
-    gtk_tree_path_up (source_parent_path);
+  for (guint sources_cnt = 0; sources_cnt < drag_sources->len; sources_cnt++) {
+    source_loop = &g_array_index (drag_sources, struct drag_source, sources_cnt);
 
-    // Prevent that menus are dragged into themselves.
-    if (streq (type_txt_loop, "menu") && dest_path_drag_motion && 
-	gtk_tree_path_is_descendant (dest_path_drag_motion, source_path_loop)) {
+    /* Prevent that menus are dragged into themselves. 
+       (Note: If the row is dropped before or after another row, the latter is inside the menu if 
+       its parent is the menu itself or one of the menu's descendants.) */
+    if (streq (source_loop->type, "menu") && dest_parent_path && 
+	(gtk_tree_path_is_descendant (dest_parent_path, source_loop->path) || 
+	 (!dropped_onto_row && gtk_tree_path_compare (dest_parent_path, source_loop->path) == 0))) {
       statusbar_txt = "!!! Menus can't be dragged into themselves !!!";
-      goto cleanup;
+      break;
     }
 
     // Prevent that menu elements are dragged to a place where they don't belong.
-    if (((dest_path_depth > 1 || dropped_onto_row) && 
-	 element_visibility_txt_loop && !streq (type_dest_parent_txt, "menu")) || 
+    if ((dest_parent_iter && source_loop->element_visibility && !streq (type_dest_parent_txt, "menu")) || 
 
-	(streq (type_txt_loop, "action") && !streq (type_dest_parent_txt, "item")) || 
+	(streq (source_loop->type, "action") && !streq (type_dest_parent_txt, "item")) || 
 
-    	(streq (type_txt_loop, "option") && streq (menu_element_txt_loop, "prompt") &&
+    	(streq (source_loop->type, "option") && streq (source_loop->menu_element, "prompt") &&
     	 !(streq (type_dest_parent_txt, "action") &&  
 	   streq_any (menu_element_dest_parent_txt, "Execute", "Exit", "SessionLogout", NULL))) || 
 	
-	(streq (type_txt_loop, "option") && streq (menu_element_txt_loop, "command") && 
+	(streq (source_loop->type, "option") && streq (source_loop->menu_element, "command") && 
 	 !(streq (type_dest_parent_txt, "action") && 
 	   streq_any (menu_element_dest_parent_txt, "Execute", "Restart", NULL))) ||
 	
-	(streq (type_txt_loop, "option block") && 
+	(streq (source_loop->type, "option block") && 
 	 !(streq (type_dest_parent_txt, "action") && streq (menu_element_dest_parent_txt, "Execute"))) ||
 
-	(streq (type_txt_loop, "option") && 
-	 streq_any (menu_element_txt_loop, "enabled", "name", "wmclass", "icon", NULL) && 
+	(streq (source_loop->type, "option") && 
+	 streq_any (source_loop->menu_element, "enabled", "name", "wmclass", "icon", NULL) && 
 	 !streq (type_dest_parent_txt, "option block"))) {
       statusbar_txt = "!!! Inappropriate new position !!!";
-      goto cleanup;
+      break;
     }
 
     // Prevent that Execute options are dragged inside the same Execute action if autosorting is activated.
-    if (autosort_options && streq_any (type_txt_loop, "option", "option block", NULL) && 
+    if (autosort_options && streq_any (source_loop->type, "option", "option block", NULL) && 
 	streq_any (menu_element_dest_parent_txt, "Execute", "startupnotify", NULL) &&
-	gtk_tree_path_compare (source_parent_path, dest_parent_path) == 0) {
+	gtk_tree_path_compare (source_loop->parent_path, dest_parent_path) == 0) {
       statusbar_txt = "!!! Autosorting active - no movement of options inside the same action possible !!!";
-      goto cleanup;
+      break;
     }
 
     // Prevent multiple identical options in one action.
     if (streq_any (type_dest_parent_txt, "action", "option block", NULL) &&
-	streq_any (type_txt_loop, "option", "option block", NULL) && 
-	gtk_tree_path_compare (source_parent_path, dest_parent_path) != 0) {
-      for (ch_cnt = 0; ch_cnt < gtk_tree_model_iter_n_children (model, &dest_parent_iter); ch_cnt++) {
-	gtk_tree_model_iter_nth_child (model, &action_iter_loop, &dest_parent_iter, ch_cnt);
-	gtk_tree_model_get (model, &action_iter_loop, TS_MENU_ELEMENT, &menu_element_action_txt_loop, -1);
-	if (streq (menu_element_txt_loop, menu_element_action_txt_loop)) {
-	  statusbar_txt = "!!! Only one option of a kind allowed !!!";
-	  // Cleanup
-	  g_free (menu_element_action_txt_loop);
-	  goto cleanup;
+	streq_any (source_loop->type, "option", "option block", NULL) && 
+	gtk_tree_path_compare (source_loop->parent_path, dest_parent_path) != 0) {
+      if (!options_of_dest_parent) {
+	options_of_dest_parent = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	valid = gtk_tree_model_iter_children (model, &action_iter_loop, dest_parent_iter);
+	while (valid) {
+	  gtk_tree_model_get (model, &action_iter_loop, TS_MENU_ELEMENT, &menu_element_action_txt_loop, -1);
+	  g_hash_table_add (options_of_dest_parent, menu_element_action_txt_loop);
+	  valid = gtk_tree_model_iter_next (model, &action_iter_loop);
 	}
-	// Cleanup
-	g_free (menu_element_action_txt_loop);
+      }
+      if (g_hash_table_contains (options_of_dest_parent, source_loop->menu_element)) {
+	statusbar_txt = "!!! Only one option of a kind allowed !!!";
+	break;
       }
     }
 
     /* Prevent that a prompt option with a value other than "yes" or "no" is dragged into the actions 
        "Exit" and "SessionLogout". */
-    if (streq (type_txt_loop, "option") && streq (menu_element_txt_loop, "prompt") && 
+    if (streq (source_loop->type, "option") && streq (source_loop->menu_element, "prompt") && 
 	streq_any (menu_element_dest_parent_txt, "Exit", "SessionLogout", NULL) && 
-	!streq_any (value_txt_loop, "yes", "no", NULL)) {
+	!streq_any (source_loop->value, "yes", "no", NULL)) {
       statusbar_txt = "!!! Prompt option must have value \"yes\" or \"no\" !!!";
-      goto cleanup;
+      break;
     }
+  }
 
-  cleanup:
-    gtk_tree_path_free (source_path_loop);
-    gtk_tree_path_free (source_parent_path);
-    g_free (menu_element_txt_loop); 
-    g_free (type_txt_loop);
-    g_free (value_txt_loop);
-    g_free (element_visibility_txt_loop);
+  // Cleanup
+  g_free (menu_element_dest_parent_txt);
+  g_free (type_dest_parent_txt);
+  if (options_of_dest_parent)
+    g_hash_table_destroy (options_of_dest_parent);
 
-    if (statusbar_txt)
-      break;
+  return statusbar_txt;
+}
+
+/* 
+
+   Allows a drop only under conditions which make sense.
+   The result of the check is stored for every destination parent and drop position, 
+   so moving the pointer inside the same place of the tree doesn't repeat the check. 
+   The statusbar is only changed if the message differs from the one that is already shown.
+
+*/
+
+gboolean drag_motion_handler (GtkWidget G_GNUC_UNUSED *widget, 
+			      GdkDragContext          *drag_context, 
+			      gint                     x, 
+			      gint                     y, 
+			      guint                    time)
+{
+  GtkTreeViewDropPosition position;
+  gboolean dropped_onto_row = FALSE; // Default
+
+  gint dest_path_depth;
+  GtkTreeIter dest_parent_iter;
+  GtkTreePath *dest_path_drag_motion, *dest_parent_path = NULL; // Default
+  gchar *dest_parent_path_str;
+  gchar *verdict_key;
+  gpointer statusbar_txt;
+
+  if (!drag_sources)
+    drag_begin_handler ();
+
+  gtk_tree_view_get_dest_row_at_pos (GTK_TREE_VIEW (treeview), x, y, &dest_path_drag_motion, &position);
+  /* if the result is NULL, not TRUE (unsucessful) is returned here, since the result indicates that the 
+     row has been dragged after the last row of the menu. */ 
+
+  if (dest_path_drag_motion) {
+    dest_path_depth = gtk_tree_path_get_depth (dest_path_drag_motion);
+    if (position == GTK_TREE_VIEW_DROP_INTO_OR_BEFORE || position == GTK_TREE_VIEW_DROP_INTO_OR_AFTER) {
+      gtk_tree_model_get_iter (model, &dest_parent_iter, dest_path_drag_motion);
+      dropped_onto_row = TRUE;
+    } 
+    else if (dest_path_depth > 1) {
+      GtkTreeIter dest_iter;
+
+      gtk_tree_model_get_iter (model, &dest_iter, dest_path_drag_motion);
+      gtk_tree_model_iter_parent (model, &dest_parent_iter, &dest_iter);
+    }
+
+    if (dest_path_depth > 1 || dropped_onto_row)
+      dest_parent_path = gtk_tree_model_get_path (model, &dest_parent_iter);
+  }
+
+  dest_parent_path_str = (dest_parent_path) ? gtk_tree_path_to_string (dest_parent_path) : NULL;
+  verdict_key = g_strdup_printf ("%s%s", (dropped_onto_row) ? "onto " : "", 
+				 (dest_parent_path_str) ? dest_parent_path_str : "");
+
+  if (g_hash_table_lookup_extended (drop_verdicts, verdict_key, NULL, &statusbar_txt))
+    g_free (verdict_key);
+  else {
+    statusbar_txt = (gpointer) get_drop_verdict ((dest_parent_path) ? &dest_parent_iter : NULL, 
+						 dest_parent_path, dropped_onto_row);
+    g_hash_table_insert (drop_verdicts, verdict_key, statusbar_txt);
   }
 
   // Cleanup
   gtk_tree_path_free (dest_path_drag_motion);
   gtk_tree_path_free (dest_parent_path);
-  g_free (menu_element_dest_parent_txt);
-  g_free (type_dest_parent_txt);
+  g_free (dest_parent_path_str);
+
+  if (statusbar_txt != shown_drag_msg) {
+    show_msg_in_statusbar ((statusbar_txt) ? statusbar_txt : "");
+    shown_drag_msg = statusbar_txt;
+  }
 
   if (statusbar_txt) {
-    show_msg_in_statusbar (statusbar_txt);
     gdk_drag_status (drag_context, 0, time); // indicates that a drop will not be accepted.
     return TRUE;
   }
@@ -203,110 +322,163 @@ gboolean drag_motion_handler (GtkWidget G_GNUC_UNUSED *widget,
 
 /* 
 
-   Helps with the duplication of the original subrows and the adjustment of their visibility status to 
-   their new parent by two steps:
-   1. Creation of arrays of the source row's subrows that includes their path depth and expansion status.
-   2. Adjustment of the expansion status of each subrow according to the ones of the source row.
-   The element visibility of all menus, pipe menus, items and separators
-   of subrows is also adjusted to the one of the destination parent.
+   Retrieves all fields of a row at once.
 
 */
 
-static gboolean subrows_creation_auxiliary (GtkTreeModel *filter_model, 
-					    GtkTreePath  *filter_path, 
-					    GtkTreeIter  *filter_iter, 
-					    GPtrArray    **subrows)
+static void get_row_values (GtkTreeIter *local_iter, 
+			    GValue      *values)
 {
-  if (streq (g_ptr_array_index (subrows[SUBROWS_PARENT_VISIBILITY], 0), "n/a")) {
-    // --- Step 1: Creation of subrow array(s) ---
+  for (guint8 ts_cnt = 0; ts_cnt < NUMBER_OF_TS_ELEMENTS; ts_cnt++)
+    gtk_tree_model_get_value (model, local_iter, ts_cnt, &values[ts_cnt]);
+}
+
+/* 
 
-    gint current_path_depth = gtk_tree_path_get_depth (filter_path);
-    gint *max_path_depth = (gint *) subrows[SUBROWS_MAX_PATH_DEPTH][0].pdata;
-    GtkTreePath *model_path;
+   Inserts a new row with all its fields set at once, so only one signal is emitted for the new row, 
+   and unsets the values afterwards.
 
-    gpointer current_ts_field;
+*/
 
-    guint8 subrows_elm_cnt;
+static void insert_row_values (GtkTreeIter *new_iter, 
+			       GtkTreeIter *parent, 
+			       gint         position, 
+			       GValue      *values)
+{
+  gint ts_columns[NUMBER_OF_TS_ELEMENTS];
+  guint8 ts_cnt;
 
-    if (current_path_depth > *max_path_depth)
-      *max_path_depth = current_path_depth;
+  for (ts_cnt = 0; ts_cnt < NUMBER_OF_TS_ELEMENTS; ts_cnt++)
+    ts_columns[ts_cnt] = ts_cnt;
 
-    for (subrows_elm_cnt = 0; subrows_elm_cnt <= SUBROWS_ELEMENT_VISIBILITY; subrows_elm_cnt++) {
-      gtk_tree_model_get (filter_model, filter_iter, subrows_elm_cnt, &current_ts_field, -1);
-      g_ptr_array_add (subrows[subrows_elm_cnt], current_ts_field);
-    }
+  gtk_tree_store_insert_with_valuesv (treestore, new_iter, parent, position, ts_columns, values, NUMBER_OF_TS_ELEMENTS);
 
-    // SUBROWS_EXPANSION_STATUS
-    // The path of the model, not filter model, is needed to check whether the row is expanded.
-    model_path = gtk_tree_model_filter_convert_path_to_child_path ((GtkTreeModelFilter *) filter_model, filter_path);
-    g_ptr_array_add (subrows[SUBROWS_EXPANSION_STATUS], 
-		     GUINT_TO_POINTER (gtk_tree_view_row_expanded (GTK_TREE_VIEW (treeview), model_path)));
-    // Cleanup
-    gtk_tree_path_free (model_path);
+  // Cleanup
+  for (ts_cnt = 0; ts_cnt < NUMBER_OF_TS_ELEMENTS; ts_cnt++)
+    g_value_unset (&values[ts_cnt]);
+}
 
-    // SUBROWS_CURRENT_PATH_DEPTH
-    g_ptr_array_add (subrows[SUBROWS_CURRENT_PATH_DEPTH], GUINT_TO_POINTER (current_path_depth));
-  }
-  else {
-    // --- Step 2: Adjustment of subrows ---
+/* 
 
-    // --- Step 2a: Expansion status ---
-    // The path of the model, not filter model, is needed to set the expansion status.
-    GtkTreePath *model_path = 
-      gtk_tree_model_filter_convert_path_to_child_path (GTK_TREE_MODEL_FILTER (filter_model), filter_path);
+   Returns the element visibility of a menu, pipe menu, item or separator that is moved or pasted into a menu 
+   or to the toplevel, according to the element visibility of the new parent (NULL for the toplevel).
 
-    if (GPOINTER_TO_UINT (g_ptr_array_index (subrows[SUBROWS_EXPANSION_STATUS], 0)))
-      gtk_tree_view_expand_row (GTK_TREE_VIEW (treeview), model_path, FALSE);
+*/
 
-    // Cleanup
-    gtk_tree_path_free (model_path);
+const gchar *get_element_visibility_of_moved_row (const gchar *element_visibility_parent_txt, 
+						 const gchar *element_visibility_source_txt, 
+						 const gchar *menu_element_txt, 
+						 const gchar *type_txt)
+{
+  if (!element_visibility_parent_txt || streq (element_visibility_parent_txt, "visible")) {
+    if (!element_visibility_parent_txt && streq (element_visibility_source_txt, "invisible unintegrated menu"))
+      return "invisible unintegrated menu";
+    else if (!menu_element_txt && !streq (type_txt, "separator"))
+      return (streq (type_txt, "item")) ? "invisible item" : "invisible menu";
+    else
+      return "visible";
+  }
+  else if (g_str_has_suffix (element_visibility_parent_txt, "invisible menu"))
+    return "invisible dsct. of invisible menu";
+  else
+    return "invisible dsct. of invisible unintegrated menu";
+}
 
-    g_ptr_array_remove_index (subrows[SUBROWS_EXPANSION_STATUS], 0);
+/* 
 
-    // --- Step 2b: Visibilty of menus, pipe menus, items and separators ---
-    gchar *element_visibility_txt_filter;
+   Adjusts the element visibility of a menu, pipe menu, item or separator inside a moved row to the visibility 
+   of the moved row and to the one of the nearest invisible ancestor between them.
 
-    gtk_tree_model_get (filter_model, filter_iter, TS_ELEMENT_VISIBILITY, &element_visibility_txt_filter, -1);
+*/
 
-    if (!element_visibility_txt_filter)
-      return FALSE;
+const gchar *get_element_visibility_of_descendant (const gchar *element_visibility_root_txt, 
+						   const gchar *element_visibility_ancestor_txt, 
+						   const gchar *menu_element_txt, 
+						   const gchar *type_txt)
+{
+  if (g_str_has_suffix (element_visibility_root_txt, "unintegrated menu"))
+    return "invisible dsct. of invisible unintegrated menu";
+  else if (g_str_has_suffix (element_visibility_root_txt, "invisible menu") || 
+	   (element_visibility_ancestor_txt && g_str_has_suffix (element_visibility_ancestor_txt, "invisible menu")))
+    return "invisible dsct. of invisible menu";
+  else if (!element_visibility_ancestor_txt && !menu_element_txt && !streq (type_txt, "separator"))
+    return (streq (type_txt, "menu")) ? "invisible menu" : "invisible item";
+  else
+    return "visible";
+}
 
-    GtkTreeIter iter_model;
-    gchar *element_visibility_txt_parent = g_ptr_array_index (subrows[SUBROWS_PARENT_VISIBILITY], 0);
-    gchar *menu_element_txt_filter, *type_txt_filter;
-    gchar *new_element_visibility_txt = "visible"; // Default
+/* 
 
-    gtk_tree_model_get (filter_model, filter_iter, 
-			TS_MENU_ELEMENT, &menu_element_txt_filter, 
-			TS_TYPE, &type_txt_filter, 
-			-1);
+   Copies the children of a row that is moved to another parent and all their descendants. 
+   All children of a row are inserted first, so the new row can be expanded like the source row 
+   before the next level is copied. 
+   The element visibility of menus, pipe menus, items and separators is adjusted while they are copied.
 
-    gchar *element_visiblity_txt_ancestor_filter = check_if_invisible_ancestor_exists (filter_model, filter_path);
-    if (g_str_has_suffix (element_visibility_txt_parent, "unintegrated menu"))
-      new_element_visibility_txt = "invisible dsct. of invisible unintegrated menu";
-    else if (g_str_has_suffix (element_visibility_txt_parent, "invisible menu") || 
-	     (element_visiblity_txt_ancestor_filter && 
-	      g_str_has_suffix (element_visiblity_txt_ancestor_filter, "invisible menu"))) {
-      new_element_visibility_txt = "invisible dsct. of invisible menu";
+*/
+
+static void copy_children (GtkTreeIter *source_parent_iter, 
+			   GtkTreeIter *new_parent_iter, 
+			   const gchar *element_visibility_root_txt, 
+			   const gchar *element_visibility_ancestor_txt)
+{
+  G_GNUC_EXTENSION GValue values[NUMBER_OF_TS_ELEMENTS] = { [0 ... NUMBER_OF_TS_ELEMENTS - 1] = G_VALUE_INIT };
+  GtkTreePath *source_parent_path = gtk_tree_model_get_path (model, source_parent_iter);
+
+  GtkTreeIter source_iter_loop, new_iter_loop;
+  gchar *element_visibility_txt_loop;
+  gboolean valid;
+
+  valid = gtk_tree_model_iter_children (model, &source_iter_loop, source_parent_iter);
+  while (valid) {
+    get_row_values (&source_iter_loop, values);
+    if (element_visibility_root_txt && g_value_get_string (&values[TS_ELEMENT_VISIBILITY])) {
+      g_value_set_string (&values[TS_ELEMENT_VISIBILITY], 
+			  get_element_visibility_of_descendant (element_visibility_root_txt, 
+								element_visibility_ancestor_txt, 
+								g_value_get_string (&values[TS_MENU_ELEMENT]), 
+								g_value_get_string (&values[TS_TYPE])));
     }
-    else if (!element_visiblity_txt_ancestor_filter && !menu_element_txt_filter && !streq (type_txt_filter, "separator"))
-      new_element_visibility_txt = (streq (type_txt_filter, "menu")) ? "invisible menu" : "invisible item";
- 
-    gtk_tree_model_filter_convert_iter_to_child_iter (GTK_TREE_MODEL_FILTER (filter_model), &iter_model, filter_iter);
-    gtk_tree_store_set (treestore, &iter_model, TS_ELEMENT_VISIBILITY, new_element_visibility_txt, -1);
+    insert_row_values (&new_iter_loop, new_parent_iter, -1, values);
+    valid = gtk_tree_model_iter_next (model, &source_iter_loop);
+  }
+
+  // If the source row was a node that was expanded, expand the new row as well.
+  if (gtk_tree_view_row_expanded (GTK_TREE_VIEW (treeview), source_parent_path)) {
+    GtkTreePath *new_parent_path = gtk_tree_model_get_path (model, new_parent_iter);
+
+    gtk_tree_view_expand_row (GTK_TREE_VIEW (treeview), new_parent_path, FALSE);
 
     // Cleanup
-    g_free (menu_element_txt_filter);
-    g_free (type_txt_filter);
-    g_free (element_visibility_txt_filter);
+    gtk_tree_path_free (new_parent_path);
   }
 
-  return FALSE;
+  // Cleanup
+  gtk_tree_path_free (source_parent_path);
+
+  gtk_tree_model_iter_children (model, &source_iter_loop, source_parent_iter);
+  valid = gtk_tree_model_iter_children (model, &new_iter_loop, new_parent_iter);
+  while (valid) {
+    if (gtk_tree_model_iter_has_child (model, &source_iter_loop)) {
+      gtk_tree_model_get (model, &new_iter_loop, TS_ELEMENT_VISIBILITY, &element_visibility_txt_loop, -1);
+      copy_children (&source_iter_loop, &new_iter_loop, element_visibility_root_txt, 
+		     (element_visibility_txt_loop && g_str_has_prefix (element_visibility_txt_loop, "invisible")) ? 
+		     element_visibility_txt_loop : element_visibility_ancestor_txt);
+
+      // Cleanup
+      g_free (element_visibility_txt_loop);
+    }
+    gtk_tree_model_iter_next (model, &source_iter_loop);
+    valid = gtk_tree_model_iter_next (model, &new_iter_loop);
+  }
 }
 
 /* 
 
-   Creates a new row at destination and copies all subrows of the source row to it.
+   Moves the dragged rows to their destination.
+   Rows that stay inside the same parent are only relinked by the treestore, which emits a single 
+   "rows-reordered" signal and keeps the rows themselves, including their expansion status. 
+   Since a GtkTreeStore can't relink a row to another parent, rows that are moved to another parent are 
+   copied with all fields of a row set at once and then removed at their old position.
 
 */
 
@@ -318,32 +490,25 @@ void drag_data_received_handler (GtkWidget G_GNUC_UNUSED      *widget,
   GtkTreeViewDropPosition position;
   gboolean dropped_onto_row = FALSE; // Default
 
-  gboolean to_be_appended_at_toplevel = FALSE, to_be_appended_as_last_row = FALSE; // Defaults.
-  gint insertion_position = 0; // Initialised to avoid compiler warning since this variable might not be used.
+  gboolean to_be_appended = FALSE; // Default
+  // The dragged rows are inserted in front of this row, so they keep their order.
+  GtkTreeRowReference *next_row = NULL; // Default
 
   GSList *new_rows = NULL;
-  GtkTreePath *dest_path, *new_path;
-  GtkTreeModel *filter_model;
-  GtkTreeIter source_iter, *subrow_iters;
-  GtkTreeIter dest_iter, dest_parent_iter;
-  GtkTreeIter new_iter;
+  GtkTreePath *dest_path, *dest_parent_path, *new_path;
+  GtkTreeIter dest_iter, dest_parent_iter, *dest_parent = NULL; // Default for dest_parent: toplevel.
+  GtkTreeIter source_iter, source_parent_iter, next_iter, new_iter;
   gint dest_path_depth = 0; // Initialised to avoid compiler warning since this variable might not be used.
-  guint current_path_depth;
   gchar *menu_element_dest_parent_txt = NULL, *type_dest_parent_txt = NULL, *element_visibility_parent_txt = NULL;
   gchar *menu_element_new_row_txt, *type_new_row_txt;
   GtkTreeSelection *selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview));
 
-  GPtrArray *subrows[NUMBER_OF_SUBROW_ELEMENTS];
-
-  gpointer copied_ts_row_fields[NUMBER_OF_TS_ELEMENTS];
-  gchar *new_element_visibility_txt;
-
-  gpointer current_array;
+  G_GNUC_EXTENSION GValue values[NUMBER_OF_TS_ELEMENTS] = { [0 ... NUMBER_OF_TS_ELEMENTS - 1] = G_VALUE_INIT };
+  gchar *element_visibility_new_row_txt;
 
-  GtkTreePath *source_path_loop;
+  GtkTreePath *source_path_loop, *next_path_loop;
+  gboolean same_parent_loop;
   GSList *g_slist_loop;
-  guint subrows_len_cnt;
-  guint8 ts_cnt, elm_cnt, subrows_elm_cnt;
 
   gtk_tree_view_get_dest_row_at_pos (GTK_TREE_VIEW (treeview), x, y, &dest_path, &position);
   /* if the result is NULL, the function is not aborted, since the result indicates 
@@ -376,168 +541,138 @@ void drag_data_received_handler (GtkWidget G_GNUC_UNUSED      *widget,
 
   if (!dest_path) {
     dest_path_depth = 1;
-    to_be_appended_at_toplevel = TRUE;
+    to_be_appended = TRUE;
   }
-  else if (!dropped_onto_row) {
+  else if (dropped_onto_row)
+    to_be_appended = TRUE;
+  else {
     dest_path_depth = gtk_tree_path_get_depth (dest_path);
-    insertion_position = gtk_tree_path_get_indices (dest_path)[dest_path_depth - 1];
+    if (gtk_tree_model_get_iter (model, &dest_iter, dest_path))
+      next_row = gtk_tree_row_reference_new (model, dest_path);
+    else // Append as last row(s)
+      to_be_appended = TRUE;
   }
 
   if (dest_path_depth > 1) {
-    if (gtk_tree_model_get_iter (model, &dest_iter, dest_path))
-      gtk_tree_model_iter_parent (model, &dest_parent_iter, &dest_iter);
-    else { // Append as last row(s)
-      GtkTreePath *dest_parent_path = gtk_tree_path_copy (dest_path);
-
-      to_be_appended_as_last_row = TRUE;
-      gtk_tree_path_up (dest_parent_path);
-      gtk_tree_model_get_iter (model, &dest_parent_iter, dest_parent_path);
-
-      // Cleanup
-      gtk_tree_path_free (dest_parent_path);
-    }
+    dest_parent_path = gtk_tree_path_copy (dest_path);
+    gtk_tree_path_up (dest_parent_path);
+    gtk_tree_model_get_iter (model, &dest_parent_iter, dest_parent_path);
     gtk_tree_model_get (model, &dest_parent_iter, TS_MENU_ELEMENT, &menu_element_dest_parent_txt, -1);
+
+    // Cleanup
+    gtk_tree_path_free (dest_parent_path);
   }
 
   if (dest_path_depth > 1 || dropped_onto_row) {
+    dest_parent = &dest_parent_iter;
     gtk_tree_model_get (model, &dest_parent_iter, 
 			TS_TYPE, &type_dest_parent_txt, 
 			TS_ELEMENT_VISIBILITY, &element_visibility_parent_txt, 
 			-1);
   }
 
+  g_signal_handler_block (selection, handler_id_row_selected); // Deactivates unnecessary selection check.
+
   for (g_slist_loop = source_paths; g_slist_loop; g_slist_loop = g_slist_loop->next) {
     source_path_loop = gtk_tree_row_reference_get_path (g_slist_loop->data);
     gtk_tree_model_get_iter (model, &source_iter, source_path_loop);
+    /* (Note: Rows that have been moved to another parent are removed inside this loop, which shifts the paths 
+       of the following rows, so the parents are compared by their iters, which stay the same.) */
+    if (gtk_tree_model_iter_parent (model, &source_parent_iter, &source_iter))
+      same_parent_loop = (dest_parent && source_parent_iter.user_data == dest_parent->user_data);
+    else
+      same_parent_loop = !dest_parent;
+    next_path_loop = (next_row) ? gtk_tree_row_reference_get_path (next_row) : NULL;
+    if (next_path_loop)
+      gtk_tree_model_get_iter (model, &next_iter, next_path_loop);
 
 
-    // --- Create root row at destination. ---
-
-
-    // Retrieve source row.
-    for (ts_cnt = 0; ts_cnt < NUMBER_OF_TS_ELEMENTS; ts_cnt++)
-      gtk_tree_model_get (model, &source_iter, ts_cnt, &copied_ts_row_fields[ts_cnt], -1);
+    // --- Row stays inside the same parent: Relink it. ---
 
-    /* If a menu, pipe menu, item or separator is dragged into a menu, 
-       its element visibility is set according to the one of the latter. 
-       If dragged to toplevel, the element visiblity is adjusted as well. */
-    if (!type_dest_parent_txt || streq (type_dest_parent_txt, "menu")) {
-      new_element_visibility_txt = "visible"; // Default
 
-      if (!element_visibility_parent_txt || streq (element_visibility_parent_txt, "visible")) {
-	if (!element_visibility_parent_txt && 
-	    streq (copied_ts_row_fields[SUBROWS_ELEMENT_VISIBILITY], "invisible unintegrated menu")) {
-	  new_element_visibility_txt = "invisible unintegrated menu";
-	}
-	else if (!copied_ts_row_fields[SUBROWS_MENU_ELEMENT] && 
-		 !streq (copied_ts_row_fields[SUBROWS_TYPE], "separator")) {
-	  new_element_visibility_txt = ((streq (copied_ts_row_fields[SUBROWS_TYPE], "item") ? 
-					 "invisible item" : "invisible menu"));
+    if (same_parent_loop) {
+      // The row is already in front of the next row; the following rows are inserted behind it.
+      if (next_path_loop && gtk_tree_path_compare (source_path_loop, next_path_loop) == 0) {
+	gtk_tree_row_reference_free (next_row);
+	next_row = NULL;
+	if (gtk_tree_model_iter_next (model, &next_iter)) {
+	  gtk_tree_path_next (next_path_loop);
+	  next_row = gtk_tree_row_reference_new (model, next_path_loop);
 	}
+	else
+	  to_be_appended = TRUE;
       }
-      else if (g_str_has_suffix (element_visibility_parent_txt, "invisible menu"))
-	new_element_visibility_txt = "invisible dsct. of invisible menu";
       else
-	new_element_visibility_txt = "invisible dsct. of invisible unintegrated menu";
-
-      free_and_reassign (copied_ts_row_fields[SUBROWS_ELEMENT_VISIBILITY], g_strdup (new_element_visibility_txt));
-    }
+	gtk_tree_store_move_before (treestore, &source_iter, (to_be_appended) ? NULL : &next_iter);
 
-    // Add dragged source row at new position.
-    gtk_tree_store_insert (treestore, &new_iter, (dest_path_depth == 1) ? NULL : &dest_parent_iter, 
-			   (to_be_appended_at_toplevel || to_be_appended_as_last_row || dropped_onto_row) ? 
-			   -1 : insertion_position++);
-
-    for (ts_cnt = 0; ts_cnt < NUMBER_OF_TS_ELEMENTS; ts_cnt++) {
-      gtk_tree_store_set (treestore, &new_iter, ts_cnt, (ts_cnt != TS_ICON_IMG_STATUS) ? 
-			  copied_ts_row_fields[ts_cnt] : 
-			  (gpointer) GPOINTER_TO_UINT (copied_ts_row_fields[ts_cnt]), 
-			  -1);
+      new_rows = g_slist_prepend (new_rows, gtk_tree_row_reference_copy (g_slist_loop->data));
     }
 
-    // If at least one row was dropped onto another one, expand the latter if it had not already been expanded.
-    if (dropped_onto_row && !gtk_tree_view_row_expanded (GTK_TREE_VIEW (treeview), dest_path))
-      gtk_tree_view_expand_row (GTK_TREE_VIEW (treeview), dest_path, FALSE);
 
-    // Add path of new row as row reference to a list.
-    new_path = gtk_tree_model_get_path (model, &new_iter);
-    new_rows = g_slist_prepend (new_rows, gtk_tree_row_reference_new (model, new_path));
-    // new_path is still needed and thus not yet freed.
+    // --- Row is moved to another parent: Copy it and remove it at its old position. ---
 
 
-    // --- Add subrows, if exist. ---
+    else {
+      get_row_values (&source_iter, values);
 
+      /* If a menu, pipe menu, item or separator is dragged into a menu, 
+	 its element visibility is set according to the one of the latter. 
+	 If dragged to toplevel, the element visiblity is adjusted as well. */
+      if (!type_dest_parent_txt || streq (type_dest_parent_txt, "menu")) {
+	g_value_set_string (&values[TS_ELEMENT_VISIBILITY], 
+			    get_element_visibility_of_moved_row (element_visibility_parent_txt, 
+								 g_value_get_string (&values[TS_ELEMENT_VISIBILITY]), 
+								 g_value_get_string (&values[TS_MENU_ELEMENT]), 
+								 g_value_get_string (&values[TS_TYPE])));
+      }
 
-    // Reset source path, since it is no longer valid if a row has been moved from bottom to top.
-    gtk_tree_path_free (source_path_loop);
-    source_path_loop = gtk_tree_row_reference_get_path (g_slist_loop->data);
-    gtk_tree_model_get_iter (model, &source_iter, source_path_loop);
-    if (gtk_tree_model_iter_has_child (model, &source_iter)) {
-      for (subrows_elm_cnt = 0; subrows_elm_cnt < NUMBER_OF_SUBROW_ELEMENTS; subrows_elm_cnt++)
-	subrows[subrows_elm_cnt] = g_ptr_array_new ();
-      g_ptr_array_add (subrows[SUBROWS_MAX_PATH_DEPTH], GUINT_TO_POINTER (0));
-      g_ptr_array_add (subrows[SUBROWS_PARENT_VISIBILITY], "n/a");
-
-      filter_model = gtk_tree_model_filter_new (model, source_path_loop);
-      gtk_tree_model_foreach (filter_model, (GtkTreeModelForeachFunc) subrows_creation_auxiliary, &subrows);
-
-      // Copy all children of the source row to the new root row.
-      subrow_iters = 
-	g_malloc (GPOINTER_TO_UINT (g_ptr_array_index (subrows[SUBROWS_MAX_PATH_DEPTH], 0)) * sizeof (GtkTreeIter));
-
-      for (subrows_len_cnt = 0; 
-	   subrows_len_cnt < subrows[0]->len;
-	   subrows_len_cnt++) {
-	current_path_depth = GPOINTER_TO_UINT (g_ptr_array_index (subrows[SUBROWS_CURRENT_PATH_DEPTH], 
-								  subrows_len_cnt));
-	gtk_tree_store_append (treestore, &subrow_iters[current_path_depth - 1], 
-			       (current_path_depth == 1) ? &new_iter : &subrow_iters[current_path_depth - 2]);
-	
-	for (ts_cnt = 0; ts_cnt < NUMBER_OF_TS_ELEMENTS; ts_cnt++) {
-	  current_array = g_ptr_array_index (subrows[ts_cnt], subrows_len_cnt);
+      // Add dragged source row at new position.
+      insert_row_values (&new_iter, dest_parent, 
+			 (to_be_appended) ? -1 : 
+			 gtk_tree_path_get_indices (next_path_loop)[gtk_tree_path_get_depth (next_path_loop) - 1], 
+			 values);
 
-	  gtk_tree_store_set (treestore, &subrow_iters[current_path_depth - 1], ts_cnt, (ts_cnt != TS_ICON_IMG_STATUS) ? 
-			      current_array : (gpointer) GPOINTER_TO_UINT (current_array), -1);
+      // Add subrows, if exist.
+      if (gtk_tree_model_iter_has_child (model, &source_iter)) {
+	gtk_tree_model_get (model, &new_iter, TS_ELEMENT_VISIBILITY, &element_visibility_new_row_txt, -1);
+	copy_children (&source_iter, &new_iter, element_visibility_new_row_txt, NULL);
 
-	  // Cleanup
-	  if (ts_cnt == TS_ICON_IMG)
-	    unref_icon ((GdkPixbuf **) &current_array, FALSE);
-	  else if (ts_cnt > TS_ICON_IMG_STATUS)
-	    g_free (current_array);
-	}
+	// Cleanup
+	g_free (element_visibility_new_row_txt);
       }
 
-      // If the source row was a node that was expanded, expand the destination as well.
-      if (gtk_tree_view_row_expanded (GTK_TREE_VIEW (treeview), source_path_loop))
-	gtk_tree_view_expand_row (GTK_TREE_VIEW (treeview), new_path, FALSE);
-
-      // Set expansions status of all subrows, also element visibility for all menus, pipe menus, items and separators.
-      g_ptr_array_index (subrows[SUBROWS_PARENT_VISIBILITY], 0) = copied_ts_row_fields[TS_ELEMENT_VISIBILITY];
-      filter_model = gtk_tree_model_filter_new (model, new_path);
-      gtk_tree_model_foreach (filter_model, (GtkTreeModelForeachFunc) subrows_creation_auxiliary, &subrows);
+      // Add path of new row as row reference to a list.
+      new_path = gtk_tree_model_get_path (model, &new_iter);
+      new_rows = g_slist_prepend (new_rows, gtk_tree_row_reference_new (model, new_path));
 
       // Cleanup
       gtk_tree_path_free (new_path);
-      for (subrows_elm_cnt = 0; subrows_elm_cnt < NUMBER_OF_SUBROW_ELEMENTS; subrows_elm_cnt++)
-      	g_ptr_array_free (subrows[subrows_elm_cnt], TRUE);
-      g_free (subrow_iters);
+
+      // The source iter is still valid, since the rows of a treestore keep their iters until they are removed.
+      gtk_tree_store_remove (treestore, &source_iter);
     }
 
     // Cleanup
-    unref_icon ((GdkPixbuf **) &copied_ts_row_fields[TS_ICON_IMG], FALSE);
-    for (elm_cnt = TS_ICON_MODIFIED; elm_cnt < NUMBER_OF_TS_ELEMENTS; elm_cnt++)
-      g_free (copied_ts_row_fields[elm_cnt]);
     gtk_tree_path_free (source_path_loop);
+    gtk_tree_path_free (next_path_loop);
+  }
+
+  // If at least one row was dropped onto another one, expand the latter if it had not already been expanded.
+  if (dropped_onto_row) {
+    GtkTreePath *dest_parent_path_after_move = gtk_tree_model_get_path (model, &dest_parent_iter);
+
+    if (!gtk_tree_view_row_expanded (GTK_TREE_VIEW (treeview), dest_parent_path_after_move))
+      gtk_tree_view_expand_row (GTK_TREE_VIEW (treeview), dest_parent_path_after_move, FALSE);
+
+    // Cleanup
+    gtk_tree_path_free (dest_parent_path_after_move);
   }
 
   // Cleanup
   g_free (type_dest_parent_txt);
   g_free (element_visibility_parent_txt);
-
-  g_signal_handler_block (selection, handler_id_row_selected); // Deactivates unnecessary selection check.
-
-  // The source rows are still selected, so they may be deleted that simple.
-  remove_rows ("dnd");
+  if (next_row)
+    gtk_tree_row_reference_free (next_row);
 
   /* Select the new root row(s). If these rows are options or option blocks that have been moved elsewhere and 
      autosorting is activated, sort the options resp. option block. */
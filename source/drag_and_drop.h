@@ -19,7 +19,6 @@
 #ifndef __drag_and_drop_h
 #define __drag_and_drop_h
 
-#define free_and_reassign(string, new_value) { g_free (string); string = new_value; }
 #define streq(string1, string2) (g_strcmp0 ((string1), (string2)) == 0)
 
 extern GtkTreeStore *treestore;
@@ -34,14 +33,11 @@ extern gboolean autosort_options;
 extern gint handler_id_row_selected;
 
 extern void activate_change_done (void);
-extern gchar *check_if_invisible_ancestor_exists (GtkTreeModel *local_model, GtkTreePath *path);
-extern void remove_rows (gchar *origin);
 extern void row_selected (void);
 extern void show_msg_in_statusbar (gchar *message);
 extern void sort_execute_or_startupnotify_options_after_insertion (gchar *execute_or_startupnotify,
 								   GtkTreeSelection *selection,
 								   GtkTreeIter *parent, gchar *option);
 G_GNUC_NULL_TERMINATED extern gboolean streq_any (const gchar *string, ...);
-extern void unref_icon (GdkPixbuf **icon, gboolean set_to_NULL);
 
 #endif
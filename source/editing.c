@@ -18,6 +18,7 @@
 */
 
 #include <gtk/gtk.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "general_header_files/enum__columns.h"
@@ -30,21 +31,63 @@
 
 enum { FILTER_SELECTED_PATH, VISUALISE_RECURSIVELY, NUMBER_OF_FILTER_VISUALISATION_ELEMENTS };
 
+// Selected rows that share the same parent.
+struct sibling_group {
+  GtkTreeIter parent;
+  gboolean toplevel;
+  gint number_of_children;
+  gboolean *selected; // Indexed by the position of a child.
+};
+
+// Visualisation of the selected rows, processed row by row as an idle job.
+struct visualisation_job {
+  GList *selected_rows; // Row references of the selected rows that haven't been processed yet.
+  gpointer recursively_pointer;
+  GtkTreeModel *filter_model; // Has the toplevel ancestor of the currently processed selected row as its root.
+  GtkTreePath *filter_selected_path;
+  GtkTreeRowReference *next_row;
+};
+
+// Removal of icons, processed row by row as an idle job.
+struct icon_removal_job {
+  GList *rows; // Row references of the rows whose icon hasn't been removed yet.
+};
+
+// Child row of a menu whose children are sorted alphabetically.
+struct sort_entry {
+  const gchar *collation_key; // (Note: Owned by the collation keys of the sort; NULL if the row has no label.)
+  gint position;
+};
+
 void sort_execute_or_startupnotify_options_after_insertion (gchar *execute_or_startupnotify,
 							    GtkTreeSelection *selection,
 							    GtkTreeIter *parent, gchar *option);
-static void sort_execute_or_startupnotify_options (GtkTreeIter *parent_iter, gchar *execute_or_startupnotify);
+static void sort_execute_or_startupnotify_options (GtkTreeStore *local_treestore, GtkTreeIter *parent_iter, 
+						   gchar *execute_or_startupnotify);
 gboolean sort_loop_after_sorting_activation (GtkTreeModel *local_model, GtkTreePath G_GNUC_UNUSED *local_path,
 					     GtkTreeIter *local_iter);
-void key_pressed (GtkWidget G_GNUC_UNUSED *widget, GdkEventKey *event);
+gboolean key_pressed (GtkWidget G_GNUC_UNUSED *widget, GdkEventKey *event);
+static void free_sibling_group (struct sibling_group *sibling_group);
+static gboolean reorder_sibling_group (struct sibling_group *sibling_group, guint8 direction);
 void move_selection (gpointer direction_pointer);
+static GList *get_references_of_selected_rows (void);
+static const gchar *get_collation_key (GHashTable *collation_keys, const gchar *label);
+static gint compare_sort_entries (const struct sort_entry *entry_a, const struct sort_entry *entry_b);
+static gboolean sort_children_of_menu (GtkTreeIter *parent_iter, GHashTable *collation_keys, gboolean recursively);
+gboolean children_of_selection_can_be_sorted (void);
+void sort_children (gpointer recursively_pointer);
 static gboolean check_and_adjust_dependent_element_visibilities (GtkTreeModel *filter_model, GtkTreePath *filter_path, 
 								 GtkTreeIter *filter_iter, gchar **filter_visualisation);
+static void stop_visualisation_of_subtree (struct visualisation_job *job);
+static gboolean visualise_next_row (struct visualisation_job *job);
+static void visualisation_job_finished (struct visualisation_job *job, gpointer G_GNUC_UNUSED cancelled_pointer);
 void visualise_menus_items_and_separators (gpointer recursively_pointer);
 static gboolean image_type_filter (const GtkFileFilterInfo *filter_info);
 gchar *choose_icon (void);
 void icon_choosing_by_button_or_context_menu (void);
 gboolean set_icon (gchar *icon_path, GtkTreeIter *icon_iter, gboolean automated);
+static gboolean remove_icon_of_next_row (struct icon_removal_job *job);
+static void icon_removal_job_finished (struct icon_removal_job *job, gpointer G_GNUC_UNUSED cancelled_pointer);
 void remove_icons_from_menus_or_items (void);
 void change_row (void);
 void cell_edited (GtkCellRendererText G_GNUC_UNUSED *renderer, gchar *path, 
@@ -67,7 +110,7 @@ void sort_execute_or_startupnotify_options_after_insertion (gchar            *ex
 
   gchar *menu_element_txt_loop;
 
-  sort_execute_or_startupnotify_options (parent, execute_or_startupnotify);
+  sort_execute_or_startupnotify_options (treestore, parent, execute_or_startupnotify);
   for (gint ch_cnt = 0; ch_cnt < gtk_tree_model_iter_n_children (model, parent); ch_cnt++) {
     gtk_tree_model_iter_nth_child (model, &sub_iter, parent, ch_cnt);
     gtk_tree_model_get (model, &sub_iter, TS_MENU_ELEMENT, &menu_element_txt_loop, -1);
@@ -87,49 +130,67 @@ void sort_execute_or_startupnotify_options_after_insertion (gchar            *ex
    Sorts Execute or startupnotify options according to the order
    Execute: 1. prompt, 2. command, 3. startupnotify.
    startupnotify: 1. enabled, 2. name, 3. wmclass, 4. icon.
+   The new order is computed from the ranks of the children and applied at once; 
+   options that are already sorted are left untouched.
 
 */
 
-static void sort_execute_or_startupnotify_options (GtkTreeIter *parent_iter, 
-						   gchar       *execute_or_startupnotify)
+static void sort_execute_or_startupnotify_options (GtkTreeStore *local_treestore, 
+						   GtkTreeIter  *parent_iter, 
+						   gchar        *execute_or_startupnotify)
 {
+  GtkTreeModel *local_model = GTK_TREE_MODEL (local_treestore);
   gboolean execute = (streq (execute_or_startupnotify, "Execute"));
-  const guint number_of_options = (execute) ? NUMBER_OF_EXECUTE_OPTS : NUMBER_OF_STARTUPNOTIFY_OPTS;
-  GtkTreeIter child1_iter, child2_iter;
-  gchar *menu_element_txt_child1_loop, *menu_element_txt_child2_loop;
-
-  gint ch_cnt, foll_ch_cnt; // children counter, following children counter
-  guint8 opt_cnt;
-
-  for (ch_cnt = 0; ch_cnt < gtk_tree_model_iter_n_children (model, parent_iter) - 1; ch_cnt++) {
-    gtk_tree_model_iter_nth_child (model, &child1_iter, parent_iter, ch_cnt);
-    gtk_tree_model_get (model, &child1_iter, TS_MENU_ELEMENT, &menu_element_txt_child1_loop, -1);
-    for (opt_cnt = 0; opt_cnt < number_of_options; opt_cnt++) {
-      if (streq (menu_element_txt_child1_loop, 
-      		 (execute) ? execute_options[opt_cnt] : startupnotify_options[opt_cnt]))
+  const guint8 number_of_options = (execute) ? NUMBER_OF_EXECUTE_OPTS : NUMBER_OF_STARTUPNOTIFY_OPTS;
+  gchar **options = (execute) ? execute_options : startupnotify_options;
+  const gint number_of_children = gtk_tree_model_iter_n_children (local_model, parent_iter);
+
+  if (number_of_children < 2)
+    return;
+
+  // Rank of every child inside the sort order; unknown elements are placed behind all options.
+  guint8 *ranks = g_new (guint8, number_of_children);
+  gboolean already_sorted = TRUE; // Default
+  GtkTreeIter child_iter;
+
+  gchar *menu_element_txt_loop;
+  gint ch_cnt; // children counter
+  gint new_position = 0;
+  guint8 rank_cnt;
+
+  gtk_tree_model_iter_children (local_model, &child_iter, parent_iter);
+  for (ch_cnt = 0; ch_cnt < number_of_children; ch_cnt++) {
+    gtk_tree_model_get (local_model, &child_iter, TS_MENU_ELEMENT, &menu_element_txt_loop, -1);
+    for (ranks[ch_cnt] = 0; ranks[ch_cnt] < number_of_options; ranks[ch_cnt]++) {
+      if (streq (menu_element_txt_loop, options[ranks[ch_cnt]]))
 	break;
-      else {
-	for (foll_ch_cnt = ch_cnt + 1; 
-	     foll_ch_cnt < gtk_tree_model_iter_n_children (model, parent_iter); 
-	     foll_ch_cnt++) {
-	  gtk_tree_model_iter_nth_child (model, &child2_iter, parent_iter, foll_ch_cnt);
-	  gtk_tree_model_get (model, &child2_iter, TS_MENU_ELEMENT, &menu_element_txt_child2_loop, -1);
-	  if (streq (menu_element_txt_child2_loop, 
-		     (execute) ? execute_options[opt_cnt] : startupnotify_options[opt_cnt])) {
-	    gtk_tree_store_swap (treestore, &child1_iter, &child2_iter);
-	    // Cleanup
-	    g_free (menu_element_txt_child2_loop);
-	    goto next_child; // Break out of nested loop.
-	  }
-	  // Cleanup
-	  g_free (menu_element_txt_child2_loop);
-	}
+    }
+    if (ch_cnt > 0 && ranks[ch_cnt] < ranks[ch_cnt - 1])
+      already_sorted = FALSE;
+    gtk_tree_model_iter_next (local_model, &child_iter);
+
+    // Cleanup
+    g_free (menu_element_txt_loop);
+  }
+
+  if (!already_sorted) {
+    // (Note: new_order[new position] = old position, as expected by gtk_tree_store_reorder.)
+    gint *new_order = g_new (gint, number_of_children);
+
+    for (rank_cnt = 0; rank_cnt <= number_of_options; rank_cnt++) {
+      for (ch_cnt = 0; ch_cnt < number_of_children; ch_cnt++) {
+	if (ranks[ch_cnt] == rank_cnt)
+	  new_order[new_position++] = ch_cnt;
       }
     }
-  next_child:
+    gtk_tree_store_reorder (local_treestore, parent_iter, new_order);
+
     // Cleanup
-    g_free (menu_element_txt_child1_loop);
+    g_free (new_order);
   }
+
+  // Cleanup
+  g_free (ranks);
 }
 
 /* 
@@ -156,7 +217,7 @@ gboolean sort_loop_after_sorting_activation (GtkTreeModel              *local_mo
 
   if ((streq (type_txt_loop, "action") && streq (menu_element_txt_loop, "Execute")) || 
        streq (type_txt_loop, "option block"))
-    sort_execute_or_startupnotify_options (local_iter, menu_element_txt_loop);
+    sort_execute_or_startupnotify_options (GTK_TREE_STORE (local_model), local_iter, menu_element_txt_loop);
 
   // Cleanup
   g_free (menu_element_txt_loop);
@@ -167,46 +228,411 @@ gboolean sort_loop_after_sorting_activation (GtkTreeModel              *local_mo
 
 /* 
 
-   Function that deals with key press events, currently only used for "Delete" key.
+   Function that deals with key press events. "Delete" removes the selected rows, 
+   typing a character opens the quick jump palette (instead of the interactive search of the treeview). 
+   The keys the treeview uses to expand and collapse rows are passed on to it. 
+   Returns TRUE if the key press has been handled here.
 
 */
 
-void key_pressed (GtkWidget G_GNUC_UNUSED *widget, GdkEventKey *event)
+gboolean key_pressed (GtkWidget G_GNUC_UNUSED *widget, GdkEventKey *event)
 {
   GtkTreeSelection *selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview));
-  if (gtk_tree_selection_count_selected_rows (selection) > 0 && event->keyval == GDK_KEY_Delete)
+  gunichar typed_char = gdk_keyval_to_unicode (event->keyval);
+
+  if (gtk_tree_selection_count_selected_rows (selection) > 0 && event->keyval == GDK_KEY_Delete) {
     remove_rows ("delete key");
+
+    return TRUE;
+  }
+
+  // "+", "-", "*" and "/" (also on the keypad) are key bindings of the treeview for expanding and collapsing rows.
+  if (g_unichar_isgraph (typed_char) && !(event->state & (GDK_CONTROL_MASK | GDK_MOD1_MASK)) && 
+      !(typed_char < 128 && strchr ("+-*/", (gchar) typed_char))) {
+    gchar typed_txt[7] = { 0 }; // (Note: An UTF-8 character has at most six bytes.)
+
+    g_unichar_to_utf8 (typed_char, typed_txt);
+    show_quick_jump_palette (typed_txt);
+
+    return TRUE;
+  }
+
+  return FALSE;
 }
 
 /* 
 
-   Moves selection up or down, to the top or the bottom.
+   Frees a group of selected siblings.
 
 */
 
-void move_selection (gpointer direction_pointer)
+static void free_sibling_group (struct sibling_group *sibling_group)
 {
-  guint8 direction = GPOINTER_TO_UINT (direction_pointer);
-  GtkTreeIter iter_new_pos = iter;
+  g_free (sibling_group->selected);
+  g_free (sibling_group);
+}
+
+/* 
+
+   Computes the new order of the children of a parent after moving its selected children and applies it.
+   Selected rows that are already at the top or bottom keep their position, 
+   all others are moved as blocks, keeping their relative order.
+   Returns if the order has been changed.
+
+*/
+
+static gboolean reorder_sibling_group (struct sibling_group *sibling_group, 
+				       guint8                direction)
+{
+  const gint number_of_children = sibling_group->number_of_children;
+  gboolean *selected = sibling_group->selected;
+  // (Note: new_order[new position] = old position, as expected by gtk_tree_store_reorder.)
+  gint *new_order = g_new (gint, number_of_children);
+  gboolean order_changed = FALSE;
+
+  gint new_position = 0, swapped_position;
+  gint positions_cnt;
 
   switch (direction) {
   case UP:
   case DOWN:
-    if (direction == UP)
-      gtk_tree_model_iter_previous (model, &iter_new_pos);
-    else
-      gtk_tree_model_iter_next (model, &iter_new_pos);
-    gtk_tree_store_swap (GTK_TREE_STORE (model), &iter, &iter_new_pos);
+    for (positions_cnt = 0; positions_cnt < number_of_children; positions_cnt++)
+      new_order[positions_cnt] = positions_cnt;
+    /* A selected row is swapped with its unselected neighbour. The flags move along with the rows, 
+       so consecutive selected rows move as one block. */
+    for (positions_cnt = (direction == UP) ? 1 : number_of_children - 2; 
+	 (direction == UP) ? positions_cnt < number_of_children : positions_cnt >= 0; 
+	 positions_cnt += (direction == UP) ? 1 : -1) {
+      swapped_position = (direction == UP) ? positions_cnt - 1 : positions_cnt + 1;
+      if (selected[positions_cnt] && !selected[swapped_position]) {
+	new_order[positions_cnt] = new_order[swapped_position];
+	new_order[swapped_position] = positions_cnt;
+	selected[swapped_position] = TRUE;
+	selected[positions_cnt] = FALSE;
+	order_changed = TRUE;
+      }
+    }
     break;
   case TOP:
-    gtk_tree_store_move_after (treestore, &iter, NULL);
-    break;
   case BOTTOM:
-    gtk_tree_store_move_before (treestore, &iter, NULL);
+    // First the rows that end up at the top, then the remaining ones, both in their previous order.
+    for (positions_cnt = 0; positions_cnt < number_of_children; positions_cnt++) {
+      if (selected[positions_cnt] == (direction == TOP))
+	new_order[new_position++] = positions_cnt;
+    }
+    for (positions_cnt = 0; positions_cnt < number_of_children; positions_cnt++) {
+      if (selected[positions_cnt] != (direction == TOP))
+	new_order[new_position++] = positions_cnt;
+    }
+    for (positions_cnt = 0; positions_cnt < number_of_children && !order_changed; positions_cnt++)
+      order_changed = (new_order[positions_cnt] != positions_cnt);
   }
 
-  row_selected ();
-  activate_change_done ();
+  if (order_changed)
+    gtk_tree_store_reorder (treestore, (sibling_group->toplevel) ? NULL : &sibling_group->parent, new_order);
+
+  // Cleanup
+  g_free (new_order);
+
+  return order_changed;
+}
+
+/* 
+
+   Moves the selected rows up or down, to the top or the bottom.
+   The selected rows are grouped by their parents, and the children of each parent are 
+   reordered in one go, so moving many rows doesn't cause a signal emission for every single step.
+
+*/
+
+void move_selection (gpointer direction_pointer)
+{
+  guint8 direction = GPOINTER_TO_UINT (direction_pointer);
+  GtkTreeSelection *selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview));
+  GList *selected_rows = gtk_tree_selection_get_selected_rows (selection, &model);
+  GHashTable *sibling_groups = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, 
+						      (GDestroyNotify) free_sibling_group);
+  GHashTableIter sibling_groups_iter;
+  struct sibling_group *sibling_group;
+  gboolean rows_moved = FALSE;
+
+  GList *selected_rows_loop;
+  GtkTreePath *path_loop, *parent_path_loop;
+  gchar *parent_path_str_loop;
+  gint depth_loop;
+
+  // Collect the positions of the selected rows per parent.
+  for (selected_rows_loop = selected_rows; selected_rows_loop; selected_rows_loop = selected_rows_loop->next) {
+    path_loop = selected_rows_loop->data;
+    depth_loop = gtk_tree_path_get_depth (path_loop);
+    parent_path_loop = gtk_tree_path_copy (path_loop);
+    gtk_tree_path_up (parent_path_loop);
+    parent_path_str_loop = (depth_loop == 1) ? g_strdup ("") : gtk_tree_path_to_string (parent_path_loop);
+
+    if (!(sibling_group = g_hash_table_lookup (sibling_groups, parent_path_str_loop))) {
+      sibling_group = g_new0 (struct sibling_group, 1);
+      sibling_group->toplevel = (depth_loop == 1);
+      if (!sibling_group->toplevel)
+	gtk_tree_model_get_iter (model, &sibling_group->parent, parent_path_loop);
+      sibling_group->number_of_children = gtk_tree_model_iter_n_children (model, (sibling_group->toplevel) ? 
+									   NULL : &sibling_group->parent);
+      sibling_group->selected = g_new0 (gboolean, sibling_group->number_of_children);
+      g_hash_table_insert (sibling_groups, parent_path_str_loop, sibling_group);
+    }
+    else
+      g_free (parent_path_str_loop);
+    sibling_group->selected[gtk_tree_path_get_indices (path_loop)[depth_loop - 1]] = TRUE;
+
+    // Cleanup
+    gtk_tree_path_free (parent_path_loop);
+  }
+
+  /* (Note: Iterators of a treestore stay valid if rows are reordered, so the parents that have been 
+     retrieved above can still be used after their ancestors have been reordered.) */
+  g_hash_table_iter_init (&sibling_groups_iter, sibling_groups);
+  while (g_hash_table_iter_next (&sibling_groups_iter, NULL, (gpointer *) &sibling_group)) {
+    if (reorder_sibling_group (sibling_group, direction))
+      rows_moved = TRUE;
+  }
+
+  // Cleanup
+  g_list_free_full (selected_rows, (GDestroyNotify) gtk_tree_path_free);
+  g_hash_table_destroy (sibling_groups);
+
+  if (rows_moved) {
+    row_selected ();
+    activate_change_done ();
+  }
+}
+
+/* 
+
+   Returns row references of the selected rows, so they can still be found if the tree is changed 
+   while they are processed by an idle job. 
+
+*/
+
+static GList *get_references_of_selected_rows (void)
+{
+  GtkTreeSelection *selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview));
+  GList *selected_rows = gtk_tree_selection_get_selected_rows (selection, &model);
+  GList *g_list_loop;
+
+  for (g_list_loop = selected_rows; g_list_loop; g_list_loop = g_list_loop->next) {
+    GtkTreePath *path_loop = g_list_loop->data;
+
+    g_list_loop->data = gtk_tree_row_reference_new (model, path_loop);
+
+    // Cleanup
+    gtk_tree_path_free (path_loop);
+  }
+
+  return selected_rows;
+}
+
+/* 
+
+   Returns the collation key of a label, which is only created if it hasn't already been created during this sort. 
+
+*/
+
+static const gchar *get_collation_key (GHashTable  *collation_keys, 
+				       const gchar *label)
+{
+  gchar *collation_key;
+
+  if ((collation_key = g_hash_table_lookup (collation_keys, label)))
+    return collation_key;
+
+  collation_key = g_utf8_collate_key (label, -1);
+  g_hash_table_insert (collation_keys, g_strdup (label), collation_key);
+
+  return collation_key;
+}
+
+/* 
+
+   Sorts rows by their label according to the current locale; rows without a label are moved behind the others. 
+   Rows with equal labels keep their order. 
+
+*/
+
+static gint compare_sort_entries (const struct sort_entry *entry_a, 
+				  const struct sort_entry *entry_b)
+{
+  gint result;
+
+  if (entry_a->collation_key && entry_b->collation_key)
+    result = strcmp (entry_a->collation_key, entry_b->collation_key);
+  else
+    result = (entry_b->collation_key != NULL) - (entry_a->collation_key != NULL);
+
+  return (result) ? result : entry_a->position - entry_b->position;
+}
+
+/* 
+
+   Sorts the children of a menu alphabetically by their label. 
+   Separators stay where they are, so the rows between two separators are sorted as a group of their own. 
+   If recursively is TRUE, the children of the submenus are sorted as well. 
+   Returns TRUE if the order of any rows has been changed. 
+
+*/
+
+static gboolean sort_children_of_menu (GtkTreeIter *parent_iter, 
+				       GHashTable  *collation_keys, 
+				       gboolean     recursively)
+{
+  gint number_of_children = gtk_tree_model_iter_n_children (model, parent_iter);
+  struct sort_entry *sort_entries = g_new (struct sort_entry, number_of_children);
+  gint *new_order = g_new (gint, number_of_children);
+  gint group_start = 0;
+  gboolean reordering_necessary = FALSE;
+  gboolean order_changed = FALSE; // Of this menu or one of its submenus.
+
+  GtkTreeIter iter_loop;
+  gchar *menu_element_txt_loop, *type_txt_loop;
+  gint children_cnt;
+
+  gtk_tree_model_iter_children (model, &iter_loop, parent_iter);
+  for (children_cnt = 0; children_cnt < number_of_children; children_cnt++) {
+    gtk_tree_model_get (model, &iter_loop, 
+			TS_MENU_ELEMENT, &menu_element_txt_loop, 
+			TS_TYPE, &type_txt_loop, 
+			-1);
+
+    sort_entries[children_cnt].position = children_cnt;
+    sort_entries[children_cnt].collation_key = (menu_element_txt_loop && !streq (type_txt_loop, "separator")) ? 
+      get_collation_key (collation_keys, menu_element_txt_loop) : NULL;
+
+    if (streq (type_txt_loop, "separator")) {
+      qsort (sort_entries + group_start, children_cnt - group_start, sizeof (struct sort_entry), 
+	     (gint (*) (const void *, const void *)) compare_sort_entries);
+      group_start = children_cnt + 1;
+    }
+    else if (recursively && streq (type_txt_loop, "menu") && gtk_tree_model_iter_has_child (model, &iter_loop))
+      // (Note: The iters of a tree store stay valid if their parent's children are reordered.)
+      order_changed |= sort_children_of_menu (&iter_loop, collation_keys, TRUE);
+
+    // Cleanup
+    g_free (menu_element_txt_loop);
+    g_free (type_txt_loop);
+
+    gtk_tree_model_iter_next (model, &iter_loop);
+  }
+  qsort (sort_entries + group_start, number_of_children - group_start, sizeof (struct sort_entry), 
+	 (gint (*) (const void *, const void *)) compare_sort_entries);
+
+  for (children_cnt = 0; children_cnt < number_of_children; children_cnt++) {
+    new_order[children_cnt] = sort_entries[children_cnt].position;
+    if (new_order[children_cnt] != children_cnt)
+      reordering_necessary = TRUE;
+  }
+
+  // A reordering is only done if necessary, since it creates an entry in the journal and redraws the rows.
+  if (reordering_necessary) {
+    gtk_tree_store_reorder (treestore, parent_iter, new_order);
+    order_changed = TRUE;
+  }
+
+  // Cleanup
+  g_free (sort_entries);
+  g_free (new_order);
+
+  return order_changed;
+}
+
+/* 
+
+   Checks if at least one of the selected rows is a menu with children. 
+
+*/
+
+gboolean children_of_selection_can_be_sorted (void)
+{
+  GtkTreeSelection *selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview));
+  GList *selected_rows = gtk_tree_selection_get_selected_rows (selection, &model);
+  gboolean menu_with_children_selected = FALSE;
+
+  GList *g_list_loop;
+  GtkTreeIter iter_loop;
+  gchar *type_txt_loop;
+
+  for (g_list_loop = selected_rows; g_list_loop && !menu_with_children_selected; g_list_loop = g_list_loop->next) {
+    gtk_tree_model_get_iter (model, &iter_loop, g_list_loop->data);
+    gtk_tree_model_get (model, &iter_loop, TS_TYPE, &type_txt_loop, -1);
+    menu_with_children_selected = (streq (type_txt_loop, "menu") && gtk_tree_model_iter_has_child (model, &iter_loop));
+
+    // Cleanup
+    g_free (type_txt_loop);
+  }
+
+  // Cleanup
+  g_list_free_full (selected_rows, (GDestroyNotify) gtk_tree_path_free);
+
+  return menu_with_children_selected;
+}
+
+/* 
+
+   Sorts the children of the selected menus alphabetically, 
+   if chosen also the children of all menus inside them. 
+
+*/
+
+void sort_children (gpointer recursively_pointer)
+{
+  gboolean recursively = GPOINTER_TO_UINT (recursively_pointer);
+
+  // (Note: Paths of selected rows inside a sorted menu would point to other rows afterwards.)
+  GList *selected_rows = get_references_of_selected_rows ();
+  GtkTreePath *last_sorted_path = NULL;
+  // Key: label, value: its collation key. Only kept during this sort, so labels that occur repeatedly get one key.
+  GHashTable *collation_keys = g_hash_table_new_full ((GHashFunc) g_str_hash, (GEqualFunc) g_str_equal, 
+						      (GDestroyNotify) g_free, (GDestroyNotify) g_free);
+  gboolean order_changed = FALSE;
+
+  GList *g_list_loop;
+  GtkTreePath *path_loop;
+  GtkTreeIter iter_loop;
+  gchar *type_txt_loop;
+
+  for (g_list_loop = selected_rows; g_list_loop; g_list_loop = g_list_loop->next) {
+    path_loop = gtk_tree_row_reference_get_path (g_list_loop->data);
+    /* A selected submenu of a menu whose children have already been sorted recursively is skipped. 
+       (Note: The selected rows are sorted in tree order and sorting doesn't move rows to another menu.) */
+    if (recursively && last_sorted_path && gtk_tree_path_is_descendant (path_loop, last_sorted_path)) {
+      // Cleanup
+      gtk_tree_path_free (path_loop);
+
+      continue;
+    }
+
+    gtk_tree_model_get_iter (model, &iter_loop, path_loop);
+    gtk_tree_model_get (model, &iter_loop, TS_TYPE, &type_txt_loop, -1);
+    if (streq (type_txt_loop, "menu") && gtk_tree_model_iter_has_child (model, &iter_loop)) {
+      order_changed |= sort_children_of_menu (&iter_loop, collation_keys, recursively);
+      gtk_tree_path_free (last_sorted_path);
+      last_sorted_path = path_loop;
+    }
+    else
+      gtk_tree_path_free (path_loop);
+
+    // Cleanup
+    g_free (type_txt_loop);
+  }
+
+  // Cleanup
+  gtk_tree_path_free (last_sorted_path);
+  g_hash_table_destroy (collation_keys);
+  g_list_free_full (selected_rows, (GDestroyNotify) gtk_tree_row_reference_free);
+
+  if (order_changed) {
+    row_selected ();
+    activate_change_done ();
+  }
+  else
+    show_msg_in_statusbar ("The children are already sorted.");
 }
 
 /* 
@@ -283,48 +709,139 @@ static gboolean check_and_adjust_dependent_element_visibilities (GtkTreeModel *f
 
 /* 
 
-   Changes the status of one or more menus, pipe menus, items and separators to visible.
+   Releases the filter model of the currently processed subtree of a visualisation job. 
 
 */
 
-void visualise_menus_items_and_separators (gpointer recursively_pointer)
+static void stop_visualisation_of_subtree (struct visualisation_job *job)
 {
-  GtkTreeSelection *selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview));
-  GList *selected_rows = gtk_tree_selection_get_selected_rows (selection, &model);
+  if (job->filter_model) {
+    g_object_unref (job->filter_model);
+    job->filter_model = NULL;
+  }
+  gtk_tree_path_free (job->filter_selected_path); // (Note: NULL if the selected row is on toplevel.)
+  job->filter_selected_path = NULL;
+  if (job->next_row) {
+    gtk_tree_row_reference_free (job->next_row);
+    job->next_row = NULL;
+  }
+}
 
-  GtkTreeIter iter_toplevel;
-  GtkTreePath *path_toplevel;
-  GtkTreeModel *filter_model;
-  gpointer filter_visualisation[NUMBER_OF_FILTER_VISUALISATION_ELEMENTS];
+/* 
 
-  GList *g_list_loop;
-  gchar *menu_element_txt_loop;
+   Processes the next step of a visualisation job: 
+   either the toplevel ancestor of the next selected row is made visible 
+   or the visibility of the next row inside its subtree is adjusted. 
 
-  for (g_list_loop = selected_rows; g_list_loop; g_list_loop = g_list_loop->next) {
-    get_toplevel_iter_from_path (&iter_toplevel, g_list_loop->data);
+*/
+
+static gboolean visualise_next_row (struct visualisation_job *job)
+{
+  GtkTreePath *path;
+  GtkTreeIter iter_loop, filter_iter;
+
+  if (!job->filter_model) {
+    GtkTreeRowReference *selected_row = job->selected_rows->data;
+    GtkTreePath *selected_path = gtk_tree_row_reference_get_path (selected_row);
+    GtkTreeIter iter_toplevel;
+    GtkTreePath *path_toplevel;
+    gchar *menu_element_txt;
+
+    job->selected_rows = g_list_delete_link (job->selected_rows, job->selected_rows);
+
+    // Cleanup
+    gtk_tree_row_reference_free (selected_row);
+
+    if (!selected_path) // Row has been removed in the meantime.
+      return (job->selected_rows != NULL);
+
+    get_toplevel_iter_from_path (&iter_toplevel, selected_path);
     gtk_tree_store_set (treestore, &iter_toplevel, TS_ELEMENT_VISIBILITY, "visible", -1);
-    gtk_tree_model_get (model, &iter_toplevel, TS_MENU_ELEMENT, &menu_element_txt_loop, -1);
-    if (!menu_element_txt_loop)
+    gtk_tree_model_get (model, &iter_toplevel, TS_MENU_ELEMENT, &menu_element_txt, -1);
+    if (!menu_element_txt)
       gtk_tree_store_set (treestore, &iter_toplevel, TS_MENU_ELEMENT, "(Newly created label)",  -1);
 
     path_toplevel = gtk_tree_model_get_path (model, &iter_toplevel);
-    filter_model = gtk_tree_model_filter_new (model, path_toplevel);
+    job->filter_model = gtk_tree_model_filter_new (model, path_toplevel);
+    job->filter_selected_path = 
+      gtk_tree_model_filter_convert_child_path_to_path ((GtkTreeModelFilter *) job->filter_model, selected_path);
 
-    filter_visualisation[FILTER_SELECTED_PATH] = (gpointer) 
-      gtk_tree_model_filter_convert_child_path_to_path ((GtkTreeModelFilter *) filter_model, g_list_loop->data);
-    filter_visualisation[VISUALISE_RECURSIVELY] = recursively_pointer;
+    if (gtk_tree_model_iter_children (model, &iter_loop, &iter_toplevel)) {
+      path = gtk_tree_model_get_path (model, &iter_loop);
+      job->next_row = gtk_tree_row_reference_new (model, path);
 
-    gtk_tree_model_foreach (filter_model, (GtkTreeModelForeachFunc) check_and_adjust_dependent_element_visibilities, 
-			    &filter_visualisation);
+      // Cleanup
+      gtk_tree_path_free (path);
+    }
+    else
+      stop_visualisation_of_subtree (job);
 
     // Cleanup
-    g_free (menu_element_txt_loop);
+    g_free (menu_element_txt);
+    gtk_tree_path_free (selected_path);
     gtk_tree_path_free (path_toplevel);
-    gtk_tree_path_free ((GtkTreePath *) filter_visualisation[FILTER_SELECTED_PATH]);
+
+    return (job->filter_model || job->selected_rows);
   }
 
+  /* The subtree is left if the next row has been removed or moved out of it in the meantime; 
+     the latter is the case if it can't be converted to a row of the filter model. */
+  if (!(path = gtk_tree_row_reference_get_path (job->next_row))) {
+    stop_visualisation_of_subtree (job);
+
+    return (job->selected_rows != NULL);
+  }
+  gtk_tree_model_get_iter (model, &iter_loop, path);
+
   // Cleanup
-  g_list_free_full (selected_rows, (GDestroyNotify) gtk_tree_path_free);
+  gtk_tree_path_free (path);
+
+  if (!gtk_tree_model_filter_convert_child_iter_to_iter ((GtkTreeModelFilter *) job->filter_model, 
+							 &filter_iter, &iter_loop)) {
+    stop_visualisation_of_subtree (job);
+
+    return (job->selected_rows != NULL);
+  }
+
+  GtkTreePath *filter_path = gtk_tree_model_get_path (job->filter_model, &filter_iter);
+  gpointer filter_visualisation[NUMBER_OF_FILTER_VISUALISATION_ELEMENTS];
+
+  filter_visualisation[FILTER_SELECTED_PATH] = (gpointer) job->filter_selected_path;
+  filter_visualisation[VISUALISE_RECURSIVELY] = job->recursively_pointer;
+
+  check_and_adjust_dependent_element_visibilities (job->filter_model, filter_path, &filter_iter, 
+						   (gchar **) filter_visualisation);
+
+  // Cleanup
+  gtk_tree_path_free (filter_path);
+  gtk_tree_row_reference_free (job->next_row);
+  job->next_row = NULL;
+
+  if (get_next_row_in_preorder (model, &iter_loop, 0, TRUE)) {
+    path = gtk_tree_model_get_path (model, &iter_loop);
+    job->next_row = gtk_tree_row_reference_new (model, path);
+
+    // Cleanup
+    gtk_tree_path_free (path);
+  }
+  else
+    stop_visualisation_of_subtree (job);
+
+  return (job->filter_model || job->selected_rows);
+}
+
+/* 
+
+   Releases the data of a visualisation job and updates the display of the selected row. 
+
+*/
+
+static void visualisation_job_finished (struct visualisation_job               *job, 
+					gpointer                 G_GNUC_UNUSED  cancelled_pointer)
+{
+  stop_visualisation_of_subtree (job);
+  g_list_free_full (job->selected_rows, (GDestroyNotify) gtk_tree_row_reference_free);
+  g_free (job);
 
   /* If just the txt_fields array would be repopulated, 
      the menu bar sensivity for visualisation wouldn't be updated. */
@@ -332,6 +849,45 @@ void visualise_menus_items_and_separators (gpointer recursively_pointer)
   activate_change_done ();
 }
 
+/* 
+
+   Changes the status of one or more menus, pipe menus, items and separators to visible. 
+   The whole subtree of the toplevel ancestor of each selected row is checked for dependent visibilities, 
+   so this is done in the background, row by row. 
+
+*/
+
+void visualise_menus_items_and_separators (gpointer recursively_pointer)
+{
+  struct visualisation_job *job = g_new0 (struct visualisation_job, 1);
+  guint number_of_steps = 0;
+  GtkTreePath *path_loop;
+  GtkTreeIter iter_toplevel;
+
+  GList *g_list_loop;
+
+  job->selected_rows = get_references_of_selected_rows ();
+  job->recursively_pointer = recursively_pointer;
+
+  if (!job->selected_rows) {
+    g_free (job);
+
+    return;
+  }
+
+  for (g_list_loop = job->selected_rows; g_list_loop; g_list_loop = g_list_loop->next) {
+    path_loop = gtk_tree_row_reference_get_path (g_list_loop->data);
+    get_toplevel_iter_from_path (&iter_toplevel, path_loop);
+    number_of_steps += 1 + count_rows_of_subtree (&iter_toplevel);
+
+    // Cleanup
+    gtk_tree_path_free (path_loop);
+  }
+
+  start_idle_job ("Visualising", number_of_steps, 
+		  (GSourceFunc) visualise_next_row, (GFunc) visualisation_job_finished, job);
+}
+
 /* 
 
    File filter is limited to display only image files.
@@ -429,6 +985,7 @@ gboolean set_icon (gchar       *icon_path,
   }
 
   icon = gdk_pixbuf_scale_simple (icon_in_original_size, font_size + 10, font_size + 10, GDK_INTERP_BILINEAR);
+  store_original_icon (icon_path, icon_in_original_size);
 
   // Cleanup
   g_object_unref (icon_in_original_size);
@@ -446,7 +1003,7 @@ gboolean set_icon (gchar       *icon_path,
   g_object_unref (icon);
   g_free (icon_modified);
 
-  // This function might have been called from the timer function, with currently no selection done at that time.
+  // This function might have been called from the icon monitoring, with currently no selection done at that time.
   if (gtk_tree_selection_count_selected_rows (selection)) {
     repopulate_txt_fields_array ();
     set_entry_fields ();
@@ -457,20 +1014,20 @@ gboolean set_icon (gchar       *icon_path,
 
 /* 
 
-   Removes icons from menus or items.
+   Removes the icon of the next row of an icon removal job. 
 
 */
 
-void remove_icons_from_menus_or_items (void)
+static gboolean remove_icon_of_next_row (struct icon_removal_job *job)
 {
-  GtkTreeSelection *selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview));
-  GList *selected_rows = gtk_tree_selection_get_selected_rows (selection, &model);
-  
+  GtkTreeRowReference *row = job->rows->data;
+  GtkTreePath *path = gtk_tree_row_reference_get_path (row);
   GtkTreeIter iter_loop;
-  GList *g_list_loop;
 
-  for (g_list_loop = selected_rows; g_list_loop; g_list_loop = g_list_loop->next) {
-    gtk_tree_model_get_iter (model, &iter_loop, g_list_loop->data);
+  job->rows = g_list_delete_link (job->rows, job->rows);
+
+  if (path) { // Otherwise the row has been removed in the meantime.
+    gtk_tree_model_get_iter (model, &iter_loop, path);
     gtk_tree_store_set (GTK_TREE_STORE (model), &iter_loop,
 			TS_ICON_IMG, NULL,
 			TS_ICON_IMG_STATUS, NONE_OR_NORMAL,
@@ -479,17 +1036,56 @@ void remove_icons_from_menus_or_items (void)
 			-1);
   }
 
+  // Cleanup
+  gtk_tree_row_reference_free (row);
+  gtk_tree_path_free (path);
+
+  return (job->rows != NULL);
+}
+
+/* 
+
+   Releases the data of an icon removal job and updates the entry fields. 
+
+*/
+
+static void icon_removal_job_finished (struct icon_removal_job               *job, 
+				       gpointer                G_GNUC_UNUSED  cancelled_pointer)
+{
+  GtkTreeSelection *selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview));
+
+  g_list_free_full (job->rows, (GDestroyNotify) gtk_tree_row_reference_free);
+  g_free (job);
+
   if (gtk_tree_selection_count_selected_rows (selection) == 1) {
     repopulate_txt_fields_array ();
     set_entry_fields ();
   }
 
-  // Cleanup
-  g_list_free_full (selected_rows, (GDestroyNotify) gtk_tree_path_free);
-
   activate_change_done ();
 }
 
+/* 
+
+   Removes icons from menus or items. 
+   Large selections are processed in the background, row by row. 
+
+*/
+
+void remove_icons_from_menus_or_items (void)
+{
+  struct icon_removal_job *job = g_new (struct icon_removal_job, 1);
+
+  if (!(job->rows = get_references_of_selected_rows ())) {
+    g_free (job);
+
+    return;
+  }
+
+  start_idle_job ("Removing icons", g_list_length (job->rows), 
+		  (GSourceFunc) remove_icon_of_next_row, (GFunc) icon_removal_job_finished, job);
+}
+
 /* 
 
    Changes one or more values of a row after at least one of the entry fields has been altered.
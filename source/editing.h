@@ -43,10 +43,13 @@ extern gchar *startupnotify_options[];
 extern gint font_size;
 
 extern void activate_change_done (void);
+extern guint count_rows_of_subtree (GtkTreeIter *parent_iter);
 extern gchar *check_if_invisible_ancestor_exists (GtkTreeModel *local_model, GtkTreePath *path);
 extern GtkWidget *create_dialog (GtkWidget **dialog, gchar *dialog_title, gchar *stock_id, gchar *button_txt_1, 
 				 gchar *button_txt_2, gchar *button_txt_3, gchar *label_txt, gboolean show_immediately);
 extern gchar *get_modified_date_for_icon (gchar *icon_path);
+extern gboolean get_next_row_in_preorder (GtkTreeModel *local_model, GtkTreeIter *local_iter, gint root_depth, 
+					  gboolean descend);
 extern void get_toplevel_iter_from_path (GtkTreeIter *local_iter, GtkTreePath *local_path);
 extern void remove_menu_id (gchar *menu_id);
 extern void remove_rows (gchar *origin);
@@ -54,6 +57,10 @@ extern void repopulate_txt_fields_array (void);
 extern void row_selected (void);
 extern void set_entry_fields (void);
 extern void show_errmsg (gchar *errmsg_raw_txt);
+extern void show_msg_in_statusbar (gchar *message);
+extern void show_quick_jump_palette (const gchar *initial_txt);
+extern void start_idle_job (gchar *description, guint number_of_steps, GSourceFunc step, GFunc finish, gpointer job_data);
+extern void store_original_icon (const gchar *icon_path, GdkPixbuf *icon_in_original_size);
 G_GNUC_NULL_TERMINATED gboolean streq_any (const gchar *string, ...);
 
 #endif
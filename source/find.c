@@ -18,24 +18,79 @@
 */
 
 #include <gtk/gtk.h>
+#include <string.h>
 
 #include "general_header_files/enum__columns.h"
 #include "general_header_files/enum__find_entry_row_buttons.h"
+#include "general_header_files/enum__invalid_icon_imgs_status.h"
 #include "general_header_files/enum__ts_elements.h"
 #include "general_header_files/enum__view_and_options_menu_items.h"
+#include "general_header_files/struct__match_record.h"
 #include "find.h"
 
+struct search_data {
+  GRegex *regex;
+  struct query_node *query;
+  guint8 columns_to_search;
+  gchar *error_txt; // Syntax error of a query that couldn't be compiled, shown by run_search.
+};
+
+// The compiled search of the current list of results, kept so changed rows can be searched again.
+static struct search_data active_search = { NULL, NULL, 0, NULL };
+// Set while replace_occurrences changes rows; the changed rows are searched again afterwards.
+static gboolean update_of_found_occurrences_suspended = FALSE;
+// Key: node (iter.user_data) of a row that is shown inside the "Show matches only" view.
+static GHashTable *rows_shown_in_matches_view = NULL;
+
 void show_or_hide_find_grid (void);
 void find_buttons_management (gchar *find_in_check_button_clicked);
+GArray *get_match_ranges (GRegex *regex, const gchar *cell_txt);
+static gboolean get_match_record (GtkTreePath *path, GtkTreeIter *local_iter, struct match_record *record);
 static gboolean add_occurrence_to_list (GtkTreeModel G_GNUC_UNUSED *local_model, 
 					GtkTreePath *local_path, GtkTreeIter *local_iter);
+static void clear_match_record (struct match_record *record);
+static void new_list_of_rows_with_found_occurrences (void);
 static inline void clear_list_of_rows_with_found_occurrences (void);
+static gboolean compile_search (struct search_data *search);
 void create_list_of_rows_with_found_occurrences (void);
-gboolean check_for_match (const gchar *search_term_str, GtkTreeIter *local_iter, guint8 column_number);
-static gboolean ensure_visibility_of_find (GtkTreeModel G_GNUC_UNUSED *local_model, GtkTreePath *local_path, 
-					   GtkTreeIter *local_iter, const gchar *search_term_str);
+void finish_update_of_rows_with_found_occurrences (void);
+static guint get_index_of_occurrence (GtkTreePath *path, gboolean behind_path);
+static void update_occurrence_of_row (GtkTreePath *path, GtkTreeIter *local_iter);
+static void update_occurrences_of_descendants (GtkTreeIter *parent_iter);
+static void update_occurrences_of_ancestors (GtkTreeIter *child_iter);
+static void update_occurrences_around_row (GtkTreePath *path, GtkTreeIter *local_iter);
+static void shift_paths_of_occurrences (GtkTreePath *path, gint offset);
+static gint compare_match_records (struct match_record *record_a, struct match_record *record_b);
+void found_occurrences_row_inserted (GtkTreeModel G_GNUC_UNUSED *local_model, 
+				     GtkTreePath *local_path, GtkTreeIter *local_iter);
+void found_occurrences_row_changed (GtkTreeModel G_GNUC_UNUSED *local_model, 
+				    GtkTreePath *local_path, GtkTreeIter *local_iter);
+void found_occurrences_row_deleted (GtkTreeModel G_GNUC_UNUSED *local_model, GtkTreePath *local_path);
+void found_occurrences_rows_reordered (GtkTreeModel G_GNUC_UNUSED *local_model, GtkTreePath *local_path, 
+				       GtkTreeIter *local_iter, gint *new_order);
+gchar *get_highlighted_markup (GtkTreePath *path, guint8 column_number, const gchar *cell_txt, 
+			       gboolean row_is_selected);
+static void show_matching_columns (guint8 matching_columns);
+static void ensure_visibility_of_find (struct match_record *record);
+static void ensure_visibility_of_all_finds (void);
+static GHashTable *get_matches_and_their_ancestors (void);
+static gboolean row_is_match_or_ancestor_of_match (GtkTreeModel G_GNUC_UNUSED *local_model, GtkTreeIter *local_iter);
+static void update_matches_only_view (void);
+void set_matches_column_attributes (GtkTreeViewColumn G_GNUC_UNUSED *cell_column, GtkCellRenderer *txt_renderer, 
+				    GtkTreeModel *filter_model, GtkTreeIter *filter_iter, gpointer column_number_pointer);
+static void select_row_inside_matches_view (GtkTreePath *path);
+void matches_row_selected (GtkTreeSelection *matches_selection);
+void leave_matches_only_view (void);
 void run_search (void);
 void jump_to_previous_or_next_occurrence (gpointer direction_pointer);
+static void select_occurrence (struct match_record *occurrence);
+static gboolean cell_is_replaceable (GtkTreeIter *local_iter, const gchar *type_txt, 
+				     const gchar *menu_element_txt, guint8 ranges_index);
+static gchar *replace_match_ranges (const gchar *cell_txt, GArray *ranges, const gchar *replacement_txt);
+static void set_icon_values (const gchar *icon_path, GValue *icon_values, GHashTable *loaded_icons);
+static void free_loaded_icon_values (GValue *loaded_icon_values);
+static guint replace_occurrences (guint first_index, guint last_index);
+void replace_or_replace_all (gpointer replace_all_pointer);
 
 /* 
 
@@ -47,14 +102,18 @@ void show_or_hide_find_grid (void)
 {
   if (gtk_widget_get_visible (find_grid)) {
     gtk_entry_set_text (GTK_ENTRY (find_entry), "");
+    gtk_entry_set_text (GTK_ENTRY (find_replace_entry), "");
     gtk_widget_override_background_color (find_entry, GTK_STATE_NORMAL, NULL);
     gtk_widget_set_sensitive (find_button_entry_row[BACK], FALSE);
     gtk_widget_set_sensitive (find_button_entry_row[FORWARD], FALSE);
     gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (find_in_all_columns), TRUE);
     gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (find_match_case), FALSE);
     gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (find_regular_expression), TRUE);
+    gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (find_structured_query), FALSE);
+    gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (find_matches_only), FALSE);
     gtk_widget_hide (find_grid);
     clear_list_of_rows_with_found_occurrences ();
+    update_matches_only_view ();
     gtk_widget_queue_draw (GTK_WIDGET (treeview)); // Force redrawing of treeview.
   }
   else {
@@ -66,7 +125,8 @@ void show_or_hide_find_grid (void)
 /* 
 
    (De)activates all other buttons if "All columns" is (un)selected. 
-   Search results are updated for any change of the chosen columns and criteria ("match case" and "regular expression").
+   Search results are updated for any change of the chosen columns and criteria 
+   ("match case", "regular expression" and "structured query").
 
 */
 
@@ -112,7 +172,88 @@ void find_buttons_management (gchar *find_in_check_button_clicked)
 
 /* 
 
-   Adds a row that contains a column matching the search term to a list.
+   Collects the start and end byte offsets of all matches inside a cell.
+   Returns NULL if there is no match.
+
+*/
+
+GArray *get_match_ranges (GRegex      *regex, 
+			  const gchar *cell_txt)
+{
+  GArray *ranges = NULL;
+  GMatchInfo *match_info;
+  gint start_pos, end_pos;
+
+  g_regex_match (regex, cell_txt, G_REGEX_MATCH_NOTEMPTY, &match_info);
+  while (g_match_info_matches (match_info)) {
+    g_match_info_fetch_pos (match_info, 0, &start_pos, &end_pos);
+    if (!ranges)
+      ranges = g_array_new (FALSE, FALSE, sizeof (gint));
+    g_array_append_val (ranges, start_pos);
+    g_array_append_val (ranges, end_pos);
+    g_match_info_next (match_info, NULL);
+  }
+
+  // Cleanup
+  g_match_info_free (match_info);
+
+  return ranges;
+}
+
+/* 
+
+   Searches a row and fills the match record if the row contains at least one column matching the search term 
+   or matches the structured query. Returns TRUE in this case.
+
+*/
+
+static gboolean get_match_record (GtkTreePath         *path, 
+				  GtkTreeIter         *local_iter, 
+				  struct match_record *record)
+{
+  gboolean query_match = FALSE; // Default
+  gchar *cell_txt_loop;
+  guint8 columns_cnt;
+
+  if (active_search.query) {
+    if ((query_match = evaluate_query (active_search.query, path, local_iter))) {
+      collect_query_match_ranges (active_search.query, path, local_iter, record->ranges);
+      for (columns_cnt = 0; columns_cnt < COL_ELEMENT_VISIBILITY; columns_cnt++) {
+	if (record->ranges[columns_cnt])
+	  record->matching_columns |= 1 << columns_cnt;
+      }
+    }
+  }
+  else {
+    for (columns_cnt = 0; columns_cnt < COL_ELEMENT_VISIBILITY; columns_cnt++) {
+      if (!(active_search.columns_to_search & (1 << columns_cnt)))
+	continue;
+
+      gtk_tree_model_get (model, local_iter, columns_cnt + TREEVIEW_COLUMN_OFFSET, &cell_txt_loop, -1);
+      if (cell_txt_loop && (record->ranges[columns_cnt] = get_match_ranges (active_search.regex, cell_txt_loop)))
+	record->matching_columns |= 1 << columns_cnt;
+
+      // Cleanup
+      g_free (cell_txt_loop);
+    }
+  }
+
+  /* (Note: Rows that match a query only by fields that aren't displayed inside a column, 
+     like the depth, have no matching columns.) */
+  if (record->matching_columns || query_match) {
+    /* (Note: Row references are not used here, since the paths are adjusted by the handlers of the treestore signals 
+       below, which is done for all of them at once instead of for every single reference.) */
+    record->path = gtk_tree_path_copy (path);
+    return TRUE;
+  }
+
+  return FALSE;
+}
+
+/* 
+
+   Adds a match record for a row that matches the search.
+   Since gtk_tree_model_foreach walks through the tree in path order, the array of records is sorted.
 
 */
 
@@ -120,74 +261,494 @@ static gboolean add_occurrence_to_list (GtkTreeModel G_GNUC_UNUSED *local_model,
 					GtkTreePath                *local_path, 
 					GtkTreeIter                *local_iter)
 {
-  for (guint8 columns_cnt = 0; columns_cnt < COL_ELEMENT_VISIBILITY; columns_cnt++) {
-    if (gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (find_in_columns[columns_cnt])) && 
-	check_for_match (search_term_str, local_iter, columns_cnt)) {
-      // (Note: Row references are not used here, since the list is recreated everytime the treestore is changed.)
-      rows_with_found_occurrences = g_list_prepend (rows_with_found_occurrences, gtk_tree_path_copy (local_path));
-      break;
-    }
-  }
+  struct match_record record = { NULL, 0, { NULL } };
+
+  if (get_match_record (local_path, local_iter, &record))
+    g_array_append_val (rows_with_found_occurrences, record);
     
   return FALSE;
 }
 
 /* 
 
-   Clears the list of rows so it can be rebuild later.
+   Frees the path and the match ranges of a match record.
+
+*/
+
+static void clear_match_record (struct match_record *record)
+{
+  gtk_tree_path_free (record->path);
+  for (guint8 columns_cnt = 0; columns_cnt <= ICON_PATH_RANGES; columns_cnt++) {
+    if (record->ranges[columns_cnt])
+      g_array_free (record->ranges[columns_cnt], TRUE);
+  }
+}
+
+/* 
+
+   Creates an empty array of match records.
+
+*/
+
+static void new_list_of_rows_with_found_occurrences (void)
+{
+  rows_with_found_occurrences = g_array_new (FALSE, FALSE, sizeof (struct match_record));
+  g_array_set_clear_func (rows_with_found_occurrences, (GDestroyNotify) clear_match_record);
+}
+
+/* 
+
+   Clears the list of rows and the compiled search so it can be rebuild later.
 
 */
 
 static inline void clear_list_of_rows_with_found_occurrences (void) {
-  g_list_free_full (rows_with_found_occurrences, (GDestroyNotify) gtk_tree_path_free);
-  rows_with_found_occurrences = NULL;
+  if (rows_with_found_occurrences) {
+    g_array_free (rows_with_found_occurrences, TRUE);
+    rows_with_found_occurrences = NULL;
+  }
+  if (active_search.query)
+    free_query (active_search.query);
+  if (active_search.regex)
+    g_regex_unref (active_search.regex);
+  g_free (active_search.error_txt);
+  active_search = (struct search_data) { NULL, NULL, 0, NULL };
+  gtk_widget_set_sensitive (find_replace_button, FALSE);
+  gtk_widget_set_sensitive (find_replace_all_button, FALSE);
 }
 
 /* 
 
-   Creates a list of all rows that contain at least one cell with the search term.
+   Compiles the search term, either as a regular expression or as a structured query.
+   Returns FALSE if the search term is invalid or no columns have been chosen for a non-query search.
+
+*/
+
+static gboolean compile_search (struct search_data *search)
+{
+  gchar *search_term_str_escaped;
+
+  for (guint8 columns_cnt = 0; columns_cnt < COL_ELEMENT_VISIBILITY; columns_cnt++) {
+    if (gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (find_in_columns[columns_cnt])))
+      search->columns_to_search |= 1 << columns_cnt;
+  }
+
+  if (gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (find_structured_query))) {
+    // (Note: error_txt is only set if the query couldn't be compiled.)
+    search->query = compile_query (search_term_str, 
+				   gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (find_match_case)), 
+				   gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (find_regular_expression)), 
+				   search->columns_to_search, &search->error_txt);
+
+    return (search->query != NULL);
+  }
+
+  search_term_str_escaped = (gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (find_regular_expression))) ? 
+    NULL : g_regex_escape_string (search_term_str, -1);
+  search->regex = g_regex_new ((search_term_str_escaped) ? search_term_str_escaped : search_term_str, 
+			       (gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (find_match_case))) ? 
+			       0 : G_REGEX_CASELESS, 0, NULL);
+
+  // Cleanup
+  g_free (search_term_str_escaped);
+
+  if (search->regex && !search->columns_to_search) { // No columns chosen.
+    g_regex_unref (search->regex);
+    search->regex = NULL;
+  }
+
+  return (search->regex != NULL);
+}
+
+/* 
+
+   Creates a sorted array of match records for all rows that contain at least one cell with the search term 
+   or, if "Structured query" is activated, that match the query.
+   The search term is compiled only once and every cell is only evaluated once; 
+   highlighting and navigation reuse the stored match ranges afterwards.
+   The compiled search is kept, so later changes of the treestore only require the changed rows to be searched.
 
 */
 
 void create_list_of_rows_with_found_occurrences (void)
 {
   clear_list_of_rows_with_found_occurrences ();
-  gtk_tree_model_foreach (model, (GtkTreeModelForeachFunc) add_occurrence_to_list, NULL);
-  rows_with_found_occurrences = g_list_reverse (rows_with_found_occurrences);
+
+  if (*search_term_str && compile_search (&active_search)) {
+    new_list_of_rows_with_found_occurrences ();
+    gtk_tree_model_foreach (model, (GtkTreeModelForeachFunc) add_occurrence_to_list, NULL);
+  }
+
+  finish_update_of_rows_with_found_occurrences ();
 }
 
 /* 
 
-   Checks for each column if it contains the search term.
+   Called after the list of rows has been created or adjusted for changes of the treestore. 
+   An empty list is removed, the replace buttons are (de)activated and 
+   the "Show matches only" view is updated accordingly.
 
 */
 
-gboolean check_for_match (const gchar *search_term_str, 
-                          GtkTreeIter *local_iter, 
-                          guint8       column_number)
+void finish_update_of_rows_with_found_occurrences (void)
 {
-  gboolean match = FALSE; // Default
-  gchar *current_column;
-  
-  gtk_tree_model_get (model, local_iter, column_number + TREEVIEW_COLUMN_OFFSET, &current_column, -1);
-  if (current_column) {
-    gchar *search_term_str_escaped = (gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (find_regular_expression))) ? 
-      NULL : g_regex_escape_string (search_term_str, -1);
-
-    if (g_regex_match_simple ((search_term_str_escaped) ? search_term_str_escaped : search_term_str, current_column, 
-			      (gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (find_match_case))) ? 
-			      0 : G_REGEX_CASELESS, G_REGEX_MATCH_NOTEMPTY)) {
-      match = TRUE;
+  if (rows_with_found_occurrences && !rows_with_found_occurrences->len) {
+    g_array_free (rows_with_found_occurrences, TRUE);
+    rows_with_found_occurrences = NULL;
+  }
+
+  gtk_widget_set_sensitive (find_replace_button, (rows_with_found_occurrences != NULL));
+  gtk_widget_set_sensitive (find_replace_all_button, (rows_with_found_occurrences != NULL));
+
+  update_matches_only_view ();
+}
+
+/* 
+
+   Binary search inside the sorted array of match records. 
+   Returns the index of the first record whose path is behind the given path (behind_path = TRUE) or 
+   the index of the first record whose path is not in front of it (behind_path = FALSE).
+
+*/
+
+static guint get_index_of_occurrence (GtkTreePath *path, 
+				      gboolean     behind_path)
+{
+  guint lower_bound = 0, upper_bound = rows_with_found_occurrences->len, middle;
+  gint comparison;
+
+  while (lower_bound < upper_bound) {
+    middle = lower_bound + (upper_bound - lower_bound) / 2;
+    comparison = gtk_tree_path_compare (g_array_index (rows_with_found_occurrences, 
+						       struct match_record, middle).path, path);
+    if (comparison < 0 || (behind_path && comparison == 0))
+      lower_bound = middle + 1;
+    else
+      upper_bound = middle;
+  }
+
+  return lower_bound;
+}
+
+/* 
+
+   Searches a single row again and adds, replaces or removes its match record.
+
+*/
+
+static void update_occurrence_of_row (GtkTreePath *path, 
+				      GtkTreeIter *local_iter)
+{
+  struct match_record record = { NULL, 0, { NULL } };
+  guint index;
+  gboolean row_is_listed;
+
+  if (!rows_with_found_occurrences)
+    new_list_of_rows_with_found_occurrences ();
+
+  index = get_index_of_occurrence (path, FALSE);
+  row_is_listed = (index < rows_with_found_occurrences->len && 
+		   gtk_tree_path_compare (g_array_index (rows_with_found_occurrences, 
+							 struct match_record, index).path, path) == 0);
+
+  if (get_match_record (path, local_iter, &record)) {
+    if (row_is_listed) {
+      clear_match_record (&g_array_index (rows_with_found_occurrences, struct match_record, index));
+      g_array_index (rows_with_found_occurrences, struct match_record, index) = record;
     }
+    else
+      g_array_insert_val (rows_with_found_occurrences, index, record);
+  }
+  else if (row_is_listed)
+    g_array_remove_index (rows_with_found_occurrences, index);
+}
+
+/* 
+
+   Searches all descendants of a row again.
+
+*/
+
+static void update_occurrences_of_descendants (GtkTreeIter *parent_iter)
+{
+  GtkTreeIter iter_loop;
+  GtkTreePath *path_loop;
+  gboolean valid = gtk_tree_model_iter_children (model, &iter_loop, parent_iter);
+
+  while (valid) {
+    path_loop = gtk_tree_model_get_path (model, &iter_loop);
+    update_occurrence_of_row (path_loop, &iter_loop);
+    update_occurrences_of_descendants (&iter_loop);
 
     // Cleanup
-    g_free (search_term_str_escaped);
+    gtk_tree_path_free (path_loop);
+
+    valid = gtk_tree_model_iter_next (model, &iter_loop);
+  }
+}
+
+/* 
+
+   Searches all ancestors of a row again.
+
+*/
+
+static void update_occurrences_of_ancestors (GtkTreeIter *child_iter)
+{
+  GtkTreeIter iter_ancestor, iter_child = *child_iter;
+  GtkTreePath *path_ancestor;
+
+  while (gtk_tree_model_iter_parent (model, &iter_ancestor, &iter_child)) {
+    path_ancestor = gtk_tree_model_get_path (model, &iter_ancestor);
+    update_occurrence_of_row (path_ancestor, &iter_ancestor);
+
+    // Cleanup
+    gtk_tree_path_free (path_ancestor);
+
+    iter_child = iter_ancestor;
+  }
+}
+
+/* 
+
+   Searches a changed row again. Action and option fields of a structured query depend on the 
+   ancestors and descendants of a row, so these are searched again, too, if the search is a query.
+
+*/
+
+static void update_occurrences_around_row (GtkTreePath *path, 
+					   GtkTreeIter *local_iter)
+{
+  update_occurrence_of_row (path, local_iter);
+  if (active_search.query) {
+    update_occurrences_of_ancestors (local_iter);
+    update_occurrences_of_descendants (local_iter);
+  }
+}
+
+/* 
+
+   Adjusts the paths of the match records of the following siblings of a row and their descendants 
+   after a row has been inserted (offset = 1) or deleted (offset = -1) at this path.
+   Since the records are sorted, these records directly follow the position of the path.
+
+*/
+
+static void shift_paths_of_occurrences (GtkTreePath *path, 
+					gint         offset)
+{
+  gint depth = gtk_tree_path_get_depth (path);
+  GtkTreePath *parent_path = gtk_tree_path_copy (path);
+  GtkTreePath *path_loop;
+
+  gtk_tree_path_up (parent_path);
+
+  for (guint occurrences_cnt = get_index_of_occurrence (path, FALSE); 
+       occurrences_cnt < rows_with_found_occurrences->len; 
+       occurrences_cnt++) {
+    path_loop = g_array_index (rows_with_found_occurrences, struct match_record, occurrences_cnt).path;
+    if (depth > 1 && !gtk_tree_path_is_descendant (path_loop, parent_path))
+      break;
+    gtk_tree_path_get_indices (path_loop)[depth - 1] += offset;
   }
 
   // Cleanup
-  g_free (current_column);
+  gtk_tree_path_free (parent_path);
+}
 
-  return match;
+/* 
+
+   Sort function for match records, used after rows have been reordered.
+
+*/
+
+static gint compare_match_records (struct match_record *record_a, 
+				   struct match_record *record_b)
+{
+  return gtk_tree_path_compare (record_a->path, record_b->path);
+}
+
+/* 
+
+   The following four functions are called for every change of the treestore while a search is active. 
+   They keep the list of rows with found occurrences up to date by searching only the inserted or changed rows 
+   and by adjusting the paths of the other records, so a change doesn't require the whole menu to be searched again.
+   activate_change_done finishes the update by calling finish_update_of_rows_with_found_occurrences.
+
+*/
+
+void found_occurrences_row_inserted (GtkTreeModel G_GNUC_UNUSED *local_model, 
+				     GtkTreePath                *local_path, 
+				     GtkTreeIter                *local_iter)
+{
+  if (!active_search.regex && !active_search.query)
+    return;
+
+  if (rows_with_found_occurrences)
+    shift_paths_of_occurrences (local_path, 1);
+  update_occurrences_around_row (local_path, local_iter);
+}
+
+void found_occurrences_row_changed (GtkTreeModel G_GNUC_UNUSED *local_model, 
+				    GtkTreePath                *local_path, 
+				    GtkTreeIter                *local_iter)
+{
+  if ((!active_search.regex && !active_search.query) || update_of_found_occurrences_suspended)
+    return;
+
+  update_occurrences_around_row (local_path, local_iter);
+}
+
+void found_occurrences_row_deleted (GtkTreeModel G_GNUC_UNUSED *local_model, 
+				    GtkTreePath                *local_path)
+{
+  if (!active_search.regex && !active_search.query)
+    return;
+
+  if (rows_with_found_occurrences) {
+    guint index = get_index_of_occurrence (local_path, FALSE);
+    GtkTreePath *path_loop;
+
+    // Removes the records of the deleted row and its descendants.
+    while (index < rows_with_found_occurrences->len) {
+      path_loop = g_array_index (rows_with_found_occurrences, struct match_record, index).path;
+      if (gtk_tree_path_compare (path_loop, local_path) != 0 && !gtk_tree_path_is_descendant (path_loop, local_path))
+	break;
+      g_array_remove_index (rows_with_found_occurrences, index);
+    }
+
+    shift_paths_of_occurrences (local_path, -1);
+  }
+
+  if (active_search.query && gtk_tree_path_get_depth (local_path) > 1) {
+    GtkTreePath *parent_path = gtk_tree_path_copy (local_path);
+    GtkTreeIter parent_iter;
+
+    gtk_tree_path_up (parent_path);
+    gtk_tree_model_get_iter (model, &parent_iter, parent_path);
+    update_occurrence_of_row (parent_path, &parent_iter);
+    update_occurrences_of_ancestors (&parent_iter);
+
+    // Cleanup
+    gtk_tree_path_free (parent_path);
+  }
+}
+
+void found_occurrences_rows_reordered (GtkTreeModel G_GNUC_UNUSED *local_model, 
+				       GtkTreePath                *local_path, 
+				       GtkTreeIter                *local_iter, 
+				       gint                       *new_order)
+{
+  if (!rows_with_found_occurrences)
+    return;
+
+  gint depth = gtk_tree_path_get_depth (local_path);
+  gint number_of_children = gtk_tree_model_iter_n_children (model, local_iter);
+  // (Note: new_order contains the former position of every row at its new position.)
+  gint *new_positions = g_new (gint, number_of_children);
+  guint first_index = (depth) ? get_index_of_occurrence (local_path, TRUE) : 0;
+  guint occurrences_cnt;
+  GtkTreePath *path_loop;
+
+  for (gint children_cnt = 0; children_cnt < number_of_children; children_cnt++)
+    new_positions[new_order[children_cnt]] = children_cnt;
+
+  for (occurrences_cnt = first_index; occurrences_cnt < rows_with_found_occurrences->len; occurrences_cnt++) {
+    path_loop = g_array_index (rows_with_found_occurrences, struct match_record, occurrences_cnt).path;
+    if (depth && !gtk_tree_path_is_descendant (path_loop, local_path))
+      break;
+    gtk_tree_path_get_indices (path_loop)[depth] = new_positions[gtk_tree_path_get_indices (path_loop)[depth]];
+  }
+
+  // Only the records of the reordered rows and their descendants have to be sorted again.
+  g_qsort_with_data (&g_array_index (rows_with_found_occurrences, struct match_record, first_index), 
+		     occurrences_cnt - first_index, sizeof (struct match_record), 
+		     (GCompareDataFunc) compare_match_records, NULL);
+
+  // Cleanup
+  g_free (new_positions);
+}
+
+/* 
+
+   Creates the markup of a cell with all matches highlighted, based on the stored match ranges.
+   Returns NULL if the cell contains no match.
+
+*/
+
+gchar *get_highlighted_markup (GtkTreePath *path, 
+			       guint8       column_number, 
+			       const gchar *cell_txt, 
+			       gboolean     row_is_selected)
+{
+  if (!rows_with_found_occurrences || !cell_txt)
+    return NULL;
+
+  guint index = get_index_of_occurrence (path, FALSE);
+  struct match_record *record;
+
+  if (index == rows_with_found_occurrences->len)
+    return NULL;
+
+  record = &g_array_index (rows_with_found_occurrences, struct match_record, index);
+
+  if (gtk_tree_path_compare (record->path, path) != 0 || !(record->matching_columns & (1 << column_number)))
+    return NULL;
+
+  GArray *ranges = record->ranges[column_number];
+  GString *highlighted_txt = g_string_new ("");
+  gint cell_txt_length = strlen (cell_txt);
+  gint start_pos, end_pos, prev_end_pos = 0;
+  gchar *escaped_txt;
+
+  for (guint ranges_cnt = 0; ranges_cnt < ranges->len; ranges_cnt += 2) {
+    start_pos = g_array_index (ranges, gint, ranges_cnt);
+    end_pos = g_array_index (ranges, gint, ranges_cnt + 1);
+    // The cell might have been changed after the search has been done; the remaining ranges are outdated then.
+    // This is also the case if a range doesn't start and end at character boundaries, which would split characters.
+    if (end_pos > cell_txt_length || start_pos < prev_end_pos || start_pos > end_pos || 
+	!g_utf8_validate (cell_txt + prev_end_pos, start_pos - prev_end_pos, NULL) || 
+	!g_utf8_validate (cell_txt + start_pos, end_pos - start_pos, NULL))
+      break;
+
+    escaped_txt = g_markup_escape_text (cell_txt + prev_end_pos, start_pos - prev_end_pos);
+    g_string_append (highlighted_txt, escaped_txt);
+    // Cleanup
+    g_free (escaped_txt);
+
+    escaped_txt = g_markup_escape_text (cell_txt + start_pos, end_pos - start_pos);
+    g_string_append_printf (highlighted_txt, "<span background='%s>%s</span>", 
+			    (row_is_selected) ? "black'" : "yellow' foreground='black'", escaped_txt);
+    // Cleanup
+    g_free (escaped_txt);
+
+    prev_end_pos = end_pos;
+  }
+
+  escaped_txt = g_markup_escape_text (cell_txt + prev_end_pos, -1);
+  g_string_append (highlighted_txt, escaped_txt);
+
+  // Cleanup
+  g_free (escaped_txt);
+
+  return g_string_free (highlighted_txt, FALSE);
+}
+
+/* 
+
+   Shows the hidden columns among the passed ones. 
+
+*/
+
+static void show_matching_columns (guint8 matching_columns)
+{
+  for (guint8 columns_cnt = COL_MENU_ID; columns_cnt <= COL_EXECUTE; columns_cnt++) {
+    if ((matching_columns & (1 << columns_cnt)) && !gtk_tree_view_column_get_visible (columns[columns_cnt])) {
+      gtk_check_menu_item_set_active (GTK_CHECK_MENU_ITEM (mb_view_and_options[(columns_cnt == COL_MENU_ID) ? 
+									       SHOW_MENU_ID_COL : 
+									       SHOW_EXECUTE_COL]), TRUE);
+    }
+  }
 }
 
 /* 
@@ -198,28 +759,285 @@ gboolean check_for_match (const gchar *search_term_str,
 
 */
 
-static gboolean ensure_visibility_of_find (GtkTreeModel G_GNUC_UNUSED *local_model, 
-					   GtkTreePath                *local_path, 
-					   GtkTreeIter                *local_iter, 
-					   const gchar                *search_term_str)
+static void ensure_visibility_of_find (struct match_record *record)
 {
-  for (guint8 columns_cnt = 0; columns_cnt < COL_ELEMENT_VISIBILITY; columns_cnt++) {
-    if (gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (find_in_columns[columns_cnt])) && 
-	check_for_match (search_term_str, local_iter, columns_cnt)) {
-      if (gtk_tree_path_get_depth (local_path) > 1 &&
-	  !gtk_tree_view_row_expanded (GTK_TREE_VIEW (treeview), local_path)) {
-	gtk_tree_view_expand_to_path (GTK_TREE_VIEW (treeview), local_path);
-	gtk_tree_view_collapse_row (GTK_TREE_VIEW (treeview), local_path);
-      }
-      if (!gtk_tree_view_column_get_visible (columns[columns_cnt])) {
-	gtk_check_menu_item_set_active (GTK_CHECK_MENU_ITEM (mb_view_and_options[(columns_cnt == COL_MENU_ID) ? 
-										 SHOW_MENU_ID_COL : 
-										 SHOW_EXECUTE_COL]), TRUE);
+  if (gtk_tree_path_get_depth (record->path) > 1 &&
+      !gtk_tree_view_row_expanded (GTK_TREE_VIEW (treeview), record->path)) {
+    gtk_tree_view_expand_to_path (GTK_TREE_VIEW (treeview), record->path);
+    gtk_tree_view_collapse_row (GTK_TREE_VIEW (treeview), record->path);
+  }
+
+  show_matching_columns (record->matching_columns);
+}
+
+/* 
+
+   Does the same as ensure_visibility_of_find for all found occurrences in one pass: 
+   each parent is expanded at most once, without redrawing the tree view in between, 
+   and the columns are checked once for all occurrences. 
+
+*/
+
+static void ensure_visibility_of_all_finds (void)
+{
+  GtkTreePath *last_expanded_parent_path = NULL;
+  GtkTreePath *parent_path;
+  guint8 matching_columns = 0;
+
+  struct match_record *record_loop;
+
+  begin_batch_expansion ();
+
+  for (guint occurrences_cnt = 0; occurrences_cnt < rows_with_found_occurrences->len; occurrences_cnt++) {
+    record_loop = &g_array_index (rows_with_found_occurrences, struct match_record, occurrences_cnt);
+    matching_columns |= record_loop->matching_columns;
+    if (gtk_tree_path_get_depth (record_loop->path) == 1)
+      continue;
+
+    parent_path = gtk_tree_path_copy (record_loop->path);
+    gtk_tree_path_up (parent_path);
+    /* Siblings are next to each other, since the occurrences are sorted in tree order. 
+       (Note: If the parent is expanded, all other ancestors are expanded as well.) */
+    if ((last_expanded_parent_path && gtk_tree_path_compare (parent_path, last_expanded_parent_path) == 0) || 
+	gtk_tree_view_row_expanded (GTK_TREE_VIEW (treeview), parent_path)) {
+      // Cleanup
+      gtk_tree_path_free (parent_path);
+    }
+    else {
+      gtk_tree_view_expand_to_path (GTK_TREE_VIEW (treeview), parent_path);
+      gtk_tree_path_free (last_expanded_parent_path);
+      last_expanded_parent_path = parent_path;
+    }
+  }
+
+  end_batch_expansion ();
+
+  show_matching_columns (matching_columns);
+
+  // Cleanup
+  gtk_tree_path_free (last_expanded_parent_path);
+}
+
+/* 
+
+   Returns the set of the nodes of all rows with matches and their ancestors. 
+   The ancestors of a row are only walked up until one of them is already inside the set.
+
+*/
+
+static GHashTable *get_matches_and_their_ancestors (void)
+{
+  GHashTable *rows = g_hash_table_new (g_direct_hash, g_direct_equal);
+  GtkTreeIter iter_loop, parent_loop;
+
+  for (guint occurrences_cnt = 0; occurrences_cnt < rows_with_found_occurrences->len; occurrences_cnt++) {
+    gtk_tree_model_get_iter (model, &iter_loop, 
+			     g_array_index (rows_with_found_occurrences, struct match_record, occurrences_cnt).path);
+    while (!g_hash_table_contains (rows, iter_loop.user_data)) {
+      g_hash_table_add (rows, iter_loop.user_data);
+      if (!gtk_tree_model_iter_parent (model, &parent_loop, &iter_loop))
+	break;
+      iter_loop = parent_loop;
+    }
+  }
+
+  return rows;
+}
+
+/* 
+
+   Visibility function of the filter model used for the "Show matches only" view.
+
+*/
+
+static gboolean row_is_match_or_ancestor_of_match (GtkTreeModel G_GNUC_UNUSED *local_model, 
+						   GtkTreeIter                *local_iter)
+{
+  return (rows_shown_in_matches_view && g_hash_table_contains (rows_shown_in_matches_view, local_iter->user_data));
+}
+
+/* 
+
+   Shows only the rows with matches and their ancestors inside a separate treeview if "Show matches only" is active, 
+   otherwise the regular treeview is shown. 
+   While the view is shown, its filter model is kept and only refiltered; rows that have become visible are expanded.
+
+*/
+
+static void update_matches_only_view (void)
+{
+  GtkWidget *scrolled_window = gtk_widget_get_parent (GTK_WIDGET (treeview));
+
+  if (gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (find_matches_only)) && rows_with_found_occurrences) {
+    GtkTreeModel *filter_model = gtk_tree_view_get_model (GTK_TREE_VIEW (matches_treeview));
+    GHashTable *previously_shown_rows = rows_shown_in_matches_view;
+    GList *selected_rows = gtk_tree_selection_get_selected_rows (gtk_tree_view_get_selection 
+								 (GTK_TREE_VIEW (treeview)), NULL);
+
+    GtkTreePath *path_loop, *filter_path_loop;
+    GtkTreeIter iter_loop;
+
+    rows_shown_in_matches_view = get_matches_and_their_ancestors ();
+
+    if (filter_model) {
+      gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (filter_model));
+      // The expansion status of the rows that have been shown before is kept.
+      for (guint occurrences_cnt = 0; occurrences_cnt < rows_with_found_occurrences->len; occurrences_cnt++) {
+	path_loop = g_array_index (rows_with_found_occurrences, struct match_record, occurrences_cnt).path;
+	gtk_tree_model_get_iter (model, &iter_loop, path_loop);
+	if (previously_shown_rows && g_hash_table_contains (previously_shown_rows, iter_loop.user_data))
+	  continue;
+	if ((filter_path_loop = gtk_tree_model_filter_convert_child_path_to_path (GTK_TREE_MODEL_FILTER (filter_model), 
+										 path_loop))) {
+	  gtk_tree_view_expand_to_path (GTK_TREE_VIEW (matches_treeview), filter_path_loop);
+
+	  // Cleanup
+	  gtk_tree_path_free (filter_path_loop);
+	}
       }
     }
+    else {
+      filter_model = gtk_tree_model_filter_new (model, NULL);
+      gtk_tree_model_filter_set_visible_func (GTK_TREE_MODEL_FILTER (filter_model), 
+					      (GtkTreeModelFilterVisibleFunc) row_is_match_or_ancestor_of_match, 
+					      NULL, NULL);
+      gtk_tree_view_set_model (GTK_TREE_VIEW (matches_treeview), filter_model);
+      g_object_unref (filter_model);
+      gtk_tree_view_expand_all (GTK_TREE_VIEW (matches_treeview));
+    }
+
+    // Cleanup
+    if (previously_shown_rows)
+      g_hash_table_destroy (previously_shown_rows);
+
+    for (guint8 columns_cnt = 0; columns_cnt < COL_ELEMENT_VISIBILITY; columns_cnt++) {
+      gtk_tree_view_column_set_visible (gtk_tree_view_get_column (GTK_TREE_VIEW (matches_treeview), columns_cnt), 
+					gtk_tree_view_column_get_visible (columns[columns_cnt]));
+    }
+
+    if (selected_rows)
+      select_row_inside_matches_view (selected_rows->data);
+
+    gtk_widget_hide (scrolled_window);
+    gtk_widget_show (matches_scrolled_window);
+
+    // Cleanup
+    g_list_free_full (selected_rows, (GDestroyNotify) gtk_tree_path_free);
+  }
+  else if (gtk_widget_get_visible (matches_scrolled_window)) {
+    gtk_widget_hide (matches_scrolled_window);
+    gtk_tree_view_set_model (GTK_TREE_VIEW (matches_treeview), NULL);
+    gtk_widget_show (scrolled_window);
   }
 
-  return FALSE;
+  if (!gtk_tree_view_get_model (GTK_TREE_VIEW (matches_treeview)) && rows_shown_in_matches_view) {
+    g_hash_table_destroy (rows_shown_in_matches_view);
+    rows_shown_in_matches_view = NULL;
+  }
+}
+
+/* 
+
+   Sets the text of the cells of the "Show matches only" view and highlights the matches. 
+   Ancestors that are only shown to keep the tree structure are greyed out.
+
+*/
+
+void set_matches_column_attributes (GtkTreeViewColumn G_GNUC_UNUSED *cell_column, 
+				    GtkCellRenderer                 *txt_renderer,
+				    GtkTreeModel                    *filter_model, 
+				    GtkTreeIter                     *filter_iter, 
+				    gpointer                         column_number_pointer)
+{
+  guint8 column_number = GPOINTER_TO_UINT (column_number_pointer);
+  GtkTreeIter child_iter;
+  GtkTreePath *path;
+  gchar *cell_txt, *highlighted_txt;
+  gboolean row_is_selected = gtk_tree_selection_iter_is_selected (gtk_tree_view_get_selection 
+								  (GTK_TREE_VIEW (matches_treeview)), filter_iter);
+
+  gtk_tree_model_filter_convert_iter_to_child_iter (GTK_TREE_MODEL_FILTER (filter_model), &child_iter, filter_iter);
+  path = gtk_tree_model_get_path (model, &child_iter);
+  gtk_tree_model_get (model, &child_iter, column_number + TREEVIEW_COLUMN_OFFSET, &cell_txt, -1);
+
+  if ((highlighted_txt = get_highlighted_markup (path, column_number, cell_txt, row_is_selected)))
+    g_object_set (txt_renderer, "markup", highlighted_txt, "foreground-set", FALSE, NULL);
+  else
+    g_object_set (txt_renderer, "text", cell_txt, "foreground", "grey", "foreground-set", !row_is_selected, NULL);
+
+  // Cleanup
+  gtk_tree_path_free (path);
+  g_free (cell_txt);
+  g_free (highlighted_txt);
+}
+
+/* 
+
+   Selects the row inside the "Show matches only" view that corresponds to a row of the regular treeview.
+
+*/
+
+static void select_row_inside_matches_view (GtkTreePath *path)
+{
+  GtkTreeModel *filter_model = gtk_tree_view_get_model (GTK_TREE_VIEW (matches_treeview));
+  GtkTreePath *filter_path;
+
+  if (!filter_model || 
+      !(filter_path = gtk_tree_model_filter_convert_child_path_to_path (GTK_TREE_MODEL_FILTER (filter_model), path)))
+    return;
+
+  gtk_tree_selection_select_path (gtk_tree_view_get_selection (GTK_TREE_VIEW (matches_treeview)), filter_path);
+  gtk_tree_view_scroll_to_cell (GTK_TREE_VIEW (matches_treeview), filter_path, NULL, FALSE, 0, 0);
+
+  // Cleanup
+  gtk_tree_path_free (filter_path);
+}
+
+/* 
+
+   Transfers a selection done inside the "Show matches only" view to the regular treeview, 
+   so the row can be edited as usual.
+
+*/
+
+void matches_row_selected (GtkTreeSelection *matches_selection)
+{
+  GtkTreeModel *filter_model;
+  GtkTreeIter filter_iter, child_iter;
+
+  if (!gtk_tree_selection_get_selected (matches_selection, &filter_model, &filter_iter))
+    return;
+
+  GtkTreeSelection *selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview));
+  GtkTreePath *path;
+
+  gtk_tree_model_filter_convert_iter_to_child_iter (GTK_TREE_MODEL_FILTER (filter_model), &child_iter, &filter_iter);
+  path = gtk_tree_model_get_path (model, &child_iter);
+
+  if (!gtk_tree_selection_path_is_selected (selection, path) || 
+      gtk_tree_selection_count_selected_rows (selection) > 1) {
+    if (gtk_tree_path_get_depth (path) > 1) {
+      gtk_tree_view_expand_to_path (GTK_TREE_VIEW (treeview), path);
+      gtk_tree_view_collapse_row (GTK_TREE_VIEW (treeview), path);
+    }
+    gtk_tree_selection_unselect_all (selection);
+    gtk_tree_selection_select_path (selection, path);
+    gtk_tree_view_scroll_to_cell (GTK_TREE_VIEW (treeview), path, NULL, FALSE, 0, 0);
+  }
+
+  // Cleanup
+  gtk_tree_path_free (path);
+}
+
+/* 
+
+   Returns to the regular treeview, keeping the selection (double click inside the "Show matches only" view).
+
+*/
+
+void leave_matches_only_view (void)
+{
+  gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (find_matches_only), FALSE);
 }
 
 /* 
@@ -231,6 +1049,7 @@ static gboolean ensure_visibility_of_find (GtkTreeModel G_GNUC_UNUSED *local_mod
 void run_search (void)
 {
   GdkRGBA missing_fields_bg_color = { 0.92, 0.73, 0.73, 1.0 };
+  gboolean structured_query = gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (find_structured_query));
   gboolean no_find_in_columns_buttons_clicked = TRUE; // Default
 
   guint8 columns_cnt;
@@ -247,7 +1066,8 @@ void run_search (void)
     }
   }
 
-  if (!(*search_term_str) || no_find_in_columns_buttons_clicked) {
+  // (Note: A structured query doesn't need any columns if it only consists of field comparisons.)
+  if (!(*search_term_str) || (no_find_in_columns_buttons_clicked && !structured_query)) {
     if (no_find_in_columns_buttons_clicked) {
       for (columns_cnt = 0; columns_cnt < COL_ELEMENT_VISIBILITY; columns_cnt++)
 	gtk_widget_override_background_color (find_in_columns[columns_cnt], GTK_STATE_NORMAL, &missing_fields_bg_color);
@@ -260,17 +1080,31 @@ void run_search (void)
 
     if (rows_with_found_occurrences) {
       GtkTreeSelection *selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview));
+      GtkTreePath *path_of_first_occurrence = g_array_index (rows_with_found_occurrences, 
+							     struct match_record, 0).path;
 
-      gtk_tree_model_foreach (model, (GtkTreeModelForeachFunc) ensure_visibility_of_find, (gpointer) search_term_str);
+      /* Expanding all matching rows is not necessary if only the matches are shown; 
+	 in this case only the first occurrence, which is selected, is made visible. */
+      if (gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (find_matches_only)))
+	ensure_visibility_of_find (&g_array_index (rows_with_found_occurrences, struct match_record, 0));
+      else
+	ensure_visibility_of_all_finds ();
 
       gtk_tree_selection_unselect_all (selection);
-      gtk_tree_selection_select_path (selection, rows_with_found_occurrences->data);
-      gtk_tree_view_scroll_to_cell (GTK_TREE_VIEW (treeview), rows_with_found_occurrences->data, NULL, FALSE, 0, 0);
+      gtk_tree_selection_select_path (selection, path_of_first_occurrence);
+      gtk_tree_view_scroll_to_cell (GTK_TREE_VIEW (treeview), path_of_first_occurrence, NULL, FALSE, 0, 0);
+      select_row_inside_matches_view (path_of_first_occurrence);
     }
   }
 
   row_selected (); // Reset status of forward and back buttons.
 
+  // Show syntax errors of a structured query (this has to be done after row_selected, which clears the statusbar).
+  if (structured_query && active_search.error_txt) {
+    gtk_widget_override_background_color (find_entry, GTK_STATE_NORMAL, &missing_fields_bg_color);
+    show_msg_in_statusbar (active_search.error_txt);
+  }
+
   gtk_widget_queue_draw (GTK_WIDGET (treeview)); // Force redrawing of treeview (for highlighting of search results).
 }
 
@@ -284,30 +1118,389 @@ void jump_to_previous_or_next_occurrence (gpointer direction_pointer)
 {
   gboolean forward = GPOINTER_TO_INT (direction_pointer);
 
+  GtkTreePath *path = gtk_tree_model_get_path (model, &iter);
+  guint index = get_index_of_occurrence (path, forward);
+
+  // Cleanup
+  gtk_tree_path_free (path);
+
+  // (Note: The back and forward buttons are insensitive if there is no previous or next occurrence.)
+  if ((forward) ? (index == rows_with_found_occurrences->len) : (index == 0))
+    return;
+
+  select_occurrence (&g_array_index (rows_with_found_occurrences, struct match_record, 
+				     (forward) ? index : index - 1));
+}
+
+/* 
+
+   Makes an occurrence visible and selects it.
+
+*/
+
+static void select_occurrence (struct match_record *occurrence)
+{
   GtkTreeSelection *selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview));
-  GtkTreePath *path = gtk_tree_model_get_path (model, &iter), *path_of_occurrence;
-  GtkTreeIter iter_of_occurrence;
-
-  GList *rows_with_found_occurrences_loop;
-
-  for (rows_with_found_occurrences_loop = (forward) ? 
-	 rows_with_found_occurrences : g_list_last (rows_with_found_occurrences); 
-       rows_with_found_occurrences_loop; 
-       rows_with_found_occurrences_loop = (forward) ? rows_with_found_occurrences_loop->next : 
-	 rows_with_found_occurrences_loop->prev)
-    if ((forward) ? (gtk_tree_path_compare (path, rows_with_found_occurrences_loop->data) < 0) : 
-	(gtk_tree_path_compare (path, rows_with_found_occurrences_loop->data) > 0))
-      break;
-  
-  path_of_occurrence = rows_with_found_occurrences_loop->data;
-  gtk_tree_model_get_iter (model, &iter_of_occurrence, path_of_occurrence);
 
-  ensure_visibility_of_find (NULL, path_of_occurrence, &iter_of_occurrence, search_term_str);
+  ensure_visibility_of_find (occurrence);
 
   gtk_tree_selection_unselect_all (selection);
-  gtk_tree_selection_select_path (selection, path_of_occurrence);
-  gtk_tree_view_scroll_to_cell (GTK_TREE_VIEW (treeview), path_of_occurrence, NULL, FALSE, 0, 0);
-  
+  gtk_tree_selection_select_path (selection, occurrence->path);
+  gtk_tree_view_scroll_to_cell (GTK_TREE_VIEW (treeview), occurrence->path, NULL, FALSE, 0, 0);
+  select_row_inside_matches_view (occurrence->path);
+}
+
+/* 
+
+   Checks if a cell may be changed by a replacement. Types and element visibilities are never replaced, 
+   just like the names of actions and options and boolean option values.
+
+*/
+
+static gboolean cell_is_replaceable (GtkTreeIter *local_iter, 
+				     const gchar *type_txt, 
+				     const gchar *menu_element_txt, 
+				     guint8       ranges_index)
+{
+  switch (ranges_index) {
+  case COL_MENU_ELEMENT:
+    return streq_any (type_txt, "menu", "pipe menu", "item", "separator", NULL);
+  case COL_VALUE:
+    if (!streq (type_txt, "option"))
+      return FALSE;
+    if (streq (menu_element_txt, "enabled"))
+      return FALSE;
+    if (streq (menu_element_txt, "prompt")) {
+      GtkTreeIter parent;
+      gchar *menu_element_txt_parent;
+      gboolean execute_prompt;
+
+      gtk_tree_model_iter_parent (model, &parent, local_iter);
+      gtk_tree_model_get (model, &parent, TS_MENU_ELEMENT, &menu_element_txt_parent, -1);
+      execute_prompt = streq (menu_element_txt_parent, "Execute");
+
+      // Cleanup
+      g_free (menu_element_txt_parent);
+
+      return execute_prompt; // The prompt option of all other actions is a boolean.
+    }
+    return TRUE;
+  case COL_MENU_ID:
+    return streq_any (type_txt, "menu", "pipe menu", NULL);
+  case COL_EXECUTE:
+    return streq (type_txt, "pipe menu");
+  case ICON_PATH_RANGES:
+    return streq_any (type_txt, "menu", "pipe menu", "item", NULL);
+  default:
+    return FALSE;
+  }
+}
+
+/* 
+
+   Returns a copy of the cell text with all matches replaced by the replacement text.
+
+*/
+
+static gchar *replace_match_ranges (const gchar *cell_txt, 
+				    GArray      *ranges, 
+				    const gchar *replacement_txt)
+{
+  gint cell_txt_length = strlen (cell_txt);
+  GString *new_txt = g_string_sized_new (cell_txt_length);
+  gint *offsets = (gint *) ranges->data;
+  gint end_of_previous_match = 0;
+
+  for (guint ranges_cnt = 0; ranges_cnt < ranges->len; ranges_cnt += 2) {
+    if (offsets[ranges_cnt + 1] > cell_txt_length) // Outdated range.
+      break;
+    g_string_append_len (new_txt, cell_txt + end_of_previous_match, offsets[ranges_cnt] - end_of_previous_match);
+    g_string_append (new_txt, replacement_txt);
+    end_of_previous_match = offsets[ranges_cnt + 1];
+  }
+  g_string_append (new_txt, cell_txt + end_of_previous_match);
+
+  return g_string_free (new_txt, FALSE);
+}
+
+/* 
+
+   Loads the icon of a replaced icon path and fills the values for the icon image, its status and its 
+   modification date, so they can be set together with the other replaced cells of the row.
+   Each icon path is loaded only once per replacement; the values of a loaded icon are kept in loaded_icons.
+   An empty icon path removes the icon.
+
+*/
+
+static void set_icon_values (const gchar *icon_path, 
+			     GValue      *icon_values, 
+			     GHashTable  *loaded_icons)
+{
+  GValue *loaded_icon_values;
+  GdkPixbuf *icon_in_original_size;
+  GdkPixbuf *icon_img = NULL; // Default
+  guint icon_img_status = NONE_OR_NORMAL; // Default
+  gchar *icon_modified = NULL; // Default
+  guint8 values_cnt;
+
+  if ((loaded_icon_values = g_hash_table_lookup (loaded_icons, icon_path))) {
+    for (values_cnt = 0; values_cnt < 3; values_cnt++) {
+      g_value_init (&icon_values[values_cnt], G_VALUE_TYPE (&loaded_icon_values[values_cnt]));
+      g_value_copy (&loaded_icon_values[values_cnt], &icon_values[values_cnt]);
+    }
+
+    return;
+  }
+
+  if (*icon_path) {
+    if ((icon_in_original_size = gdk_pixbuf_new_from_file (icon_path, NULL))) {
+      icon_img = gdk_pixbuf_scale_simple (icon_in_original_size, font_size + 10, font_size + 10, GDK_INTERP_BILINEAR);
+      store_original_icon (icon_path, icon_in_original_size);
+      icon_modified = get_modified_date_for_icon ((gchar *) icon_path);
+
+      // Cleanup
+      g_object_unref (icon_in_original_size);
+    }
+    else {
+      gboolean file_exists = g_file_test (icon_path, G_FILE_TEST_EXISTS);
+
+      icon_img = gdk_pixbuf_copy (invalid_icon_imgs[(file_exists)]); // INVALID_FILE_ICON (TRUE) or INVALID_PATH_ICON
+      icon_img_status = (file_exists) ? INVALID_FILE : INVALID_PATH;
+      if (file_exists)
+	icon_modified = get_modified_date_for_icon ((gchar *) icon_path);
+    }
+  }
+
+  g_value_init (&icon_values[0], GDK_TYPE_PIXBUF);
+  g_value_take_object (&icon_values[0], icon_img);
+  g_value_init (&icon_values[1], G_TYPE_UINT);
+  g_value_set_uint (&icon_values[1], icon_img_status);
+  g_value_init (&icon_values[2], G_TYPE_STRING);
+  g_value_take_string (&icon_values[2], icon_modified);
+
+  loaded_icon_values = g_new0 (GValue, 3);
+  for (values_cnt = 0; values_cnt < 3; values_cnt++) {
+    g_value_init (&loaded_icon_values[values_cnt], G_VALUE_TYPE (&icon_values[values_cnt]));
+    g_value_copy (&icon_values[values_cnt], &loaded_icon_values[values_cnt]);
+  }
+  g_hash_table_insert (loaded_icons, g_strdup (icon_path), loaded_icon_values);
+}
+
+/* 
+
+   Frees the values of an icon that has been loaded by set_icon_values.
+
+*/
+
+static void free_loaded_icon_values (GValue *loaded_icon_values)
+{
+  for (guint8 values_cnt = 0; values_cnt < 3; values_cnt++)
+    g_value_unset (&loaded_icon_values[values_cnt]);
+  g_free (loaded_icon_values);
+}
+
+/* 
+
+   Replaces the matches of the given range of occurrences, reusing the stored match ranges of the search.
+   Returns the number of matches that couldn't be replaced (not editable, empty label or duplicate menu ID).
+
+*/
+
+static guint replace_occurrences (guint first_index, 
+				  guint last_index)
+{
+  const gchar *replacement_txt = gtk_entry_get_text (GTK_ENTRY (find_replace_entry));
+  // Label, value, menu ID, execute, icon path, icon image, icon image status and icon modification date.
+  gint changed_columns[ICON_PATH_RANGES + 4];
+  GValue changed_values[ICON_PATH_RANGES + 4] = { G_VALUE_INIT }; // (Note: g_value_unset resets a value to this state.)
+  guint8 number_of_changed_columns;
+  guint number_of_skipped_cells = 0;
+  // The changed rows are searched again after all replacements have been done, since this changes the list.
+  GPtrArray *changed_rows = g_ptr_array_new_with_free_func ((GDestroyNotify) gtk_tree_path_free);
+  // Key: icon path, value: icon image, icon image status and icon modification date.
+  GHashTable *loaded_icons = g_hash_table_new_full (g_str_hash, g_str_equal, 
+						    g_free, (GDestroyNotify) free_loaded_icon_values);
+  // Set of all menu IDs, created if the first menu ID is replaced; menu_ids is rebuilt from it at the end.
+  GHashTable *menu_ids_set = NULL;
+  GHashTableIter menu_ids_iter;
+  gpointer menu_id;
+
+  struct match_record *record_loop;
+  GtkTreeIter iter_loop;
+  gchar *type_txt_loop, *menu_element_txt_loop;
+  gchar *old_txt_loop, *new_txt_loop;
+  guint8 ts_column_loop;
+
+  guint8 ranges_cnt, values_cnt;
+
+  update_of_found_occurrences_suspended = TRUE;
+
+  for (guint occurrences_cnt = first_index; occurrences_cnt <= last_index; occurrences_cnt++) {
+    record_loop = &g_array_index (rows_with_found_occurrences, struct match_record, occurrences_cnt);
+    gtk_tree_model_get_iter (model, &iter_loop, record_loop->path);
+    gtk_tree_model_get (model, &iter_loop, 
+			TS_TYPE, &type_txt_loop, 
+			TS_MENU_ELEMENT, &menu_element_txt_loop, 
+			-1);
+    number_of_changed_columns = 0;
+
+    for (ranges_cnt = 0; ranges_cnt <= ICON_PATH_RANGES; ranges_cnt++) {
+      if (!record_loop->ranges[ranges_cnt])
+	continue;
+
+      if (!cell_is_replaceable (&iter_loop, type_txt_loop, menu_element_txt_loop, ranges_cnt)) {
+	number_of_skipped_cells++;
+	continue;
+      }
+
+      if (ranges_cnt == COL_MENU_ID && !menu_ids_set) {
+	menu_ids_set = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	for (GSList *menu_ids_loop = menu_ids; menu_ids_loop; menu_ids_loop = menu_ids_loop->next)
+	  g_hash_table_add (menu_ids_set, g_strdup (menu_ids_loop->data));
+      }
+
+      ts_column_loop = (ranges_cnt == ICON_PATH_RANGES) ? TS_ICON_PATH : ranges_cnt + TREEVIEW_COLUMN_OFFSET;
+      gtk_tree_model_get (model, &iter_loop, ts_column_loop, &old_txt_loop, -1);
+      new_txt_loop = replace_match_ranges (old_txt_loop, record_loop->ranges[ranges_cnt], replacement_txt);
+
+      if (streq (new_txt_loop, old_txt_loop) || 
+	  (ranges_cnt == COL_MENU_ELEMENT && !(*new_txt_loop) && !streq (type_txt_loop, "separator")) || 
+	  (ranges_cnt == COL_MENU_ID && 
+	   (!(*new_txt_loop) || g_hash_table_contains (menu_ids_set, new_txt_loop)))) {
+	if (!streq (new_txt_loop, old_txt_loop))
+	  number_of_skipped_cells++;
+
+	// Cleanup
+	g_free (old_txt_loop);
+	g_free (new_txt_loop);
+
+	continue;
+      }
+
+      if (ranges_cnt == COL_MENU_ID) {
+	g_hash_table_remove (menu_ids_set, old_txt_loop);
+	g_hash_table_add (menu_ids_set, g_strdup (new_txt_loop));
+      }
+      else if (ranges_cnt == ICON_PATH_RANGES) {
+	set_icon_values (new_txt_loop, &changed_values[number_of_changed_columns], loaded_icons);
+	changed_columns[number_of_changed_columns++] = TS_ICON_IMG;
+	changed_columns[number_of_changed_columns++] = TS_ICON_IMG_STATUS;
+	changed_columns[number_of_changed_columns++] = TS_ICON_MODIFIED;
+      }
+
+      // Empty labels of separators and empty icon paths are stored as NULL.
+      if (!(*new_txt_loop) && (ranges_cnt == COL_MENU_ELEMENT || ranges_cnt == ICON_PATH_RANGES)) {
+	g_free (new_txt_loop);
+	new_txt_loop = NULL;
+      }
+
+      changed_columns[number_of_changed_columns] = ts_column_loop;
+      g_value_init (&changed_values[number_of_changed_columns], G_TYPE_STRING);
+      g_value_take_string (&changed_values[number_of_changed_columns++], new_txt_loop);
+
+      // Cleanup
+      g_free (old_txt_loop);
+    }
+
+    if (number_of_changed_columns) {
+      gtk_tree_store_set_valuesv (treestore, &iter_loop, changed_columns, changed_values, number_of_changed_columns);
+      g_ptr_array_add (changed_rows, gtk_tree_path_copy (record_loop->path));
+
+      // Cleanup
+      for (values_cnt = 0; values_cnt < number_of_changed_columns; values_cnt++)
+	g_value_unset (&changed_values[values_cnt]);
+    }
+
+    // Cleanup
+    g_free (type_txt_loop);
+    g_free (menu_element_txt_loop);
+  }
+
+  update_of_found_occurrences_suspended = FALSE;
+
+  if (menu_ids_set) {
+    g_slist_free_full (menu_ids, (GDestroyNotify) g_free);
+    menu_ids = NULL;
+    g_hash_table_iter_init (&menu_ids_iter, menu_ids_set);
+    while (g_hash_table_iter_next (&menu_ids_iter, &menu_id, NULL))
+      menu_ids = g_slist_prepend (menu_ids, g_strdup (menu_id));
+  }
+
+  for (guint rows_cnt = 0; rows_cnt < changed_rows->len; rows_cnt++) {
+    gtk_tree_model_get_iter (model, &iter_loop, g_ptr_array_index (changed_rows, rows_cnt));
+    update_occurrences_around_row (g_ptr_array_index (changed_rows, rows_cnt), &iter_loop);
+  }
+
+  if (changed_rows->len)
+    activate_change_done ();
+
+  // Cleanup
+  g_ptr_array_free (changed_rows, TRUE);
+  g_hash_table_destroy (loaded_icons);
+  if (menu_ids_set)
+    g_hash_table_destroy (menu_ids_set);
+
+  row_selected (); // Update entry fields and the status of forward and back buttons.
+
+  return number_of_skipped_cells;
+}
+
+/* 
+
+   Replace: If the selected row is an occurrence, its matches are replaced and the next occurrence is selected, 
+   otherwise the next occurrence is only selected, so it can be checked before it is replaced.
+   Replace all: Replaces the matches of all occurrences in one go.
+
+*/
+
+void replace_or_replace_all (gpointer replace_all_pointer)
+{
+  gboolean replace_all = GPOINTER_TO_INT (replace_all_pointer);
+  GtkTreeSelection *selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview));
+  GtkTreePath *path;
+  guint index;
+  gboolean row_is_occurrence;
+  guint number_of_skipped_matches = 0; // Default
+
+  // (Note: The replace buttons are insensitive if there are no occurrences.)
+  if (replace_all) {
+    number_of_skipped_matches = replace_occurrences (0, rows_with_found_occurrences->len - 1);
+    goto show_number_of_skipped_matches;
+  }
+
+  if (gtk_tree_selection_count_selected_rows (selection) != 1) {
+    select_occurrence (&g_array_index (rows_with_found_occurrences, struct match_record, 0));
+    return;
+  }
+
+  path = gtk_tree_model_get_path (model, &iter);
+  index = get_index_of_occurrence (path, FALSE);
+  row_is_occurrence = (index < rows_with_found_occurrences->len && 
+		       gtk_tree_path_compare (g_array_index (rows_with_found_occurrences, 
+							     struct match_record, index).path, path) == 0);
+
   // Cleanup
   gtk_tree_path_free (path);
+
+  if (row_is_occurrence)
+    number_of_skipped_matches = replace_occurrences (index, index);
+
+  /* If there are no occurrences left after the replacement, 
+     the list of occurrences has been cleared by activate_change_done. */
+  if (rows_with_found_occurrences)
+    jump_to_previous_or_next_occurrence (GINT_TO_POINTER (TRUE));
+
+ show_number_of_skipped_matches:
+  // (Note: Has to be done after row_selected, which clears the statusbar.)
+  if (number_of_skipped_matches) {
+    gchar *statusbar_msg = g_strdup_printf ("%u match(es) not replaced "
+					    "(not editable, empty label or duplicate menu ID)", 
+					    number_of_skipped_matches);
+    show_msg_in_statusbar (statusbar_msg);
+
+    // Cleanup
+    g_free (statusbar_msg);
+  }
+
+  gtk_widget_queue_draw (GTK_WIDGET (treeview)); // Force redrawing of treeview (for highlighting of search results).
 }
@@ -20,8 +20,12 @@
 #ifndef __find_h
 #define __find_h
 
+#define streq(string1, string2) (g_strcmp0 ((string1), (string2)) == 0)
+
+extern GtkTreeStore *treestore;
 extern GtkTreeModel *model;
 extern GtkTreeView *treeview;
+extern GtkWidget *matches_treeview, *matches_scrolled_window;
 extern GtkTreeIter iter;
 
 extern GtkTreeViewColumn *columns[];
@@ -33,14 +37,36 @@ extern GtkWidget *find_grid;
 extern GtkWidget *find_button_entry_row[];
 extern GtkWidget *find_entry;
 extern GtkWidget *find_in_columns[], *find_in_all_columns;
-extern GtkWidget *find_match_case, *find_regular_expression; 
+extern GtkWidget *find_match_case, *find_regular_expression, *find_structured_query; 
+extern GtkWidget *find_matches_only;
+extern GtkWidget *find_replace_entry, *find_replace_button, *find_replace_all_button;
 
 extern const gchar *search_term_str;
 
-extern GList *rows_with_found_occurrences;
+extern GArray *rows_with_found_occurrences;
 
 extern gint handler_id_find_in_columns[];
 
+extern GSList *menu_ids;
+
+extern guint font_size;
+extern GdkPixbuf *invalid_icon_imgs[];
+
+struct query_node; // Defined inside query.c.
+
+extern void activate_change_done (void);
+extern void begin_batch_expansion (void);
+extern void collect_query_match_ranges (struct query_node *query, GtkTreePath *query_path, 
+					GtkTreeIter *query_iter, GArray **ranges);
+extern struct query_node *compile_query (const gchar *query_str, gboolean match_case, gboolean regular_expression, 
+					 guint8 columns_to_search, gchar **error_txt);
+extern void end_batch_expansion (void);
+extern gboolean evaluate_query (struct query_node *query, GtkTreePath *query_path, GtkTreeIter *query_iter);
+extern void free_query (struct query_node *query);
+extern gchar *get_modified_date_for_icon (gchar *icon_path);
 extern void row_selected (void);
+extern void show_msg_in_statusbar (gchar *message);
+extern void store_original_icon (const gchar *icon_path, GdkPixbuf *icon_in_original_size);
+G_GNUC_NULL_TERMINATED extern gboolean streq_any (const gchar *string, ...);
 
 #endif
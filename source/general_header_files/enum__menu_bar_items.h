@@ -1,8 +1,9 @@
 #ifndef __enum__menu_bar_items_h
 #define __enum__menu_bar_items_h
 
-enum { MB_NEW, MB_OPEN, MB_SAVE, MB_SAVE_AS, MB_SEPARATOR_FILE, MB_QUIT, NUMBER_OF_FILE_MENU_ITEMS};
-enum { MB_MOVE_TOP, MB_MOVE_UP, MB_MOVE_DOWN, MB_MOVE_BOTTOM, MB_SEPARATOR_EDIT1, MB_REMOVE, MB_REMOVE_ALL_CHILDREN, 
-       MB_SEPARATOR_EDIT2, MB_VISUALISE, MB_VISUALISE_RECURSIVELY, NUMBER_OF_EDIT_MENU_ITEMS };
+enum { MB_NEW, MB_OPEN, MB_SAVE, MB_SAVE_AS, MB_VERSION_HISTORY, MB_SEPARATOR_FILE, MB_QUIT, NUMBER_OF_FILE_MENU_ITEMS};
+enum { MB_MOVE_TOP, MB_MOVE_UP, MB_MOVE_DOWN, MB_MOVE_BOTTOM, MB_SEPARATOR_EDIT1, MB_CUT, MB_COPY, MB_PASTE, 
+       MB_SEPARATOR_EDIT2, MB_REMOVE, MB_REMOVE_ALL_CHILDREN, MB_SEPARATOR_EDIT3, MB_VISUALISE, MB_VISUALISE_RECURSIVELY, 
+       MB_SEPARATOR_EDIT4, MB_SORT_CHILDREN, MB_SORT_CHILDREN_RECURSIVELY, NUMBER_OF_EDIT_MENU_ITEMS };
 
 #endif
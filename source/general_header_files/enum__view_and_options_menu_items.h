@@ -4,6 +4,6 @@
 enum { SHOW_MENU_ID_COL, SHOW_EXECUTE_COL, SHOW_ELEMENT_VISIBILITY_COL_ACT, SHOW_ELEMENT_VISIBILITY_COL_KEEP_HIGHL, 
        SHOW_ELEMENT_VISIBILITY_COL_DONT_KEEP_HIGHL, SHOW_ICONS, SHOW_SEP_IN_BOLD_TYPE, DRAW_ROWS_IN_ALT_COLOURS, 
        SHOW_TREE_LINES, NO_GRID_LINES, SHOW_GRID_HOR, SHOW_GRID_VER, BOTH, SORT_EXECUTE_AND_STARTUPN_OPTIONS, 
-       NOTIFY_ABOUT_EXECUTE_OPT_CONVERSIONS, NUMBER_OF_VIEW_AND_OPTIONS };
+       NOTIFY_ABOUT_EXECUTE_OPT_CONVERSIONS, SYNC_MENU_FILE_TO_DISK, NUMBER_OF_VIEW_AND_OPTIONS };
 
 #endif
@@ -0,0 +1,12 @@
+#ifndef __struct__match_record_h
+#define __struct__match_record_h
+
+#define ICON_PATH_RANGES COL_ELEMENT_VISIBILITY // Only structured queries with an icon field fill this element.
+
+struct match_record {
+  GtkTreePath *path;
+  guint8 matching_columns; // One bit for each column that contains at least one match.
+  GArray *ranges[ICON_PATH_RANGES + 1]; // Start and end byte offsets of all matches inside a column or the icon path.
+};
+
+#endif
@@ -0,0 +1,200 @@
+/*
+   Kickshaw - A Menu Editor for Openbox
+
+   Copyright (c) 2010-2013        Marcus Schaetzle
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along 
+   with Kickshaw. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <gtk/gtk.h>
+
+#include "idle_jobs.h"
+
+// Work time in microseconds a job may take up within one iteration of the main loop.
+#define JOB_TIME_SLICE 8000
+
+struct idle_job {
+  GSourceFunc step; // Processes one unit of work, returns FALSE if there is nothing left to do.
+  GFunc finish; // Called with the job data and GUINT_TO_POINTER (cancelled) after the last step or a cancellation.
+  gpointer job_data;
+  guint number_of_steps;
+  guint steps_done;
+  guint source_id;
+};
+
+static struct idle_job *running_job = NULL;
+
+static void end_idle_job (gboolean cancelled);
+static gboolean run_job_slice (void);
+void start_idle_job (gchar *description, guint number_of_steps, GSourceFunc step, GFunc finish, gpointer job_data);
+void cancel_idle_job (void);
+gboolean get_next_row_in_preorder (GtkTreeModel *local_model, GtkTreeIter *local_iter, gint root_depth, 
+				   gboolean descend);
+guint count_rows_of_subtree (GtkTreeIter *parent_iter);
+
+/* 
+
+   Hides the progress indicator, lets the job clean up and releases it. 
+
+*/
+
+static void end_idle_job (gboolean cancelled)
+{
+  struct idle_job *job = running_job;
+
+  if (!job)
+    return;
+
+  // The job is detached first, so its finish function may start a new one.
+  running_job = NULL;
+  if (job->source_id)
+    g_source_remove (job->source_id);
+
+  gtk_widget_hide (job_progress_bar);
+  gtk_widget_hide (job_cancel_button);
+
+  job->finish (job->job_data, GUINT_TO_POINTER (cancelled));
+
+  // Cleanup
+  g_free (job);
+}
+
+/* 
+
+   Runs steps of the current job until it is done or its time slice is used up. 
+   Drawing and user input are handled by the main loop in between two slices. 
+
+*/
+
+static gboolean run_job_slice (void)
+{
+  gint64 end_of_slice = g_get_monotonic_time () + JOB_TIME_SLICE;
+  gboolean steps_left;
+
+  do {
+    steps_left = running_job->step (running_job->job_data);
+    running_job->steps_done++;
+  } while (steps_left && g_get_monotonic_time () < end_of_slice);
+
+  if (!steps_left) {
+    running_job->source_id = 0; // The idle source is removed by returning FALSE.
+    end_idle_job (FALSE);
+
+    return FALSE;
+  }
+
+  gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (job_progress_bar), 
+				 MIN ((gdouble) running_job->steps_done / MAX (running_job->number_of_steps, 1), 1.0));
+
+  return TRUE;
+}
+
+/* 
+
+   Starts a job that is processed step by step while the program stays responsive. 
+   A job that is still running is cancelled first. The first slice is run immediately, 
+   so small jobs are finished before this function returns and the progress indicator isn't shown at all. 
+   number_of_steps is only used to display the progress. 
+
+*/
+
+void start_idle_job (gchar       *description, 
+		     guint        number_of_steps, 
+		     GSourceFunc  step, 
+		     GFunc        finish, 
+		     gpointer     job_data)
+{
+  cancel_idle_job ();
+
+  running_job = g_new0 (struct idle_job, 1);
+  running_job->step = step;
+  running_job->finish = finish;
+  running_job->job_data = job_data;
+  running_job->number_of_steps = number_of_steps;
+
+  if (!run_job_slice ())
+    return;
+
+  gtk_progress_bar_set_text (GTK_PROGRESS_BAR (job_progress_bar), description);
+  gtk_widget_show (job_progress_bar);
+  gtk_widget_show (job_cancel_button);
+
+  // Lower priority than redrawing and event handling.
+  running_job->source_id = g_idle_add ((GSourceFunc) run_job_slice, NULL);
+}
+
+/* 
+
+   Stops the current job, if there is one. The rows that have been processed so far keep their changes. 
+
+*/
+
+void cancel_idle_job (void)
+{
+  end_idle_job (TRUE);
+}
+
+/* 
+
+   Moves the iter to the next row in the order in which the rows are displayed if all nodes are expanded. 
+   If descend is FALSE, the children of the current row are skipped. 
+   Rows that are not deeper than root_depth are never left, so a root_depth of -1 walks through the whole tree. 
+   Returns FALSE if there is no next row. 
+
+*/
+
+gboolean get_next_row_in_preorder (GtkTreeModel *local_model, 
+				   GtkTreeIter  *local_iter, 
+				   gint          root_depth, 
+				   gboolean      descend)
+{
+  GtkTreeIter child_iter, parent_iter;
+
+  if (descend && gtk_tree_model_iter_children (local_model, &child_iter, local_iter)) {
+    *local_iter = child_iter;
+
+    return TRUE;
+  }
+
+  while (gtk_tree_store_iter_depth (GTK_TREE_STORE (local_model), local_iter) > root_depth) {
+    child_iter = *local_iter; // (Note: gtk_tree_model_iter_next invalidates the iter if there is no next sibling.)
+    if (gtk_tree_model_iter_next (local_model, local_iter))
+      return TRUE;
+    if (!gtk_tree_model_iter_parent (local_model, &parent_iter, &child_iter))
+      return FALSE;
+    *local_iter = parent_iter;
+  }
+
+  return FALSE;
+}
+
+/* 
+
+   Counts all descendants of a row, or all rows of the tree if parent_iter is NULL. 
+
+*/
+
+guint count_rows_of_subtree (GtkTreeIter *parent_iter)
+{
+  GtkTreeIter iter_loop;
+  guint number_of_rows = 0;
+  gboolean valid = gtk_tree_model_iter_children (model, &iter_loop, parent_iter);
+
+  while (valid) {
+    number_of_rows += 1 + count_rows_of_subtree (&iter_loop);
+    valid = gtk_tree_model_iter_next (model, &iter_loop);
+  }
+
+  return number_of_rows;
+}
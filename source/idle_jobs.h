@@ -0,0 +1,28 @@
+/*
+   Kickshaw - A Menu Editor for Openbox
+
+   Copyright (c) 2010-2013        Marcus Schaetzle
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along 
+   with Kickshaw. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef __idle_jobs_h
+#define __idle_jobs_h
+
+extern GtkTreeStore *treestore;
+extern GtkTreeModel *model;
+
+extern GtkWidget *job_progress_bar, *job_cancel_button;
+
+#endif
@@ -0,0 +1,647 @@
+/*
+   Kickshaw - A Menu Editor for Openbox
+
+   Copyright (c) 2010-2013        Marcus Schaetzle
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along 
+   with Kickshaw. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <gtk/gtk.h>
+#include <glib/gstdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "general_header_files/enum__invalid_icon_imgs.h"
+#include "general_header_files/enum__invalid_icon_imgs_status.h"
+#include "general_header_files/enum__ts_elements.h"
+#include "journal.h"
+
+/* 
+   The journal is a binary file next to the menu file that records every change of the treestore 
+   since the menu file has been loaded or saved, so unsaved changes can be restored after a crash. 
+   It starts with a header that identifies the version of the menu file it refers to, followed by the records. 
+   Each record consists of its type and the path of the changed row; inserted and changed rows also contain 
+   all values of the row, reorderings the new order of the children.
+*/
+#define JOURNAL_MAGIC "KSJ1"
+#define JOURNAL_HEADER_SIZE (sizeof (JOURNAL_MAGIC) - 1 + 2 * sizeof (gint64))
+
+enum { JOURNAL_ROW_INSERTED, JOURNAL_ROW_CHANGED, JOURNAL_ROW_DELETED, JOURNAL_ROWS_REORDERED, 
+       JOURNAL_ALL_ROWS_REMOVED };
+// Enumeration for the dialog.
+enum { RESTORE = 1, DISCARD };
+
+// = -1 if there is no journal, e.g. for a new menu that hasn't been saved yet.
+static gint journal_file_descriptor = -1;
+static gchar *journal_filename = NULL;
+static gsize journal_size = 0;
+
+struct journal_reader {
+  const gchar *position;
+  const gchar *end;
+};
+
+static gchar *get_journal_filename (const gchar *menu_filename);
+static void append_header (GString *journal_buffer);
+static void append_path (GString *journal_buffer, GtkTreePath *path);
+static void write_to_journal (GString *journal_buffer);
+static void write_journal_file (GString *journal_buffer);
+static void write_record (guint8 record_type, GtkTreeModel *local_model, GtkTreePath *local_path, 
+			  GtkTreeIter *local_iter);
+void journal_row_inserted (GtkTreeModel *local_model, GtkTreePath *local_path, GtkTreeIter *local_iter);
+void journal_row_changed (GtkTreeModel *local_model, GtkTreePath *local_path, GtkTreeIter *local_iter);
+void journal_row_deleted (GtkTreeModel *local_model, GtkTreePath *local_path);
+void journal_rows_reordered (GtkTreeModel *local_model, GtkTreePath *local_path, GtkTreeIter *local_iter, 
+			     gint *new_order);
+static gboolean append_row_to_journal_buffer (GtkTreeModel *local_model, GtkTreePath *local_path, 
+					      GtkTreeIter *local_iter, GString *journal_buffer);
+static GtkTreePath *read_path (struct journal_reader *reader);
+static gboolean replay_row_values (struct journal_reader *reader, GtkTreeIter *row_iter);
+static gboolean replay_reordering (struct journal_reader *reader, GtkTreePath *parent_path);
+static gboolean replay_record (struct journal_reader *reader);
+void open_journal (void);
+gsize get_journal_size (void);
+void journal_menu_saved (gsize saved_journal_size);
+void rebase_journal (void);
+void close_journal (void);
+
+/* 
+
+   Returns the file name of the journal for a menu file, which is a hidden file inside the same folder.
+
+*/
+
+static gchar *get_journal_filename (const gchar *menu_filename)
+{
+  gchar *menu_folder = g_path_get_dirname (menu_filename);
+  gchar *menu_basename = g_path_get_basename (menu_filename);
+  gchar *new_journal_filename = g_strdup_printf ("%s/.%s.kickshaw-journal", menu_folder, menu_basename);
+
+  // Cleanup
+  g_free (menu_folder);
+  g_free (menu_basename);
+
+  return new_journal_filename;
+}
+
+/* 
+
+   Appends the header of the journal, which contains the size and the modification time of the menu file, 
+   so a journal that belongs to another version of the menu file isn't replayed.
+
+*/
+
+static void append_header (GString *journal_buffer)
+{
+  GStatBuf menu_file_status;
+  gint64 menu_file_identification[2] = { -1, -1 };
+
+  if (g_stat (filename, &menu_file_status) == 0) {
+    menu_file_identification[0] = menu_file_status.st_size;
+    menu_file_identification[1] = menu_file_status.st_mtime;
+  }
+
+  g_string_append (journal_buffer, JOURNAL_MAGIC);
+  g_string_append_len (journal_buffer, (gchar *) menu_file_identification, sizeof (menu_file_identification));
+}
+
+/* 
+
+   Appends a path to a record, consisting of its depth and its indices.
+
+*/
+
+static void append_path (GString     *journal_buffer, 
+			 GtkTreePath *path)
+{
+  gint path_depth;
+  gint *indices = gtk_tree_path_get_indices_with_depth (path, &path_depth);
+  gint indices_cnt;
+
+  append_int_to_buffer (journal_buffer, path_depth);
+  for (indices_cnt = 0; indices_cnt < path_depth; indices_cnt++)
+    append_int_to_buffer (journal_buffer, indices[indices_cnt]);
+}
+
+/* 
+
+   Appends data to the journal file. The data isn't synchronised to disk, 
+   the journal only has to survive a crash of the program or the X session, which the kernel takes care of.
+
+*/
+
+static void write_to_journal (GString *journal_buffer)
+{
+  gsize written_bytes = 0;
+  gssize write_result;
+
+  while (written_bytes < journal_buffer->len) {
+    if ((write_result = write (journal_file_descriptor, journal_buffer->str + written_bytes, 
+			       journal_buffer->len - written_bytes)) == -1) {
+      if (errno == EINTR)
+	continue;
+      break;
+    }
+    written_bytes += write_result;
+  }
+
+  journal_size += written_bytes;
+
+  // A journal with missing records would restore a wrong menu, so journaling is stopped.
+  if (written_bytes < journal_buffer->len) {
+    close (journal_file_descriptor);
+    journal_file_descriptor = -1;
+    g_unlink (journal_filename);
+    show_msg_in_statusbar ("The journal for crash recovery could not be written, it has been deactivated.");
+  }
+}
+
+/* 
+
+   (Re)creates the journal file of the current menu file with the given content and keeps it open for appending.
+
+*/
+
+static void write_journal_file (GString *journal_buffer)
+{
+  gchar *new_journal_filename = get_journal_filename (filename);
+
+  if (journal_file_descriptor != -1)
+    close (journal_file_descriptor);
+  // After a "Save as" the journal refers to the new menu file.
+  if (journal_filename && !streq (journal_filename, new_journal_filename))
+    g_unlink (journal_filename);
+  free_and_reassign (journal_filename, new_journal_filename);
+
+  journal_size = 0;
+  if ((journal_file_descriptor = g_open (journal_filename, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0600)) != -1)
+    write_to_journal (journal_buffer);
+}
+
+/* 
+
+   Writes a record for a change of the treestore.
+
+*/
+
+static void write_record (guint8        record_type, 
+			  GtkTreeModel *local_model, 
+			  GtkTreePath  *local_path, 
+			  GtkTreeIter  *local_iter)
+{
+  GString *record = g_string_sized_new (256);
+
+  g_string_append_c (record, record_type);
+  append_path (record, local_path);
+  if (record_type == JOURNAL_ROW_INSERTED || record_type == JOURNAL_ROW_CHANGED)
+    append_row_values_to_buffer (record, local_model, local_iter);
+
+  write_to_journal (record);
+
+  // Cleanup
+  g_string_free (record, TRUE);
+}
+
+/* 
+
+   Records an inserted row. Since rows may be inserted together with their values, these are recorded, too.
+
+*/
+
+void journal_row_inserted (GtkTreeModel *local_model, 
+			   GtkTreePath  *local_path, 
+			   GtkTreeIter  *local_iter)
+{
+  if (journal_file_descriptor != -1)
+    write_record (JOURNAL_ROW_INSERTED, local_model, local_path, local_iter);
+}
+
+/* 
+
+   Records a changed row.
+
+*/
+
+void journal_row_changed (GtkTreeModel *local_model, 
+			  GtkTreePath  *local_path, 
+			  GtkTreeIter  *local_iter)
+{
+  if (journal_file_descriptor != -1)
+    write_record (JOURNAL_ROW_CHANGED, local_model, local_path, local_iter);
+}
+
+/* 
+
+   Records a deleted row.
+
+*/
+
+void journal_row_deleted (GtkTreeModel *local_model, 
+			  GtkTreePath  *local_path)
+{
+  if (journal_file_descriptor != -1)
+    write_record (JOURNAL_ROW_DELETED, local_model, local_path, NULL);
+}
+
+/* 
+
+   Records reordered children, e.g. after moving or sorting rows.
+
+*/
+
+void journal_rows_reordered (GtkTreeModel *local_model, 
+			     GtkTreePath  *local_path, 
+			     GtkTreeIter  *local_iter, 
+			     gint         *new_order)
+{
+  if (journal_file_descriptor == -1)
+    return;
+
+  GString *record = g_string_new (NULL);
+  gint number_of_children = gtk_tree_model_iter_n_children (local_model, local_iter);
+  gint children_cnt;
+
+  g_string_append_c (record, JOURNAL_ROWS_REORDERED);
+  append_path (record, local_path);
+  append_int_to_buffer (record, number_of_children);
+  for (children_cnt = 0; children_cnt < number_of_children; children_cnt++)
+    append_int_to_buffer (record, new_order[children_cnt]);
+
+  write_to_journal (record);
+
+  // Cleanup
+  g_string_free (record, TRUE);
+}
+
+/* 
+
+   Appends a record that inserts a row; used for recording the whole menu.
+
+*/
+
+static gboolean append_row_to_journal_buffer (GtkTreeModel *local_model, 
+					      GtkTreePath  *local_path, 
+					      GtkTreeIter  *local_iter, 
+					      GString      *journal_buffer)
+{
+  g_string_append_c (journal_buffer, JOURNAL_ROW_INSERTED);
+  append_path (journal_buffer, local_path);
+  append_row_values_to_buffer (journal_buffer, local_model, local_iter);
+
+  return FALSE;
+}
+
+/* 
+
+   Reads a path of a record. Returns NULL if the record is incomplete.
+
+*/
+
+static GtkTreePath *read_path (struct journal_reader *reader)
+{
+  GtkTreePath *path;
+  gint32 path_depth, index;
+
+  if (!read_int_from_buffer (&reader->position, reader->end, &path_depth) || path_depth < 0)
+    return NULL;
+
+  path = gtk_tree_path_new ();
+  while (path_depth--) {
+    if (!read_int_from_buffer (&reader->position, reader->end, &index) || index < 0) {
+      // Cleanup
+      gtk_tree_path_free (path);
+
+      return NULL;
+    }
+    gtk_tree_path_append_index (path, index);
+  }
+
+  return path;
+}
+
+/* 
+
+   Sets the recorded values of a row. The icon image is recreated from the icon path if the icon has changed.
+
+*/
+
+static gboolean replay_row_values (struct journal_reader *reader, 
+				   GtkTreeIter           *row_iter)
+{
+  gint columns[NUMBER_OF_TS_ELEMENTS];
+  G_GNUC_EXTENSION GValue values[NUMBER_OF_TS_ELEMENTS] = { [0 ... NUMBER_OF_TS_ELEMENTS - 1] = G_VALUE_INIT };
+  gchar *txt_values[NUMBER_OF_TS_ELEMENTS] = { NULL };
+  gint number_of_values = 0;
+  guint icon_img_status;
+
+  guint old_icon_img_status;
+  gchar *old_icon_path, *icon_path;
+  gint values_cnt;
+
+  if (!read_row_values_from_buffer (&reader->position, reader->end, &icon_img_status, txt_values))
+    return FALSE;
+
+  columns[number_of_values] = TS_ICON_IMG_STATUS;
+  g_value_init (&values[number_of_values], G_TYPE_UINT);
+  g_value_set_uint (&values[number_of_values++], icon_img_status);
+
+  for (gint ts_elements_cnt = TS_ICON_MODIFIED; ts_elements_cnt < NUMBER_OF_TS_ELEMENTS; ts_elements_cnt++) {
+    columns[number_of_values] = ts_elements_cnt;
+    g_value_init (&values[number_of_values], G_TYPE_STRING);
+    g_value_take_string (&values[number_of_values++], txt_values[ts_elements_cnt]);
+  }
+
+  gtk_tree_model_get (model, row_iter, 
+		      TS_ICON_IMG_STATUS, &old_icon_img_status, 
+		      TS_ICON_PATH, &old_icon_path, 
+		      -1);
+
+  gtk_tree_store_set_valuesv (treestore, row_iter, columns, values, number_of_values);
+
+  gtk_tree_model_get (model, row_iter, TS_ICON_PATH, &icon_path, -1);
+  if (!icon_path)
+    gtk_tree_store_set (treestore, row_iter, TS_ICON_IMG, NULL, -1);
+  else if (!streq (icon_path, old_icon_path) || icon_img_status != old_icon_img_status) {
+    if (icon_img_status != NONE_OR_NORMAL || !set_icon (icon_path, row_iter, TRUE)) {
+      icon_img_status = (g_file_test (icon_path, G_FILE_TEST_EXISTS)) ? INVALID_FILE : INVALID_PATH;
+      gtk_tree_store_set (treestore, row_iter, 
+			  TS_ICON_IMG, invalid_icon_imgs[(icon_img_status == INVALID_PATH) ? 
+							 INVALID_PATH_ICON : INVALID_FILE_ICON], 
+			  TS_ICON_IMG_STATUS, icon_img_status, 
+			  -1);
+    }
+  }
+
+  // Cleanup
+  g_free (old_icon_path);
+  g_free (icon_path);
+  for (values_cnt = 0; values_cnt < number_of_values; values_cnt++)
+    g_value_unset (&values[values_cnt]);
+
+  return TRUE;
+}
+
+/* 
+
+   Reorders the children of a row as recorded.
+
+*/
+
+static gboolean replay_reordering (struct journal_reader *reader, 
+				   GtkTreePath           *parent_path)
+{
+  GtkTreeIter parent_iter;
+  gboolean toplevel = (gtk_tree_path_get_depth (parent_path) == 0);
+  gint32 number_of_children, children_cnt;
+  gint *new_order;
+  gboolean record_valid = TRUE;
+
+  if (!read_int_from_buffer (&reader->position, reader->end, &number_of_children) || 
+      (!toplevel && !gtk_tree_model_get_iter (model, &parent_iter, parent_path)) || 
+      number_of_children != gtk_tree_model_iter_n_children (model, (toplevel) ? NULL : &parent_iter))
+    return FALSE;
+
+  new_order = g_new (gint, number_of_children);
+  for (children_cnt = 0; children_cnt < number_of_children; children_cnt++) {
+    if (!read_int_from_buffer (&reader->position, reader->end, &new_order[children_cnt]) || 
+	new_order[children_cnt] < 0 || new_order[children_cnt] >= number_of_children) {
+      record_valid = FALSE;
+      break;
+    }
+  }
+
+  if (record_valid && number_of_children > 0)
+    gtk_tree_store_reorder (treestore, (toplevel) ? NULL : &parent_iter, new_order);
+
+  // Cleanup
+  g_free (new_order);
+
+  return record_valid;
+}
+
+/* 
+
+   Replays a single record. Returns FALSE if the record is incomplete or doesn't fit the current menu.
+
+*/
+
+static gboolean replay_record (struct journal_reader *reader)
+{
+  guint8 record_type;
+  GtkTreePath *path;
+  GtkTreeIter record_iter, parent_iter;
+  gint path_depth, position;
+  gboolean record_valid = FALSE;
+
+  if (reader->position >= reader->end)
+    return FALSE;
+  record_type = *(reader->position++);
+
+  if (record_type == JOURNAL_ALL_ROWS_REMOVED) {
+    gtk_tree_store_clear (treestore);
+
+    return TRUE;
+  }
+
+  if (!(path = read_path (reader)))
+    return FALSE;
+
+  path_depth = gtk_tree_path_get_depth (path);
+
+  if (record_type == JOURNAL_ROW_INSERTED && path_depth > 0) {
+    position = gtk_tree_path_get_indices (path)[path_depth - 1];
+    gtk_tree_path_up (path);
+    if (path_depth == 1 || gtk_tree_model_get_iter (model, &parent_iter, path)) {
+      gtk_tree_store_insert (treestore, &record_iter, (path_depth == 1) ? NULL : &parent_iter, position);
+      if (!(record_valid = replay_row_values (reader, &record_iter)))
+	gtk_tree_store_remove (treestore, &record_iter);
+    }
+  }
+  else if (record_type == JOURNAL_ROW_CHANGED)
+    record_valid = gtk_tree_model_get_iter (model, &record_iter, path) && replay_row_values (reader, &record_iter);
+  else if (record_type == JOURNAL_ROW_DELETED) {
+    if ((record_valid = gtk_tree_model_get_iter (model, &record_iter, path)))
+      gtk_tree_store_remove (treestore, &record_iter);
+  }
+  else if (record_type == JOURNAL_ROWS_REORDERED)
+    record_valid = replay_reordering (reader, path);
+
+  // Cleanup
+  gtk_tree_path_free (path);
+
+  return record_valid;
+}
+
+/* 
+
+   Opens the journal of a menu file that has just been loaded. 
+   If the journal contains changes of this version of the menu file that haven't been saved, 
+   the user is asked whether they should be restored.
+
+*/
+
+void open_journal (void)
+{
+  GString *journal_buffer = g_string_new (NULL);
+  gchar *journal_content;
+  gsize journal_content_size;
+  guint replayed_records_cnt = 0;
+
+  free_and_reassign (journal_filename, get_journal_filename (filename));
+  append_header (journal_buffer);
+
+  if (g_file_get_contents (journal_filename, &journal_content, &journal_content_size, NULL)) {
+    if (journal_content_size > JOURNAL_HEADER_SIZE && 
+	memcmp (journal_content, journal_buffer->str, JOURNAL_HEADER_SIZE) == 0) {
+      GtkWidget *dialog;
+      gint result;
+
+      create_dialog (&dialog, "Unsaved changes found", GTK_STOCK_DIALOG_QUESTION, "Restore", "Discard", NULL, 
+		     "This menu has changes that have not been saved, "
+		     "probably because the program or the system has crashed.\n"
+		     "Should these changes be restored?", TRUE);
+
+      result = gtk_dialog_run (GTK_DIALOG (dialog));
+      gtk_widget_destroy (dialog);
+
+      if (result == RESTORE) {
+	GtkTreeSelection *selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview));
+	struct journal_reader reader = { journal_content + JOURNAL_HEADER_SIZE, journal_content + journal_content_size };
+	const gchar *replayed_end = reader.position;
+
+	g_signal_handler_block (selection, handler_id_row_selected);
+	while (replay_record (&reader)) {
+	  replayed_end = reader.position;
+	  replayed_records_cnt++;
+	}
+	g_signal_handler_unblock (selection, handler_id_row_selected);
+
+	// The replayed records are kept, an incomplete record at the end and everything after it is discarded.
+	g_string_append_len (journal_buffer, journal_content + JOURNAL_HEADER_SIZE, 
+			     replayed_end - (journal_content + JOURNAL_HEADER_SIZE));
+      }
+    }
+
+    // Cleanup
+    g_free (journal_content);
+  }
+
+  write_journal_file (journal_buffer);
+
+  // Cleanup
+  g_string_free (journal_buffer, TRUE);
+
+  if (replayed_records_cnt) {
+    gchar *statusbar_msg = g_strdup_printf ("%u unsaved change%s restored.", 
+					    replayed_records_cnt, (replayed_records_cnt == 1) ? "" : "s");
+
+    rebuild_menu_ids ();
+    activate_change_done ();
+    gtk_tree_view_columns_autosize (GTK_TREE_VIEW (treeview));
+    show_msg_in_statusbar (statusbar_msg);
+
+    // Cleanup
+    g_free (statusbar_msg);
+  }
+}
+
+/* 
+
+   Returns the current size of the journal; the records up to this size are part of a menu that is being saved.
+
+*/
+
+gsize get_journal_size (void)
+{
+  return journal_size;
+}
+
+/* 
+
+   Removes the records that are part of the saved menu from the journal after the menu has been saved. 
+   Changes done while the menu was being saved are kept.
+
+*/
+
+void journal_menu_saved (gsize saved_journal_size)
+{
+  GString *journal_buffer = g_string_new (NULL);
+  gchar *journal_content;
+  gsize journal_content_size;
+
+  append_header (journal_buffer);
+
+  if (journal_file_descriptor != -1 && saved_journal_size >= JOURNAL_HEADER_SIZE && 
+      saved_journal_size < journal_size && 
+      g_file_get_contents (journal_filename, &journal_content, &journal_content_size, NULL)) {
+    if (journal_content_size == journal_size)
+      g_string_append_len (journal_buffer, journal_content + saved_journal_size, journal_size - saved_journal_size);
+
+    // Cleanup
+    g_free (journal_content);
+  }
+
+  write_journal_file (journal_buffer);
+
+  // Cleanup
+  g_string_free (journal_buffer, TRUE);
+}
+
+/* 
+
+   Lets the journal refer to the current version of the menu file after it has been changed by another program. 
+   Unsaved changes can't be expressed as changes of the new version, so the whole menu is recorded then.
+
+*/
+
+void rebase_journal (void)
+{
+  if (!filename)
+    return;
+
+  GString *journal_buffer = g_string_new (NULL);
+
+  append_header (journal_buffer);
+  if (change_done) {
+    g_string_append_c (journal_buffer, JOURNAL_ALL_ROWS_REMOVED);
+    gtk_tree_model_foreach (model, (GtkTreeModelForeachFunc) append_row_to_journal_buffer, journal_buffer);
+  }
+
+  write_journal_file (journal_buffer);
+
+  // Cleanup
+  g_string_free (journal_buffer, TRUE);
+}
+
+/* 
+
+   Closes and removes the journal if the menu is closed and its unsaved changes are discarded deliberately.
+
+*/
+
+void close_journal (void)
+{
+  if (journal_file_descriptor != -1) {
+    close (journal_file_descriptor);
+    journal_file_descriptor = -1;
+  }
+  if (journal_filename) {
+    g_unlink (journal_filename);
+    free_and_reassign (journal_filename, NULL);
+  }
+  journal_size = 0;
+}
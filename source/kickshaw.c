@@ -61,6 +61,7 @@ GtkTreeStore *treestore;
 GtkTreeModel *model;
 
 GtkWidget *treeview;
+GtkWidget *matches_treeview, *matches_scrolled_window;
 GtkTreeViewColumn *columns[NUMBER_OF_COLUMNS];
 enum { TXT_RENDERER, EXCL_TXT_RENDERER, PIXBUF_RENDERER, BOOL_RENDERER, NUMBER_OF_RENDERERS };
 GtkCellRenderer *renderer[NUMBER_OF_RENDERERS];
@@ -70,7 +71,7 @@ GtkTreeIter iter;
 
  // = automatically NULL
 GSList *menu_ids;
-GSList *rows_with_icons;
+GList *rows_with_icons;
 
 GdkPixbuf *invalid_icon_imgs[2]; // = automatically NULL
 
@@ -78,7 +79,7 @@ GtkWidget *mb_file_menu_items[NUMBER_OF_FILE_MENU_ITEMS];
 GtkWidget *mb_edit;
 GtkWidget *mb_edit_menu_items[NUMBER_OF_EDIT_MENU_ITEMS];
 GtkWidget *mb_search;
-GtkWidget *mb_expand_all_nodes, *mb_collapse_all_nodes;
+GtkWidget *mb_expand_all_nodes, *mb_collapse_all_nodes, *mb_expand_selected_subtrees, *mb_expand_to_depth;
 GtkWidget *mb_options;
 
 GtkWidget *mb_view_and_options[NUMBER_OF_VIEW_AND_OPTIONS];
@@ -105,9 +106,11 @@ GtkWidget *find_grid;
 GtkWidget *find_button_entry_row[NUMBER_OF_FIND_ENTRY_ROW_BUTTONS];
 GtkWidget *find_entry;
 GtkWidget *find_in_columns[NUMBER_OF_COLUMNS - 1], *find_in_all_columns;
-GtkWidget *find_match_case, *find_regular_expression; 
+GtkWidget *find_match_case, *find_regular_expression, *find_structured_query; 
+GtkWidget *find_matches_only;
+GtkWidget *find_replace_entry, *find_replace_button, *find_replace_all_button;
 const gchar *search_term_str = "";
-GList *rows_with_found_occurrences; // = automatically NULL
+GArray *rows_with_found_occurrences; // = automatically NULL
 
 GtkWidget *entry_grid;
 GtkWidget *entry_labels[NUMBER_OF_ENTRY_FIELDS], *entry_fields[NUMBER_OF_ENTRY_FIELDS];
@@ -116,6 +119,7 @@ GtkWidget *icon_chooser, *remove_icon;
 GSList *source_paths; // = automatically NULL
 
 GtkWidget *statusbar;
+GtkWidget *job_progress_bar, *job_cancel_button;
 
 guint font_size;
 
@@ -127,6 +131,19 @@ gint handler_id_row_selected, handler_id_action_option_combo_box,
   handler_id_action_option_button_clicked, handler_id_show_startupnotify_options;
 gint handler_id_find_in_columns[NUMBER_OF_COLUMNS];
 
+// Expanding or collapsing all nodes, processed row by row as an idle job.
+struct expansion_job {
+  gboolean expand;
+  GtkTreeRowReference *next_row;
+};
+
+static struct expansion_job *running_expansion_job = NULL;
+
+// Depths offered by "Expand to depth"; a depth of 1 corresponds to "Collapse all nodes".
+#define MIN_EXPANSION_DEPTH 2
+#define MAX_EXPANSION_DEPTH 6
+
+static void handle_event (GdkEvent *event);
 static void general_initialisiation (void);
 static void add_button_content (GtkWidget *button, gchar *label_text);
 void show_errmsg (gchar *errmsg_raw_txt);
@@ -145,12 +162,17 @@ gboolean check_if_invisible_descendant_exists (GtkTreeModel *filter_model, GtkTr
 					       GtkTreeIter *filter_iter, 
 					       gboolean *at_least_one_descendant_is_invisible);
 gchar *check_if_invisible_ancestor_exists (GtkTreeModel *local_model, GtkTreePath *path);
-static gboolean evaluate_match (const GMatchInfo *match_info, GString *result, gpointer data);
 static void set_column_attributes (GtkTreeViewColumn G_GNUC_UNUSED *cell_column, GtkCellRenderer *txt_renderer,
 				   GtkTreeModel *cell_model, GtkTreeIter *cell_iter, gpointer column_number_pointer);
 void change_view_and_options (gpointer activated_menu_item_pointer);
 void clear_global_static_data (void);
+static gboolean expand_or_collapse_next_row (struct expansion_job *job);
+static void expansion_job_finished (struct expansion_job *job, gpointer G_GNUC_UNUSED cancelled_pointer);
 static void expand_or_collapse_all (gpointer expand_pointer);
+void begin_batch_expansion (void);
+void end_batch_expansion (void);
+static void expand_to_depth (gpointer depth_pointer);
+static void expand_selected_subtrees (void);
 static void about (void);
 gboolean unsaved_changes (void);
 void new_menu (void);
@@ -203,9 +225,30 @@ int main (int argc, char *argv[])
 
   gtk_init (&argc, &argv);
 
+  gdk_event_handler_set ((GdkEventFunc) handle_event, NULL, NULL);
   general_initialisiation ();
 
   gtk_main ();
+
+  // If the window has been closed while there were unsaved changes, these can be restored at the next start.
+  if (!change_done)
+    close_journal ();
+}
+
+/* 
+
+   Passes all events on to GTK. Since the handlers of key presses, menu items, buttons and drags 
+   use the data of the selected rows, a change of the selection whose processing is still pending 
+   is processed before such an event.
+
+*/
+
+static void handle_event (GdkEvent *event)
+{
+  if (event->type == GDK_KEY_PRESS || event->type == GDK_BUTTON_PRESS || event->type == GDK_BUTTON_RELEASE)
+    process_pending_selection_change ();
+
+  gtk_main_do_event (event);
 }
 
 /* 
@@ -222,8 +265,9 @@ static void general_initialisiation (void)
   GSList *element_visibility_menu_item_group = NULL, *grid_menu_item_group = NULL;
   GtkWidget *mb_file, *mb_filemenu, 
     *mb_editmenu,
-    *mb_searchmenu, *mb_find, 
-    *mb_view, *mb_viewmenu, *mb_show_element_visibility_column, *mb_show_element_visibility_column_submenu, 
+    *mb_searchmenu, *mb_find, *mb_quick_jump, 
+    *mb_view, *mb_viewmenu, *mb_expand_to_depth_submenu, *mb_expand_to_depth_level, 
+    *mb_show_element_visibility_column, *mb_show_element_visibility_column_submenu, 
     *mb_show_grid, *mb_show_grid_submenu, 
     *mb_optionsmenu,
     *mb_help, *mb_helpmenu, *mb_about;
@@ -236,6 +280,7 @@ static void general_initialisiation (void)
   gchar *visibility_txts[] = { "Show Element Visibility column", "Keep highlighting", "Don't keep highlighting"};
   gchar *grid_txts[] = { "No grid lines", "Horizontal", "Vertical", "Both" };
   guint8 txts_cnt;
+  guint8 depth_cnt;
 
   GtkWidget *toolbar;
   gchar *button_IDs[] = { GTK_STOCK_NEW, GTK_STOCK_OPEN, GTK_STOCK_SAVE, GTK_STOCK_SAVE_AS, GTK_STOCK_GO_UP, 
@@ -252,11 +297,13 @@ static void general_initialisiation (void)
   
   gchar *find_buttons[] = { GTK_STOCK_CLOSE, GTK_STOCK_GO_BACK, GTK_STOCK_GO_FORWARD };
   gchar *find_buttons_tooltips[] = { "Close", "Back", "Forward" };
-  GtkWidget *find_entry_row, *find_buttons_row, *find_special_options_row;
+  GtkWidget *find_entry_row, *find_buttons_row, *find_special_options_row, *find_replace_row;
   GtkWidget *find_button_entry_row_image[NUMBER_OF_FIND_ENTRY_ROW_BUTTONS];
   
   GtkWidget *scrolled_window;
   GtkTreeSelection *selection;
+  GtkCellRenderer *matches_renderer;
+  GtkTreeViewColumn *matches_column;
 
   GtkCellRenderer *action_option_combo_box_renderer;
   GtkWidget *action_option_cancel;
@@ -268,6 +315,7 @@ static void general_initialisiation (void)
   GKeyFile *settings_file = g_key_file_new ();
   GError *settings_file_error = NULL;
   gchar *settings_file_path;
+  const gchar *settings_group, *settings_key;
 
   gchar *new_filename;
 
@@ -305,6 +353,7 @@ static void general_initialisiation (void)
   mb_helpmenu = gtk_menu_new ();
 
   // Submenus
+  mb_expand_to_depth_submenu = gtk_menu_new ();
   mb_show_element_visibility_column_submenu = gtk_menu_new ();
   mb_show_grid_submenu = gtk_menu_new ();
 
@@ -321,6 +370,7 @@ static void general_initialisiation (void)
   gtk_accelerator_parse ("<Shift><Ctl>S", &accel_key, &accel_mod);
   gtk_widget_add_accelerator (mb_file_menu_items[MB_SAVE_AS], "activate", accel_group, 
 			      accel_key, accel_mod, GTK_ACCEL_VISIBLE);
+  mb_file_menu_items[MB_VERSION_HISTORY] = gtk_menu_item_new_with_label ("Version History...");
   mb_file_menu_items[MB_SEPARATOR_FILE] = gtk_separator_menu_item_new ();
   mb_file_menu_items[MB_QUIT] = gtk_image_menu_item_new_from_stock (GTK_STOCK_QUIT, accel_group);
 
@@ -336,11 +386,18 @@ static void general_initialisiation (void)
   mb_edit_menu_items[MB_MOVE_DOWN] = gtk_image_menu_item_new_from_stock (GTK_STOCK_GO_DOWN, NULL);
   mb_edit_menu_items[MB_MOVE_BOTTOM] = gtk_image_menu_item_new_from_stock (GTK_STOCK_GOTO_BOTTOM, NULL);
   mb_edit_menu_items[MB_SEPARATOR_EDIT1] = gtk_separator_menu_item_new ();
+  mb_edit_menu_items[MB_CUT] = gtk_image_menu_item_new_from_stock (GTK_STOCK_CUT, NULL);
+  mb_edit_menu_items[MB_COPY] = gtk_image_menu_item_new_from_stock (GTK_STOCK_COPY, NULL);
+  mb_edit_menu_items[MB_PASTE] = gtk_image_menu_item_new_from_stock (GTK_STOCK_PASTE, NULL);
+  mb_edit_menu_items[MB_SEPARATOR_EDIT2] = gtk_separator_menu_item_new ();
   mb_edit_menu_items[MB_REMOVE] = gtk_image_menu_item_new_from_stock (GTK_STOCK_REMOVE, NULL);
   mb_edit_menu_items[MB_REMOVE_ALL_CHILDREN] = gtk_menu_item_new_with_label ("Remove all children");
-  mb_edit_menu_items[MB_SEPARATOR_EDIT2] = gtk_separator_menu_item_new ();
+  mb_edit_menu_items[MB_SEPARATOR_EDIT3] = gtk_separator_menu_item_new ();
   mb_edit_menu_items[MB_VISUALISE] = gtk_menu_item_new_with_label ("Visualise");
   mb_edit_menu_items[MB_VISUALISE_RECURSIVELY] = gtk_menu_item_new_with_label ("Visualise recursively");
+  mb_edit_menu_items[MB_SEPARATOR_EDIT4] = gtk_separator_menu_item_new ();
+  mb_edit_menu_items[MB_SORT_CHILDREN] = gtk_menu_item_new_with_label ("Sort children");
+  mb_edit_menu_items[MB_SORT_CHILDREN_RECURSIVELY] = gtk_menu_item_new_with_label ("Sort children recursively");
 
   gtk_menu_item_set_submenu (GTK_MENU_ITEM (mb_edit), mb_editmenu);
   for (mb_menu_items_cnt = 0; mb_menu_items_cnt < NUMBER_OF_EDIT_MENU_ITEMS; mb_menu_items_cnt++)
@@ -350,9 +407,13 @@ static void general_initialisiation (void)
   // Search
   mb_search = gtk_menu_item_new_with_mnemonic ("_Search");
   mb_find = gtk_image_menu_item_new_from_stock (GTK_STOCK_FIND, accel_group);
+  mb_quick_jump = gtk_menu_item_new_with_label ("Quick jump...");
+  gtk_accelerator_parse ("<Ctl>P", &accel_key, &accel_mod);
+  gtk_widget_add_accelerator (mb_quick_jump, "activate", accel_group, accel_key, accel_mod, GTK_ACCEL_VISIBLE);
 
   gtk_menu_item_set_submenu (GTK_MENU_ITEM (mb_search), mb_searchmenu);
   gtk_menu_shell_append (GTK_MENU_SHELL (mb_searchmenu), mb_find);
+  gtk_menu_shell_append (GTK_MENU_SHELL (mb_searchmenu), mb_quick_jump);
   gtk_menu_shell_append (GTK_MENU_SHELL (menubar), mb_search);
 
   // View
@@ -363,6 +424,8 @@ static void general_initialisiation (void)
   mb_collapse_all_nodes = gtk_menu_item_new_with_label ("Collapse all nodes");
   gtk_accelerator_parse ("<Ctl>C", &accel_key, &accel_mod);
   gtk_widget_add_accelerator (mb_collapse_all_nodes, "activate", accel_group, accel_key, accel_mod, GTK_ACCEL_VISIBLE);
+  mb_expand_selected_subtrees = gtk_menu_item_new_with_label ("Expand selected subtrees");
+  mb_expand_to_depth = gtk_menu_item_new_with_label ("Expand to depth");
   mb_separator_view[0] = gtk_separator_menu_item_new ();
   mb_view_and_options[SHOW_MENU_ID_COL] = gtk_check_menu_item_new_with_label ("Show Menu ID column");
   mb_view_and_options[SHOW_EXECUTE_COL] = gtk_check_menu_item_new_with_label ("Show Execute column");
@@ -377,6 +440,20 @@ static void general_initialisiation (void)
   mb_view_and_options[SHOW_TREE_LINES] = gtk_check_menu_item_new_with_label ("Show tree lines"); 
   mb_show_grid = gtk_menu_item_new_with_label ("Show grid");
 
+  gtk_menu_item_set_submenu (GTK_MENU_ITEM (mb_expand_to_depth), mb_expand_to_depth_submenu);
+  for (depth_cnt = MIN_EXPANSION_DEPTH; depth_cnt <= MAX_EXPANSION_DEPTH; depth_cnt++) {
+    gchar *level_txt = g_strdup_printf ("%i levels", depth_cnt);
+
+    mb_expand_to_depth_level = gtk_menu_item_new_with_label (level_txt);
+    gtk_menu_shell_append (GTK_MENU_SHELL (mb_expand_to_depth_submenu), mb_expand_to_depth_level);
+    // (Note: The items are not kept, so their signal is connected here.)
+    g_signal_connect_swapped (mb_expand_to_depth_level, "activate", 
+			      G_CALLBACK (expand_to_depth), GUINT_TO_POINTER (depth_cnt));
+
+    // Cleanup
+    g_free (level_txt);
+  }
+
   gtk_menu_item_set_submenu (GTK_MENU_ITEM (mb_show_element_visibility_column), 
 			     mb_show_element_visibility_column_submenu);
   for (mb_menu_items_cnt = SHOW_ELEMENT_VISIBILITY_COL_ACT, txts_cnt = 0;
@@ -407,6 +484,8 @@ static void general_initialisiation (void)
   gtk_menu_item_set_submenu (GTK_MENU_ITEM (mb_view), mb_viewmenu);
   gtk_menu_shell_append (GTK_MENU_SHELL (mb_viewmenu), mb_expand_all_nodes);
   gtk_menu_shell_append (GTK_MENU_SHELL (mb_viewmenu), mb_collapse_all_nodes);
+  gtk_menu_shell_append (GTK_MENU_SHELL (mb_viewmenu), mb_expand_selected_subtrees);
+  gtk_menu_shell_append (GTK_MENU_SHELL (mb_viewmenu), mb_expand_to_depth);
   gtk_menu_shell_append (GTK_MENU_SHELL (mb_viewmenu), mb_separator_view[0]);
   gtk_menu_shell_append (GTK_MENU_SHELL (mb_viewmenu), mb_view_and_options[SHOW_MENU_ID_COL]);
   gtk_menu_shell_append (GTK_MENU_SHELL (mb_viewmenu), mb_view_and_options[SHOW_EXECUTE_COL]);
@@ -436,14 +515,18 @@ static void general_initialisiation (void)
 		      gtk_check_menu_item_new_with_label ("Sort execute/startupnotify options");
   mb_view_and_options[NOTIFY_ABOUT_EXECUTE_OPT_CONVERSIONS] = 
 		      gtk_check_menu_item_new_with_label ("Always notify about execute opt. conversions");
+  mb_view_and_options[SYNC_MENU_FILE_TO_DISK] = 
+		      gtk_check_menu_item_new_with_label ("Write menu file to disk immediately when saving");
 
   gtk_menu_item_set_submenu (GTK_MENU_ITEM (mb_options), mb_optionsmenu);
   gtk_menu_shell_append (GTK_MENU_SHELL (mb_optionsmenu), mb_view_and_options[SORT_EXECUTE_AND_STARTUPN_OPTIONS]);
   gtk_menu_shell_append (GTK_MENU_SHELL (mb_optionsmenu), mb_view_and_options[NOTIFY_ABOUT_EXECUTE_OPT_CONVERSIONS]);
+  gtk_menu_shell_append (GTK_MENU_SHELL (mb_optionsmenu), mb_view_and_options[SYNC_MENU_FILE_TO_DISK]);
   gtk_menu_shell_append (GTK_MENU_SHELL (menubar), mb_options);
 
   // Default settings
   gtk_check_menu_item_set_active (GTK_CHECK_MENU_ITEM (mb_view_and_options[NOTIFY_ABOUT_EXECUTE_OPT_CONVERSIONS]), TRUE);
+  gtk_check_menu_item_set_active (GTK_CHECK_MENU_ITEM (mb_view_and_options[SYNC_MENU_FILE_TO_DISK]), TRUE);
 
   // Help
   mb_help = gtk_menu_item_new_with_mnemonic ("_Help");
@@ -615,6 +698,39 @@ static void general_initialisiation (void)
   find_regular_expression = gtk_check_button_new_with_label ("Regular expression");
   gtk_container_add (GTK_CONTAINER (find_special_options_row), find_regular_expression);
 
+  find_structured_query = gtk_check_button_new_with_label ("Structured query");
+  gtk_widget_set_tooltip_text (find_structured_query, 
+			       "Terms separated by spaces have to match all, \"|\" separates alternatives, "
+			       "\"-\" negates a term, parentheses group terms.\n"
+			       "field:value (starts with), field=value (equals), field~regex, field: (has a value)\n"
+			       "depth:n, depth<n, depth>n, depth<=n, depth>=n\n"
+			       "Fields: label, type, value, id, execute, visibility, icon, action, "
+			       "command, prompt, enabled, wmclass, name\n"
+			       "Other terms are searched inside the chosen columns.\n"
+			       "Example: type:item action:Execute command~firefox -icon:");
+  gtk_container_add (GTK_CONTAINER (find_special_options_row), find_structured_query);
+
+  find_matches_only = gtk_check_button_new_with_label ("Show matches only");
+  gtk_container_add (GTK_CONTAINER (find_special_options_row), find_matches_only);
+
+  find_replace_row = gtk_grid_new ();
+  gtk_container_add (GTK_CONTAINER (find_grid), find_replace_row);
+
+  find_replace_entry = gtk_entry_new ();
+  gtk_widget_set_hexpand (find_replace_entry, TRUE);
+  gtk_widget_set_tooltip_text (find_replace_entry, "Replacement text (inserted literally). Types, action and option "
+			       "names and boolean values are never replaced; structured queries may also "
+			       "replace inside icon paths (icon field).");
+  gtk_container_add (GTK_CONTAINER (find_replace_row), find_replace_entry);
+
+  find_replace_button = gtk_button_new_with_label ("Replace");
+  gtk_widget_set_sensitive (find_replace_button, FALSE);
+  gtk_container_add (GTK_CONTAINER (find_replace_row), find_replace_button);
+
+  find_replace_all_button = gtk_button_new_with_label ("Replace all");
+  gtk_widget_set_sensitive (find_replace_all_button, FALSE);
+  gtk_container_add (GTK_CONTAINER (find_replace_row), find_replace_all_button);
+
   // Default settings
   gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (find_regular_expression), TRUE);
 
@@ -680,6 +796,29 @@ static void general_initialisiation (void)
   gtk_container_add (GTK_CONTAINER (scrolled_window), treeview);
   gtk_widget_set_vexpand (scrolled_window, TRUE);
 
+  /* Create a second treeview that replaces the first one if "Show matches only" is activated. 
+     Its model is a filter model that is set when the view is shown. */
+  matches_treeview = gtk_tree_view_new ();
+  gtk_tree_view_set_enable_tree_lines (GTK_TREE_VIEW (matches_treeview), TRUE);
+
+  for (columns_cnt = 0; columns_cnt < COL_ELEMENT_VISIBILITY; columns_cnt++) {
+    matches_renderer = gtk_cell_renderer_text_new ();
+    matches_column = gtk_tree_view_column_new_with_attributes (column_header_txts[columns_cnt], matches_renderer, NULL);
+    gtk_tree_view_column_set_cell_data_func (matches_column, matches_renderer, 
+					     (GtkTreeCellDataFunc) set_matches_column_attributes, 
+					     GUINT_TO_POINTER (columns_cnt), NULL);
+    gtk_tree_view_column_set_resizable (matches_column, TRUE);
+    gtk_tree_view_append_column (GTK_TREE_VIEW (matches_treeview), matches_column);
+  }
+
+  matches_scrolled_window = gtk_scrolled_window_new (NULL, NULL);
+  gtk_container_add (GTK_CONTAINER (main_grid), matches_scrolled_window);
+
+  gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (matches_scrolled_window), 
+				  GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+  gtk_container_add (GTK_CONTAINER (matches_scrolled_window), matches_treeview);
+  gtk_widget_set_vexpand (matches_scrolled_window, TRUE);
+
   // Set drag and drop destination parameters.
   gtk_tree_view_enable_model_drag_dest (GTK_TREE_VIEW (treeview), enable_list, 1, GDK_ACTION_MOVE);
 
@@ -729,8 +868,20 @@ static void general_initialisiation (void)
   statusbar = gtk_statusbar_new ();
   gtk_container_add (GTK_CONTAINER (main_grid), statusbar);
 
-  // ### Get the default font size. ###
+  // Progress of long running operations; only shown while such an operation is processed.
+  job_cancel_button = gtk_button_new_from_stock (GTK_STOCK_CANCEL);
+  gtk_widget_set_no_show_all (job_cancel_button, TRUE);
+  gtk_box_pack_end (GTK_BOX (statusbar), job_cancel_button, FALSE, FALSE, 0);
+  job_progress_bar = gtk_progress_bar_new ();
+  gtk_progress_bar_set_show_text (GTK_PROGRESS_BAR (job_progress_bar), TRUE);
+  gtk_widget_set_no_show_all (job_progress_bar, TRUE);
+  gtk_widget_set_valign (job_progress_bar, GTK_ALIGN_CENTER);
+  gtk_box_pack_end (GTK_BOX (statusbar), job_progress_bar, FALSE, FALSE, 0);
+
+  // ### Get the default font size and follow its changes. ###
   font_size = get_font_size ();
+  g_signal_connect_swapped (gtk_settings_get_default (), "notify::gtk-font-name", 
+			    G_CALLBACK (font_size_changed), NULL);
 
   // ### Create broken icon image suitable for that font size.
   create_invalid_icon_imgs ();
@@ -739,7 +890,7 @@ static void general_initialisiation (void)
   // --- Create signals for all buttons and relevant events. ---
 
 
-  handler_id_row_selected = g_signal_connect (selection, "changed", G_CALLBACK (row_selected), NULL);
+  handler_id_row_selected = g_signal_connect (selection, "changed", G_CALLBACK (selection_changed), NULL);
   g_signal_connect (treeview, "row-expanded", G_CALLBACK (set_status_of_expand_and_collapse_buttons_and_menu_items),
 							  NULL);
   g_signal_connect (treeview, "row-collapsed", G_CALLBACK (set_status_of_expand_and_collapse_buttons_and_menu_items), 
@@ -749,6 +900,32 @@ static void general_initialisiation (void)
 
   g_signal_connect (treeview, "key-press-event", G_CALLBACK (key_pressed), NULL);
 
+  // Any change of the treestore makes the quick jump index outdated.
+  g_signal_connect (model, "row-changed", G_CALLBACK (quick_jump_index_row_changed), NULL);
+  g_signal_connect (model, "row-inserted", G_CALLBACK (quick_jump_index_row_inserted), NULL);
+  g_signal_connect (model, "row-deleted", G_CALLBACK (quick_jump_index_row_deleted), NULL);
+  g_signal_connect (model, "rows-reordered", G_CALLBACK (quick_jump_index_rows_reordered), NULL);
+  // The same applies to the cached fragments of the menus that contain the changed row.
+  g_signal_connect (model, "row-changed", G_CALLBACK (invalidate_cached_fragments), NULL);
+  g_signal_connect (model, "row-inserted", G_CALLBACK (invalidate_cached_fragments), NULL);
+  g_signal_connect (model, "row-deleted", G_CALLBACK (cached_fragments_row_deleted), NULL);
+  g_signal_connect (model, "rows-reordered", G_CALLBACK (invalidate_cached_fragments), NULL);
+  // Every change of the treestore is recorded inside the journal for crash recovery.
+  g_signal_connect (model, "row-inserted", G_CALLBACK (journal_row_inserted), NULL);
+  g_signal_connect (model, "row-changed", G_CALLBACK (journal_row_changed), NULL);
+  g_signal_connect (model, "row-deleted", G_CALLBACK (journal_row_deleted), NULL);
+  g_signal_connect (model, "rows-reordered", G_CALLBACK (journal_rows_reordered), NULL);
+  // The list of search results and the list of rows with icons are adjusted only for the changed rows.
+  g_signal_connect (model, "row-inserted", G_CALLBACK (found_occurrences_row_inserted), NULL);
+  g_signal_connect (model, "row-changed", G_CALLBACK (found_occurrences_row_changed), NULL);
+  g_signal_connect (model, "row-deleted", G_CALLBACK (found_occurrences_row_deleted), NULL);
+  g_signal_connect (model, "rows-reordered", G_CALLBACK (found_occurrences_rows_reordered), NULL);
+  g_signal_connect (model, "row-inserted", G_CALLBACK (icon_row_changed), NULL);
+  g_signal_connect (model, "row-changed", G_CALLBACK (icon_row_changed), NULL);
+  g_signal_connect_swapped (model, "row-deleted", G_CALLBACK (icon_row_deleted), NULL);
+
+  g_signal_connect (treeview, "drag-begin", G_CALLBACK (drag_begin_handler), NULL);
+  g_signal_connect (treeview, "drag-end", G_CALLBACK (drag_end_handler), NULL);
   g_signal_connect (treeview, "drag-motion", G_CALLBACK (drag_motion_handler), NULL);
   g_signal_connect (treeview, "drag_data_received", G_CALLBACK (drag_data_received_handler), NULL);
 
@@ -756,25 +933,35 @@ static void general_initialisiation (void)
   g_signal_connect (mb_file_menu_items[MB_OPEN], "activate", G_CALLBACK (open_menu), NULL);
   g_signal_connect_swapped (mb_file_menu_items[MB_SAVE], "activate", G_CALLBACK (save_menu), NULL);
   g_signal_connect (mb_file_menu_items[MB_SAVE_AS], "activate", G_CALLBACK (save_menu_as), NULL);
+  g_signal_connect (mb_file_menu_items[MB_VERSION_HISTORY], "activate", G_CALLBACK (show_version_history), NULL);
   g_signal_connect (mb_file_menu_items[MB_QUIT], "activate", G_CALLBACK (quit_program), NULL);
 
   for (mb_menu_items_cnt = TOP; mb_menu_items_cnt <= BOTTOM; mb_menu_items_cnt++) {
     g_signal_connect_swapped (mb_edit_menu_items[mb_menu_items_cnt], "activate", 
 			      G_CALLBACK (move_selection), GUINT_TO_POINTER (mb_menu_items_cnt));
   }
+  g_signal_connect (mb_edit_menu_items[MB_CUT], "activate", G_CALLBACK (cut_rows), NULL);
+  g_signal_connect (mb_edit_menu_items[MB_COPY], "activate", G_CALLBACK (copy_rows), NULL);
+  g_signal_connect (mb_edit_menu_items[MB_PASTE], "activate", G_CALLBACK (paste_rows), NULL);
   g_signal_connect_swapped (mb_edit_menu_items[MB_REMOVE], "activate", G_CALLBACK (remove_rows), "menu bar");
   g_signal_connect (mb_edit_menu_items[MB_REMOVE_ALL_CHILDREN], "activate", G_CALLBACK (remove_all_children), NULL);
   g_signal_connect_swapped (mb_edit_menu_items[MB_VISUALISE], "activate", 
 			    G_CALLBACK (visualise_menus_items_and_separators), GUINT_TO_POINTER (FALSE));
   g_signal_connect_swapped (mb_edit_menu_items[MB_VISUALISE_RECURSIVELY], "activate", 
 			    G_CALLBACK (visualise_menus_items_and_separators), GUINT_TO_POINTER (TRUE));
+  g_signal_connect_swapped (mb_edit_menu_items[MB_SORT_CHILDREN], "activate", 
+			    G_CALLBACK (sort_children), GUINT_TO_POINTER (FALSE));
+  g_signal_connect_swapped (mb_edit_menu_items[MB_SORT_CHILDREN_RECURSIVELY], "activate", 
+			    G_CALLBACK (sort_children), GUINT_TO_POINTER (TRUE));
 
   g_signal_connect (mb_find, "activate", G_CALLBACK (show_or_hide_find_grid), NULL);
+  g_signal_connect_swapped (mb_quick_jump, "activate", G_CALLBACK (show_quick_jump_palette), NULL);
 
   g_signal_connect_swapped (mb_expand_all_nodes, "activate",
 			    G_CALLBACK (expand_or_collapse_all), GUINT_TO_POINTER (TRUE));
   g_signal_connect_swapped (mb_collapse_all_nodes, "activate", 
 			    G_CALLBACK (expand_or_collapse_all), GUINT_TO_POINTER (FALSE));
+  g_signal_connect (mb_expand_selected_subtrees, "activate", G_CALLBACK (expand_selected_subtrees), NULL);
   for (mb_menu_items_cnt = 0; mb_menu_items_cnt < NUMBER_OF_VIEW_AND_OPTIONS; mb_menu_items_cnt++)
     g_signal_connect_swapped (mb_view_and_options[mb_menu_items_cnt], "activate", 
 			      G_CALLBACK (change_view_and_options), GUINT_TO_POINTER (mb_menu_items_cnt));
@@ -794,6 +981,8 @@ static void general_initialisiation (void)
 			    G_CALLBACK (expand_or_collapse_all), GUINT_TO_POINTER (FALSE));
   g_signal_connect (tb[TB_QUIT], "clicked", G_CALLBACK (quit_program), NULL);
 
+  g_signal_connect (job_cancel_button, "clicked", G_CALLBACK (cancel_idle_job), NULL);
+
   for (buttons_cnt = 0; buttons_cnt < ACTION_OR_OPTION; buttons_cnt++)
     // Dyn. alloc. mem. is not freed here, since the texts have to be present as long as the program runs.
     g_signal_connect_swapped (bt_add[buttons_cnt], "clicked", G_CALLBACK (add_new), 
@@ -825,6 +1014,15 @@ static void general_initialisiation (void)
   g_signal_connect_swapped (find_in_all_columns, "clicked", G_CALLBACK (find_buttons_management), "ALL");
   g_signal_connect_swapped (find_match_case, "clicked", G_CALLBACK (find_buttons_management), NULL);
   g_signal_connect_swapped (find_regular_expression, "clicked", G_CALLBACK (find_buttons_management), NULL);
+  g_signal_connect_swapped (find_structured_query, "clicked", G_CALLBACK (find_buttons_management), NULL);
+  g_signal_connect_swapped (find_matches_only, "clicked", G_CALLBACK (find_buttons_management), NULL);
+  g_signal_connect_swapped (find_replace_button, "clicked", G_CALLBACK (replace_or_replace_all), 
+			    GINT_TO_POINTER (FALSE));
+  g_signal_connect_swapped (find_replace_all_button, "clicked", G_CALLBACK (replace_or_replace_all), 
+			    GINT_TO_POINTER (TRUE));
+  g_signal_connect (gtk_tree_view_get_selection (GTK_TREE_VIEW (matches_treeview)), "changed", 
+		    G_CALLBACK (matches_row_selected), NULL);
+  g_signal_connect (matches_treeview, "row-activated", G_CALLBACK (leave_matches_only_view), NULL);
   
   for (entry_fields_cnt = 0; entry_fields_cnt < NUMBER_OF_ENTRY_FIELDS; entry_fields_cnt++)
     g_signal_connect (entry_fields[entry_fields_cnt], "activate", G_CALLBACK (change_row), NULL);
@@ -864,12 +1062,15 @@ static void general_initialisiation (void)
     }
     else {
       for (view_and_opts_cnt = 0; view_and_opts_cnt < NUMBER_OF_VIEW_AND_OPTIONS; view_and_opts_cnt++) {
-	gtk_check_menu_item_set_active 
-	  (GTK_CHECK_MENU_ITEM (mb_view_and_options[view_and_opts_cnt]), 
-	   g_key_file_get_boolean (settings_file, (view_and_opts_cnt < SORT_EXECUTE_AND_STARTUPN_OPTIONS) ? 
-				   "VIEW" : "OPTIONS", 
-				   gtk_menu_item_get_label ((GtkMenuItem *) mb_view_and_options[view_and_opts_cnt]), 
-				   NULL));
+	settings_group = (view_and_opts_cnt < SORT_EXECUTE_AND_STARTUPN_OPTIONS) ? "VIEW" : "OPTIONS";
+	settings_key = gtk_menu_item_get_label ((GtkMenuItem *) mb_view_and_options[view_and_opts_cnt]);
+
+	// Settings that have been added in later versions of the program keep their default values.
+	if (!g_key_file_has_key (settings_file, settings_group, settings_key, NULL))
+	  continue;
+
+	gtk_check_menu_item_set_active (GTK_CHECK_MENU_ITEM (mb_view_and_options[view_and_opts_cnt]), 
+					g_key_file_get_boolean (settings_file, settings_group, settings_key, NULL));
       }
       // Cleanup
       g_key_file_free (settings_file);
@@ -882,6 +1083,7 @@ static void general_initialisiation (void)
   // Defaults
   gtk_widget_hide (action_option_grid);
   gtk_widget_hide (find_grid);
+  gtk_widget_hide (matches_scrolled_window);
 
  /* The height of the message label is set to be identical to the one of the buttons, so the button grid doesn't 
     shrink if the buttons are missing. This can only be done after all widgets have already been added to the grid, 
@@ -1164,27 +1366,6 @@ gchar *check_if_invisible_ancestor_exists (GtkTreeModel *local_model, GtkTreePat
   return NULL;
 }
 
-/* 
-
-   Checks if there is a match for a search, used for replacing several matches at once.
-
-*/
-
-static gboolean evaluate_match (const GMatchInfo *match_info, 
-				GString          *result, 
-				gpointer          data)
-{
-  gchar *match = g_match_info_fetch (match_info, 0);
-  gchar *single_result = g_hash_table_lookup ((GHashTable *) data, match);
-
-  g_string_append (result, single_result);
-
-  // Cleanup
-  g_free (match);
-
-  return FALSE;
-}
-
 /* 
 
    Sets attributes like foreground and background colour, visibility of cell renderers and 
@@ -1221,6 +1402,7 @@ static void set_column_attributes (GtkTreeViewColumn G_GNUC_UNUSED *cell_column,
   gchar *background;
   gboolean background_set;
   gchar *highlighted_txt = NULL;
+  gchar *highlighted_txt_core;
 
   gboolean show_icons = gtk_check_menu_item_get_active (GTK_CHECK_MENU_ITEM (mb_view_and_options[SHOW_ICONS]));
   gboolean show_separators_in_bold_type = 
@@ -1289,53 +1471,15 @@ static void set_column_attributes (GtkTreeViewColumn G_GNUC_UNUSED *cell_column,
   background_set = (unintegrated_or_integrated_inv && keep_highlighting);
 
   // If a search is going on, highlight all matches.
-  if (column_number < COL_ELEMENT_VISIBILITY && !gtk_widget_get_visible (action_option_grid) && *search_term_str && 
-      gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (find_in_columns[column_number])) &&
-      check_for_match (search_term_str, cell_iter, column_number)) {
-    gchar *search_term_str_escaped = (gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (find_regular_expression))) ? 
-      NULL : g_regex_escape_string (search_term_str, -1);
-    GRegex *regex = g_regex_new ((search_term_str_escaped) ? search_term_str_escaped : search_term_str, 
-				 (gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (find_match_case))) ? 
-				 0 : G_REGEX_CASELESS, 0, NULL);
-    GMatchInfo *match_info = NULL;
-    gchar *match;
-    GSList *matches = NULL;
-    GSList *replacement_txts = NULL;
-    GHashTable *hash_table = g_hash_table_new (g_str_hash, g_str_equal);
-    gchar *highlighted_txt_core;
-
-    g_regex_match (regex, cell_data[column_number], 0, &match_info);
-    while (g_match_info_matches (match_info)) {
-      if (!g_slist_find_custom (matches, match = g_match_info_fetch (match_info, 0), (GCompareFunc) strcmp)) {
-	matches = g_slist_prepend (matches, g_strdup (match));
-	replacement_txts = g_slist_prepend (replacement_txts, 
-					    g_strconcat ("<span background='", (row_is_selected) ? "black'>" : 
-							 "yellow' foreground='black'>", match, "</span>", NULL));
-	g_hash_table_insert (hash_table, matches->data, replacement_txts->data);
-      }
-      g_match_info_next (match_info, NULL);
-
-      // Cleanup
-      g_free (match);
-    }
-
-    // Cleanup
-    g_match_info_free (match_info);
-
-    // Replace all findings with a highlighted version at once.
-    highlighted_txt_core = g_regex_replace_eval (regex, cell_data[column_number], -1, 0, 0, 
-						 evaluate_match, hash_table, NULL);
+  if (column_number < COL_ELEMENT_VISIBILITY && !gtk_widget_get_visible (action_option_grid) && 
+      (highlighted_txt_core = get_highlighted_markup (cell_path, column_number, cell_data[column_number], 
+						      row_is_selected))) {
     highlighted_txt = (!background_set) ? g_strdup (highlighted_txt_core) : 
       g_strdup_printf ("<span foreground='white'>%s</span>", highlighted_txt_core);
 
     g_object_set (txt_renderer, "markup", highlighted_txt, NULL);
 
     // Cleanup
-    g_free (search_term_str_escaped);
-    g_slist_free_full (matches, (GDestroyNotify) g_free);
-    g_slist_free_full (replacement_txts, (GDestroyNotify) g_free);
-    g_hash_table_destroy (hash_table);
-    g_regex_unref (regex);
     g_free (highlighted_txt_core);
   }
 
@@ -1439,11 +1583,16 @@ void clear_global_static_data (void)
 {
   GtkTreeSelection *selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview));
 
+  cancel_idle_job ();
   free_and_reassign (filename, NULL);
+  stop_menu_file_monitoring ();
+  close_journal ();
+  clear_fragment_cache ();
+  invalidate_quick_jump_index ();
   g_slist_free_full (menu_ids, (GDestroyNotify) g_free);
   menu_ids = NULL;
-  if (rows_with_icons)
-    stop_timer ();
+  stop_icon_monitoring ();
+  clear_original_icons ();
   if (gtk_widget_get_visible (find_grid))
     show_or_hide_find_grid ();
   g_signal_handler_block (selection, handler_id_row_selected);
@@ -1452,28 +1601,215 @@ void clear_global_static_data (void)
   change_done = FALSE;
 }
 
+/* 
+
+   Expands or collapses the next row of an expansion job. 
+   Expanding walks through all rows, collapsing only through the toplevel rows, 
+   since collapsing a row collapses its descendants as well. 
+
+*/
+
+static gboolean expand_or_collapse_next_row (struct expansion_job *job)
+{
+  GtkTreePath *path = gtk_tree_row_reference_get_path (job->next_row);
+  GtkTreeIter iter_loop;
+  gboolean next_row_exists;
+
+  gtk_tree_row_reference_free (job->next_row);
+  job->next_row = NULL;
+
+  if (!path) // Row has been removed in the meantime.
+    return FALSE;
+
+  gtk_tree_model_get_iter (model, &iter_loop, path);
+  if (job->expand) {
+    if (gtk_tree_model_iter_has_child (model, &iter_loop))
+      gtk_tree_view_expand_row (GTK_TREE_VIEW (treeview), path, FALSE);
+    next_row_exists = get_next_row_in_preorder (model, &iter_loop, -1, TRUE);
+  }
+  else {
+    gtk_tree_view_collapse_row (GTK_TREE_VIEW (treeview), path);
+    next_row_exists = gtk_tree_model_iter_next (model, &iter_loop);
+  }
+
+  // Cleanup
+  gtk_tree_path_free (path);
+
+  if (!next_row_exists)
+    return FALSE;
+
+  path = gtk_tree_model_get_path (model, &iter_loop);
+  job->next_row = gtk_tree_row_reference_new (model, path);
+
+  // Cleanup
+  gtk_tree_path_free (path);
+
+  return TRUE;
+}
+
+/* 
+
+   Updates the expansion status once after an expansion job has finished or been cancelled. 
+
+*/
+
+static void expansion_job_finished (struct expansion_job                *job, 
+				    gpointer             G_GNUC_UNUSED  cancelled_pointer)
+{
+  if (!job->expand)
+    gtk_tree_view_columns_autosize (GTK_TREE_VIEW (treeview));
+
+  // (Note: A job that is cancelled by the start of a new one mustn't reset the reference to the latter.)
+  if (running_expansion_job == job)
+    running_expansion_job = NULL;
+  g_signal_handlers_unblock_by_func (treeview, set_status_of_expand_and_collapse_buttons_and_menu_items, NULL);
+  set_status_of_expand_and_collapse_buttons_and_menu_items ();
+
+  // Cleanup
+  if (job->next_row)
+    gtk_tree_row_reference_free (job->next_row);
+  g_free (job);
+}
+
 /* 
 
    Expands the tree view so the whole structure is visible or
-   collapses the tree view so just the toplevel elements are visible.
+   collapses the tree view so just the toplevel elements are visible. 
+   Large menus are processed in the background, so the window stays responsive. 
 
 */
 
 static void expand_or_collapse_all (gpointer expand_pointer)
 {
   gboolean expand = GPOINTER_TO_UINT (expand_pointer);
+  struct expansion_job *job;
+  GtkTreeIter iter_toplevel;
+  GtkTreePath *path_toplevel;
 
-  if (expand)
-    gtk_tree_view_expand_all (GTK_TREE_VIEW (treeview));
-  else {
-    gtk_tree_view_collapse_all (GTK_TREE_VIEW (treeview));
-    gtk_tree_view_columns_autosize (GTK_TREE_VIEW (treeview));
+  if (!gtk_tree_model_get_iter_first (model, &iter_toplevel))
+    return;
+
+  job = g_new (struct expansion_job, 1);
+  job->expand = expand;
+  path_toplevel = gtk_tree_model_get_path (model, &iter_toplevel);
+  job->next_row = gtk_tree_row_reference_new (model, path_toplevel);
+
+  // Cleanup
+  gtk_tree_path_free (path_toplevel);
+
+  // The bin window isn't frozen, so the tree view is redrawn between the time slices of the job.
+  g_signal_handlers_block_by_func (treeview, set_status_of_expand_and_collapse_buttons_and_menu_items, NULL);
+  /* (Note: Set before the job is started, since a small job is finished and freed before start_idle_job returns; 
+     a previous expansion job that is cancelled by start_idle_job leaves this reference untouched.) */
+  running_expansion_job = job;
+
+  start_idle_job ((expand) ? "Expanding all nodes" : "Collapsing all nodes", 
+		  (expand) ? count_rows_of_subtree (NULL) : (guint) gtk_tree_model_iter_n_children (model, NULL), 
+		  (GSourceFunc) expand_or_collapse_next_row, (GFunc) expansion_job_finished, job);
+}
+
+/* 
+
+   Starts a batch of expansions and collapses: the tree view isn't redrawn and 
+   the expansion status of the whole tree isn't checked after each single row, 
+   this is done once by end_batch_expansion. Batches may be nested. 
+
+*/
+
+void begin_batch_expansion (void)
+{
+  GdkWindow *bin_window = gtk_tree_view_get_bin_window (GTK_TREE_VIEW (treeview));
+
+  if (bin_window) // Not realized yet if the menu is loaded at startup.
+    gdk_window_freeze_updates (bin_window);
+  g_signal_handlers_block_by_func (treeview, set_status_of_expand_and_collapse_buttons_and_menu_items, NULL);
+}
+
+/* 
+
+   Ends a batch of expansions and collapses started by begin_batch_expansion. 
+
+*/
+
+void end_batch_expansion (void)
+{
+  GdkWindow *bin_window = gtk_tree_view_get_bin_window (GTK_TREE_VIEW (treeview));
+
+  g_signal_handlers_unblock_by_func (treeview, set_status_of_expand_and_collapse_buttons_and_menu_items, NULL);
+  if (bin_window)
+    gdk_window_thaw_updates (bin_window);
+  set_status_of_expand_and_collapse_buttons_and_menu_items ();
+}
+
+/* 
+
+   Expands all nodes down to the passed depth and collapses the ones below, 
+   so only the rows of the first depth levels are visible. 
+   Rows below these levels are not visited at all. 
+
+*/
+
+static void expand_to_depth (gpointer depth_pointer)
+{
+  guint8 depth = GPOINTER_TO_UINT (depth_pointer);
+  GtkTreeIter iter_loop;
+  GtkTreePath *path_loop;
+  guint8 row_depth;
+  gboolean valid = gtk_tree_model_get_iter_first (model, &iter_loop);
+
+  // Otherwise a running "Expand all nodes" would continue to expand rows below the depth.
+  if (running_expansion_job)
+    cancel_idle_job ();
+
+  begin_batch_expansion ();
+
+  gtk_tree_view_collapse_all (GTK_TREE_VIEW (treeview));
+  while (valid) {
+    row_depth = gtk_tree_store_iter_depth (treestore, &iter_loop) + 1; // Toplevel rows have a depth of 1.
+    if (row_depth < depth && gtk_tree_model_iter_has_child (model, &iter_loop)) {
+      path_loop = gtk_tree_model_get_path (model, &iter_loop);
+      gtk_tree_view_expand_row (GTK_TREE_VIEW (treeview), path_loop, FALSE);
+
+      // Cleanup
+      gtk_tree_path_free (path_loop);
+    }
+    // The children of a row are only visited if they are expanded themselves.
+    valid = get_next_row_in_preorder (model, &iter_loop, -1, row_depth + 1 < depth);
+  }
+  gtk_tree_view_columns_autosize (GTK_TREE_VIEW (treeview));
+
+  end_batch_expansion ();
+}
+
+/* 
+
+   Expands the selected rows recursively. 
+
+*/
+
+static void expand_selected_subtrees (void)
+{
+  GtkTreeSelection *selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview));
+  GList *selected_rows = gtk_tree_selection_get_selected_rows (selection, &model);
+  GtkTreePath *last_expanded_path = NULL;
+
+  GList *g_list_loop;
+
+  begin_batch_expansion ();
+
+  for (g_list_loop = selected_rows; g_list_loop; g_list_loop = g_list_loop->next) {
+    /* A selected descendant of a row that has already been expanded recursively is skipped. 
+       (Note: The selected rows are sorted in tree order.) */
+    if (last_expanded_path && gtk_tree_path_is_descendant (g_list_loop->data, last_expanded_path))
+      continue;
+    gtk_tree_view_expand_row (GTK_TREE_VIEW (treeview), g_list_loop->data, TRUE);
+    last_expanded_path = g_list_loop->data;
   }
 
-  gtk_widget_set_sensitive (mb_expand_all_nodes, !expand);
-  gtk_widget_set_sensitive (mb_collapse_all_nodes, expand);
-  gtk_widget_set_sensitive ((GtkWidget *) tb[TB_EXPAND_ALL], !expand);
-  gtk_widget_set_sensitive ((GtkWidget *) tb[TB_COLLAPSE_ALL], expand);
+  end_batch_expansion ();
+
+  // Cleanup
+  g_list_free_full (selected_rows, (GDestroyNotify) gtk_tree_path_free);
 }
 
 /* 
@@ -1563,9 +1899,14 @@ void new_menu (void)
 */
 
 static void quit_program (void) {
+  // A failed save sets change_done again, so a running save has to be finished before.
+  wait_for_saving_to_finish ();
+
   if (change_done && !unsaved_changes ())
     return;
 
+  close_journal ();
+
   exit (EXIT_SUCCESS);
 }
 
@@ -1605,7 +1946,7 @@ static gboolean add_icon_occurrence_to_list (GtkTreeModel G_GNUC_UNUSED *local_m
 
   gtk_tree_model_get (model, local_iter, TS_ICON_IMG, &icon, -1);
   if (icon) {
-    rows_with_icons = g_slist_prepend (rows_with_icons, gtk_tree_row_reference_new (model, local_path));
+    rows_with_icons = g_list_prepend (rows_with_icons, gtk_tree_row_reference_new (model, local_path));
 
     // Cleanup
     unref_icon (&icon, FALSE);
@@ -1616,23 +1957,24 @@ static gboolean add_icon_occurrence_to_list (GtkTreeModel G_GNUC_UNUSED *local_m
 
 /* 
 
-   Creates a list that contains all rows with an icon.
+   Creates a list that contains all rows with an icon and monitors their icon files.
+   Afterwards the list is kept up to date by icon_row_changed and icon_row_deleted.
 
 */
 
 void create_list_of_icon_occurrences (void)
 {
+  stop_icon_monitoring ();
   gtk_tree_model_foreach (model, (GtkTreeModelForeachFunc) add_icon_occurrence_to_list, NULL);
-  if (rows_with_icons)
-    g_timeout_add (1000, (GSourceFunc) check_for_external_file_and_settings_changes, "timer");
+  start_icon_monitoring ();
 }
 
 /* 
 
    Activates "Save" menubar item/toolbar button (provided that there is a filename) if a change has been done.
    Also sets a global veriable so a program-wide check for a change is possible.
-   If a search is still active, the list of results is recreated.     
-   A list of rows with icons is (re)created, too.
+   The list of search results and the list of rows with icons have already been adjusted for the changed rows 
+   by the handlers of the treestore signals; here only the rest of the bookkeeping is done.
 
 */
 
@@ -1644,11 +1986,9 @@ void activate_change_done (void)
   }
   
   if (gtk_widget_get_visible (find_grid))
-    create_list_of_rows_with_found_occurrences ();
+    finish_update_of_rows_with_found_occurrences ();
 
-  if (rows_with_icons)
-    stop_timer ();
-  create_list_of_icon_occurrences ();
+  update_list_of_icon_occurrences ();
 
   change_done = TRUE;
 }
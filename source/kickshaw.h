@@ -23,25 +23,54 @@
 extern void action_option_insert (gchar *origin);
 extern void add_new (gchar *new_element_type);
 extern void boolean_toogled (void);
+extern void cached_fragments_row_deleted (GtkTreeModel *local_model, GtkTreePath *local_path);
+extern void cancel_idle_job (void);
 extern void hide_action_option (void);
 extern void change_row (void);
-extern gboolean check_for_external_file_and_settings_changes (gpointer G_GNUC_UNUSED identifier);
-extern gboolean check_for_match (const gchar *search_term_str, GtkTreeIter *local_iter, guint8 column_number);
+extern gboolean copy_rows (void);
+extern guint count_rows_of_subtree (GtkTreeIter *parent_iter);
 extern void create_context_menu (GdkEventButton *event);
-extern void create_list_of_rows_with_found_occurrences (void);
+extern void cut_rows (void);
 extern void cell_edited (GtkCellRendererText G_GNUC_UNUSED *renderer, gchar *path, 
 			 gchar *new_text, gpointer column_number_pointer);
+extern void drag_begin_handler (void);
+extern void drag_end_handler (void);
 extern gboolean drag_motion_handler (GtkWidget G_GNUC_UNUSED *widget, GdkDragContext *drag_context, 
 				     gint x, gint y, guint time);
 extern void drag_data_received_handler (GtkWidget G_GNUC_UNUSED *widget, GdkDragContext G_GNUC_UNUSED *context, 
 					gint x, gint y);
+extern void clear_fragment_cache (void);
+extern void clear_original_icons (void);
+extern void close_journal (void);
 extern void find_buttons_management (gchar *find_in_check_button_clicked);
+extern void finish_update_of_rows_with_found_occurrences (void);
+extern void found_occurrences_row_changed (GtkTreeModel *local_model, GtkTreePath *local_path, GtkTreeIter *local_iter);
+extern void found_occurrences_row_deleted (GtkTreeModel *local_model, GtkTreePath *local_path);
+extern void found_occurrences_row_inserted (GtkTreeModel *local_model, GtkTreePath *local_path, GtkTreeIter *local_iter);
+extern void found_occurrences_rows_reordered (GtkTreeModel *local_model, GtkTreePath *local_path, GtkTreeIter *local_iter, 
+					      gint *new_order);
 extern void free_elements_of_static_string_array (gchar **string_array, gint8 number_of_fields, gboolean set_to_NULL);
+extern void font_size_changed (void);
 extern guint get_font_size (void);
+extern gboolean get_next_row_in_preorder (GtkTreeModel *local_model, GtkTreeIter *local_iter, gint root_depth, 
+					  gboolean descend);
+extern gchar *get_highlighted_markup (GtkTreePath *path, guint8 column_number, const gchar *cell_txt, 
+				      gboolean row_is_selected);
 extern void get_tree_row_data (gchar *new_filename);
 extern void icon_choosing_by_button_or_context_menu (void);
-extern void key_pressed (GtkWidget G_GNUC_UNUSED *widget, GdkEventKey *event);
+extern void icon_row_changed (GtkTreeModel *local_model, GtkTreePath *local_path, GtkTreeIter *local_iter);
+extern void icon_row_deleted (void);
+extern void invalidate_cached_fragments (GtkTreeModel *local_model, GtkTreePath *local_path);
+extern void leave_matches_only_view (void);
+extern void invalidate_quick_jump_index (void);
+extern gboolean key_pressed (GtkWidget G_GNUC_UNUSED *widget, GdkEventKey *event);
+extern void journal_row_changed (GtkTreeModel *local_model, GtkTreePath *local_path, GtkTreeIter *local_iter);
+extern void journal_row_deleted (GtkTreeModel *local_model, GtkTreePath *local_path);
+extern void journal_row_inserted (GtkTreeModel *local_model, GtkTreePath *local_path, GtkTreeIter *local_iter);
+extern void journal_rows_reordered (GtkTreeModel *local_model, GtkTreePath *local_path, GtkTreeIter *local_iter, 
+				    gint *new_order);
 extern void jump_to_previous_or_next_occurrence (gpointer direction_pointer);
+extern void matches_row_selected (GtkTreeSelection *matches_selection);
 extern void move_selection (gpointer direction_pointer);
 extern void open_menu (void);
 extern void option_list_with_headlines (GtkCellLayout G_GNUC_UNUSED *cell_layout, 
@@ -49,23 +78,43 @@ extern void option_list_with_headlines (GtkCellLayout G_GNUC_UNUSED *cell_layout
 					GtkTreeModel *action_option_combo_box_model, 
 					GtkTreeIter *action_option_combo_box_iter, 
 					gpointer G_GNUC_UNUSED data);
+extern void paste_rows (void);
+extern void quick_jump_index_row_changed (GtkTreeModel *local_model, GtkTreePath *local_path, GtkTreeIter *local_iter);
+extern void quick_jump_index_row_deleted (GtkTreeModel *local_model, GtkTreePath *local_path);
+extern void quick_jump_index_row_inserted (GtkTreeModel *local_model, GtkTreePath *local_path, GtkTreeIter *local_iter);
+extern void quick_jump_index_rows_reordered (GtkTreeModel *local_model, GtkTreePath *local_path, GtkTreeIter *local_iter, 
+					     gint *new_order);
 extern void remove_all_children (void);
 extern void remove_icons_from_menus_or_items (void);
 extern void remove_rows (gchar *origin);
+extern void replace_or_replace_all (gpointer replace_all_pointer);
 extern void row_selected (void);
 extern void run_search (void);
 extern void save_menu (void);
 extern void save_menu_as (gchar *save_as_filename);
+extern void selection_changed (void);
+extern void process_pending_selection_change (void);
+extern void set_matches_column_attributes (GtkTreeViewColumn G_GNUC_UNUSED *cell_column, GtkCellRenderer *txt_renderer, 
+					  GtkTreeModel *filter_model, GtkTreeIter *filter_iter, 
+					  gpointer column_number_pointer);
 extern void set_status_of_expand_and_collapse_buttons_and_menu_items (void);
 extern void show_action_options (void);
+extern void show_quick_jump_palette (const gchar *initial_txt);
 extern void show_or_hide_find_grid (void);
 extern void show_startupnotify_options (void);
+extern void show_version_history (void);
 extern void single_field_entry (void);
+extern void sort_children (gpointer recursively_pointer);
+extern void start_icon_monitoring (void);
+extern void start_idle_job (gchar *description, guint number_of_steps, GSourceFunc step, GFunc finish, gpointer job_data);
 extern gboolean sort_loop_after_sorting_activation (GtkTreeModel *local_model, GtkTreePath G_GNUC_UNUSED *local_path,
 						    GtkTreeIter *local_iter);
-extern void stop_timer (void);
+extern void stop_icon_monitoring (void);
+extern void stop_menu_file_monitoring (void);
 G_GNUC_NULL_TERMINATED extern gboolean streq_any (const gchar *string, ...);
 extern void unref_icon (GdkPixbuf **icon, gboolean set_to_NULL);
+extern void update_list_of_icon_occurrences (void);
 extern void visualise_menus_items_and_separators (gpointer recursively_pointer);
+extern void wait_for_saving_to_finish (void);
 
 #endif
@@ -60,6 +60,8 @@ struct menu_building_data {
 
   guint8 loading_stage;
   gboolean root_menu_finished;
+
+  gboolean silent_loading;
 };
 
 static void start_element (GMarkupParseContext *parse_context, const gchar *element_name, const gchar **attribute_names,
@@ -70,9 +72,13 @@ static void element_text (GMarkupParseContext G_GNUC_UNUSED *parse_context, cons
 			  gsize G_GNUC_UNUSED text_len, gpointer menu_building_pnt, GError G_GNUC_UNUSED **error);
 static gboolean elements_visibility (GtkTreeModel *local_model, GtkTreePath *local_path,
 				     GtkTreeIter *local_iter, GSList **menu_and_items_without_label);
+static void set_elements_visibility (GtkTreeModel *local_model, GSList **menus_and_items_without_label);
 static void create_dialogs_for_invisible_menus_and_items (guint8 dialog_type, GtkTreeSelection *selection, 
 							  GSList **menus_and_items_without_label);
+static gboolean fill_treestore_from_menu_file (GtkTreeStore *local_treestore, gchar *new_filename, 
+					       gchar *menu_file_content);
 void get_tree_row_data (gchar *new_filename);
+GtkTreeStore *get_treestore_of_menu_file_content (gchar *menu_file_content);
 void open_menu (void);
 
 /* 
@@ -383,6 +389,7 @@ static void start_element (GMarkupParseContext  *parse_context,
 
       if (!icon_img_status) {
 	icon_img = gdk_pixbuf_scale_simple (icon_in_original_size, font_size + 10, font_size + 10, GDK_INTERP_BILINEAR);
+	store_original_icon (icon_path, icon_in_original_size);
 	free_and_reassign (icon_modified, get_modified_date_for_icon (icon_path));
 
 	// Cleanup
@@ -493,6 +500,12 @@ static void element_text (GMarkupParseContext G_GNUC_UNUSED  *parse_context,
     if ((streq (current_element, "enabled") || 
 	 (streq (current_element, "prompt") && streq_any (current_action, "Exit", "SessionLogout", NULL)))
 	&& !streq_any (*current_text, "yes", "no", NULL)) {
+      // A silent loading process takes the same value as if the dialog below had been closed.
+      if (menu_building->silent_loading) {
+	free_and_reassign (*current_text, g_strdup ("no"));
+	return;
+      }
+
       GtkWidget *dialog;
       gchar *dialog_title_txt, *dialog_txt;
       gint result;
@@ -534,7 +547,7 @@ static gboolean elements_visibility (GtkTreeModel  *local_model,
 {
   gchar *type_txt, *element_visibility_txt;
 
-  gtk_tree_model_get (model, local_iter, 
+  gtk_tree_model_get (local_model, local_iter, 
 		      TS_TYPE, &type_txt, 
 		      TS_ELEMENT_VISIBILITY, &element_visibility_txt, -1);
 
@@ -552,8 +565,8 @@ static gboolean elements_visibility (GtkTreeModel  *local_model,
   GtkTreeSelection *selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview));
   gchar *menu_element_txt;
 
-  get_toplevel_iter_from_path (&iter_toplevel, local_path);
-  gtk_tree_model_get (model, &iter_toplevel, TS_ELEMENT_VISIBILITY, &element_visibility_txt_toplevel, -1);
+  gtk_tree_model_iter_nth_child (local_model, &iter_toplevel, NULL, gtk_tree_path_get_indices (local_path)[0]);
+  gtk_tree_model_get (local_model, &iter_toplevel, TS_ELEMENT_VISIBILITY, &element_visibility_txt_toplevel, -1);
 
   gtk_tree_model_get (local_model, local_iter, TS_MENU_ELEMENT, &menu_element_txt, -1);
 
@@ -574,7 +587,8 @@ static gboolean elements_visibility (GtkTreeModel  *local_model,
       }
     }
 
-    gtk_tree_store_set (treestore, local_iter, TS_ELEMENT_VISIBILITY, new_element_visibility_txt, -1);
+    gtk_tree_store_set (GTK_TREE_STORE (local_model), local_iter, 
+			TS_ELEMENT_VISIBILITY, new_element_visibility_txt, -1);
   }
 
   /* if the function is called from the "Missing Labels" dialog, the menus_and_items_without_label lists were already 
@@ -622,6 +636,35 @@ static gboolean elements_visibility (GtkTreeModel  *local_model,
   return FALSE;
 }
 
+/* 
+
+   Runs elements_visibility for all menus, pipe menus, items and separators. 
+   Only menus are descended into, so actions and options, which don't have a visibility status, 
+   are skipped without being visited. 
+
+*/
+
+static void set_elements_visibility (GtkTreeModel  *local_model, 
+				     GSList       **menus_and_items_without_label)
+{
+  GtkTreeIter iter_loop;
+  GtkTreePath *path_loop;
+  gchar *type_txt_loop;
+  gboolean valid = gtk_tree_model_get_iter_first (local_model, &iter_loop);
+
+  while (valid) {
+    path_loop = gtk_tree_model_get_path (local_model, &iter_loop);
+    gtk_tree_model_get (local_model, &iter_loop, TS_TYPE, &type_txt_loop, -1);
+
+    elements_visibility (local_model, path_loop, &iter_loop, menus_and_items_without_label);
+    valid = get_next_row_in_preorder (local_model, &iter_loop, -1, streq (type_txt_loop, "menu"));
+
+    // Cleanup
+    gtk_tree_path_free (path_loop);
+    g_free (type_txt_loop);
+  }
+}
+
 /* 
 
    Creates dialogs that ask about the handling of invisible menus and items.
@@ -847,7 +890,7 @@ static void create_dialogs_for_invisible_menus_and_items (guint8             dia
       }
     }
     if (dialog_type == MISSING_LABELS)
-      gtk_tree_model_foreach (model, (GtkTreeModelForeachFunc) elements_visibility, NULL);
+      set_elements_visibility (model, NULL);
 
     activate_change_done ();
 
@@ -863,15 +906,27 @@ static void create_dialogs_for_invisible_menus_and_items (guint8             dia
 
 /* 
 
-   Parses a menu file and appends collected elements to the tree view.
+   Parses a menu file and appends collected elements to the passed treestore.
+
+   If the content of a menu file is passed instead of a filename, the menu is loaded silently:
+   No dialogs are shown and neither the tree view nor the global data of the currently opened menu are touched, 
+   only the passed treestore is filled.
 
 */
 
-void get_tree_row_data (gchar *new_filename)
+static gboolean fill_treestore_from_menu_file (GtkTreeStore *local_treestore, 
+					       gchar        *new_filename, 
+					       gchar        *menu_file_content)
 {
-  FILE *file;
+  GtkTreeModel *local_model = GTK_TREE_MODEL (local_treestore);
+  gboolean silent_loading = (menu_file_content != NULL);
+  FILE *file = (silent_loading) ? 
+    fmemopen (menu_file_content, strlen (menu_file_content), "r") : fopen (new_filename, "r");
+
+  if (!file) {
+    if (silent_loading)
+      return FALSE;
 
-  if (!(file = fopen (new_filename, "r"))) {
     gchar *err_txt = g_strdup_printf ("<b>Could not open menu</b>\n<tt>%s</tt><b>!</b>", new_filename);
     show_errmsg (err_txt);
 
@@ -879,7 +934,7 @@ void get_tree_row_data (gchar *new_filename)
     g_free (err_txt);
     g_free (new_filename);
 
-    return;
+    return FALSE;
   }
 
   gchar *line = NULL;
@@ -895,12 +950,13 @@ void get_tree_row_data (gchar *new_filename)
     .max_path_depth =                      1, 
     .menu_ids =                            NULL,
     .toplevel_menu_ids =                   { NULL }, 
-    .icon_creation_error_handling =        UNDEFINED, 
+    .icon_creation_error_handling =        (silent_loading) ? IGNORE_ALL_UPCOMING_ERRORS : UNDEFINED, 
     .current_action =                      NULL, 
     .previous_type =                       NULL, 
     .dep_exe_cmds_have_been_converted =    FALSE, 
     .loading_stage =                       MENUS, 
-    .root_menu_finished =                  FALSE
+    .root_menu_finished =                  FALSE, 
+    .silent_loading =                      silent_loading
   };
 
   GMarkupParser parser = { start_element, end_element, element_text, NULL, NULL };
@@ -908,8 +964,17 @@ void get_tree_row_data (gchar *new_filename)
 
   guint8 ts_build_cnt;
 
+  gboolean menu_file_loaded = FALSE; // Default
+
   while (getline (&line, &length, file) != -1) {
     if (!g_markup_parse_context_parse (parse_context, line, strlen (line), &error)) {
+      if (silent_loading) {
+	// Cleanup
+	g_error_free (error);
+
+	goto parsing_abort;
+      }
+
       gchar *pure_errmsg, *escaped_markup_txt;
       GString *full_errmsg = g_string_new ("");
 
@@ -957,11 +1022,16 @@ void get_tree_row_data (gchar *new_filename)
     menu_building.treestore_build[ts_build_cnt] = g_slist_reverse (menu_building.treestore_build[ts_build_cnt]);
 
 
+  menu_file_loaded = TRUE;
+
+
   // --- Menu file loaded without erros, now (re)set global variables. ---
 
-  clear_global_static_data ();
-  menu_ids = g_slist_copy_deep (menu_building.menu_ids, (GCopyFunc) g_strdup, NULL);
-  set_filename_and_window_title (new_filename);
+  if (!silent_loading) {
+    clear_global_static_data ();
+    menu_ids = g_slist_copy_deep (menu_building.menu_ids, (GCopyFunc) g_strdup, NULL);
+    set_filename_and_window_title (new_filename);
+  }
 
 
   // --- Fill treestore. ---
@@ -997,7 +1067,7 @@ void get_tree_row_data (gchar *new_filename)
     menu_building_loop[ts_build_cnt] = menu_building.treestore_build[ts_build_cnt];
   while (menu_building_loop[TS_BUILD_MENU_ELEMENT]) {
     if (streq (menu_building_loop[TS_BUILD_MENU_ID]->data, "root-menu")) {
-      number_of_toplevel_menu_ids = gtk_tree_model_iter_n_children (model, NULL);
+      number_of_toplevel_menu_ids = gtk_tree_model_iter_n_children (local_model, NULL);
       root_menu_stage = TRUE;
       
       if (number_of_toplevel_menu_ids) {
@@ -1017,12 +1087,12 @@ void get_tree_row_data (gchar *new_filename)
 	for (g_slist_loop = menu_building.toplevel_menu_ids[ROOT_MENU]; 
 	     g_slist_loop; 
 	     g_slist_loop = g_slist_loop->next) {
-	  valid = gtk_tree_model_get_iter_first (model, &iter_loop);
+	  valid = gtk_tree_model_get_iter_first (local_model, &iter_loop);
 	  while (valid) {
-	    gtk_tree_model_get (model, &iter_loop, TS_MENU_ID, &menu_id_txt_loop, -1);
+	    gtk_tree_model_get (local_model, &iter_loop, TS_MENU_ID, &menu_id_txt_loop, -1);
 	    if (streq (g_slist_loop->data, menu_id_txt_loop)) {
-	      gtk_tree_model_get (model, &iter_loop, TS_MENU_ELEMENT, &menu_element_txt_loop, -1);
-	      gtk_tree_store_set (treestore, &iter_loop, TS_ELEMENT_VISIBILITY, 
+	      gtk_tree_model_get (local_model, &iter_loop, TS_MENU_ELEMENT, &menu_element_txt_loop, -1);
+	      gtk_tree_store_set (local_treestore, &iter_loop, TS_ELEMENT_VISIBILITY, 
 				  (menu_element_txt_loop) ? "visible" : "invisible menu", -1);
 	      menu_ids_of_visible_toplevel_menus_defined_outside_root = 
 		g_slist_prepend (menu_ids_of_visible_toplevel_menus_defined_outside_root, g_strdup (menu_id_txt_loop));
@@ -1032,7 +1102,7 @@ void get_tree_row_data (gchar *new_filename)
 
 	      break;
 	    }
-	    valid = gtk_tree_model_iter_next (model, &iter_loop);
+	    valid = gtk_tree_model_iter_next (local_model, &iter_loop);
 
 	    // Cleanup
 	    g_free (menu_id_txt_loop);
@@ -1043,16 +1113,16 @@ void get_tree_row_data (gchar *new_filename)
 	   keeping their original order, and mark them as invisible. */
 
 	invisible_menu_outside_root_index = number_of_toplevel_menu_ids - 1;
-	valid = gtk_tree_model_iter_nth_child (model, &iter_loop, NULL, invisible_menu_outside_root_index);
+	valid = gtk_tree_model_iter_nth_child (local_model, &iter_loop, NULL, invisible_menu_outside_root_index);
 	while (valid) {
-	  gtk_tree_model_get (model, &iter_loop, TS_ELEMENT_VISIBILITY, &element_visibility_txt_loop, -1);
+	  gtk_tree_model_get (local_model, &iter_loop, TS_ELEMENT_VISIBILITY, &element_visibility_txt_loop, -1);
 	  if (!element_visibility_txt_loop) {
-	    gtk_tree_store_set (treestore, &iter_loop, TS_ELEMENT_VISIBILITY, "invisible unintegrated menu", -1);
-	    gtk_tree_model_iter_nth_child (model, &iter_swap, NULL, invisible_menu_outside_root_index--);
-	    gtk_tree_store_swap (treestore, &iter_loop, &iter_swap);
+	    gtk_tree_store_set (local_treestore, &iter_loop, TS_ELEMENT_VISIBILITY, "invisible unintegrated menu", -1);
+	    gtk_tree_model_iter_nth_child (local_model, &iter_swap, NULL, invisible_menu_outside_root_index--);
+	    gtk_tree_store_swap (local_treestore, &iter_loop, &iter_swap);
 	    iter_loop = iter_swap;
 	  }
-	  valid = gtk_tree_model_iter_previous (model, &iter_loop);
+	  valid = gtk_tree_model_iter_previous (local_model, &iter_loop);
 
 	  // Cleanup
 	  g_free (element_visibility_txt_loop);
@@ -1061,18 +1131,18 @@ void get_tree_row_data (gchar *new_filename)
 	/* The order of the toplevel menus depends on the order inside the root menu, 
 	   so the menus are sorted accordingly to it. */
 
-	gtk_tree_model_get_iter_first (model, &iter_loop);
+	gtk_tree_model_get_iter_first (local_model, &iter_loop);
 	for (g_slist_loop = menu_ids_of_visible_toplevel_menus_defined_outside_root; 
 	     g_slist_loop; 
 	     g_slist_loop = g_slist_loop->next) {
-	  gtk_tree_model_get (model, &iter_loop, TS_MENU_ID, &menu_id_txt_loop, -1);
+	  gtk_tree_model_get (local_model, &iter_loop, TS_MENU_ID, &menu_id_txt_loop, -1);
 
 	  if (!streq (g_slist_loop->data, menu_id_txt_loop)) {
 	    for (root_menus_cnt = number_of_used_toplevel_root_menus + 1; // = 1 at first time.
 		 root_menus_cnt <= invisible_menu_outside_root_index; 
 		 root_menus_cnt++) {
-	      gtk_tree_model_iter_nth_child (model, &iter_swap, NULL, root_menus_cnt);
-	      gtk_tree_model_get (model, &iter_swap, TS_MENU_ID, &menu_id_txt_sub_loop, -1);
+	      gtk_tree_model_iter_nth_child (local_model, &iter_swap, NULL, root_menus_cnt);
+	      gtk_tree_model_get (local_model, &iter_swap, TS_MENU_ID, &menu_id_txt_sub_loop, -1);
 	      if (streq (g_slist_loop->data, menu_id_txt_sub_loop)) {
 		// Cleanup
 		g_free (menu_id_txt_sub_loop);
@@ -1081,10 +1151,10 @@ void get_tree_row_data (gchar *new_filename)
 	      // Cleanup
 	      g_free (menu_id_txt_sub_loop);
 	    }
-	    gtk_tree_store_swap (treestore, &iter_loop, &iter_swap);
+	    gtk_tree_store_swap (local_treestore, &iter_loop, &iter_swap);
 	  }
 
-	  gtk_tree_model_iter_nth_child (model, &iter_loop, NULL, ++number_of_used_toplevel_root_menus);
+	  gtk_tree_model_iter_nth_child (local_model, &iter_loop, NULL, ++number_of_used_toplevel_root_menus);
 
 	  // Cleanup
 	  g_free (menu_id_txt_loop);
@@ -1112,12 +1182,12 @@ void get_tree_row_data (gchar *new_filename)
 	     toplevel menu inside the treeview (it will exist if it has already been defined outside the root menu),
 	     and if one exists, add the icon data to this toplevel menu. */
 	  if (menu_building_loop[TS_BUILD_ICON_IMG]->data) {
-	    valid = gtk_tree_model_get_iter_first (model, &iter_loop);
+	    valid = gtk_tree_model_get_iter_first (local_model, &iter_loop);
 	    while (valid) {
-	      gtk_tree_model_get (model, &iter_loop, TS_MENU_ID, &menu_id_txt_loop, -1);
+	      gtk_tree_model_get (local_model, &iter_loop, TS_MENU_ID, &menu_id_txt_loop, -1);
 	      if (streq (menu_building_loop[TS_BUILD_MENU_ID]->data, menu_id_txt_loop)) {
 		for (ts_build_cnt = 0; ts_build_cnt <= TS_BUILD_ICON_PATH; ts_build_cnt++)
-		  gtk_tree_store_set (treestore, &iter_loop, ts_build_cnt, menu_building_loop[ts_build_cnt]->data, -1);
+		  gtk_tree_store_set (local_treestore, &iter_loop, ts_build_cnt, menu_building_loop[ts_build_cnt]->data, -1);
 		
 		// Cleanup
 		g_free (menu_id_txt_loop);
@@ -1126,7 +1196,7 @@ void get_tree_row_data (gchar *new_filename)
 	      // Cleanup
 	      g_free (menu_id_txt_loop);
 	      
-	      valid = gtk_tree_model_iter_next (model, &iter_loop);
+	      valid = gtk_tree_model_iter_next (local_model, &iter_loop);
 	    }
 	  }
 
@@ -1142,21 +1212,20 @@ void get_tree_row_data (gchar *new_filename)
     if (add_row) {
       GtkTreePath *path;
 
-      gtk_tree_store_insert (treestore, &levels[current_level], (current_level == 0) ? 
+      gtk_tree_store_insert (local_treestore, &levels[current_level], (current_level == 0) ? 
 			     NULL : &levels[current_level - 1], 
 			     (menu_or_item_or_separator_at_root_toplevel) ? row_number : -1);
       
-      iter = levels[current_level];
-      path = gtk_tree_model_get_path (model, &iter);
+      path = gtk_tree_model_get_path (local_model, &levels[current_level]);
 
       for (ts_build_cnt = 0; ts_build_cnt < TS_BUILD_PATH_DEPTH; ts_build_cnt++)
-	gtk_tree_store_set (treestore, &iter, ts_build_cnt, menu_building_loop[ts_build_cnt]->data, -1);
+	gtk_tree_store_set (local_treestore, &levels[current_level], ts_build_cnt, menu_building_loop[ts_build_cnt]->data, -1);
 
       if (GPOINTER_TO_UINT (menu_building_loop[TS_ICON_IMG_STATUS]->data) && gtk_tree_path_get_depth (path) > 1) {
 	/* Add a row reference of a path of a menu, pipe menu or item that has an invalid icon path or 
 	   a path that points to a file that contains no valid image data. */
 	menus_and_items_with_inaccessible_icon_image = g_slist_prepend (menus_and_items_with_inaccessible_icon_image, 
-									gtk_tree_row_reference_new (model, path));
+									gtk_tree_row_reference_new (local_model, path));
       }
 
       // Cleanup
@@ -1171,19 +1240,23 @@ void get_tree_row_data (gchar *new_filename)
       menu_building_loop[ts_build_cnt] = menu_building_loop[ts_build_cnt]->next;
   }
 
-  g_signal_handler_block (selection, handler_id_row_selected);
+  if (silent_loading) // Without lists the tree view stays untouched and the visibility status of all elements is kept.
+    set_elements_visibility (local_model, NULL);
+  else {
+    g_signal_handler_block (selection, handler_id_row_selected);
 
-  // Show a message if there are invisible menus outside root.
-  if (number_of_used_toplevel_root_menus < number_of_toplevel_menu_ids)
-    create_dialogs_for_invisible_menus_and_items (UNINTEGRATED_MENUS, selection, NULL);
+    // Show a message if there are invisible menus outside root.
+    if (number_of_used_toplevel_root_menus < number_of_toplevel_menu_ids)
+      create_dialogs_for_invisible_menus_and_items (UNINTEGRATED_MENUS, selection, NULL);
 
-  gtk_tree_model_foreach (model, (GtkTreeModelForeachFunc) elements_visibility, menus_and_items_without_label);
+    set_elements_visibility (local_model, menus_and_items_without_label);
 
-  /* Show a message if there are menus and items without a label (=invisible). */
-  if (menus_and_items_without_label[MENUS_LIST] || menus_and_items_without_label[ITEMS_LIST])
-    create_dialogs_for_invisible_menus_and_items (MISSING_LABELS, selection, menus_and_items_without_label);
+    /* Show a message if there are menus and items without a label (=invisible). */
+    if (menus_and_items_without_label[MENUS_LIST] || menus_and_items_without_label[ITEMS_LIST])
+      create_dialogs_for_invisible_menus_and_items (MISSING_LABELS, selection, menus_and_items_without_label);
 
-  g_signal_handler_unblock (selection, handler_id_row_selected);
+    g_signal_handler_unblock (selection, handler_id_row_selected);
+  }
 
 
   // --- Finalisation ---
@@ -1191,7 +1264,10 @@ void get_tree_row_data (gchar *new_filename)
 
   // Pre-sort options of Execute action and startupnotify, if autosorting is activated.
   if (autosort_options)
-    gtk_tree_model_foreach (model, (GtkTreeModelForeachFunc) sort_loop_after_sorting_activation, NULL);
+    gtk_tree_model_foreach (local_model, (GtkTreeModelForeachFunc) sort_loop_after_sorting_activation, NULL);
+
+  if (silent_loading)
+    goto cleanup;
 
   // Expand nodes that contain a broken icon.
   gtk_tree_view_collapse_all (GTK_TREE_VIEW (treeview));
@@ -1241,6 +1317,7 @@ void get_tree_row_data (gchar *new_filename)
   // --- Cleanup ---
 
 
+ cleanup:
   g_free (levels);
 
   g_slist_free_full (menus_and_items_with_inaccessible_icon_image, (GDestroyNotify) gtk_tree_row_reference_free);
@@ -1273,6 +1350,48 @@ void get_tree_row_data (gchar *new_filename)
 
   g_free (menu_building.current_action);
   g_free (menu_building.previous_type);
+
+  return menu_file_loaded;
+}
+
+/* 
+
+   Parses a menu file and appends collected elements to the tree view.
+
+*/
+
+void get_tree_row_data (gchar *new_filename)
+{
+  if (fill_treestore_from_menu_file (treestore, new_filename, NULL))
+    open_journal ();
+}
+
+/* 
+
+   Loads the content of a menu file silently into a treestore of its own, 
+   so it can be compared with the currently edited menu. Returns NULL if the content could not be parsed.
+
+*/
+
+GtkTreeStore *get_treestore_of_menu_file_content (gchar *menu_file_content)
+{
+  gint number_of_columns = gtk_tree_model_get_n_columns (model);
+  GType column_types[number_of_columns];
+
+  GtkTreeStore *loaded_treestore;
+
+  for (gint columns_cnt = 0; columns_cnt < number_of_columns; columns_cnt++)
+    column_types[columns_cnt] = gtk_tree_model_get_column_type (model, columns_cnt);
+  loaded_treestore = gtk_tree_store_newv (number_of_columns, column_types);
+
+  if (!fill_treestore_from_menu_file (loaded_treestore, NULL, menu_file_content)) {
+    // Cleanup
+    g_object_unref (loaded_treestore);
+
+    return NULL;
+  }
+
+  return loaded_treestore;
 }
 
 /* 
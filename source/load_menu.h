@@ -27,7 +27,6 @@ extern GtkWidget *window;
 extern GtkTreeStore *treestore;
 extern GtkTreeModel *model;
 extern GtkWidget *treeview;
-extern GtkTreeIter iter;
 
 extern GtkWidget *mb_view_and_options[];
 
@@ -53,12 +52,16 @@ extern GtkWidget *create_dialog (GtkWidget **dialog, gchar *dialog_title, gchar
 extern void create_file_dialog (GtkWidget **dialog, gchar *dialog_title);
 extern void create_list_of_icon_occurrences (void);
 extern gchar *extract_substring_via_regex (gchar *string, gchar *regex_str);
+extern gboolean get_next_row_in_preorder (GtkTreeModel *local_model, GtkTreeIter *local_iter, gint root_depth, 
+					  gboolean descend);
 extern void get_toplevel_iter_from_path (GtkTreeIter *local_iter, GtkTreePath *local_path);
 extern GtkWidget *new_label_with_formattings (gchar *label_txt);
+extern void open_journal (void);
 extern void remove_rows (gchar *origin);
 extern void row_selected (void);
 extern void set_filename_and_window_title (gchar *new_filename);
 extern void show_errmsg (gchar *errmsg_raw_txt);
+extern void store_original_icon (const gchar *icon_path, GdkPixbuf *icon_in_original_size);
 extern gboolean sort_loop_after_sorting_activation (GtkTreeModel *local_model, GtkTreePath G_GNUC_UNUSED *local_path,
 						    GtkTreeIter *local_iter);
 extern gchar *get_modified_date_for_icon (gchar *icon_path);
@@ -0,0 +1,800 @@
+/*
+   Kickshaw - A Menu Editor for Openbox
+
+   Copyright (c) 2010-2013        Marcus Schaetzle
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along 
+   with Kickshaw. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <gtk/gtk.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "general_header_files/enum__columns.h"
+#include "general_header_files/enum__ts_elements.h"
+#include "general_header_files/struct__match_record.h"
+#include "query.h"
+
+/* 
+
+   Query syntax:
+
+   term                  Free text, searched inside the chosen columns (regular expression if activated).
+   "a term"              Free text that contains spaces or special characters.
+   field:value           Field value starts with value. "field:" alone matches if the field has any value.
+   field=value           Field value equals value.
+   field~regex           Field value contains a match of the regular expression.
+   depth:n, depth<n,
+   depth>n, depth<=n,
+   depth>=n              Compares the depth of a row (toplevel rows have a depth of 1).
+   -expression           Negation.
+   a b                   Both expressions have to match.
+   a | b                 At least one of the expressions has to match.
+   ( ... )               Grouping.
+
+   Fields: label, type, value, id, execute, visibility, icon, action, depth and the options
+   command, prompt, enabled, wmclass and name. Action and option fields of items, actions and option blocks
+   refer to their descendants, those of options refer to their ancestors.
+
+*/
+
+enum { QUERY_OR, QUERY_AND, QUERY_NOT, QUERY_TERM };
+enum { FIELD_TEXT, FIELD_LABEL, FIELD_TYPE, FIELD_VALUE, FIELD_MENU_ID, FIELD_EXECUTE, FIELD_VISIBILITY,
+       FIELD_ICON, FIELD_ACTION, FIELD_DEPTH, FIELD_OPTION };
+enum { OP_PREFIX, OP_EQUAL, OP_REGEX, OP_EXISTS, OP_LESS, OP_LESS_OR_EQUAL, OP_GREATER, OP_GREATER_OR_EQUAL };
+
+struct query_node {
+  guint8 node_type;
+  GSList *children; // QUERY_OR, QUERY_AND and QUERY_NOT
+
+  // QUERY_TERM
+  guint8 field;
+  guint8 operator;
+  gchar *option_name; // FIELD_OPTION
+  GRegex *regex; // Text comparisons, including OP_PREFIX and OP_EQUAL.
+  gint number; // FIELD_DEPTH
+  guint8 columns_to_search; // FIELD_TEXT
+};
+
+struct query_parser {
+  const gchar *pos;
+  gboolean match_case;
+  gboolean regular_expression;
+  guint8 columns_to_search;
+  gchar *error_txt;
+};
+
+static const gchar *query_fields[] = { "label", "type", "value", "id", "execute", "visibility", "icon", "action",
+				       "depth", "command", "prompt", "enabled", "wmclass", "name" };
+// Treestore columns of the fields from FIELD_LABEL to FIELD_ICON.
+static const guint8 query_field_ts_columns[] = { TS_MENU_ELEMENT, TS_TYPE, TS_VALUE, TS_MENU_ID, TS_EXECUTE,
+						 TS_ELEMENT_VISIBILITY, TS_ICON_PATH };
+
+static inline void skip_whitespace (struct query_parser *parser);
+static struct query_node *new_query_node (guint8 node_type);
+static struct query_node *parse_or_expression (struct query_parser *parser);
+static struct query_node *parse_and_expression (struct query_parser *parser);
+static struct query_node *parse_unary_expression (struct query_parser *parser);
+static struct query_node *parse_term (struct query_parser *parser);
+static gchar *parse_value (struct query_parser *parser);
+struct query_node *compile_query (const gchar *query_str, gboolean match_case, gboolean regular_expression,
+				  guint8 columns_to_search, gchar **error_txt);
+void free_query (struct query_node *query);
+static void collect_option_values (GtkTreeIter *parent, const gchar *option_name, GSList **values);
+static GSList *get_related_values (struct query_node *term, GtkTreeIter *query_iter);
+static gboolean evaluate_term (struct query_node *term, GtkTreePath *query_path, GtkTreeIter *query_iter);
+gboolean evaluate_query (struct query_node *query, GtkTreePath *query_path, GtkTreeIter *query_iter);
+static void add_match_ranges (GArray **ranges, GRegex *regex, const gchar *cell_txt);
+static void sort_and_merge_ranges (GArray *ranges);
+static void collect_ranges_of_node (struct query_node *node, GtkTreePath *query_path,
+				    GtkTreeIter *query_iter, GArray **ranges);
+void collect_query_match_ranges (struct query_node *query, GtkTreePath *query_path,
+				 GtkTreeIter *query_iter, GArray **ranges);
+
+/* 
+
+   Moves the parser position behind any whitespace.
+
+*/
+
+static inline void skip_whitespace (struct query_parser *parser)
+{
+  while (g_ascii_isspace (*parser->pos))
+    (parser->pos)++;
+}
+
+/* 
+
+   Creates a new, empty node of the predicate tree.
+
+*/
+
+static struct query_node *new_query_node (guint8 node_type)
+{
+  struct query_node *node = g_slice_new0 (struct query_node);
+
+  node->node_type = node_type;
+
+  return node;
+}
+
+/* 
+
+   Parses alternatives separated by "|".
+
+*/
+
+static struct query_node *parse_or_expression (struct query_parser *parser)
+{
+  struct query_node *node, *or_node;
+
+  if (!(node = parse_and_expression (parser)))
+    return NULL;
+
+  skip_whitespace (parser);
+  if (*parser->pos != '|')
+    return node;
+
+  or_node = new_query_node (QUERY_OR);
+  or_node->children = g_slist_prepend (or_node->children, node);
+
+  while (*parser->pos == '|') {
+    (parser->pos)++;
+    if (!(node = parse_and_expression (parser))) {
+      free_query (or_node);
+      return NULL;
+    }
+    or_node->children = g_slist_prepend (or_node->children, node);
+    skip_whitespace (parser);
+  }
+
+  or_node->children = g_slist_reverse (or_node->children);
+
+  return or_node;
+}
+
+/* 
+
+   Parses a sequence of expressions that all have to match.
+
+*/
+
+static struct query_node *parse_and_expression (struct query_parser *parser)
+{
+  struct query_node *and_node = new_query_node (QUERY_AND);
+  struct query_node *node;
+
+  skip_whitespace (parser);
+  while (*parser->pos && *parser->pos != '|' && *parser->pos != ')') {
+    if (!(node = parse_unary_expression (parser))) {
+      free_query (and_node);
+      return NULL;
+    }
+    and_node->children = g_slist_prepend (and_node->children, node);
+    skip_whitespace (parser);
+  }
+
+  if (!and_node->children) {
+    free_query (and_node);
+    parser->error_txt = g_strdup ("Empty expression");
+    return NULL;
+  }
+
+  // A single expression doesn't need an enclosing node.
+  if (!and_node->children->next) {
+    node = and_node->children->data;
+    g_slist_free (and_node->children);
+    g_slice_free (struct query_node, and_node);
+    return node;
+  }
+
+  and_node->children = g_slist_reverse (and_node->children);
+
+  return and_node;
+}
+
+/* 
+
+   Parses a negation, a group inside parentheses or a single term.
+
+*/
+
+static struct query_node *parse_unary_expression (struct query_parser *parser)
+{
+  struct query_node *node, *not_node;
+
+  if (*parser->pos == '-') {
+    (parser->pos)++;
+    if (!(*parser->pos) || g_ascii_isspace (*parser->pos)) {
+      parser->error_txt = g_strdup ("Nothing to negate after '-'");
+      return NULL;
+    }
+    if (!(node = parse_unary_expression (parser)))
+      return NULL;
+    not_node = new_query_node (QUERY_NOT);
+    not_node->children = g_slist_prepend (NULL, node);
+
+    return not_node;
+  }
+
+  if (*parser->pos == '(') {
+    (parser->pos)++;
+    if (!(node = parse_or_expression (parser)))
+      return NULL;
+    if (*parser->pos != ')') {
+      free_query (node);
+      parser->error_txt = g_strdup ("Missing ')'");
+      return NULL;
+    }
+    (parser->pos)++;
+
+    return node;
+  }
+
+  return parse_term (parser);
+}
+
+/* 
+
+   Parses a value, either inside double quotes or up to the next whitespace, parenthesis or "|".
+
+*/
+
+static gchar *parse_value (struct query_parser *parser)
+{
+  const gchar *value_start;
+
+  if (*parser->pos == '"') {
+    value_start = ++(parser->pos);
+    while (*parser->pos && *parser->pos != '"')
+      (parser->pos)++;
+    if (!(*parser->pos)) {
+      parser->error_txt = g_strdup ("Missing closing '\"'");
+      return NULL;
+    }
+
+    return g_strndup (value_start, (parser->pos)++ - value_start);
+  }
+
+  value_start = parser->pos;
+  while (*parser->pos && !g_ascii_isspace (*parser->pos) && !strchr ("()|", *parser->pos))
+    (parser->pos)++;
+
+  return g_strndup (value_start, parser->pos - value_start);
+}
+
+/* 
+
+   Parses a single term and compiles its comparison.
+
+*/
+
+static struct query_node *parse_term (struct query_parser *parser)
+{
+  struct query_node *term = new_query_node (QUERY_TERM);
+  const gchar *field_start = parser->pos;
+  gchar *field_name, *value, *pattern;
+
+  guint8 fields_cnt;
+
+  // Defaults
+  term->field = FIELD_TEXT;
+  term->operator = OP_REGEX;
+
+  while (g_ascii_isalpha (*parser->pos))
+    (parser->pos)++;
+
+  if (parser->pos > field_start && *parser->pos && strchr (":=~<>", *parser->pos)) {
+    field_name = g_ascii_strdown (field_start, parser->pos - field_start);
+    for (fields_cnt = 0; fields_cnt < G_N_ELEMENTS (query_fields); fields_cnt++) {
+      if (streq (field_name, query_fields[fields_cnt]))
+	break;
+    }
+    if (fields_cnt < G_N_ELEMENTS (query_fields)) {
+      term->field = (fields_cnt <= FIELD_DEPTH - 1) ? fields_cnt + 1 : FIELD_OPTION;
+      if (term->field == FIELD_OPTION)
+	term->option_name = g_strdup (query_fields[fields_cnt]);
+    }
+
+    // Cleanup
+    g_free (field_name);
+  }
+
+  if (term->field == FIELD_TEXT) {
+    // Not a known field, so the whole term is free text.
+    parser->pos = field_start;
+    term->columns_to_search = parser->columns_to_search;
+  }
+  else {
+    switch (*(parser->pos)++) {
+    case ':':
+      term->operator = OP_PREFIX;
+      break;
+    case '=':
+      term->operator = OP_EQUAL;
+      break;
+    case '~':
+      term->operator = OP_REGEX;
+      break;
+    default: // '<' or '>'
+      term->operator = (*(parser->pos - 1) == '<') ? OP_LESS : OP_GREATER;
+      if (*parser->pos == '=') {
+	term->operator++; // OP_LESS_OR_EQUAL or OP_GREATER_OR_EQUAL
+	(parser->pos)++;
+      }
+      if (term->field != FIELD_DEPTH) {
+	parser->error_txt = g_strdup ("'<' and '>' can only be used for the depth field");
+	free_query (term);
+	return NULL;
+      }
+    }
+  }
+
+  if (!(value = parse_value (parser))) {
+    free_query (term);
+    return NULL;
+  }
+
+  if (term->field == FIELD_DEPTH) {
+    gchar *end_of_number;
+
+    term->number = strtol (value, &end_of_number, 10);
+    if (!(*value) || *end_of_number) {
+      parser->error_txt = g_strdup_printf ("'%s' is not a valid depth", value);
+      // Cleanup
+      g_free (value);
+      free_query (term);
+      return NULL;
+    }
+    if (term->operator == OP_PREFIX || term->operator == OP_REGEX)
+      term->operator = OP_EQUAL;
+  }
+  else if (term->operator == OP_PREFIX && !(*value))
+    term->operator = OP_EXISTS;
+  else if (!(*value)) {
+    parser->error_txt = g_strdup ("A search term is missing");
+    // Cleanup
+    g_free (value);
+    free_query (term);
+    return NULL;
+  }
+  else {
+    GError *error = NULL;
+    gchar *value_escaped = (term->operator == OP_REGEX &&
+			    (term->field != FIELD_TEXT || parser->regular_expression)) ?
+      NULL : g_regex_escape_string (value, -1);
+
+    if (term->operator == OP_PREFIX)
+      pattern = g_strconcat ("^", value_escaped, NULL);
+    else if (term->operator == OP_EQUAL)
+      pattern = g_strconcat ("^", value_escaped, "$", NULL);
+    else
+      pattern = g_strdup ((value_escaped) ? value_escaped : value);
+
+    if (!(term->regex = g_regex_new (pattern, (parser->match_case) ? 0 : G_REGEX_CASELESS, 0, &error))) {
+      parser->error_txt = g_strdup_printf ("Invalid regular expression '%s': %s", value, error->message);
+      // Cleanup
+      g_error_free (error);
+    }
+
+    // Cleanup
+    g_free (value_escaped);
+    g_free (pattern);
+
+    if (!term->regex) {
+      // Cleanup
+      g_free (value);
+      free_query (term);
+      return NULL;
+    }
+  }
+
+  // Cleanup
+  g_free (value);
+
+  return term;
+}
+
+/* 
+
+   Compiles a query into a predicate tree. Returns NULL and an error text in case of a syntax error.
+
+*/
+
+struct query_node *compile_query (const gchar  *query_str,
+				  gboolean      match_case,
+				  gboolean      regular_expression,
+				  guint8        columns_to_search,
+				  gchar       **error_txt)
+{
+  struct query_parser parser = {
+    .pos =                   query_str,
+    .match_case =            match_case,
+    .regular_expression =    regular_expression,
+    .columns_to_search =     columns_to_search,
+    .error_txt =             NULL
+  };
+  struct query_node *query = parse_or_expression (&parser);
+
+  if (query && *parser.pos) { // Only possible if there is a ')' without a preceding '('.
+    free_query (query);
+    query = NULL;
+    parser.error_txt = g_strdup ("Unexpected ')'");
+  }
+
+  if (!query)
+    *error_txt = parser.error_txt;
+
+  return query;
+}
+
+/* 
+
+   Frees a predicate tree.
+
+*/
+
+void free_query (struct query_node *query)
+{
+  g_slist_free_full (query->children, (GDestroyNotify) free_query);
+  g_free (query->option_name);
+  if (query->regex)
+    g_regex_unref (query->regex);
+  g_slice_free (struct query_node, query);
+}
+
+/* 
+
+   Collects the values of all options with a given name that are descendants of a row.
+
+*/
+
+static void collect_option_values (GtkTreeIter  *parent,
+				   const gchar  *option_name,
+				   GSList      **values)
+{
+  GtkTreeIter iter_loop;
+  gboolean valid;
+  gchar *type_txt_loop, *menu_element_txt_loop;
+
+  valid = gtk_tree_model_iter_children (model, &iter_loop, parent);
+  while (valid) {
+    gtk_tree_model_get (model, &iter_loop,
+			TS_TYPE, &type_txt_loop,
+			TS_MENU_ELEMENT, &menu_element_txt_loop,
+			-1);
+
+    if (streq (type_txt_loop, "option")) {
+      if (streq (menu_element_txt_loop, option_name)) {
+	*values = g_slist_prepend (*values, NULL);
+	gtk_tree_model_get (model, &iter_loop, TS_VALUE, &((*values)->data), -1);
+      }
+    }
+    else // Action or option block
+      collect_option_values (&iter_loop, option_name, values);
+
+    // Cleanup
+    g_free (type_txt_loop);
+    g_free (menu_element_txt_loop);
+
+    valid = gtk_tree_model_iter_next (model, &iter_loop);
+  }
+}
+
+/* 
+
+   Retrieves the values of action and option fields, which depend on the rows related to the current row.
+
+*/
+
+static GSList *get_related_values (struct query_node *term,
+				   GtkTreeIter       *query_iter)
+{
+  GSList *values = NULL;
+  gchar *type_txt, *menu_element_txt;
+
+  gtk_tree_model_get (model, query_iter,
+		      TS_TYPE, &type_txt,
+		      TS_MENU_ELEMENT, &menu_element_txt,
+		      -1);
+
+  if (term->field == FIELD_ACTION) {
+    if (streq (type_txt, "action")) {
+      values = g_slist_prepend (values, menu_element_txt);
+      menu_element_txt = NULL;
+    }
+    else if (streq (type_txt, "item")) {
+      GtkTreeIter iter_loop;
+      gboolean valid = gtk_tree_model_iter_children (model, &iter_loop, query_iter);
+
+      while (valid) {
+	values = g_slist_prepend (values, NULL);
+	gtk_tree_model_get (model, &iter_loop, TS_MENU_ELEMENT, &(values->data), -1);
+	valid = gtk_tree_model_iter_next (model, &iter_loop);
+      }
+    }
+    else if (streq_any (type_txt, "option", "option block", NULL)) {
+      GtkTreeIter iter_ancestor, iter_child = *query_iter;
+      gchar *type_txt_ancestor;
+
+      while (gtk_tree_model_iter_parent (model, &iter_ancestor, &iter_child)) {
+	gtk_tree_model_get (model, &iter_ancestor, TS_TYPE, &type_txt_ancestor, -1);
+	if (streq (type_txt_ancestor, "action")) {
+	  values = g_slist_prepend (values, NULL);
+	  gtk_tree_model_get (model, &iter_ancestor, TS_MENU_ELEMENT, &(values->data), -1);
+	  // Cleanup
+	  g_free (type_txt_ancestor);
+	  break;
+	}
+	// Cleanup
+	g_free (type_txt_ancestor);
+	iter_child = iter_ancestor;
+      }
+    }
+  }
+  else { // FIELD_OPTION
+    if (streq (type_txt, "option")) {
+      if (streq (menu_element_txt, term->option_name)) {
+	values = g_slist_prepend (values, NULL);
+	gtk_tree_model_get (model, query_iter, TS_VALUE, &(values->data), -1);
+      }
+    }
+    else if (streq_any (type_txt, "item", "action", "option block", NULL))
+      collect_option_values (query_iter, term->option_name, &values);
+  }
+
+  // Cleanup
+  g_free (type_txt);
+  g_free (menu_element_txt);
+
+  return values;
+}
+
+/* 
+
+   Evaluates a single term for the current row.
+
+*/
+
+static gboolean evaluate_term (struct query_node *term,
+			       GtkTreePath       *query_path,
+			       GtkTreeIter       *query_iter)
+{
+  gboolean match = FALSE; // Default
+  gchar *cell_txt;
+
+  if (term->field == FIELD_DEPTH) {
+    gint depth = gtk_tree_path_get_depth (query_path);
+
+    switch (term->operator) {
+    case OP_EQUAL:
+      return depth == term->number;
+    case OP_LESS:
+      return depth < term->number;
+    case OP_LESS_OR_EQUAL:
+      return depth <= term->number;
+    case OP_GREATER:
+      return depth > term->number;
+    default: // OP_GREATER_OR_EQUAL
+      return depth >= term->number;
+    }
+  }
+
+  if (term->field == FIELD_TEXT) {
+    for (guint8 columns_cnt = 0; columns_cnt < COL_ELEMENT_VISIBILITY && !match; columns_cnt++) {
+      if (!(term->columns_to_search & (1 << columns_cnt)))
+	continue;
+
+      gtk_tree_model_get (model, query_iter, columns_cnt + TREEVIEW_COLUMN_OFFSET, &cell_txt, -1);
+      match = (cell_txt && g_regex_match (term->regex, cell_txt, G_REGEX_MATCH_NOTEMPTY, NULL));
+
+      // Cleanup
+      g_free (cell_txt);
+    }
+
+    return match;
+  }
+
+  if (term->field <= FIELD_ICON) {
+    gtk_tree_model_get (model, query_iter, query_field_ts_columns[term->field - FIELD_LABEL], &cell_txt, -1);
+    match = (term->operator == OP_EXISTS) ? (cell_txt && *cell_txt) :
+      (cell_txt && g_regex_match (term->regex, cell_txt, 0, NULL));
+
+    // Cleanup
+    g_free (cell_txt);
+
+    return match;
+  }
+
+  // Action and option fields
+  GSList *values = get_related_values (term, query_iter);
+
+  for (GSList *values_loop = values; values_loop && !match; values_loop = values_loop->next) {
+    match = (term->operator == OP_EXISTS) ? (values_loop->data && *((gchar *) values_loop->data)) :
+      (values_loop->data && g_regex_match (term->regex, values_loop->data, 0, NULL));
+  }
+
+  // Cleanup
+  g_slist_free_full (values, (GDestroyNotify) g_free);
+
+  return match;
+}
+
+/* 
+
+   Evaluates the predicate tree for the current row.
+
+*/
+
+gboolean evaluate_query (struct query_node *query,
+			 GtkTreePath       *query_path,
+			 GtkTreeIter       *query_iter)
+{
+  GSList *children_loop;
+
+  switch (query->node_type) {
+  case QUERY_OR:
+    for (children_loop = query->children; children_loop; children_loop = children_loop->next) {
+      if (evaluate_query (children_loop->data, query_path, query_iter))
+	return TRUE;
+    }
+    return FALSE;
+  case QUERY_AND:
+    for (children_loop = query->children; children_loop; children_loop = children_loop->next) {
+      if (!evaluate_query (children_loop->data, query_path, query_iter))
+	return FALSE;
+    }
+    return TRUE;
+  case QUERY_NOT:
+    return !evaluate_query (query->children->data, query_path, query_iter);
+  default: // QUERY_TERM
+    return evaluate_term (query, query_path, query_iter);
+  }
+}
+
+/* 
+
+   Adds the byte ranges of all matches inside a cell to the ranges of a column.
+
+*/
+
+static void add_match_ranges (GArray      **ranges,
+			      GRegex       *regex,
+			      const gchar  *cell_txt)
+{
+  GArray *new_ranges;
+
+  if (!cell_txt || !(new_ranges = get_match_ranges (regex, cell_txt)))
+    return;
+
+  if (!(*ranges))
+    *ranges = new_ranges;
+  else {
+    g_array_append_vals (*ranges, new_ranges->data, new_ranges->len);
+    // Cleanup
+    g_array_free (new_ranges, TRUE);
+  }
+}
+
+/* 
+
+   Sorts the ranges of a column by their start offsets and merges overlapping ranges,
+   since several terms may match the same part of a cell.
+
+*/
+
+static void sort_and_merge_ranges (GArray *ranges)
+{
+  gint *offsets = (gint *) ranges->data;
+  guint number_of_ranges = ranges->len / 2;
+  guint ranges_cnt, ranges_cnt2, merged_cnt = 0;
+  gint start_pos, end_pos;
+
+  // Insertion sort, there are only a few ranges per cell.
+  for (ranges_cnt = 1; ranges_cnt < number_of_ranges; ranges_cnt++) {
+    start_pos = offsets[ranges_cnt * 2];
+    end_pos = offsets[ranges_cnt * 2 + 1];
+    for (ranges_cnt2 = ranges_cnt; ranges_cnt2 > 0 && offsets[(ranges_cnt2 - 1) * 2] > start_pos; ranges_cnt2--) {
+      offsets[ranges_cnt2 * 2] = offsets[(ranges_cnt2 - 1) * 2];
+      offsets[ranges_cnt2 * 2 + 1] = offsets[(ranges_cnt2 - 1) * 2 + 1];
+    }
+    offsets[ranges_cnt2 * 2] = start_pos;
+    offsets[ranges_cnt2 * 2 + 1] = end_pos;
+  }
+
+  for (ranges_cnt = 1; ranges_cnt < number_of_ranges; ranges_cnt++) {
+    if (offsets[ranges_cnt * 2] <= offsets[merged_cnt * 2 + 1])
+      offsets[merged_cnt * 2 + 1] = MAX (offsets[merged_cnt * 2 + 1], offsets[ranges_cnt * 2 + 1]);
+    else {
+      merged_cnt++;
+      offsets[merged_cnt * 2] = offsets[ranges_cnt * 2];
+      offsets[merged_cnt * 2 + 1] = offsets[ranges_cnt * 2 + 1];
+    }
+  }
+
+  g_array_set_size (ranges, (merged_cnt + 1) * 2);
+}
+
+/* 
+
+   Collects the match ranges of all terms that contributed to a match. Negated terms are not highlighted.
+
+*/
+
+static void collect_ranges_of_node (struct query_node  *node,
+				    GtkTreePath        *query_path,
+				    GtkTreeIter        *query_iter,
+				    GArray            **ranges)
+{
+  gchar *cell_txt;
+
+  if (node->node_type == QUERY_OR || node->node_type == QUERY_AND) {
+    for (GSList *children_loop = node->children; children_loop; children_loop = children_loop->next) {
+      if (evaluate_query (children_loop->data, query_path, query_iter))
+	collect_ranges_of_node (children_loop->data, query_path, query_iter, ranges);
+    }
+    return;
+  }
+
+  if (node->node_type == QUERY_NOT || !node->regex)
+    return;
+
+  if (node->field == FIELD_TEXT) {
+    for (guint8 columns_cnt = 0; columns_cnt < COL_ELEMENT_VISIBILITY; columns_cnt++) {
+      if (!(node->columns_to_search & (1 << columns_cnt)))
+	continue;
+
+      gtk_tree_model_get (model, query_iter, columns_cnt + TREEVIEW_COLUMN_OFFSET, &cell_txt, -1);
+      add_match_ranges (&ranges[columns_cnt], node->regex, cell_txt);
+
+      // Cleanup
+      g_free (cell_txt);
+    }
+  }
+  // Only fields that are displayed inside a column can be highlighted.
+  else if (node->field >= FIELD_LABEL && node->field <= FIELD_EXECUTE) {
+    gtk_tree_model_get (model, query_iter, query_field_ts_columns[node->field - FIELD_LABEL], &cell_txt, -1);
+    add_match_ranges (&ranges[node->field - FIELD_LABEL], node->regex, cell_txt);
+
+    // Cleanup
+    g_free (cell_txt);
+  }
+  // The icon path isn't displayed, but its ranges are needed for replacing.
+  else if (node->field == FIELD_ICON) {
+    gtk_tree_model_get (model, query_iter, TS_ICON_PATH, &cell_txt, -1);
+    add_match_ranges (&ranges[ICON_PATH_RANGES], node->regex, cell_txt);
+
+    // Cleanup
+    g_free (cell_txt);
+  }
+}
+
+/* 
+
+   Collects the match ranges for all columns and the icon path of a row that matches the query.
+
+*/
+
+void collect_query_match_ranges (struct query_node  *query,
+				 GtkTreePath        *query_path,
+				 GtkTreeIter        *query_iter,
+				 GArray            **ranges)
+{
+  collect_ranges_of_node (query, query_path, query_iter, ranges);
+
+  for (guint8 columns_cnt = 0; columns_cnt <= ICON_PATH_RANGES; columns_cnt++) {
+    if (ranges[columns_cnt])
+      sort_and_merge_ranges (ranges[columns_cnt]);
+  }
+}
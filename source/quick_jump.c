@@ -0,0 +1,718 @@
+/*
+   Kickshaw - A Menu Editor for Openbox
+
+   Copyright (c) 2010-2013        Marcus Schaetzle
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along 
+   with Kickshaw. If not, see http://www.gnu.org/licenses/.
+*/
+
+
+#include <gtk/gtk.h>
+#include <string.h>
+
+#include "general_header_files/enum__ts_elements.h"
+#include "quick_jump.h"
+
+#define QUICK_JUMP_MAX_RESULTS 50
+
+enum { QUICK_JUMP_LABEL, QUICK_JUMP_MENU_ID, QUICK_JUMP_COMMAND, NUMBER_OF_QUICK_JUMP_KINDS };
+enum { QJ_RESULT_MARKUP, QJ_RESULT_KIND, QJ_RESULT_LOCATION, QJ_RESULT_INDEX, NUMBER_OF_QJ_RESULT_COLUMNS };
+
+struct quick_jump_entry {
+  GtkTreePath *path;
+  gchar *txt;
+  guint64 char_mask; // One bit for each ASCII letter or digit that occurs inside the text.
+  guint8 kind;
+};
+
+struct quick_jump_result {
+  gint score;
+  guint index;
+};
+
+struct quick_jump_palette {
+  GtkWidget *dialog;
+  GtkWidget *entry;
+  GtkWidget *results_treeview;
+  GtkListStore *results_store;
+};
+
+static const gchar *quick_jump_kind_txts[] = { "Label", "Menu ID", "Command" };
+
+/* Built on first use after loading a menu, afterwards kept up to date by the change signals of the treestore. 
+   The entries are sorted in tree order, like the match records of find.c. */
+static GArray *quick_jump_index = NULL;
+
+static guint64 get_char_mask (const gchar *txt);
+static gchar *get_label_of_ancestor (GtkTreeIter *local_iter, guint8 generations);
+static void add_entry_to_index (GArray *entries, GtkTreePath *local_path, const gchar *txt, guint8 kind);
+static gboolean add_row_to_index (GtkTreeModel G_GNUC_UNUSED *local_model, GtkTreePath *local_path, 
+				  GtkTreeIter *local_iter, GArray *entries);
+static void clear_quick_jump_entry (struct quick_jump_entry *entry);
+void invalidate_quick_jump_index (void);
+static void build_quick_jump_index (void);
+static guint get_index_of_entry (GtkTreePath *path, gboolean behind_path);
+static void update_entries_of_row (GtkTreePath *path, GtkTreeIter *local_iter);
+static void shift_paths_of_entries (GtkTreePath *path, gint offset);
+static gint compare_quick_jump_entries (struct quick_jump_entry *entry_a, struct quick_jump_entry *entry_b);
+void quick_jump_index_row_inserted (GtkTreeModel G_GNUC_UNUSED *local_model, GtkTreePath *local_path, 
+				    GtkTreeIter *local_iter);
+void quick_jump_index_row_changed (GtkTreeModel G_GNUC_UNUSED *local_model, GtkTreePath *local_path, 
+				   GtkTreeIter *local_iter);
+void quick_jump_index_row_deleted (GtkTreeModel G_GNUC_UNUSED *local_model, GtkTreePath *local_path);
+void quick_jump_index_rows_reordered (GtkTreeModel G_GNUC_UNUSED *local_model, GtkTreePath *local_path, 
+				      GtkTreeIter *local_iter, gint *new_order);
+static gint get_fuzzy_score (const gchar *query_lowercase, const gchar *txt, GString *markup);
+static void update_quick_jump_results (struct quick_jump_palette *palette);
+static gboolean quick_jump_key_pressed (GtkWidget G_GNUC_UNUSED *widget, GdkEventKey *event, 
+					struct quick_jump_palette *palette);
+static void accept_quick_jump_result (struct quick_jump_palette *palette);
+static void jump_to_selected_result (struct quick_jump_palette *palette);
+void show_quick_jump_palette (const gchar *initial_txt);
+
+/* 
+
+   Returns a bit mask of the ASCII letters (case insensitive) and digits that occur inside a text. 
+   A text can only contain the query as a subsequence if its mask contains all bits of the query's mask, 
+   so most texts are rejected by a single AND operation before the scorer is run.
+
+*/
+
+static guint64 get_char_mask (const gchar *txt)
+{
+  guint64 char_mask = 0;
+  gchar lowercase_char;
+
+  for (; *txt; txt++) {
+    lowercase_char = g_ascii_tolower (*txt);
+    if (lowercase_char >= 'a' && lowercase_char <= 'z')
+      char_mask |= G_GUINT64_CONSTANT (1) << (lowercase_char - 'a');
+    else if (lowercase_char >= '0' && lowercase_char <= '9')
+      char_mask |= G_GUINT64_CONSTANT (1) << (lowercase_char - '0' + 26);
+  }
+
+  return char_mask;
+}
+
+/* 
+
+   Returns the label of the parent (generations = 1) or grandparent (generations = 2) of a row, 
+   or NULL if it is a toplevel row or the ancestor has no label.
+
+*/
+
+static gchar *get_label_of_ancestor (GtkTreeIter *local_iter, 
+				     guint8       generations)
+{
+  GtkTreeIter child = *local_iter, ancestor;
+  gchar *label_txt = NULL; // Default
+
+  for (guint8 generations_cnt = 0; generations_cnt < generations; generations_cnt++) {
+    if (!gtk_tree_model_iter_parent (model, &ancestor, &child))
+      return NULL;
+    child = ancestor;
+  }
+
+  gtk_tree_model_get (model, &ancestor, TS_MENU_ELEMENT, &label_txt, -1);
+
+  return label_txt;
+}
+
+/* 
+
+   Adds an entry to an array of index entries.
+
+*/
+
+static void add_entry_to_index (GArray      *entries, 
+				GtkTreePath *local_path, 
+				const gchar *txt, 
+				guint8       kind)
+{
+  struct quick_jump_entry entry;
+
+  entry.path = gtk_tree_path_copy (local_path);
+  entry.txt = g_strdup (txt);
+  entry.char_mask = get_char_mask (txt);
+  entry.kind = kind;
+
+  g_array_append_val (entries, entry);
+}
+
+/* 
+
+   Adds the labels and menu IDs of menus, pipe menus and items as well as the commands of pipe menus and 
+   Execute actions of a row to an array of index entries.
+
+*/
+
+static gboolean add_row_to_index (GtkTreeModel G_GNUC_UNUSED *local_model, 
+				  GtkTreePath                *local_path, 
+				  GtkTreeIter                *local_iter, 
+				  GArray                     *entries)
+{
+  gchar *menu_element_txt, *type_txt, *value_txt, *menu_id_txt, *execute_txt;
+
+  gtk_tree_model_get (model, local_iter, 
+		      TS_MENU_ELEMENT, &menu_element_txt, 
+		      TS_TYPE, &type_txt, 
+		      TS_VALUE, &value_txt, 
+		      TS_MENU_ID, &menu_id_txt, 
+		      TS_EXECUTE, &execute_txt, 
+		      -1);
+
+  if (streq_any (type_txt, "menu", "pipe menu", "item", NULL)) {
+    if (menu_element_txt)
+      add_entry_to_index (entries, local_path, menu_element_txt, QUICK_JUMP_LABEL);
+    if (menu_id_txt)
+      add_entry_to_index (entries, local_path, menu_id_txt, QUICK_JUMP_MENU_ID);
+    if (execute_txt)
+      add_entry_to_index (entries, local_path, execute_txt, QUICK_JUMP_COMMAND);
+  }
+  // The command option of an Execute action.
+  else if (streq (type_txt, "option") && streq (menu_element_txt, "command") && value_txt)
+    add_entry_to_index (entries, local_path, value_txt, QUICK_JUMP_COMMAND);
+
+  // Cleanup
+  g_free (menu_element_txt);
+  g_free (type_txt);
+  g_free (value_txt);
+  g_free (menu_id_txt);
+  g_free (execute_txt);
+
+  return FALSE;
+}
+
+/* 
+
+   Frees the data of an index entry.
+
+*/
+
+static void clear_quick_jump_entry (struct quick_jump_entry *entry)
+{
+  gtk_tree_path_free (entry->path);
+  g_free (entry->txt);
+}
+
+/* 
+
+   Discards the index, e.g. before the treestore is cleared, so it doesn't have to be updated row by row.
+
+*/
+
+void invalidate_quick_jump_index (void)
+{
+  if (quick_jump_index) {
+    g_array_free (quick_jump_index, TRUE);
+    quick_jump_index = NULL;
+  }
+}
+
+/* 
+
+   Builds the index in one pass through the treestore.
+
+*/
+
+static void build_quick_jump_index (void)
+{
+  quick_jump_index = g_array_new (FALSE, FALSE, sizeof (struct quick_jump_entry));
+  g_array_set_clear_func (quick_jump_index, (GDestroyNotify) clear_quick_jump_entry);
+
+  gtk_tree_model_foreach (model, (GtkTreeModelForeachFunc) add_row_to_index, quick_jump_index);
+}
+
+/* 
+
+   Binary search inside the sorted index. 
+   Returns the index of the first entry whose path is behind the given path (behind_path = TRUE) or 
+   the index of the first entry whose path is not in front of it (behind_path = FALSE).
+
+*/
+
+static guint get_index_of_entry (GtkTreePath *path, 
+				 gboolean     behind_path)
+{
+  guint lower_bound = 0, upper_bound = quick_jump_index->len, middle;
+  gint comparison;
+
+  while (lower_bound < upper_bound) {
+    middle = lower_bound + (upper_bound - lower_bound) / 2;
+    comparison = gtk_tree_path_compare (g_array_index (quick_jump_index, struct quick_jump_entry, middle).path, path);
+    if (comparison < 0 || (behind_path && comparison == 0))
+      lower_bound = middle + 1;
+    else
+      upper_bound = middle;
+  }
+
+  return lower_bound;
+}
+
+/* 
+
+   Replaces the entries of a row with entries created from its current values.
+
+*/
+
+static void update_entries_of_row (GtkTreePath *path, 
+				   GtkTreeIter *local_iter)
+{
+  guint first_index = get_index_of_entry (path, FALSE);
+  GArray *entries_of_row = g_array_new (FALSE, FALSE, sizeof (struct quick_jump_entry));
+
+  g_array_remove_range (quick_jump_index, first_index, get_index_of_entry (path, TRUE) - first_index);
+
+  add_row_to_index (model, path, local_iter, entries_of_row);
+  // (Note: The new entries are owned by the index now, so the temporary array has no clear function.)
+  g_array_insert_vals (quick_jump_index, first_index, entries_of_row->data, entries_of_row->len);
+
+  // Cleanup
+  g_array_free (entries_of_row, TRUE);
+}
+
+/* 
+
+   Adjusts the paths of the entries of the following siblings of a row and their descendants 
+   after a row has been inserted (offset = 1) or deleted (offset = -1) at this path.
+   Since the entries are sorted, these entries directly follow the position of the path.
+
+*/
+
+static void shift_paths_of_entries (GtkTreePath *path, 
+				    gint         offset)
+{
+  gint depth = gtk_tree_path_get_depth (path);
+  GtkTreePath *parent_path = gtk_tree_path_copy (path);
+  GtkTreePath *path_loop;
+
+  gtk_tree_path_up (parent_path);
+
+  for (guint entries_cnt = get_index_of_entry (path, FALSE); entries_cnt < quick_jump_index->len; entries_cnt++) {
+    path_loop = g_array_index (quick_jump_index, struct quick_jump_entry, entries_cnt).path;
+    if (depth > 1 && !gtk_tree_path_is_descendant (path_loop, parent_path))
+      break;
+    gtk_tree_path_get_indices (path_loop)[depth - 1] += offset;
+  }
+
+  // Cleanup
+  gtk_tree_path_free (parent_path);
+}
+
+/* 
+
+   Sort function for index entries, used after rows have been reordered.
+
+*/
+
+static gint compare_quick_jump_entries (struct quick_jump_entry *entry_a, 
+					struct quick_jump_entry *entry_b)
+{
+  return gtk_tree_path_compare (entry_a->path, entry_b->path);
+}
+
+/* 
+
+   The following four functions keep the index up to date after it has been built, 
+   by updating only the entries of inserted or changed rows and by adjusting the paths of the other entries.
+
+*/
+
+void quick_jump_index_row_inserted (GtkTreeModel G_GNUC_UNUSED *local_model, 
+				    GtkTreePath                *local_path, 
+				    GtkTreeIter                *local_iter)
+{
+  if (!quick_jump_index)
+    return;
+
+  shift_paths_of_entries (local_path, 1);
+  update_entries_of_row (local_path, local_iter);
+}
+
+void quick_jump_index_row_changed (GtkTreeModel G_GNUC_UNUSED *local_model, 
+				   GtkTreePath                *local_path, 
+				   GtkTreeIter                *local_iter)
+{
+  if (quick_jump_index)
+    update_entries_of_row (local_path, local_iter);
+}
+
+void quick_jump_index_row_deleted (GtkTreeModel G_GNUC_UNUSED *local_model, 
+				   GtkTreePath                *local_path)
+{
+  if (!quick_jump_index)
+    return;
+
+  guint first_index = get_index_of_entry (local_path, FALSE);
+  guint entries_cnt;
+  GtkTreePath *path_loop;
+
+  // The entries of the deleted row and its descendants are removed at once.
+  for (entries_cnt = first_index; entries_cnt < quick_jump_index->len; entries_cnt++) {
+    path_loop = g_array_index (quick_jump_index, struct quick_jump_entry, entries_cnt).path;
+    if (gtk_tree_path_compare (path_loop, local_path) != 0 && !gtk_tree_path_is_descendant (path_loop, local_path))
+      break;
+  }
+  g_array_remove_range (quick_jump_index, first_index, entries_cnt - first_index);
+
+  shift_paths_of_entries (local_path, -1);
+}
+
+void quick_jump_index_rows_reordered (GtkTreeModel G_GNUC_UNUSED *local_model, 
+				      GtkTreePath                *local_path, 
+				      GtkTreeIter                *local_iter, 
+				      gint                       *new_order)
+{
+  if (!quick_jump_index)
+    return;
+
+  gint depth = gtk_tree_path_get_depth (local_path);
+  gint number_of_children = gtk_tree_model_iter_n_children (model, local_iter);
+  // (Note: new_order contains the former position of every row at its new position.)
+  gint *new_positions = g_new (gint, number_of_children);
+  guint first_index = (depth) ? get_index_of_entry (local_path, TRUE) : 0;
+  guint entries_cnt;
+  GtkTreePath *path_loop;
+
+  for (gint children_cnt = 0; children_cnt < number_of_children; children_cnt++)
+    new_positions[new_order[children_cnt]] = children_cnt;
+
+  for (entries_cnt = first_index; entries_cnt < quick_jump_index->len; entries_cnt++) {
+    path_loop = g_array_index (quick_jump_index, struct quick_jump_entry, entries_cnt).path;
+    if (depth && !gtk_tree_path_is_descendant (path_loop, local_path))
+      break;
+    gtk_tree_path_get_indices (path_loop)[depth] = new_positions[gtk_tree_path_get_indices (path_loop)[depth]];
+  }
+
+  // Only the entries of the reordered rows and their descendants have to be sorted again.
+  g_qsort_with_data (&g_array_index (quick_jump_index, struct quick_jump_entry, first_index), 
+		     entries_cnt - first_index, sizeof (struct quick_jump_entry), 
+		     (GCompareDataFunc) compare_quick_jump_entries, NULL);
+
+  // Cleanup
+  g_free (new_positions);
+}
+
+/* 
+
+   Returns the score of a text if the query is a subsequence of it (case insensitive), otherwise -1.
+   Matches at the start of a word and consecutive matches score higher, gaps lower the score.
+   If a string for markup is passed, the text is appended to it with the matching characters in bold type.
+
+*/
+
+static gint get_fuzzy_score (const gchar *query_lowercase, 
+			     const gchar *txt, 
+			     GString     *markup)
+{
+  const gchar *query_pos = query_lowercase;
+  const gchar *txt_pos;
+  gunichar query_char = g_utf8_get_char (query_pos), txt_char, previous_txt_char = ' ';
+  gboolean previous_char_matched = FALSE;
+  gint score = 0, gap = 0;
+  gchar *escaped_char;
+
+  for (txt_pos = txt; *txt_pos; txt_pos = g_utf8_next_char (txt_pos)) {
+    txt_char = g_utf8_get_char (txt_pos);
+
+    if (*query_pos && g_unichar_tolower (txt_char) == query_char) {
+      score += 1;
+      if (previous_char_matched)
+	score += 5;
+      else if (!g_unichar_isalnum (previous_txt_char))
+	score += 8; // Start of a word.
+      score -= MIN (gap, 3);
+      gap = 0;
+      previous_char_matched = TRUE;
+      query_pos = g_utf8_next_char (query_pos);
+      query_char = g_utf8_get_char (query_pos);
+    }
+    else {
+      if (score) // Characters in front of the first match aren't counted as a gap.
+	gap++;
+      previous_char_matched = FALSE;
+    }
+
+    if (markup) {
+      escaped_char = g_markup_escape_text (txt_pos, g_utf8_next_char (txt_pos) - txt_pos);
+      g_string_append_printf (markup, (previous_char_matched) ? "<b>%s</b>" : "%s", escaped_char);
+
+      // Cleanup
+      g_free (escaped_char);
+    }
+    previous_txt_char = txt_char;
+  }
+
+  return (*query_pos) ? -1 : score;
+}
+
+/* 
+
+   Scores all index entries against the entered text and shows the best results.
+   Only a fixed number of results is kept, sorted by insertion, so no complete sort is needed.
+
+*/
+
+static void update_quick_jump_results (struct quick_jump_palette *palette)
+{
+  const gchar *query_txt = gtk_entry_get_text (GTK_ENTRY (palette->entry));
+  gchar *query_lowercase;
+  guint64 query_char_mask;
+  struct quick_jump_result results[QUICK_JUMP_MAX_RESULTS];
+  guint number_of_results = 0;
+
+  struct quick_jump_entry *entry_loop;
+  gint score_loop;
+  GtkTreeIter results_iter_loop;
+  GString *markup_loop;
+  GtkTreeIter entry_iter_loop;
+  gchar *type_txt_loop, *location_txt_loop;
+
+  guint index_cnt, results_cnt;
+
+  gtk_list_store_clear (palette->results_store);
+
+  if (!(*query_txt))
+    return;
+
+  if (!quick_jump_index)
+    build_quick_jump_index ();
+
+  query_lowercase = g_utf8_strdown (query_txt, -1);
+  query_char_mask = get_char_mask (query_lowercase);
+
+  for (index_cnt = 0; index_cnt < quick_jump_index->len; index_cnt++) {
+    entry_loop = &g_array_index (quick_jump_index, struct quick_jump_entry, index_cnt);
+    if (query_char_mask & ~entry_loop->char_mask)
+      continue;
+    if ((score_loop = get_fuzzy_score (query_lowercase, entry_loop->txt, NULL)) < 0)
+      continue;
+    if (number_of_results == QUICK_JUMP_MAX_RESULTS && score_loop <= results[number_of_results - 1].score)
+      continue;
+
+    // Insert the result at its position; if the list is full, the last result is dropped.
+    if (number_of_results < QUICK_JUMP_MAX_RESULTS)
+      number_of_results++;
+    for (results_cnt = number_of_results - 1; results_cnt > 0 && results[results_cnt - 1].score < score_loop; 
+	 results_cnt--)
+      results[results_cnt] = results[results_cnt - 1];
+    results[results_cnt] = (struct quick_jump_result) { score_loop, index_cnt };
+  }
+
+  for (results_cnt = 0; results_cnt < number_of_results; results_cnt++) {
+    entry_loop = &g_array_index (quick_jump_index, struct quick_jump_entry, results[results_cnt].index);
+    markup_loop = g_string_new ("");
+    /* The location is the label of the menu or item the entry belongs to; 
+       for the command option of an Execute action this is the grandparent of the option. */
+    gtk_tree_model_get_iter (model, &entry_iter_loop, entry_loop->path);
+    gtk_tree_model_get (model, &entry_iter_loop, TS_TYPE, &type_txt_loop, -1);
+    location_txt_loop = get_label_of_ancestor (&entry_iter_loop, (streq (type_txt_loop, "option")) ? 2 : 1);
+    get_fuzzy_score (query_lowercase, entry_loop->txt, markup_loop);
+
+    gtk_list_store_insert_with_values (palette->results_store, &results_iter_loop, -1, 
+				       QJ_RESULT_MARKUP, markup_loop->str, 
+				       QJ_RESULT_KIND, quick_jump_kind_txts[entry_loop->kind], 
+				       QJ_RESULT_LOCATION, location_txt_loop, 
+				       QJ_RESULT_INDEX, results[results_cnt].index, 
+				       -1);
+
+    // Cleanup
+    g_string_free (markup_loop, TRUE);
+    g_free (type_txt_loop);
+    g_free (location_txt_loop);
+  }
+
+  if (number_of_results) {
+    GtkTreePath *first_result_path = gtk_tree_path_new_first ();
+
+    gtk_tree_selection_select_path (gtk_tree_view_get_selection (GTK_TREE_VIEW (palette->results_treeview)), 
+				    first_result_path);
+
+    // Cleanup
+    gtk_tree_path_free (first_result_path);
+  }
+
+  // Cleanup
+  g_free (query_lowercase);
+}
+
+/* 
+
+   Up and down keys inside the entry move the selection inside the list of results, 
+   so the palette can be used without leaving the entry.
+
+*/
+
+static gboolean quick_jump_key_pressed (GtkWidget                 G_GNUC_UNUSED *widget, 
+					GdkEventKey                             *event, 
+					struct quick_jump_palette               *palette)
+{
+  GtkTreeSelection *results_selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (palette->results_treeview));
+  GtkTreeModel *results_model;
+  GtkTreeIter results_iter;
+  GtkTreePath *results_path;
+  gboolean new_row_exists;
+
+  if ((event->keyval != GDK_KEY_Up && event->keyval != GDK_KEY_Down) || 
+      !gtk_tree_selection_get_selected (results_selection, &results_model, &results_iter))
+    return FALSE;
+
+  results_path = gtk_tree_model_get_path (results_model, &results_iter);
+  if (event->keyval == GDK_KEY_Up)
+    new_row_exists = gtk_tree_path_prev (results_path);
+  else {
+    gtk_tree_path_next (results_path);
+    new_row_exists = gtk_tree_model_get_iter (results_model, &results_iter, results_path);
+  }
+
+  if (new_row_exists) {
+    gtk_tree_selection_select_path (results_selection, results_path);
+    gtk_tree_view_scroll_to_cell (GTK_TREE_VIEW (palette->results_treeview), results_path, NULL, FALSE, 0, 0);
+  }
+
+  // Cleanup
+  gtk_tree_path_free (results_path);
+
+  return TRUE;
+}
+
+/* 
+
+   Closes the palette with a positive response if a result is selected.
+
+*/
+
+static void accept_quick_jump_result (struct quick_jump_palette *palette)
+{
+  if (gtk_tree_selection_count_selected_rows (gtk_tree_view_get_selection (GTK_TREE_VIEW (palette->results_treeview))))
+    gtk_dialog_response (GTK_DIALOG (palette->dialog), GTK_RESPONSE_ACCEPT);
+}
+
+/* 
+
+   Makes the row of the selected result visible without expanding it and selects it.
+
+*/
+
+static void jump_to_selected_result (struct quick_jump_palette *palette)
+{
+  GtkTreeSelection *selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview));
+  GtkTreeModel *results_model;
+  GtkTreeIter results_iter, target_iter;
+  GtkTreePath *target_path, *parent_path;
+  guint index;
+
+  if (!gtk_tree_selection_get_selected (gtk_tree_view_get_selection (GTK_TREE_VIEW (palette->results_treeview)), 
+					&results_model, &results_iter))
+    return;
+
+  gtk_tree_model_get (results_model, &results_iter, QJ_RESULT_INDEX, &index, -1);
+  target_path = g_array_index (quick_jump_index, struct quick_jump_entry, index).path;
+
+  if (!gtk_tree_model_get_iter (model, &target_iter, target_path))
+    return;
+
+  if (gtk_tree_path_get_depth (target_path) > 1) {
+    parent_path = gtk_tree_path_copy (target_path);
+    gtk_tree_path_up (parent_path);
+    gtk_tree_view_expand_to_path (GTK_TREE_VIEW (treeview), parent_path);
+
+    // Cleanup
+    gtk_tree_path_free (parent_path);
+  }
+
+  gtk_tree_selection_unselect_all (selection);
+  gtk_tree_selection_select_path (selection, target_path);
+  gtk_tree_view_scroll_to_cell (GTK_TREE_VIEW (treeview), target_path, NULL, TRUE, 0.5, 0);
+}
+
+/* 
+
+   Shows a palette that finds labels, menu IDs and commands by fuzzy matching while typing and 
+   jumps to the chosen row. If the palette has been opened by typing inside the treeview, 
+   the typed character is taken over.
+
+*/
+
+void show_quick_jump_palette (const gchar *initial_txt)
+{
+  struct quick_jump_palette palette;
+  GtkWidget *content_area, *scrolled_window;
+  GtkCellRenderer *results_renderer;
+  GtkTreeViewColumn *results_column;
+  gint result;
+
+  palette.dialog = gtk_dialog_new_with_buttons ("Quick jump", GTK_WINDOW (window), GTK_DIALOG_MODAL, 
+						GTK_STOCK_CLOSE, GTK_RESPONSE_CLOSE, 
+						NULL);
+  gtk_window_set_default_size (GTK_WINDOW (palette.dialog), 550, 400);
+
+  content_area = gtk_dialog_get_content_area (GTK_DIALOG (palette.dialog));
+  gtk_orientable_set_orientation (GTK_ORIENTABLE (content_area), GTK_ORIENTATION_VERTICAL);
+  gtk_container_set_border_width (GTK_CONTAINER (content_area), 10);
+
+  palette.entry = gtk_entry_new ();
+  gtk_widget_set_tooltip_text (palette.entry, "Characters have to occur in this order, but not necessarily "
+			       "one after another. Enter jumps to the selected result.");
+  gtk_container_add (GTK_CONTAINER (content_area), palette.entry);
+
+  palette.results_store = gtk_list_store_new (NUMBER_OF_QJ_RESULT_COLUMNS, 
+					      G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_UINT);
+  palette.results_treeview = gtk_tree_view_new_with_model (GTK_TREE_MODEL (palette.results_store));
+  gtk_tree_view_set_headers_visible (GTK_TREE_VIEW (palette.results_treeview), FALSE);
+
+  results_renderer = gtk_cell_renderer_text_new ();
+  results_column = gtk_tree_view_column_new_with_attributes ("Result", results_renderer, 
+							     "markup", QJ_RESULT_MARKUP, NULL);
+  gtk_tree_view_column_set_expand (results_column, TRUE);
+  gtk_tree_view_append_column (GTK_TREE_VIEW (palette.results_treeview), results_column);
+
+  results_renderer = gtk_cell_renderer_text_new ();
+  g_object_set (results_renderer, "foreground", "grey", NULL);
+  gtk_tree_view_append_column (GTK_TREE_VIEW (palette.results_treeview), 
+			       gtk_tree_view_column_new_with_attributes ("Kind", results_renderer, 
+									 "text", QJ_RESULT_KIND, NULL));
+  gtk_tree_view_append_column (GTK_TREE_VIEW (palette.results_treeview), 
+			       gtk_tree_view_column_new_with_attributes ("Location", results_renderer, 
+									 "text", QJ_RESULT_LOCATION, NULL));
+
+  scrolled_window = gtk_scrolled_window_new (NULL, NULL);
+  gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (scrolled_window), 
+				  GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+  gtk_widget_set_vexpand (scrolled_window, TRUE);
+  gtk_container_add (GTK_CONTAINER (scrolled_window), palette.results_treeview);
+  gtk_container_add (GTK_CONTAINER (content_area), scrolled_window);
+
+  g_signal_connect_swapped (palette.entry, "changed", G_CALLBACK (update_quick_jump_results), &palette);
+  g_signal_connect (palette.entry, "key-press-event", G_CALLBACK (quick_jump_key_pressed), &palette);
+  g_signal_connect_swapped (palette.entry, "activate", G_CALLBACK (accept_quick_jump_result), &palette);
+  g_signal_connect_swapped (palette.results_treeview, "row-activated", 
+			    G_CALLBACK (accept_quick_jump_result), &palette);
+
+  if (initial_txt)
+    gtk_entry_set_text (GTK_ENTRY (palette.entry), initial_txt);
+
+  gtk_widget_show_all (palette.dialog);
+  gtk_widget_grab_focus (palette.entry);
+  gtk_editable_set_position (GTK_EDITABLE (palette.entry), -1); // Deselects the text after grabbing the focus.
+  result = gtk_dialog_run (GTK_DIALOG (palette.dialog));
+
+  if (result == GTK_RESPONSE_ACCEPT)
+    jump_to_selected_result (&palette);
+
+  gtk_widget_destroy (palette.dialog);
+
+  // Cleanup
+  g_object_unref (palette.results_store);
+}
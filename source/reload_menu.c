@@ -0,0 +1,873 @@
+/*
+   Kickshaw - A Menu Editor for Openbox
+
+   Copyright (c) 2010-2013        Marcus Schaetzle
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along 
+   with Kickshaw. If not, see http://www.gnu.org/licenses/.
+*/
+
+
+#include <gtk/gtk.h>
+
+#include "general_header_files/enum__menu_bar_items.h"
+#include "general_header_files/enum__toolbar_buttons.h"
+#include "general_header_files/enum__ts_elements.h"
+#include "reload_menu.h"
+
+// Time in ms without further changes of the menu file before it is reloaded.
+#define RELOAD_DELAY 200
+// Children lists whose comparison table would exceed this number of cells are compared row by row.
+#define MAX_EDIT_SCRIPT_TABLE_SIZE 1048576
+
+enum { KEEP_ROW, REMOVE_ROW, INSERT_ROW };
+// Enumeration for the dialog.
+enum { RELOAD = 1, MERGE, KEEP_OWN_VERSION };
+
+// Monitor of the currently opened menu file.
+static GFileMonitor *menu_file_monitor = NULL;
+// Content of the menu file when it was loaded or saved for the last time; it is the common base for a merge.
+static gchar *menu_file_content = NULL;
+static guint reload_timeout_id = 0;
+static gboolean reload_in_progress = FALSE;
+
+struct menu_synchronisation {
+  GtkTreeModel *file_model;
+  GtkTreeModel *base_model; // = NULL if there is no valid base version of the menu file.
+  gboolean merge;
+  guint rows_added;
+  guint rows_removed;
+  guint rows_changed;
+};
+
+void remember_menu_file_content (void);
+void stop_menu_file_monitoring (void);
+void start_menu_file_monitoring (void);
+static void menu_file_changed (GFileMonitor G_GNUC_UNUSED *monitor, GFile G_GNUC_UNUSED *file, 
+			       GFile G_GNUC_UNUSED *other_file, GFileMonitorEvent event_type);
+static guint get_children (GtkTreeModel *local_model, GtkTreeIter *parent, gboolean with_occurrence_nr, 
+			   GtkTreeIter **children, gchar ***children_keys);
+static gboolean types_of_keys_are_equal (const gchar *key1, const gchar *key2);
+static GArray *get_edit_script (gchar **edited_keys, guint number_of_edited_keys, 
+				gchar **file_keys, guint number_of_file_keys);
+static gboolean values_differ (GtkTreeModel *model1, GtkTreeIter *iter1, 
+			       GtkTreeModel *model2, GtkTreeIter *iter2, gint column);
+static gboolean subtrees_are_equal (GtkTreeModel *model1, GtkTreeIter *iter1, GtkTreeModel *model2, GtkTreeIter *iter2);
+static void update_row (struct menu_synchronisation *synchronisation, GtkTreeIter *file_iter, 
+			GtkTreeIter *edited_iter, GtkTreeIter *base_iter);
+static void copy_subtree (struct menu_synchronisation *synchronisation, GtkTreeIter *file_iter, 
+			  GtkTreeIter *parent, GtkTreeIter *sibling, GtkTreeIter *copied_iter);
+static void synchronise_children (struct menu_synchronisation *synchronisation, GtkTreeIter *file_parent, 
+				  GtkTreeIter *edited_parent);
+static void merge_children (struct menu_synchronisation *synchronisation, GtkTreeIter *file_parent, 
+			    GtkTreeIter *edited_parent, GtkTreeIter *base_parent, gboolean base_exists);
+static gboolean add_menu_id_to_list (GtkTreeModel *local_model, GtkTreePath G_GNUC_UNUSED *local_path, 
+				     GtkTreeIter *local_iter);
+void rebuild_menu_ids (void);
+gboolean replace_menu_with_content (gchar *new_menu_content);
+static void reload_menu (gchar *new_menu_file_content);
+static gboolean reload_changed_menu_file (void);
+
+/* 
+
+   Stores the current content of the menu file, so changes that are made by other programs can be recognised.
+   Called after the menu has been loaded or saved.
+
+*/
+
+void remember_menu_file_content (void)
+{
+  gchar *new_menu_file_content;
+
+  if (filename && g_file_get_contents (filename, &new_menu_file_content, NULL, NULL))
+    free_and_reassign (menu_file_content, new_menu_file_content);
+}
+
+/* 
+
+   Stops the monitoring of the menu file.
+
+*/
+
+void stop_menu_file_monitoring (void)
+{
+  if (reload_timeout_id) {
+    g_source_remove (reload_timeout_id);
+    reload_timeout_id = 0;
+  }
+  if (menu_file_monitor) {
+    g_file_monitor_cancel (menu_file_monitor);
+    g_object_unref (menu_file_monitor);
+    menu_file_monitor = NULL;
+  }
+  free_and_reassign (menu_file_content, NULL);
+}
+
+/* 
+
+   Monitors the menu file, so the menu can be reloaded if the file is changed by another program.
+
+*/
+
+void start_menu_file_monitoring (void)
+{
+  GFile *menu_file = g_file_new_for_path (filename);
+
+  stop_menu_file_monitoring ();
+  remember_menu_file_content ();
+
+  if ((menu_file_monitor = g_file_monitor_file (menu_file, G_FILE_MONITOR_NONE, NULL, NULL)))
+    g_signal_connect (menu_file_monitor, "changed", G_CALLBACK (menu_file_changed), NULL);
+
+  // Cleanup
+  g_object_unref (menu_file);
+}
+
+/* 
+
+   Called by the file monitor if the menu file has been created or changed. 
+   Since a file is often written in several steps, the reload is postponed until no more changes occur.
+
+*/
+
+static void menu_file_changed (GFileMonitor      G_GNUC_UNUSED *monitor, 
+			       GFile             G_GNUC_UNUSED *file, 
+			       GFile             G_GNUC_UNUSED *other_file, 
+			       GFileMonitorEvent                event_type)
+{
+  if (event_type != G_FILE_MONITOR_EVENT_CHANGED && event_type != G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT && 
+      event_type != G_FILE_MONITOR_EVENT_CREATED)
+    return;
+
+  if (reload_timeout_id)
+    g_source_remove (reload_timeout_id);
+  reload_timeout_id = g_timeout_add (RELOAD_DELAY, (GSourceFunc) reload_changed_menu_file, NULL);
+}
+
+/* 
+
+   Collects the children of a parent (toplevel if parent = NULL) and a key for each of them.
+   The key identifies a row by its type and its menu ID (menus and pipe menus) or its menu element 
+   (label of an item or separator, name of an action or option). 
+   If requested, a number is added that tells the how manieth occurrence of the key among its siblings it is, 
+   so the key is unique for each child.
+   Returns the number of children.
+
+*/
+
+static guint get_children (GtkTreeModel   *local_model, 
+			   GtkTreeIter    *parent, 
+			   gboolean        with_occurrence_nr, 
+			   GtkTreeIter   **children, 
+			   gchar        ***children_keys)
+{
+  guint number_of_children = gtk_tree_model_iter_n_children (local_model, parent);
+  GHashTable *occurrences = (with_occurrence_nr) ? g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL) : NULL;
+
+  gchar *type_txt_loop, *menu_element_txt_loop, *menu_id_txt_loop;
+  gchar *key_loop;
+  guint occurrence_nr_loop;
+
+  *children = g_new (GtkTreeIter, number_of_children);
+  *children_keys = g_new0 (gchar *, number_of_children + 1); // NULL-terminated, so it can be freed with g_strfreev.
+
+  for (guint children_cnt = 0; children_cnt < number_of_children; children_cnt++) {
+    if (children_cnt == 0)
+      gtk_tree_model_iter_children (local_model, &(*children)[children_cnt], parent);
+    else {
+      (*children)[children_cnt] = (*children)[children_cnt - 1];
+      gtk_tree_model_iter_next (local_model, &(*children)[children_cnt]);
+    }
+    gtk_tree_model_get (local_model, &(*children)[children_cnt], 
+			TS_TYPE, &type_txt_loop, 
+			TS_MENU_ELEMENT, &menu_element_txt_loop, 
+			TS_MENU_ID, &menu_id_txt_loop, 
+			-1);
+
+    // (Note: \x1f = unit separator, it can't be part of a menu file.)
+    key_loop = g_strconcat (type_txt_loop, "\x1f", 
+			    (streq_any (type_txt_loop, "menu", "pipe menu", NULL)) ? 
+			    menu_id_txt_loop : menu_element_txt_loop, NULL);
+    if (with_occurrence_nr) {
+      occurrence_nr_loop = GPOINTER_TO_UINT (g_hash_table_lookup (occurrences, key_loop)) + 1;
+      g_hash_table_insert (occurrences, g_strdup (key_loop), GUINT_TO_POINTER (occurrence_nr_loop));
+      (*children_keys)[children_cnt] = g_strdup_printf ("%s\x1f%u", key_loop, occurrence_nr_loop);
+
+      // Cleanup
+      g_free (key_loop);
+    }
+    else
+      (*children_keys)[children_cnt] = key_loop;
+
+    // Cleanup
+    g_free (type_txt_loop);
+    g_free (menu_element_txt_loop);
+    g_free (menu_id_txt_loop);
+  }
+
+  // Cleanup
+  if (occurrences)
+    g_hash_table_destroy (occurrences);
+
+  return number_of_children;
+}
+
+/* 
+
+   Checks if two keys belong to rows of the same type.
+
+*/
+
+static gboolean types_of_keys_are_equal (const gchar *key1, 
+					 const gchar *key2)
+{
+  while (*key1 && *key1 == *key2 && *key1 != '\x1f') {
+    key1++;
+    key2++;
+  }
+
+  return (*key1 == *key2);
+}
+
+/* 
+
+   Creates a minimal list of operations that turns the children of a row of the edited menu into 
+   the children of the corresponding row of the menu file. Rows that are kept are only updated, 
+   so their expansion and selection states are preserved.
+
+   The common beginning and end of both children lists are skipped first; the remaining part is 
+   compared via the longest common subsequence of both lists. A removal and an insertion of rows of the 
+   same type at the same position are combined to an update of the row if this doesn't cost a common row.
+   If the remaining part is too large for this, the rows are compared one by one instead.
+
+*/
+
+static GArray *get_edit_script (gchar **edited_keys, 
+				guint    number_of_edited_keys, 
+				gchar  **file_keys, 
+				guint    number_of_file_keys)
+{
+  GArray *edit_script = g_array_new (FALSE, FALSE, sizeof (guint8));
+  guint prefix_length = 0, suffix_length = 0;
+  guint edited_length, file_length;
+  guint edited_cnt, file_cnt;
+  const guint8 keep_row = KEEP_ROW, remove_row = REMOVE_ROW, insert_row = INSERT_ROW;
+
+  while (prefix_length < number_of_edited_keys && prefix_length < number_of_file_keys && 
+	 streq (edited_keys[prefix_length], file_keys[prefix_length]))
+    prefix_length++;
+  while (suffix_length < number_of_edited_keys - prefix_length && suffix_length < number_of_file_keys - prefix_length && 
+	 streq (edited_keys[number_of_edited_keys - 1 - suffix_length], 
+		file_keys[number_of_file_keys - 1 - suffix_length]))
+    suffix_length++;
+
+  edited_length = number_of_edited_keys - prefix_length - suffix_length;
+  file_length = number_of_file_keys - prefix_length - suffix_length;
+  edited_keys += prefix_length;
+  file_keys += prefix_length;
+
+  for (edited_cnt = 0; edited_cnt < prefix_length; edited_cnt++)
+    g_array_append_val (edit_script, keep_row);
+
+  if ((gsize) (edited_length + 1) * (file_length + 1) <= MAX_EDIT_SCRIPT_TABLE_SIZE) {
+    guint columns = file_length + 1;
+    // Length of the longest common subsequence of edited_keys[edited_cnt...] and file_keys[file_cnt...].
+    guint *lcs_lengths = g_new (guint, (edited_length + 1) * columns);
+
+#define LCS_LENGTH(edited_idx, file_idx) lcs_lengths[(edited_idx) * columns + (file_idx)]
+
+    for (edited_cnt = edited_length + 1; edited_cnt-- > 0;) {
+      for (file_cnt = file_length + 1; file_cnt-- > 0;) {
+	if (edited_cnt == edited_length || file_cnt == file_length)
+	  LCS_LENGTH (edited_cnt, file_cnt) = 0;
+	else if (streq (edited_keys[edited_cnt], file_keys[file_cnt]))
+	  LCS_LENGTH (edited_cnt, file_cnt) = LCS_LENGTH (edited_cnt + 1, file_cnt + 1) + 1;
+	else
+	  LCS_LENGTH (edited_cnt, file_cnt) = MAX (LCS_LENGTH (edited_cnt + 1, file_cnt), 
+						   LCS_LENGTH (edited_cnt, file_cnt + 1));
+      }
+    }
+
+    edited_cnt = file_cnt = 0;
+    while (edited_cnt < edited_length || file_cnt < file_length) {
+      if (edited_cnt < edited_length && file_cnt < file_length && 
+	  (streq (edited_keys[edited_cnt], file_keys[file_cnt]) || 
+	   (types_of_keys_are_equal (edited_keys[edited_cnt], file_keys[file_cnt]) && 
+	    LCS_LENGTH (edited_cnt, file_cnt) == LCS_LENGTH (edited_cnt + 1, file_cnt + 1)))) {
+	g_array_append_val (edit_script, keep_row);
+	edited_cnt++;
+	file_cnt++;
+      }
+      else if (file_cnt < file_length && 
+	       (edited_cnt == edited_length || 
+		LCS_LENGTH (edited_cnt, file_cnt + 1) >= LCS_LENGTH (edited_cnt + 1, file_cnt))) {
+	g_array_append_val (edit_script, insert_row);
+	file_cnt++;
+      }
+      else {
+	g_array_append_val (edit_script, remove_row);
+	edited_cnt++;
+      }
+    }
+
+#undef LCS_LENGTH
+
+    // Cleanup
+    g_free (lcs_lengths);
+  }
+  else {
+    for (edited_cnt = 0; edited_cnt < MIN (edited_length, file_length); edited_cnt++) {
+      if (types_of_keys_are_equal (edited_keys[edited_cnt], file_keys[edited_cnt]))
+	g_array_append_val (edit_script, keep_row);
+      else {
+	g_array_append_val (edit_script, remove_row);
+	g_array_append_val (edit_script, insert_row);
+      }
+    }
+    for (; edited_cnt < edited_length; edited_cnt++)
+      g_array_append_val (edit_script, remove_row);
+    for (file_cnt = edited_cnt; file_cnt < file_length; file_cnt++)
+      g_array_append_val (edit_script, insert_row);
+  }
+
+  for (edited_cnt = 0; edited_cnt < suffix_length; edited_cnt++)
+    g_array_append_val (edit_script, keep_row);
+
+  return edit_script;
+}
+
+/* 
+
+   Checks if a column of two rows, which may belong to different models, has different values.
+   The icon image itself is not compared, it is represented by its path, status and modification date.
+
+*/
+
+static gboolean values_differ (GtkTreeModel *model1, 
+			       GtkTreeIter  *iter1, 
+			       GtkTreeModel *model2, 
+			       GtkTreeIter  *iter2, 
+			       gint          column)
+{
+  gboolean txts_differ;
+
+  if (column == TS_ICON_IMG)
+    return FALSE;
+  else if (column == TS_ICON_IMG_STATUS) {
+    guint icon_img_status1, icon_img_status2;
+
+    gtk_tree_model_get (model1, iter1, column, &icon_img_status1, -1);
+    gtk_tree_model_get (model2, iter2, column, &icon_img_status2, -1);
+
+    return (icon_img_status1 != icon_img_status2);
+  }
+  else {
+    gchar *txt1, *txt2;
+
+    gtk_tree_model_get (model1, iter1, column, &txt1, -1);
+    gtk_tree_model_get (model2, iter2, column, &txt2, -1);
+
+    txts_differ = !streq (txt1, txt2);
+
+    // Cleanup
+    g_free (txt1);
+    g_free (txt2);
+
+    return txts_differ;
+  }
+}
+
+/* 
+
+   Checks if two rows and all their descendants have the same values.
+
+*/
+
+static gboolean subtrees_are_equal (GtkTreeModel *model1, 
+				    GtkTreeIter  *iter1, 
+				    GtkTreeModel *model2, 
+				    GtkTreeIter  *iter2)
+{
+  GtkTreeIter child_iter1, child_iter2;
+  gboolean valid1, valid2;
+
+  for (gint ts_elements_cnt = 0; ts_elements_cnt < NUMBER_OF_TS_ELEMENTS; ts_elements_cnt++) {
+    if (values_differ (model1, iter1, model2, iter2, ts_elements_cnt))
+      return FALSE;
+  }
+
+  valid1 = gtk_tree_model_iter_children (model1, &child_iter1, iter1);
+  valid2 = gtk_tree_model_iter_children (model2, &child_iter2, iter2);
+  while (valid1 && valid2) {
+    if (!subtrees_are_equal (model1, &child_iter1, model2, &child_iter2))
+      return FALSE;
+    valid1 = gtk_tree_model_iter_next (model1, &child_iter1);
+    valid2 = gtk_tree_model_iter_next (model2, &child_iter2);
+  }
+
+  return (valid1 == valid2);
+}
+
+/* 
+
+   Sets those values of a row of the edited menu that differ from the corresponding row of the menu file.
+   During a merge, a value is only taken over if it hasn't been changed inside the edited menu, 
+   that is if it equals the value of the base version of the menu file.
+
+*/
+
+static void update_row (struct menu_synchronisation *synchronisation, 
+			GtkTreeIter                 *file_iter, 
+			GtkTreeIter                 *edited_iter, 
+			GtkTreeIter                 *base_iter)
+{
+  GtkTreeModel *file_model = synchronisation->file_model;
+  GtkTreeModel *base_model = synchronisation->base_model;
+
+  gint changed_columns[NUMBER_OF_TS_ELEMENTS];
+  G_GNUC_EXTENSION GValue changed_values[NUMBER_OF_TS_ELEMENTS] = { [0 ... NUMBER_OF_TS_ELEMENTS - 1] = G_VALUE_INIT };
+  gint number_of_changed_values = 0;
+  gboolean icon_changed = FALSE;
+
+  for (gint ts_elements_cnt = TS_ICON_IMG_STATUS; ts_elements_cnt < NUMBER_OF_TS_ELEMENTS; ts_elements_cnt++) {
+    if (!values_differ (file_model, file_iter, model, edited_iter, ts_elements_cnt) || 
+	(synchronisation->merge && 
+	 (!base_iter || values_differ (model, edited_iter, base_model, base_iter, ts_elements_cnt))))
+      continue;
+
+    changed_columns[number_of_changed_values] = ts_elements_cnt;
+    gtk_tree_model_get_value (file_model, file_iter, ts_elements_cnt, &changed_values[number_of_changed_values++]);
+    if (ts_elements_cnt <= TS_ICON_PATH)
+      icon_changed = TRUE;
+  }
+
+  if (!number_of_changed_values)
+    return;
+
+  if (icon_changed) {
+    changed_columns[number_of_changed_values] = TS_ICON_IMG;
+    gtk_tree_model_get_value (file_model, file_iter, TS_ICON_IMG, &changed_values[number_of_changed_values++]);
+  }
+
+  gtk_tree_store_set_valuesv (treestore, edited_iter, changed_columns, changed_values, number_of_changed_values);
+  (synchronisation->rows_changed)++;
+
+  // Cleanup
+  for (gint values_cnt = 0; values_cnt < number_of_changed_values; values_cnt++)
+    g_value_unset (&changed_values[values_cnt]);
+}
+
+/* 
+
+   Copies a row of the menu file and all its descendants into the edited menu, 
+   the row is inserted after the sibling or as first child of the parent if sibling = NULL.
+
+*/
+
+static void copy_subtree (struct menu_synchronisation *synchronisation, 
+			  GtkTreeIter                 *file_iter, 
+			  GtkTreeIter                 *parent, 
+			  GtkTreeIter                 *sibling, 
+			  GtkTreeIter                 *copied_iter)
+{
+  GtkTreeModel *file_model = synchronisation->file_model;
+
+  gint columns[NUMBER_OF_TS_ELEMENTS];
+  G_GNUC_EXTENSION GValue values[NUMBER_OF_TS_ELEMENTS] = { [0 ... NUMBER_OF_TS_ELEMENTS - 1] = G_VALUE_INIT };
+  gint ts_elements_cnt;
+
+  GtkTreeIter file_child_iter, copied_child_iter, previous_copied_child_iter;
+  gboolean is_first_child = TRUE;
+  gboolean valid;
+
+  for (ts_elements_cnt = 0; ts_elements_cnt < NUMBER_OF_TS_ELEMENTS; ts_elements_cnt++) {
+    columns[ts_elements_cnt] = ts_elements_cnt;
+    gtk_tree_model_get_value (file_model, file_iter, ts_elements_cnt, &values[ts_elements_cnt]);
+  }
+
+  gtk_tree_store_insert_after (treestore, copied_iter, parent, sibling);
+  gtk_tree_store_set_valuesv (treestore, copied_iter, columns, values, NUMBER_OF_TS_ELEMENTS);
+
+  // Cleanup
+  for (ts_elements_cnt = 0; ts_elements_cnt < NUMBER_OF_TS_ELEMENTS; ts_elements_cnt++)
+    g_value_unset (&values[ts_elements_cnt]);
+
+  valid = gtk_tree_model_iter_children (file_model, &file_child_iter, file_iter);
+  while (valid) {
+    copy_subtree (synchronisation, &file_child_iter, copied_iter, 
+		  (is_first_child) ? NULL : &previous_copied_child_iter, &copied_child_iter);
+    previous_copied_child_iter = copied_child_iter;
+    is_first_child = FALSE;
+    valid = gtk_tree_model_iter_next (file_model, &file_child_iter);
+  }
+}
+
+/* 
+
+   Turns the children of a row of the edited menu (toplevel if edited_parent = NULL) into the children of 
+   the corresponding row of the menu file, using as few removals and insertions as possible.
+
+*/
+
+static void synchronise_children (struct menu_synchronisation *synchronisation, 
+				  GtkTreeIter                 *file_parent, 
+				  GtkTreeIter                 *edited_parent)
+{
+  GtkTreeIter *edited_children, *file_children;
+  gchar **edited_keys, **file_keys;
+  guint number_of_edited_children = get_children (model, edited_parent, FALSE, &edited_children, &edited_keys);
+  guint number_of_file_children = get_children (synchronisation->file_model, file_parent, FALSE, 
+						&file_children, &file_keys);
+  GArray *edit_script = get_edit_script (edited_keys, number_of_edited_children, file_keys, number_of_file_children);
+
+  guint edited_cnt = 0, file_cnt = 0;
+  GtkTreeIter previous_sibling, inserted_iter;
+  gboolean previous_sibling_exists = FALSE;
+
+  for (guint edit_script_cnt = 0; edit_script_cnt < edit_script->len; edit_script_cnt++) {
+    switch (g_array_index (edit_script, guint8, edit_script_cnt)) {
+    case KEEP_ROW:
+      update_row (synchronisation, &file_children[file_cnt], &edited_children[edited_cnt], NULL);
+      synchronise_children (synchronisation, &file_children[file_cnt++], &edited_children[edited_cnt]);
+      previous_sibling = edited_children[edited_cnt++];
+      previous_sibling_exists = TRUE;
+      break;
+    case REMOVE_ROW:
+      gtk_tree_store_remove (treestore, &edited_children[edited_cnt++]);
+      (synchronisation->rows_removed)++;
+      break;
+    case INSERT_ROW:
+      // (Note: The iters of the edited children stay valid, since GtkTreeStore iters persist as long as their rows exist.)
+      copy_subtree (synchronisation, &file_children[file_cnt++], edited_parent, 
+		    (previous_sibling_exists) ? &previous_sibling : NULL, &inserted_iter);
+      (synchronisation->rows_added)++;
+      previous_sibling = inserted_iter;
+      previous_sibling_exists = TRUE;
+      break;
+    }
+  }
+
+  // Cleanup
+  g_array_free (edit_script, TRUE);
+  g_free (edited_children);
+  g_free (file_children);
+  g_strfreev (edited_keys);
+  g_strfreev (file_keys);
+}
+
+/* 
+
+   Merges the changes that have been made to the menu file since it was loaded or saved for the last time 
+   into the children of a row of the edited menu (toplevel if edited_parent = NULL). 
+   base_exists tells if the row already existed inside this base version of the menu file.
+
+   Rows are identified among their siblings by their keys. A row of the menu file that doesn't exist inside the 
+   edited menu is inserted, unless it has been removed from the edited menu. A row of the edited menu that has been 
+   removed from the menu file is removed, unless it has been changed inside the edited menu.
+
+*/
+
+static void merge_children (struct menu_synchronisation *synchronisation, 
+			    GtkTreeIter                 *file_parent, 
+			    GtkTreeIter                 *edited_parent, 
+			    GtkTreeIter                 *base_parent, 
+			    gboolean                     base_exists)
+{
+  GtkTreeModel *file_model = synchronisation->file_model;
+  GtkTreeModel *base_model = synchronisation->base_model;
+
+  GtkTreeIter *edited_children, *file_children, *base_children = NULL;
+  gchar **edited_keys, **file_keys, **base_keys = NULL;
+  guint number_of_edited_children = get_children (model, edited_parent, TRUE, &edited_children, &edited_keys);
+  guint number_of_file_children = get_children (file_model, file_parent, TRUE, &file_children, &file_keys);
+  guint number_of_base_children = (base_exists) ? 
+    get_children (base_model, base_parent, TRUE, &base_children, &base_keys) : 0;
+
+  // Key: key of a child, value: index of the child + 1 (so it is never NULL).
+  GHashTable *edited_indices = g_hash_table_new (g_str_hash, g_str_equal);
+  GHashTable *file_indices = g_hash_table_new (g_str_hash, g_str_equal);
+  GHashTable *base_indices = g_hash_table_new (g_str_hash, g_str_equal);
+
+  guint children_cnt;
+  guint edited_idx, base_idx;
+
+  GtkTreeIter previous_sibling, inserted_iter;
+  gboolean previous_sibling_exists = FALSE;
+
+  for (children_cnt = 0; children_cnt < number_of_edited_children; children_cnt++)
+    g_hash_table_insert (edited_indices, edited_keys[children_cnt], GUINT_TO_POINTER (children_cnt + 1));
+  for (children_cnt = 0; children_cnt < number_of_file_children; children_cnt++)
+    g_hash_table_insert (file_indices, file_keys[children_cnt], GUINT_TO_POINTER (children_cnt + 1));
+  for (children_cnt = 0; children_cnt < number_of_base_children; children_cnt++)
+    g_hash_table_insert (base_indices, base_keys[children_cnt], GUINT_TO_POINTER (children_cnt + 1));
+
+  // Remove rows that have been removed from the menu file and haven't been changed inside the edited menu.
+  for (children_cnt = 0; children_cnt < number_of_edited_children; children_cnt++) {
+    if (g_hash_table_contains (file_indices, edited_keys[children_cnt]) || 
+	!(base_idx = GPOINTER_TO_UINT (g_hash_table_lookup (base_indices, edited_keys[children_cnt]))) || 
+	!subtrees_are_equal (model, &edited_children[children_cnt], base_model, &base_children[base_idx - 1]))
+      continue;
+
+    gtk_tree_store_remove (treestore, &edited_children[children_cnt]);
+    g_hash_table_remove (edited_indices, edited_keys[children_cnt]);
+    (synchronisation->rows_removed)++;
+  }
+
+  /* Update rows that exist inside both menus and insert new rows of the menu file 
+     after the row that corresponds to their previous sibling inside the menu file. */
+  for (children_cnt = 0; children_cnt < number_of_file_children; children_cnt++) {
+    base_idx = GPOINTER_TO_UINT (g_hash_table_lookup (base_indices, file_keys[children_cnt]));
+
+    if ((edited_idx = GPOINTER_TO_UINT (g_hash_table_lookup (edited_indices, file_keys[children_cnt])))) {
+      update_row (synchronisation, &file_children[children_cnt], &edited_children[edited_idx - 1], 
+		  (base_idx) ? &base_children[base_idx - 1] : NULL);
+      merge_children (synchronisation, &file_children[children_cnt], &edited_children[edited_idx - 1], 
+		      (base_idx) ? &base_children[base_idx - 1] : NULL, base_idx);
+      previous_sibling = edited_children[edited_idx - 1];
+      previous_sibling_exists = TRUE;
+    }
+    else if (!base_idx) { // Otherwise the row has been removed from the edited menu.
+      copy_subtree (synchronisation, &file_children[children_cnt], edited_parent, 
+		    (previous_sibling_exists) ? &previous_sibling : NULL, &inserted_iter);
+      (synchronisation->rows_added)++;
+      previous_sibling = inserted_iter;
+      previous_sibling_exists = TRUE;
+    }
+  }
+
+  // Cleanup
+  g_hash_table_destroy (edited_indices);
+  g_hash_table_destroy (file_indices);
+  g_hash_table_destroy (base_indices);
+  g_free (edited_children);
+  g_free (file_children);
+  g_free (base_children);
+  g_strfreev (edited_keys);
+  g_strfreev (file_keys);
+  g_strfreev (base_keys);
+}
+
+/* 
+
+   Adds the menu ID of a menu or pipe menu to the list of menu IDs.
+
+*/
+
+static gboolean add_menu_id_to_list (GtkTreeModel              *local_model, 
+				     GtkTreePath G_GNUC_UNUSED *local_path, 
+				     GtkTreeIter               *local_iter)
+{
+  gchar *menu_id_txt;
+
+  gtk_tree_model_get (local_model, local_iter, TS_MENU_ID, &menu_id_txt, -1);
+  if (menu_id_txt)
+    menu_ids = g_slist_prepend (menu_ids, menu_id_txt);
+
+  return FALSE;
+}
+
+/* 
+
+   Recreates the list of menu IDs after the rows of the menu have been changed without the usual editing functions.
+
+*/
+
+void rebuild_menu_ids (void)
+{
+  g_slist_free_full (menu_ids, (GDestroyNotify) g_free);
+  menu_ids = NULL;
+  gtk_tree_model_foreach (model, (GtkTreeModelForeachFunc) add_menu_id_to_list, NULL);
+  menu_ids = g_slist_reverse (menu_ids);
+}
+
+/* 
+
+   Replaces the edited menu with a menu of the given content, e.g. a version from the version history. 
+   Only rows that differ are changed, like it is done for a reload. 
+   Returns FALSE if the content couldn't be parsed.
+
+*/
+
+gboolean replace_menu_with_content (gchar *new_menu_content)
+{
+  GtkTreeSelection *selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview));
+  GtkTreeStore *content_treestore;
+
+  if (!(content_treestore = get_treestore_of_menu_file_content (new_menu_content)))
+    return FALSE;
+
+  struct menu_synchronisation synchronisation = {
+    .file_model = GTK_TREE_MODEL (content_treestore), 
+    .base_model = NULL, 
+    .merge = FALSE, 
+    .rows_added = 0, 
+    .rows_removed = 0, 
+    .rows_changed = 0
+  };
+
+  g_signal_handler_block (selection, handler_id_row_selected);
+  synchronise_children (&synchronisation, NULL, NULL);
+  g_signal_handler_unblock (selection, handler_id_row_selected);
+
+  rebuild_menu_ids ();
+  activate_change_done ();
+
+  gtk_tree_view_columns_autosize (GTK_TREE_VIEW (treeview));
+  row_selected ();
+
+  // Cleanup
+  g_object_unref (content_treestore);
+
+  return TRUE;
+}
+
+/* 
+
+   Applies the new content of the menu file to the edited menu. Instead of rebuilding the whole tree view, 
+   only rows that have been added, removed or changed are touched, so expansion, selection and scroll position 
+   of all other rows are preserved. If there are unsaved changes, the user may choose between a reload, 
+   a merge of both versions and keeping the own version.
+
+*/
+
+static void reload_menu (gchar *new_menu_file_content)
+{
+  GtkTreeStore *file_treestore;
+  GtkTreeStore *base_treestore = NULL;
+  GtkTreeSelection *selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview));
+
+  gint result = RELOAD; // Default
+
+  gchar *statusbar_msg;
+
+  if (!(file_treestore = get_treestore_of_menu_file_content (new_menu_file_content))) {
+    show_msg_in_statusbar ("The menu file has been changed by another program, but its new content is not valid.");
+
+    // Cleanup
+    g_free (new_menu_file_content);
+
+    return;
+  }
+
+  if (change_done) {
+    GtkWidget *dialog;
+    gchar *dialog_txt = g_markup_printf_escaped ("<b>The menu file</b>\n<tt>%s</tt>\n<b>has been changed by another program, "
+						 "but the currently edited menu has unsaved changes.</b>\n\n"
+						 "'Reload' discards your changes, 'Merge' adds the changes of the menu file "
+						 "to your version as far as they don't collide with your own changes, "
+						 "'Keep my version' ignores the changes of the menu file.", filename);
+
+    create_dialog (&dialog, "Menu file has been changed", GTK_STOCK_DIALOG_WARNING, 
+		   "Reload", "Merge", "Keep my version", dialog_txt, TRUE);
+
+    // Cleanup
+    g_free (dialog_txt);
+
+    result = gtk_dialog_run (GTK_DIALOG (dialog));
+    gtk_widget_destroy (dialog);
+
+    // The base version is only needed for a merge; if it can't be parsed, a merge adds new rows only.
+    if (result == MERGE && menu_file_content)
+      base_treestore = get_treestore_of_menu_file_content (menu_file_content);
+  }
+
+  free_and_reassign (menu_file_content, new_menu_file_content);
+
+  if (result != RELOAD && result != MERGE) {
+    // The own version is kept, but the journal has to refer to the changed menu file from now on.
+    rebase_journal ();
+
+    // Cleanup
+    g_object_unref (file_treestore);
+
+    return;
+  }
+
+  struct menu_synchronisation synchronisation = {
+    .file_model = GTK_TREE_MODEL (file_treestore), 
+    .base_model = (base_treestore) ? GTK_TREE_MODEL (base_treestore) : NULL, 
+    .merge = (result == MERGE), 
+    .rows_added = 0, 
+    .rows_removed = 0, 
+    .rows_changed = 0
+  };
+
+  g_signal_handler_block (selection, handler_id_row_selected);
+  if (result == MERGE)
+    merge_children (&synchronisation, NULL, NULL, NULL, (base_treestore != NULL));
+  else
+    synchronise_children (&synchronisation, NULL, NULL);
+  g_signal_handler_unblock (selection, handler_id_row_selected);
+
+  rebuild_menu_ids ();
+
+  // Recreates the lists of search results and icon occurrences.
+  activate_change_done ();
+  if (result == RELOAD) {
+    change_done = FALSE;
+    gtk_widget_set_sensitive (mb_file_menu_items[MB_SAVE], FALSE);
+    gtk_widget_set_sensitive ((GtkWidget *) tb[TB_SAVE], FALSE);
+  }
+  rebase_journal ();
+
+  gtk_tree_view_columns_autosize (GTK_TREE_VIEW (treeview));
+  row_selected ();
+
+  statusbar_msg = g_strdup_printf ("The menu file has been changed by another program and was %s: "
+				   "%u row%s added, %u removed, %u changed.", 
+				   (result == MERGE) ? "merged" : "reloaded", 
+				   synchronisation.rows_added, (synchronisation.rows_added == 1) ? "" : "s", 
+				   synchronisation.rows_removed, synchronisation.rows_changed);
+  show_msg_in_statusbar (statusbar_msg);
+
+  // Cleanup
+  g_free (statusbar_msg);
+  g_object_unref (file_treestore);
+  if (base_treestore)
+    g_object_unref (base_treestore);
+}
+
+/* 
+
+   Reloads the menu after the menu file hasn't been changed for a short while. 
+   Changes done by the program itself are ignored, since the content of the file is the same as after saving.
+
+*/
+
+static gboolean reload_changed_menu_file (void)
+{
+  gchar *new_menu_file_content;
+
+  /* If a reload dialog is still open or the menu is currently being saved by the program itself, 
+     the check is repeated later. */
+  if (reload_in_progress || menu_is_being_saved ())
+    return TRUE;
+
+  reload_timeout_id = 0;
+
+  if (!filename || !g_file_get_contents (filename, &new_menu_file_content, NULL, NULL))
+    return FALSE;
+
+  if (streq (new_menu_file_content, menu_file_content)) {
+    // Cleanup
+    g_free (new_menu_file_content);
+
+    return FALSE;
+  }
+
+  reload_in_progress = TRUE;
+  reload_menu (new_menu_file_content);
+  reload_in_progress = FALSE;
+
+  return FALSE;
+}
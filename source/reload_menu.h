@@ -0,0 +1,52 @@
+/*
+   Kickshaw - A Menu Editor for Openbox
+
+   Copyright (c) 2010-2013        Marcus Schaetzle
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along 
+   with Kickshaw. If not, see http://www.gnu.org/licenses/.
+*/
+
+
+#ifndef __reload_menu_h
+#define __reload_menu_h
+
+#define free_and_reassign(string, new_value) { g_free (string); string = new_value; }
+#define streq(string1, string2) (g_strcmp0 ((string1), (string2)) == 0)
+
+extern GtkTreeStore *treestore;
+extern GtkTreeModel *model;
+extern GtkWidget *treeview;
+
+extern GtkWidget *mb_file_menu_items[];
+extern GtkToolItem *tb[];
+
+extern GSList *menu_ids;
+
+extern gchar *filename;
+
+extern gboolean change_done;
+
+extern gint handler_id_row_selected;
+
+extern void activate_change_done (void);
+extern GtkWidget *create_dialog (GtkWidget **dialog, gchar *dialog_title, gchar *stock_id, gchar *button_txt_1, 
+				 gchar *button_txt_2, gchar *button_txt_3, gchar *label_txt, gboolean show_immediately);
+extern GtkTreeStore *get_treestore_of_menu_file_content (gchar *menu_file_content);
+extern gboolean menu_is_being_saved (void);
+extern void rebase_journal (void);
+extern void row_selected (void);
+extern void show_msg_in_statusbar (gchar *message);
+G_GNUC_NULL_TERMINATED extern gboolean streq_any (const gchar *string, ...);
+
+#endif
@@ -19,537 +19,882 @@
 
 #include <gtk/gtk.h>
 #include <glib/gstdio.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-#include "general_header_files/enum__columns.h"
 #include "general_header_files/enum__menu_bar_items.h"
 #include "general_header_files/enum__toolbar_buttons.h"
 #include "general_header_files/enum__ts_elements.h"
 #include "general_header_files/enum__txt_fields.h"
+#include "general_header_files/enum__view_and_options_menu_items.h"
 #include "save_menu.h"
 
-struct save_menu_args_data {
-  FILE *menu_file;
-  guint8 saving_stage;
-  GtkTreeIter filter_iter[2];
-  gint filter_path_depth_prev;
+#define INITIAL_MENU_BUFFER_SIZE 16384
+// Interval in ms in which the progress of a save is shown.
+#define SAVING_PROGRESS_INTERVAL 100
+
+// A row of the snapshot of the menu that is taken when saving starts.
+struct save_row {
+  gchar *txt_fields[NUMBER_OF_TXT_FIELDS]; // Escaped by the saving thread.
+  gint path_depth;
+  gboolean has_child;
+  // Set for menus whose serialised children are stored inside the fragment cache after saving.
+  gpointer fragment_key;
+  // Serialised children of a menu, either taken from the fragment cache or generated by the saving thread.
+  gchar *children_fragment;
+};
+
+struct save_job {
+  GArray *save_rows; // All rows of the menu in the order of the tree view.
+  gchar *menu_filename;
+  gchar *save_as_filename;
+  gboolean sync_to_disk;
+  gboolean reconfigure_openbox;
+  gchar *filename_before_saving;
+  gboolean change_done_before_saving;
+  gsize journal_size; // Size of the journal when the snapshot was taken.
+
+  gchar *errmsg_txt; // Set by the saving thread if saving failed.
+  gboolean reconfiguration_failed;
+  gboolean version_not_stored;
 };
 
 enum { MENUS, ROOT_MENU, IND_OF_MENU_STAGE };
-enum { TOPLEVEL, FILTER_LEVEL, IND_OF_LEVEL };
+enum { TOPLEVEL, SUBLEVEL, IND_OF_LEVEL };
 enum { MENU_OR_PIPE_MENU, ITEM_OR_ACTION, SEPARATOR };
-enum { CURRENT, PREV, NUMBER_OF_ITER_ARRAY_ELM };
-
-static void closing_tags (gboolean last_row_reached, GtkTreeModel *filter_model, 
-			  struct save_menu_args_data *save_menu_args);
-static void write_tag (guint8 saving_stage, guint8 level, gchar **tag_elements, FILE *menu_file, 
-		       GtkTreeModel *local_model, GtkTreeIter *local_iter, guint8 type);
-static void get_field_values (gchar **txt_fields_array, GtkTreeModel *current_model, GtkTreeIter *current_iter);
-static gboolean treestore_save_process_iteration (GtkTreeModel *filter_model, GtkTreePath *filter_path, 
-						  GtkTreeIter *filter_iter, struct save_menu_args_data *save_menu_args);
-static void process_menu_or_item (GtkTreeIter *process_iter, struct save_menu_args_data *save_menu_args);
+
+static GThread *saving_thread = NULL;
+static guint saving_progress_timeout_id = 0;
+// Number of rows that have been processed by the saving thread, accessed atomically.
+static gint saved_rows_cnt = 0;
+static gboolean save_queued = FALSE;
+static gchar *queued_save_as_filename = NULL;
+/* 
+   Serialised children of menus that haven't been changed since they have been saved, 
+   keyed by the node of the menu row inside the treestore (= user_data of its GtkTreeIter, 
+   which stays the same as long as the row exists, since the iters of a GtkTreeStore are persistent). 
+   A key without a value means that the children are currently being serialised by the saving thread.
+*/
+static GHashTable *fragment_cache = NULL;
+// Set if rows have been deleted; the cached fragments of deleted menus are removed before the next save.
+static gboolean fragments_of_deleted_rows_cached = FALSE;
+
+static void append_indentation (GString *menu_buffer, gint number_of_indentations);
+static void write_tag (guint8 saving_stage, guint8 level, gchar **tag_elements, GString *menu_buffer, 
+		       gboolean has_child, guint8 type);
+static gboolean escaping_needed (const gchar *txt);
+static void escape_field_values (gchar **txt_fields_array);
+static guint write_row (GArray *save_rows, guint row_idx, guint8 saving_stage, GString *menu_buffer);
+static guint write_children (GArray *save_rows, guint parent_row_idx, guint8 saving_stage, GString *menu_buffer);
+static const gchar *write_menu_file (gchar *menu_filename, GString *menu_buffer, gboolean sync_to_disk);
+static void add_row_to_snapshot (GtkTreeIter *row_iter, gint path_depth, gboolean use_fragment_cache, 
+				 GArray *save_rows);
+static void add_rows_to_snapshot (GtkTreeIter *parent, gint path_depth, gboolean use_fragment_cache, 
+				  GArray *save_rows);
+static void free_snapshot (GArray *save_rows);
+static void store_generated_fragments (GArray *save_rows);
+static void free_save_job (struct save_job *save_job);
+static gpointer save_menu_in_background (struct save_job *save_job);
+static gboolean show_saving_progress (GArray *save_rows);
+static gboolean saving_finished (struct save_job *save_job);
+gboolean menu_is_being_saved (void);
+void wait_for_saving_to_finish (void);
+void invalidate_cached_fragments (GtkTreeModel *local_model, GtkTreePath *local_path);
+void cached_fragments_row_deleted (GtkTreeModel *local_model, GtkTreePath *local_path);
+static void remove_cached_fragments_of_deleted_rows (void);
+void clear_fragment_cache (void);
 void save_menu (gchar *save_as_filename);
 void save_menu_as (void);
+gchar *write_rows_as_menu_fragment (GList *paths);
 
 /* 
 
-   Writes closing tags.
+   Appends the leading whitespace of a line, two spaces for each indentation level.
 
 */
 
-static void closing_tags (gboolean                    last_row_reached, 
-                          GtkTreeModel               *filter_model, 
-			  struct save_menu_args_data *save_menu_args)
+static void append_indentation (GString *menu_buffer, 
+				gint     number_of_indentations)
 {
-  FILE *menu_file = save_menu_args->menu_file;
-  guint8 saving_stage = save_menu_args->saving_stage;
-  GtkTreeIter *filter_iter = save_menu_args->filter_iter;
-  gint filter_path_depth_prev = save_menu_args->filter_path_depth_prev;
-
-  const guint8 offset = (saving_stage == MENUS); // TRUE = 1, FALSE = 0.
-
-  gchar *ts_txt[NUMBER_OF_ITER_ARRAY_ELM][2]; // COL_MENU_ELEMENT & COL_TYPE for current and previous iter.
-
-  /* 
-     action_closing_tag_subtraction contains the number of indentations 
-     that have to be removed for the closing action tag after the last option of an action.
-
-     1 = option of action (='command' and 'prompt')
-     <item label="Program">
-       <action="Exeucte">
-         <ommand>program</command>
-       </action> = removed 1 in comparison to 'command'
-     </item>
-     <item="New item">
-     ...
-
-     2 = startupnotify option (='enabled', 'name', 'wmclass' and 'icon')
-     <item label="Program">
-       <action="Execute">
-         <command>program</command>
-         <startupnotify>
-           <enabled>
-         <startupnotify />
-       </action> = removed 2 in comparison to 'enabled'
-     <item>
-     <item label="New item">
-     ...
-
-     The value is set to zero if the action is a self-closing action without an option (='Reconfigure')
-
-     <item label="Reconfigure">
-       <action="Reconfigure" /> = 0, self-closing action without an option
-     </item> 
-     <item label="New item"> 
-     ...
-  
-     action_closing_tag_subtraction defaults to -1. This is done for the case that additional </menu> 
-     closing tags have to be added. The reason for setting the default value to -1 is explained there.
-  */
-  gint8 action_closing_tag_subtraction = -1; // Default, 
-
-  gint path_depth_prev_cnt, subtr_path_depth_prev_cnt;
-  gint8 array_cnt;
-
-  for (array_cnt = CURRENT; array_cnt < NUMBER_OF_ITER_ARRAY_ELM; array_cnt++)
-    gtk_tree_model_get (filter_model, &filter_iter[array_cnt], 
-			TS_MENU_ELEMENT, &ts_txt[array_cnt][COL_MENU_ELEMENT], 
-			TS_TYPE, &ts_txt[array_cnt][COL_TYPE],
-			-1);
-
-  // startupnotify
-  if ((streq (ts_txt[PREV][COL_TYPE], "option") && 
-       streq_any (ts_txt[PREV][COL_MENU_ELEMENT], "enabled", "name", "wmclass", "icon", NULL)) &&
-      (!(streq (ts_txt[CURRENT][COL_TYPE], "option") && 
-	 streq_any (ts_txt[CURRENT][COL_MENU_ELEMENT], "enabled", "name", "wmclass", "icon", NULL))
-       || last_row_reached)) {
-    for (path_depth_prev_cnt = offset; path_depth_prev_cnt < filter_path_depth_prev; path_depth_prev_cnt++)
-      fputs ("  ", menu_file);
-    fputs ("</startupnotify>\n", menu_file);
-  }
-
-  // action
-  if (streq_any (ts_txt[PREV][COL_TYPE], "option", "option block", NULL) &&
-      (!streq_any (ts_txt[CURRENT][COL_TYPE], "option", "option block", NULL) || last_row_reached)) {
-    action_closing_tag_subtraction = (streq_any (ts_txt[PREV][COL_MENU_ELEMENT], // 2 if startupnotify option.
-						 "command", "prompt", "startupnotify", NULL)) ? 1 : 2;
-    for (subtr_path_depth_prev_cnt = offset; 
-	 subtr_path_depth_prev_cnt <= filter_path_depth_prev - action_closing_tag_subtraction;
-	 subtr_path_depth_prev_cnt++)
-      fputs ("  ", menu_file);
-    fputs ("</action>\n", menu_file);
-  }
-
-  // action without option
-  if (streq (ts_txt[PREV][COL_TYPE], "action") && !gtk_tree_model_iter_has_child (filter_model, &filter_iter[PREV]))
-    action_closing_tag_subtraction = 0;
-
-  // item
-  if (!(streq_any (ts_txt[PREV][COL_TYPE], "menu", "pipe menu", "separator", NULL) ||
-	(streq (ts_txt[PREV][COL_TYPE], "item") && 
-	 !gtk_tree_model_iter_has_child (filter_model, &filter_iter[PREV]))) && 
-      (streq_any (ts_txt[CURRENT][COL_TYPE], "menu", "pipe menu", "item", "separator", NULL) || last_row_reached)) {
-    /* 
-       If an open action has been closed (or it has been a self-closing action) and no new action follows, 
-       an </item> tag is written.
-       The calculation of the subtraction for this tag is  
-       filter_path_depth_prev - action_closing_tag_subtraction - 1, 
-       since the </item> closing tag is one indentation level below the one of the </action> closing tag:
-       Either 
-           <prompt>yes</prompt> (example)
-         </action>
-       </item>
-       or
-             <enabled>yes</enabled> (example)
-           </startupnotify>
-         </action>
-       </item> 
-    */
-    for (subtr_path_depth_prev_cnt = offset; 
-	 subtr_path_depth_prev_cnt <= filter_path_depth_prev - action_closing_tag_subtraction - 1;
-	 subtr_path_depth_prev_cnt++)
-      fputs ("  ", menu_file);
-    fputs ("</item>\n", menu_file);
-  }
-
-  // Menu
-  if (saving_stage == MENUS) {
-    GtkTreePath *filter_path = gtk_tree_model_get_path (filter_model, &filter_iter[CURRENT]);
-    const gint filter_path_depth = (last_row_reached) ? 1 : gtk_tree_path_get_depth (filter_path);
+  static const gchar spaces[] = "                                                                "; // 32 levels
 
-    // Cleanup
-    gtk_tree_path_free (filter_path);
-
-    /* 
-       If the current element is a menu, pipe menu, item or separator and the current path depth is lower than 
-       the previous one, addtional </menu> tags have to be added, as for example in these cases:
-
-       Case 1:
-
-                                                                Depth:  
-       <menu id="menu level 1a" label="menu level 1a">          1
-         <menu id="menu level 2" label="menu level 2">          2
-	   <menu id="menu level 3" label="menu level 3">        3
-	     <item label="1" />                                 4
-	     <item label="2">                                   4
-	       <action="Execute">                               5
-	         <command>                                      6
-		 <startupnotify>                                6
-		   <enabled>no</enabled>                        7 previous element
-		 </startupnotify>                               6
-	       </action>                                        5
-	     </item>                                            4
-
-	   </menu>                                              3
-         </menu>                                                2 
-       </menu>                                                  1
-       <menu id="menu level 1b">                                1 current element
-       ...
-
-       1 < filter_path_depth_prev (=7, 'enabled') - action_closing_tag_subtraction (here: 2) - 1 -> 1 < 4
-       4 - 1 = 3 menu closing tags to write.
-       
-       Case 2:
-
-                                                                Depth:
-       <menu id="menu level 1a" label="menu level 1a">          1
-         <menu id="menu level 1a" label="menu level 1a">        2
-           <separator />                                        3 previous element
-       
-	 </menu> has to be added                                2
-         <menu id="menu lebel 1b"> Level 2                      2 current element
-         ...
-
-       2 < filter_path_depth_prev (=3, 'separator') - action_closing_tag_substraction (here: -1) - 1 -> 2 < 3
-       3 - 2 = 1 closing tag to write.
-
-       If the current element is a menu/pipe menu/item/separator, its path depth is compared to the one of the 
-       previous element. If the path depth of the current element is lower than the one of the previous element, 
-       there are still open menu tags and additional </menu> tags have to be written prior to writing the tag for 
-       the current element. 
-       If the previous element is an option of an action or a self-closing action, the value of the previous path depth 
-       has to be adjusted to the additional closing tags resulting from this, since there have to be written less 
-       </menu> closing tags then. 
-       For this case the action_closing_tag_substraction has been set above, and considering there is also a closing 
-       item tag following afterwards, the calculation is 
-       filter_path_depth_prev - action_closing_tag_subtraction - 1 
-       (see above for the values for action_closing_tag subtraction). 
-       If the previous element is not an option of an action or self-closing action, 
-       but a self-closing menu/item, a pipe menu or separator, there is not only no action closing tag subtraction, 
-       but the additional reduction for the closing item tag has also to be taken to account. 
-       That is why action_closing_tag_subtraction defaults to -1 for this case, since this means  
-       filter_path_depth_prev - (-1) - 1 = filter_path_depth_prev
-       so this removes any reductions that would be caused by additional closing tags.
-    */
-    if ((streq_any (ts_txt[CURRENT][COL_TYPE], "menu", "pipe menu", "item", "separator", NULL) || last_row_reached) && 
-	filter_path_depth < filter_path_depth_prev - action_closing_tag_subtraction - 1) {
-      /* 
-	 The closing menu tags are written for each path depth from 
-	 filter_path_depth_prev - action_closing_tag_subtraction - 2
-	 down to
-	 filter_path_depth 
-      */
-      gint path_depth_of_closing_menu_tag = filter_path_depth_prev - action_closing_tag_subtraction - 2;
-      gint menu_closing_tags_cnt;
-
-      while (path_depth_of_closing_menu_tag >= filter_path_depth) {
-	for (menu_closing_tags_cnt = 1; 
-	     menu_closing_tags_cnt <= path_depth_of_closing_menu_tag; 
-	     menu_closing_tags_cnt++)
-	  fputs ("  ", menu_file);
-	fputs ("</menu>\n", menu_file);
-	path_depth_of_closing_menu_tag--;
-      }
-    }
-  }
-  
-  // Cleanup
-  for (array_cnt = CURRENT; array_cnt < NUMBER_OF_ITER_ARRAY_ELM; array_cnt++) {
-    g_free (ts_txt[array_cnt][COL_MENU_ELEMENT]);
-    g_free (ts_txt[array_cnt][COL_TYPE]);
-  }
+  for (; number_of_indentations > 32; number_of_indentations -= 32)
+    g_string_append_len (menu_buffer, spaces, 64);
+  if (number_of_indentations > 0)
+    g_string_append_len (menu_buffer, spaces, number_of_indentations * 2);
 }
 
 /* 
 
-   Writes an (opening) menu, item, separator or action tag into the menu XML file.
+   Writes an (opening) menu, item, separator or action tag into the buffer of the menu XML file.
 
 */
 
 static void write_tag (guint8         saving_stage, 
                        guint8         level, 
                        gchar        **tag_elements, 
-                       FILE          *menu_file, 
-		       GtkTreeModel  *local_model, 
-                       GtkTreeIter   *local_iter, 
+                       GString       *menu_buffer, 
+		       gboolean       has_child, 
                        guint8         type) 
 {
   /* For actions and options there is no distinction made between MENUS and ROOT_MENU, 
      the value is always IND_OF_MENU_STAGE. */
-  GString *file_string = g_string_new ((saving_stage == ROOT_MENU) ? "  " : "");
+  if (saving_stage == ROOT_MENU)
+    g_string_append (menu_buffer, "  ");
 
   if (type == MENU_OR_PIPE_MENU || type == ITEM_OR_ACTION) {
     if (type == MENU_OR_PIPE_MENU) {
-      g_string_append_printf (file_string, "<menu id=\"%s\"", tag_elements[MENU_ID_TXT]);
+      g_string_append_printf (menu_buffer, "<menu id=\"%s\"", tag_elements[MENU_ID_TXT]);
       if (tag_elements[MENU_ELEMENT_TXT] && 
 	  !(saving_stage == ROOT_MENU && streq (tag_elements[TYPE_TXT], "menu")))
-	g_string_append_printf (file_string, " label=\"%s\"", tag_elements[MENU_ELEMENT_TXT]);
+	g_string_append_printf (menu_buffer, " label=\"%s\"", tag_elements[MENU_ELEMENT_TXT]);
       if (streq (tag_elements[TYPE_TXT], "pipe menu"))
-	g_string_append_printf (file_string, " execute=\"%s\"", 
+	g_string_append_printf (menu_buffer, " execute=\"%s\"", 
 				(tag_elements[EXECUTE_TXT]) ? (tag_elements[EXECUTE_TXT]) : "");
-      if (tag_elements[ICON_PATH_TXT] && (saving_stage == ROOT_MENU || level == FILTER_LEVEL)) // icon="" is saved back.
-	g_string_append_printf (file_string, " icon=\"%s\"", tag_elements[ICON_PATH_TXT]);
+      if (tag_elements[ICON_PATH_TXT] && (saving_stage == ROOT_MENU || level == SUBLEVEL)) // icon="" is saved back.
+	g_string_append_printf (menu_buffer, " icon=\"%s\"", tag_elements[ICON_PATH_TXT]);
     }
     else if (type == ITEM_OR_ACTION) { // Item or action
-      g_string_append (file_string, (streq (tag_elements[TYPE_TXT], "item")) ? "<item" : "<action name");
+      g_string_append (menu_buffer, (streq (tag_elements[TYPE_TXT], "item")) ? "<item" : "<action name");
       if (streq (tag_elements[TYPE_TXT], "item")) {
 	if (tag_elements[MENU_ELEMENT_TXT])
-	  g_string_append_printf (file_string, " label=\"%s\"", tag_elements[MENU_ELEMENT_TXT]);
+	  g_string_append_printf (menu_buffer, " label=\"%s\"", tag_elements[MENU_ELEMENT_TXT]);
 	if (tag_elements[ICON_PATH_TXT]) // icon="" is saved back.
-	  g_string_append_printf (file_string, " icon=\"%s\"", tag_elements[ICON_PATH_TXT]);
+	  g_string_append_printf (menu_buffer, " icon=\"%s\"", tag_elements[ICON_PATH_TXT]);
       }
       else // Action
-	g_string_append_printf (file_string, "=\"%s\"", tag_elements[MENU_ELEMENT_TXT]);
+	g_string_append_printf (menu_buffer, "=\"%s\"", tag_elements[MENU_ELEMENT_TXT]);
     }
-    g_string_append_printf (file_string, "%s>\n", 
+    g_string_append_printf (menu_buffer, "%s>\n", 
 			    ((saving_stage == ROOT_MENU && type == MENU_OR_PIPE_MENU) || 
-			     !gtk_tree_model_iter_has_child (local_model, local_iter)) ? "/" : "");
+			     !has_child) ? "/" : "");
   }
   else { // Separator
     if (tag_elements[MENU_ELEMENT_TXT])
-      g_string_append_printf (file_string, "<separator label=\"%s\"/>\n", tag_elements[MENU_ELEMENT_TXT]);
+      g_string_append_printf (menu_buffer, "<separator label=\"%s\"/>\n", tag_elements[MENU_ELEMENT_TXT]);
     else
-      g_string_append (file_string, "<separator/>\n");
+      g_string_append (menu_buffer, "<separator/>\n");
   }
-    
-  fputs (file_string->str, menu_file);
-
-  // Cleanup
-  g_string_free (file_string, TRUE);
 }
 
 /* 
 
-   Gets all values of a row needed for saving and escapes their special characters.
+   Checks if a value contains any character that is replaced by g_markup_escape_text. 
+   Besides the markup characters these are control characters; 
+   the ones from U+0080 to U+009F start with 0xC2 in UTF-8.
 
 */
 
-static void get_field_values (gchar **txt_fields_array, GtkTreeModel *current_model, GtkTreeIter *current_iter)
+static gboolean escaping_needed (const gchar *txt)
 {
-  guint8 txt_cnt;
-  gchar *unescaped_save_txt;
+  const guchar *txt_char;
 
-  for (txt_cnt = 0; txt_cnt < NUMBER_OF_TXT_FIELDS; txt_cnt++) {
-    gtk_tree_model_get (current_model, current_iter, txt_cnt + TS_ICON_PATH, &unescaped_save_txt, -1);
-    txt_fields_array[txt_cnt] = (unescaped_save_txt) ? g_markup_escape_text (unescaped_save_txt, -1) : NULL;
-
-    // Cleanup
-    g_free (unescaped_save_txt);
+  for (txt_char = (const guchar *) txt; *txt_char; txt_char++) {
+    switch (*txt_char) {
+    case '&': case '<': case '>': case '\'': case '"': case 0x7f: case 0xc2:
+      return TRUE;
+    }
+    if (*txt_char < 0x20 && *txt_char != '\t' && *txt_char != '\n' && *txt_char != '\r')
+      return TRUE;
   }
+
+  return FALSE;
 }
 
 /* 
 
-   Iterates through the elements of a menu or item for processing 
-   of each node and generating lines for the xml file.
+   Escapes the special characters of all values of a row needed for saving. 
+   Most values don't contain any of them, so these are kept as they are without creating a new string.
 
 */
 
-static gboolean treestore_save_process_iteration (GtkTreeModel               *filter_model, 
-						  GtkTreePath                *filter_path, 
-						  GtkTreeIter                *filter_iter, 
-						  struct save_menu_args_data *save_menu_args)
+static void escape_field_values (gchar **txt_fields_array)
 {
-  gint filter_path_depth = gtk_tree_path_get_depth (filter_path);
-  save_menu_args->filter_iter[CURRENT] = *filter_iter;
+  for (guint8 txt_cnt = 0; txt_cnt < NUMBER_OF_TXT_FIELDS; txt_cnt++) {
+    if (txt_fields_array[txt_cnt] && escaping_needed (txt_fields_array[txt_cnt]))
+      free_and_reassign (txt_fields_array[txt_cnt], g_markup_escape_text (txt_fields_array[txt_cnt], -1));
+  }
+}
 
-  // Write closing tag(s).
-  if (filter_path_depth < save_menu_args->filter_path_depth_prev)
-    closing_tags (FALSE, filter_model, save_menu_args);
+/* 
 
-  gchar *save_txts_filter[NUMBER_OF_TXT_FIELDS];
-  FILE *menu_file = save_menu_args->menu_file;
+   Writes a row below the toplevel including all its children into the buffer of the menu XML file. 
+   The closing tag of a row with children is written after them, at the same indentation as the opening tag.
+   Returns the index of the row that follows after the written row and its children inside the snapshot.
 
-  gint path_depth_cnt;
+*/
 
-  get_field_values (save_txts_filter, filter_model, filter_iter);
+static guint write_row (GArray  *save_rows, 
+			guint    row_idx, 
+			guint8   saving_stage, 
+			GString *menu_buffer)
+{
+  struct save_row *save_row = &g_array_index (save_rows, struct save_row, row_idx);
+  gchar **txt_fields = save_row->txt_fields;
+  // Contents of toplevel items are written inside the root menu, which adds one indentation.
+  gint indentation = save_row->path_depth - 1 + (saving_stage == ROOT_MENU);
+  const gchar *closing_tag = NULL;
+  guint next_row_idx = row_idx + 1;
 
-  // Create leading whitespace for indenting.
-  for (path_depth_cnt = (save_menu_args->saving_stage == MENUS); // TRUE = 1, FALSE = 0.
-       path_depth_cnt <= filter_path_depth ;
-       path_depth_cnt++)
-    fputs ("  ", menu_file);
+  append_indentation (menu_buffer, indentation);
 
   // High-level and standard elements
-  if (streq_any (save_txts_filter[TYPE_TXT], "menu", "pipe menu", NULL))
-    write_tag (MENUS, FILTER_LEVEL, save_txts_filter, menu_file, filter_model, filter_iter, MENU_OR_PIPE_MENU);
-  else if (streq_any (save_txts_filter[TYPE_TXT], "item", "action", "separator", NULL))
-    write_tag (IND_OF_MENU_STAGE, IND_OF_LEVEL, save_txts_filter, menu_file, filter_model, filter_iter, 
-	       streq (save_txts_filter[TYPE_TXT], "separator") ? SEPARATOR : ITEM_OR_ACTION);
+  if (streq_any (txt_fields[TYPE_TXT], "menu", "pipe menu", NULL)) {
+    write_tag (MENUS, SUBLEVEL, txt_fields, menu_buffer, save_row->has_child, MENU_OR_PIPE_MENU);
+    closing_tag = "</menu>\n";
+  }
+  else if (streq_any (txt_fields[TYPE_TXT], "item", "action", "separator", NULL)) {
+    write_tag (IND_OF_MENU_STAGE, IND_OF_LEVEL, txt_fields, menu_buffer, save_row->has_child, 
+	       streq (txt_fields[TYPE_TXT], "separator") ? SEPARATOR : ITEM_OR_ACTION);
+    closing_tag = (streq (txt_fields[TYPE_TXT], "item")) ? "</item>\n" : "</action>\n";
+  }
   /* "Execute" options incl. "startupnotify" and its options 
      ("prompt" also for "Exit/SessionLogout" action, "command" also for "Restart" action). */
   else {
-    if (save_txts_filter[VALUE_TXT] || gtk_tree_model_iter_has_child (filter_model, filter_iter)) {
-      if (streq (save_txts_filter[TYPE_TXT], "option"))
-	fprintf (menu_file, "<%s>%s</%s>\n", save_txts_filter[MENU_ELEMENT_TXT], save_txts_filter[VALUE_TXT], 
-		 save_txts_filter[MENU_ELEMENT_TXT]);
-      else
-	fprintf (menu_file, "<startupnotify>\n");
+    if (txt_fields[VALUE_TXT] || save_row->has_child) {
+      if (streq (txt_fields[TYPE_TXT], "option"))
+	g_string_append_printf (menu_buffer, "<%s>%s</%s>\n", txt_fields[MENU_ELEMENT_TXT], 
+				txt_fields[VALUE_TXT], txt_fields[MENU_ELEMENT_TXT]);
+      else {
+	g_string_append (menu_buffer, "<startupnotify>\n");
+	closing_tag = "</startupnotify>\n";
+      }
     }
     else
-      fprintf (menu_file, "<%s/>\n", save_txts_filter[MENU_ELEMENT_TXT]);
+      g_string_append_printf (menu_buffer, "<%s/>\n", txt_fields[MENU_ELEMENT_TXT]);
   }
 
-  save_menu_args->filter_path_depth_prev = filter_path_depth;
-  save_menu_args->filter_iter[PREV] = *filter_iter;
+  g_atomic_int_inc (&saved_rows_cnt);
 
-  // Cleanup
-  free_elements_of_static_string_array (save_txts_filter, NUMBER_OF_TXT_FIELDS, FALSE);
+  if (save_row->has_child) {
+    next_row_idx = write_children (save_rows, row_idx, saving_stage, menu_buffer);
+    if (closing_tag) {
+      append_indentation (menu_buffer, indentation);
+      g_string_append (menu_buffer, closing_tag);
+    }
+  }
 
-  return FALSE;
+  return next_row_idx;
 }
 
 /* 
 
-   Processes all subrows of a menu or item.
+   Writes all children of a row. The snapshot is in the order of the tree view, 
+   so the children of a row follow directly after it; they end at the first row that isn't deeper than the parent. 
+   If the children of a menu are cached, they are not part of the snapshot and the cached fragment is written instead.
+   Returns the index of the row that follows after the children.
 
 */
 
-static void process_menu_or_item (GtkTreeIter                *process_iter, 
-				  struct save_menu_args_data *save_menu_args) 
+static guint write_children (GArray  *save_rows, 
+			     guint    parent_row_idx, 
+			     guint8   saving_stage, 
+			     GString *menu_buffer)
 {
-  GtkTreePath *path = gtk_tree_model_get_path (model, process_iter);
-  GtkTreeModel *filter_model = gtk_tree_model_filter_new (model, path);
+  struct save_row *parent_row = &g_array_index (save_rows, struct save_row, parent_row_idx);
+  gsize children_start = menu_buffer->len;
+  guint row_idx = parent_row_idx + 1;
 
-  // Cleanup
-  gtk_tree_path_free (path);
+  if (parent_row->children_fragment) {
+    g_string_append (menu_buffer, parent_row->children_fragment);
+
+    return row_idx;
+  }
 
-  gtk_tree_model_foreach (filter_model, (GtkTreeModelForeachFunc) treestore_save_process_iteration, save_menu_args);
-  closing_tags (TRUE, filter_model, save_menu_args);
-  save_menu_args->filter_path_depth_prev = 0; // Reset
+  while (row_idx < save_rows->len && 
+	 g_array_index (save_rows, struct save_row, row_idx).path_depth > parent_row->path_depth)
+    row_idx = write_row (save_rows, row_idx, saving_stage, menu_buffer);
+
+  if (parent_row->fragment_key)
+    parent_row->children_fragment = g_strndup (menu_buffer->str + children_start, menu_buffer->len - children_start);
+
+  return row_idx;
 }
 
 /* 
 
-   Saves the currently edited menu.
+   Writes the menu into a temporary file inside the same folder and replaces the menu file with it afterwards, 
+   so the menu file is always complete, even if the program or the system crashes while saving. 
+   If the menu file already exists, a backup of it is created before it is replaced.
+   Returns NULL on success or an error message, since this is done by the saving thread, 
+   which must not show any dialogs itself.
 
 */
 
-void save_menu (gchar *save_as_filename)
+static const gchar *write_menu_file (gchar    *menu_filename, 
+				     GString  *menu_buffer, 
+				     gboolean  sync_to_disk)
 {
-  GtkTreeIter save_menu_iter;
-  gboolean valid;
+  gchar *tmp_filename = g_strconcat (menu_filename, ".XXXXXX", NULL);
+  gchar *backup_filename = g_strconcat (menu_filename, "~", NULL);
+  const gchar *errmsg_txt = NULL;
+
+  GStatBuf menu_file_status;
+  gsize written_bytes = 0;
+  gssize write_result;
+  gint file_descriptor;
+
+  if ((file_descriptor = g_mkstemp (tmp_filename)) == -1) {
+    errmsg_txt = "Could not open menu file for writing!";
+    goto cleanup;
+  }
 
-  gchar *preliminary_filename = (save_as_filename) ? save_as_filename : filename;
-  FILE *menu_file;
+  // g_mkstemp creates files that are only accessible by the owner, so the permissions of the old file are taken over.
+  fchmod (file_descriptor, (g_stat (menu_filename, &menu_file_status) == 0) ? (menu_file_status.st_mode & 07777) : 0644);
 
-  gchar *save_txts_toplevel[NUMBER_OF_TXT_FIELDS];
+  // (Note: write may write less bytes than requested, e.g. if it has been interrupted by a signal.)
+  while (written_bytes < menu_buffer->len) {
+    if ((write_result = write (file_descriptor, menu_buffer->str + written_bytes, 
+			       menu_buffer->len - written_bytes)) == -1) {
+      if (errno == EINTR)
+	continue;
+      break;
+    }
+    written_bytes += write_result;
+  }
+
+  if (written_bytes < menu_buffer->len || (sync_to_disk && fsync (file_descriptor) != 0)) {
+    close (file_descriptor);
+    errmsg_txt = "Could not write menu file!";
+    goto remove_tmp_file;
+  }
+  if (close (file_descriptor) != 0) {
+    errmsg_txt = "Could not write menu file!";
+    goto remove_tmp_file;
+  }
 
   // Create a backup of the menu file if another one already exists with the same name.
-  if (g_file_test (preliminary_filename, G_FILE_TEST_EXISTS)) {
-    gchar *backup_file_name = g_strconcat (preliminary_filename, "~", NULL);
+  if (g_file_test (menu_filename, G_FILE_TEST_EXISTS)) {
+    GFile *menu_file = g_file_new_for_path (menu_filename);
+    GFile *backup_file = g_file_new_for_path (backup_filename);
+    gboolean backup_created = g_file_copy (menu_file, backup_file, G_FILE_COPY_OVERWRITE, NULL, NULL, NULL, NULL);
 
-    if (g_rename (preliminary_filename, backup_file_name) != 0) {
-      show_errmsg ("Could not create a backup file of the overwritten menu!");
+    // Cleanup
+    g_object_unref (menu_file);
+    g_object_unref (backup_file);
+
+    if (!backup_created) {
+      errmsg_txt = "Could not create a backup file of the overwritten menu!";
+      goto remove_tmp_file;
+    }
+  }
 
-      // Cleanup
-      g_free (save_as_filename); // If save_menu is called directly, save_as_filename is NULL.
-      g_free (backup_file_name);
+  // Renaming is atomic, so other programs like Openbox either read the old or the new menu file, never a partial one.
+  if (g_rename (tmp_filename, menu_filename) != 0) {
+    errmsg_txt = "Could not replace the menu file!";
+    goto remove_tmp_file;
+  }
+
+  // The renaming itself is only stored on disk after the folder that contains the file has been synchronised, too.
+  if (sync_to_disk) {
+    gchar *menu_folder = g_path_get_dirname (menu_filename);
 
-      return;
+    if ((file_descriptor = open (menu_folder, O_RDONLY)) != -1) {
+      fsync (file_descriptor);
+      close (file_descriptor);
     }
-    
+
     // Cleanup
-    g_free (backup_file_name);
+    g_free (menu_folder);
   }
 
-  // Open menu file.
-  if (!(menu_file = fopen (preliminary_filename, "w"))) {
-    show_errmsg ("Could not open menu file for writing!");
+  goto cleanup;
 
-    // Cleanup
-    g_free (save_as_filename); // If save_menu is called directly, save_as_filename is NULL.
+ remove_tmp_file:
+  g_unlink (tmp_filename);
 
-    return;
+ cleanup:
+  g_free (tmp_filename);
+  g_free (backup_filename);
+
+  return errmsg_txt;
+}
+
+/* 
+
+   Adds a row and its descendants to the snapshot of the menu that is saved by the saving thread. 
+   The snapshot contains copies of all values, so the menu can be edited while it is being saved. 
+   If the fragment cache is used, the children of menus whose serialised children are cached are left out.
+
+*/
+
+static void add_row_to_snapshot (GtkTreeIter *row_iter, 
+				 gint         path_depth, 
+				 gboolean     use_fragment_cache, 
+				 GArray      *save_rows)
+{
+  struct save_row save_row = {
+    .path_depth = path_depth,
+    .has_child = gtk_tree_model_iter_has_child (model, row_iter)
+  };
+  gchar **txt_fields = save_row.txt_fields;
+  gchar *cached_fragment;
+
+  gtk_tree_model_get (model, row_iter, 
+		      TS_ICON_PATH, &txt_fields[ICON_PATH_TXT], 
+		      TS_MENU_ELEMENT, &txt_fields[MENU_ELEMENT_TXT], 
+		      TS_TYPE, &txt_fields[TYPE_TXT], 
+		      TS_VALUE, &txt_fields[VALUE_TXT], 
+		      TS_MENU_ID, &txt_fields[MENU_ID_TXT], 
+		      TS_EXECUTE, &txt_fields[EXECUTE_TXT], 
+		      TS_ELEMENT_VISIBILITY, &txt_fields[ELEMENT_VISIBILITY_TXT], 
+		      -1);
+
+  if (use_fragment_cache && save_row.has_child && streq (txt_fields[TYPE_TXT], "menu")) {
+    if (g_hash_table_lookup_extended (fragment_cache, row_iter->user_data, NULL, (gpointer *) &cached_fragment) && 
+	cached_fragment)
+      save_row.children_fragment = g_strdup (cached_fragment);
+    else {
+      save_row.fragment_key = row_iter->user_data;
+      g_hash_table_insert (fragment_cache, row_iter->user_data, NULL);
+    }
   }
 
-  if (save_as_filename)
-    set_filename_and_window_title (save_as_filename);
+  g_array_append_val (save_rows, save_row);
 
+  if (save_row.has_child && !save_row.children_fragment)
+    add_rows_to_snapshot (row_iter, path_depth + 1, use_fragment_cache, save_rows);
+}
 
-  // --- Write menu file. ---
+/* 
 
+   Adds the children of a row to the snapshot of the menu.
 
-  gchar *standard_file_path = g_strconcat (getenv ("HOME"), "/.config/openbox/menu.xml", NULL);
+*/
 
-  struct save_menu_args_data save_menu_args = {
-    .menu_file = menu_file,
-    .saving_stage = MENUS,
-    .filter_path_depth_prev = 0
-  };
+static void add_rows_to_snapshot (GtkTreeIter *parent, 
+				  gint         path_depth, 
+				  gboolean     use_fragment_cache, 
+				  GArray      *save_rows)
+{
+  GtkTreeIter iter_loop;
+  gboolean valid = gtk_tree_model_iter_children (model, &iter_loop, parent);
+
+  while (valid) {
+    add_row_to_snapshot (&iter_loop, path_depth, use_fragment_cache, save_rows);
+    valid = gtk_tree_model_iter_next (model, &iter_loop);
+  }
+}
+
+/* 
+
+   Frees a snapshot of the menu.
 
-  fputs ("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n\n<openbox_menu>\n\n", menu_file);
+*/
+
+static void free_snapshot (GArray *save_rows)
+{
+  struct save_row *save_row;
+
+  for (guint row_idx = 0; row_idx < save_rows->len; row_idx++) {
+    save_row = &g_array_index (save_rows, struct save_row, row_idx);
+    free_elements_of_static_string_array (save_row->txt_fields, NUMBER_OF_TXT_FIELDS, FALSE);
+    g_free (save_row->children_fragment);
+  }
+  g_array_free (save_rows, TRUE);
+}
+
+/* 
+
+   Stores the serialised children of menus generated by the saving thread inside the fragment cache. 
+   Menus that have been changed while they were saved have been removed from the cache meanwhile, 
+   their fragments are outdated and discarded.
+
+*/
+
+static void store_generated_fragments (GArray *save_rows)
+{
+  struct save_row *save_row;
+  gchar *cached_fragment;
+  guint row_idx;
+
+  for (row_idx = 0; row_idx < save_rows->len; row_idx++) {
+    save_row = &g_array_index (save_rows, struct save_row, row_idx);
+    if (save_row->fragment_key && save_row->children_fragment && 
+	g_hash_table_lookup_extended (fragment_cache, save_row->fragment_key, NULL, (gpointer *) &cached_fragment) && 
+	!cached_fragment) {
+      g_hash_table_insert (fragment_cache, save_row->fragment_key, save_row->children_fragment);
+      save_row->children_fragment = NULL; // Now owned by the fragment cache.
+    }
+  }
+}
+
+/* 
+
+   Frees a save job including its snapshot.
+
+*/
+
+static void free_save_job (struct save_job *save_job)
+{
+  free_snapshot (save_job->save_rows);
+
+  g_free (save_job->menu_filename);
+  g_free (save_job->save_as_filename);
+  g_free (save_job->filename_before_saving);
+  g_free (save_job->errmsg_txt);
+  g_free (save_job);
+}
+
+/* 
+
+   Builds the menu from the snapshot and writes it into the menu file. 
+   This function runs inside the saving thread, so it doesn't access the treestore or any widgets; 
+   the result is handed over to the main loop afterwards.
+
+*/
+
+static gpointer save_menu_in_background (struct save_job *save_job)
+{
+  GArray *save_rows = save_job->save_rows;
+  GString *menu_buffer = g_string_sized_new (INITIAL_MENU_BUFFER_SIZE);
+  struct save_row *save_row;
+  const gchar *errmsg_txt;
+  guint row_idx;
+
+  for (row_idx = 0; row_idx < save_rows->len; row_idx++) {
+    escape_field_values (g_array_index (save_rows, struct save_row, row_idx).txt_fields);
+    g_atomic_int_inc (&saved_rows_cnt);
+  }
+
+
+  // --- Write menu into buffer. ---
+
+
+  g_string_append (menu_buffer, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n\n<openbox_menu>\n\n");
 
   // Menus
-  valid = gtk_tree_model_get_iter_first (model, &save_menu_iter);
-  while (valid) {
-    get_field_values (save_txts_toplevel, model, &save_menu_iter);
-
-    if (streq (save_txts_toplevel[TYPE_TXT], "menu") || 
-	(streq (save_txts_toplevel[TYPE_TXT], "pipe menu") && 
-	 streq (save_txts_toplevel[ELEMENT_VISIBILITY_TXT], "invisible unintegrated menu"))) {
-      write_tag (MENUS, TOPLEVEL, save_txts_toplevel, menu_file, model, &save_menu_iter, MENU_OR_PIPE_MENU);
-      if (gtk_tree_model_iter_has_child (model, &save_menu_iter)) {
-	process_menu_or_item (&save_menu_iter, &save_menu_args);
-	fputs ("</menu>\n", menu_file);
+  for (row_idx = 0; row_idx < save_rows->len; row_idx++) {
+    save_row = &g_array_index (save_rows, struct save_row, row_idx);
+
+    if (save_row->path_depth > 1)
+      continue;
+
+    if (streq (save_row->txt_fields[TYPE_TXT], "menu") || 
+	(streq (save_row->txt_fields[TYPE_TXT], "pipe menu") && 
+	 streq (save_row->txt_fields[ELEMENT_VISIBILITY_TXT], "invisible unintegrated menu"))) {
+      write_tag (MENUS, TOPLEVEL, save_row->txt_fields, menu_buffer, save_row->has_child, MENU_OR_PIPE_MENU);
+      if (save_row->has_child) {
+	write_children (save_rows, row_idx, MENUS, menu_buffer);
+	g_string_append (menu_buffer, "</menu>\n");
       }
     }
-    valid = gtk_tree_model_iter_next (model, &save_menu_iter);
-
-    // Cleanup
-    free_elements_of_static_string_array (save_txts_toplevel, NUMBER_OF_TXT_FIELDS, FALSE);
   }
 
   // Root menu
-  fputs ("\n<menu id=\"root-menu\" label=\"Openbox 3\">\n", menu_file);
+  g_string_append (menu_buffer, "\n<menu id=\"root-menu\" label=\"Openbox 3\">\n");
+
+  for (row_idx = 0; row_idx < save_rows->len; row_idx++) {
+    save_row = &g_array_index (save_rows, struct save_row, row_idx);
+
+    if (save_row->path_depth > 1)
+      continue;
+
+    if (streq_any (save_row->txt_fields[TYPE_TXT], "menu", "pipe menu", NULL) && 
+	!streq (save_row->txt_fields[ELEMENT_VISIBILITY_TXT], "invisible unintegrated menu"))
+      write_tag (ROOT_MENU, TOPLEVEL, save_row->txt_fields, menu_buffer, save_row->has_child, MENU_OR_PIPE_MENU);
+    else if (streq_any (save_row->txt_fields[TYPE_TXT], "item", "separator", NULL)) {
+      write_tag (ROOT_MENU, IND_OF_LEVEL, save_row->txt_fields, menu_buffer, save_row->has_child, 
+		 streq (save_row->txt_fields[TYPE_TXT], "item") ? ITEM_OR_ACTION : SEPARATOR);
+      if (save_row->has_child) { // = item with content.
+	write_children (save_rows, row_idx, ROOT_MENU, menu_buffer);
+	g_string_append (menu_buffer, "  </item>\n");
+      }
+    }
 
-  save_menu_args.saving_stage = ROOT_MENU;
+    g_atomic_int_inc (&saved_rows_cnt);
+  }
 
-  valid = gtk_tree_model_get_iter_first (model, &save_menu_iter);
-  while (valid) {
-    get_field_values (save_txts_toplevel, model, &save_menu_iter);
-
-    if (streq_any (save_txts_toplevel[TYPE_TXT], "menu", "pipe menu", NULL) && 
-	!streq (save_txts_toplevel[ELEMENT_VISIBILITY_TXT], "invisible unintegrated menu"))
-      write_tag (ROOT_MENU, TOPLEVEL, save_txts_toplevel, menu_file, model, &save_menu_iter, MENU_OR_PIPE_MENU);
-    else if (streq_any (save_txts_toplevel[TYPE_TXT], "item", "separator", NULL)) {
-      write_tag (ROOT_MENU, IND_OF_LEVEL, save_txts_toplevel, menu_file, model, &save_menu_iter, 
-		 streq (save_txts_toplevel[TYPE_TXT], "item") ? ITEM_OR_ACTION : SEPARATOR);
-      if (gtk_tree_model_iter_has_child (model, &save_menu_iter)) // = item with content.
-	process_menu_or_item (&save_menu_iter, &save_menu_args);
+  g_string_append (menu_buffer, "</menu>\n\n</openbox_menu>");
+
+
+  // --- Replace menu file. ---
+
+
+  if ((errmsg_txt = write_menu_file (save_job->menu_filename, menu_buffer, save_job->sync_to_disk)))
+    save_job->errmsg_txt = g_strdup (errmsg_txt);
+  else {
+    save_job->version_not_stored = !store_menu_version (save_job->menu_filename, menu_buffer->str, menu_buffer->len);
+    // "openbox --reconfigure" is only called when kickshaw is used under openbox. 
+    if (save_job->reconfigure_openbox && (system ("pgrep 'openbox' > /dev/null 2>&1")) == 0)
+      save_job->reconfiguration_failed = ((system ("openbox --reconfigure")) != 0);
+  }
+
+  // Cleanup
+  g_string_free (menu_buffer, TRUE);
+
+  g_idle_add ((GSourceFunc) saving_finished, save_job);
+
+  return NULL;
+}
+
+/* 
+
+   Shows the progress of the save inside the label of the "Save" toolbar button.
+
+*/
+
+static gboolean show_saving_progress (GArray *save_rows)
+{
+  // Each row is processed twice, once for escaping its values and once for writing it into the buffer.
+  guint percentage = MIN (g_atomic_int_get (&saved_rows_cnt) * 100 / (2 * MAX (save_rows->len, 1)), 99);
+  gchar *progress_txt = g_strdup_printf ("Saving... %u%%", percentage);
+
+  gtk_tool_button_set_label (GTK_TOOL_BUTTON (tb[TB_SAVE]), progress_txt);
+
+  // Cleanup
+  g_free (progress_txt);
+
+  return TRUE;
+}
+
+/* 
+
+   Processes the result of a save inside the main loop after the saving thread has finished.
+
+*/
+
+static gboolean saving_finished (struct save_job *save_job)
+{
+  g_thread_join (saving_thread);
+  saving_thread = NULL;
+
+  g_source_remove (saving_progress_timeout_id);
+  saving_progress_timeout_id = 0;
+  gtk_tool_button_set_label (GTK_TOOL_BUTTON (tb[TB_SAVE]), NULL);
+  gtk_tool_item_set_is_important (tb[TB_SAVE], FALSE);
+
+  // The fragments are also valid if the menu file couldn't be written.
+  store_generated_fragments (save_job->save_rows);
+
+  // Another menu might have been loaded or created while the menu was saved.
+  gboolean same_menu = streq (filename, save_job->filename_before_saving);
+
+  if (save_job->errmsg_txt) {
+    show_errmsg (save_job->errmsg_txt);
+    if (same_menu && save_job->change_done_before_saving) {
+      change_done = TRUE;
+      if (filename) {
+	gtk_widget_set_sensitive (GTK_WIDGET (mb_file_menu_items[MB_SAVE]), TRUE);
+	gtk_widget_set_sensitive (GTK_WIDGET (tb[TB_SAVE]), TRUE);
+      }
+    }
+  }
+  else {
+    if (same_menu && save_job->save_as_filename) {
+      set_filename_and_window_title (save_job->save_as_filename);
+      save_job->save_as_filename = NULL; // Now owned by filename.
+    }
+    if (streq (filename, save_job->menu_filename)) {
+      remember_menu_file_content ();
+      journal_menu_saved (save_job->journal_size);
     }
+    if (save_job->reconfiguration_failed)
+      show_errmsg ("The menu was saved, but reconfiguration of Openbox failed.");
+    if (save_job->version_not_stored)
+      show_msg_in_statusbar ("The menu was saved, but it could not be added to the version history.");
+  }
+
+  // Cleanup
+  free_save_job (save_job);
+
+  // Changes that have been done while the menu was saved are saved now.
+  if (save_queued) {
+    gchar *save_as_filename = queued_save_as_filename;
+
+    save_queued = FALSE;
+    queued_save_as_filename = NULL;
+    if (save_as_filename || filename)
+      save_menu (save_as_filename);
+  }
+
+  return FALSE;
+}
 
-    valid = gtk_tree_model_iter_next (model, &save_menu_iter);
+/* 
+
+   Returns if the menu is currently being saved by the saving thread.
+
+*/
+
+gboolean menu_is_being_saved (void)
+{
+  return saving_thread != NULL;
+}
+
+/* 
+
+   Waits until a running save, including one that has been queued meanwhile, has been finished.
+
+*/
+
+void wait_for_saving_to_finish (void)
+{
+  // The result of a save is processed inside the main loop, which may start a queued save.
+  while (saving_thread)
+    g_main_context_iteration (NULL, TRUE);
+}
+
+/* 
+
+   Removes the cached fragments of a changed row and all its ancestors, since all of them contain the row. 
+   Connected to all signals of the treestore that report changes, so any kind of editing is covered, 
+   including drag and drop, sorting, search and replace and reloading. 
+   (Note: After a row has been deleted, its path refers to the next sibling, if there is one, 
+   whose fragment is removed then, too. This is harmless, since it's only regenerated by the next save.) 
+   Deleted rows are handled by cached_fragments_row_deleted.
+
+*/
+
+void invalidate_cached_fragments (GtkTreeModel *local_model, 
+				  GtkTreePath  *local_path)
+{
+  if (!fragment_cache || g_hash_table_size (fragment_cache) == 0)
+    return;
+
+  GtkTreePath *path_loop = gtk_tree_path_copy (local_path);
+  GtkTreeIter iter_loop;
+
+  while (gtk_tree_path_get_depth (path_loop) > 0) {
+    if (gtk_tree_model_get_iter (local_model, &iter_loop, path_loop))
+      g_hash_table_remove (fragment_cache, iter_loop.user_data);
+    gtk_tree_path_up (path_loop);
+  }
+
+  // Cleanup
+  gtk_tree_path_free (path_loop);
+}
+
+/* 
+
+   Called for every deleted row of the treestore. The deleted row and its descendants are already gone when 
+   this signal is emitted, so their cached fragments are removed later at once by 
+   remove_cached_fragments_of_deleted_rows; the fragments of the ancestors are invalidated immediately.
+
+*/
+
+void cached_fragments_row_deleted (GtkTreeModel *local_model, 
+				   GtkTreePath  *local_path)
+{
+  if (!fragment_cache || g_hash_table_size (fragment_cache) == 0)
+    return;
+
+  invalidate_cached_fragments (local_model, local_path);
+  fragments_of_deleted_rows_cached = TRUE;
+}
+
+/* 
+
+   Removes the cached fragments of all menus that no longer exist. 
+   Only menus are descended into, since menus can't be children of any other element.
+
+*/
+
+static void remove_cached_fragments_of_deleted_rows (void)
+{
+  if (!fragments_of_deleted_rows_cached)
+    return;
+
+  GHashTable *existing_menus = g_hash_table_new (g_direct_hash, g_direct_equal);
+  GHashTableIter fragment_cache_iter;
+  gpointer node;
+
+  GtkTreeIter iter_loop;
+  gchar *type_txt_loop;
+  gboolean menu_loop;
+  gboolean valid = gtk_tree_model_get_iter_first (model, &iter_loop);
+
+  while (valid) {
+    gtk_tree_model_get (model, &iter_loop, TS_TYPE, &type_txt_loop, -1);
+    if ((menu_loop = streq (type_txt_loop, "menu")))
+      g_hash_table_add (existing_menus, iter_loop.user_data);
+    valid = get_next_row_in_preorder (model, &iter_loop, -1, menu_loop);
 
     // Cleanup
-    free_elements_of_static_string_array (save_txts_toplevel, NUMBER_OF_TXT_FIELDS, FALSE);
+    g_free (type_txt_loop);
+  }
+
+  g_hash_table_iter_init (&fragment_cache_iter, fragment_cache);
+  while (g_hash_table_iter_next (&fragment_cache_iter, &node, NULL)) {
+    if (!g_hash_table_contains (existing_menus, node))
+      g_hash_table_iter_remove (&fragment_cache_iter);
   }
 
-  fputs ("</menu>\n\n</openbox_menu>", menu_file);
+  fragments_of_deleted_rows_cached = FALSE;
+
+  // Cleanup
+  g_hash_table_destroy (existing_menus);
+}
+
+/* 
+
+   Removes all cached fragments, used if another menu is loaded or a new one is created.
+
+*/
+
+void clear_fragment_cache (void)
+{
+  if (fragment_cache)
+    g_hash_table_remove_all (fragment_cache);
+  fragments_of_deleted_rows_cached = FALSE;
+}
+
+/* 
 
-  fclose (menu_file);
+   Saves the currently edited menu. 
+   A snapshot of the menu is taken, which is written into the menu file by a separate thread, 
+   so the user interface isn't blocked while saving.
+
+*/
+
+void save_menu (gchar *save_as_filename)
+{
+  // A save that is requested while the menu is being saved is done after the running one has finished.
+  if (saving_thread) {
+    save_queued = TRUE;
+    if (save_as_filename)
+      free_and_reassign (queued_save_as_filename, save_as_filename);
+
+    return;
+  }
+
+  struct save_job *save_job = g_new0 (struct save_job, 1);
+  gchar *standard_file_path = g_strconcat (getenv ("HOME"), "/.config/openbox/menu.xml", NULL);
+
+  if (!fragment_cache)
+    fragment_cache = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) g_free);
+  remove_cached_fragments_of_deleted_rows ();
+
+  save_job->save_rows = g_array_sized_new (FALSE, FALSE, sizeof (struct save_row), 
+					   gtk_tree_model_iter_n_children (model, NULL));
+  add_rows_to_snapshot (NULL, 1, TRUE, save_job->save_rows);
+  save_job->menu_filename = g_strdup ((save_as_filename) ? save_as_filename : filename);
+  save_job->save_as_filename = save_as_filename;
+  save_job->filename_before_saving = g_strdup (filename);
+  save_job->sync_to_disk = 
+    gtk_check_menu_item_get_active (GTK_CHECK_MENU_ITEM (mb_view_and_options[SYNC_MENU_FILE_TO_DISK]));
+  save_job->reconfigure_openbox = streq (save_job->menu_filename, standard_file_path);
+  save_job->change_done_before_saving = change_done;
+  save_job->journal_size = get_journal_size ();
+
+  // Cleanup
+  g_free (standard_file_path);
+
+  // Changes that are done while the menu is being saved activate the "Save" menu item and toolbar button again.
   change_done = FALSE;
   gtk_widget_set_sensitive (GTK_WIDGET (mb_file_menu_items[MB_SAVE]), FALSE);
   gtk_widget_set_sensitive (GTK_WIDGET (tb[TB_SAVE]), FALSE);
 
-  // "openbox --reconfigure" is only called when kickshaw is used under openbox. 
-  if (streq (filename, standard_file_path) && 
-      (system ("pgrep 'openbox' > /dev/null 2>&1")) == 0)
-    if ((system ("openbox --reconfigure")) != 0)
-      show_errmsg ("The menu was saved, but reconfiguration of Openbox failed.");
+  g_atomic_int_set (&saved_rows_cnt, 0);
+  gtk_tool_item_set_is_important (tb[TB_SAVE], TRUE); // Shows the label with the progress next to the icon.
+  show_saving_progress (save_job->save_rows);
+  saving_progress_timeout_id = g_timeout_add (SAVING_PROGRESS_INTERVAL, (GSourceFunc) show_saving_progress, 
+					      save_job->save_rows);
 
-  // Cleanup
-  g_free (standard_file_path);
+  saving_thread = g_thread_new ("save menu", (GThreadFunc) save_menu_in_background, save_job);
 }
 
 /* 
@@ -574,3 +919,37 @@ void save_menu_as (void)
   else
     gtk_widget_destroy (dialog);
 }
+
+/* 
+
+   Writes rows including their descendants in the format of the menu file, as they appear inside a menu, 
+   so they can be inserted into any Openbox menu. 
+   Menus are written with their contents instead of references to their definitions.
+
+*/
+
+gchar *write_rows_as_menu_fragment (GList *paths)
+{
+  GArray *save_rows = g_array_new (FALSE, FALSE, sizeof (struct save_row));
+  GString *menu_buffer = g_string_sized_new (INITIAL_MENU_BUFFER_SIZE);
+  GtkTreeIter iter_loop;
+  GList *paths_loop;
+  guint row_idx;
+
+  // The written rows start at depth 1, so their tags aren't indented.
+  for (paths_loop = paths; paths_loop; paths_loop = paths_loop->next) {
+    gtk_tree_model_get_iter (model, &iter_loop, paths_loop->data);
+    add_row_to_snapshot (&iter_loop, 1, FALSE, save_rows);
+  }
+
+  for (row_idx = 0; row_idx < save_rows->len; row_idx++)
+    escape_field_values (g_array_index (save_rows, struct save_row, row_idx).txt_fields);
+
+  for (row_idx = 0; row_idx < save_rows->len;)
+    row_idx = write_row (save_rows, row_idx, MENUS, menu_buffer);
+
+  // Cleanup
+  free_snapshot (save_rows);
+
+  return g_string_free (menu_buffer, FALSE);
+}
@@ -27,6 +27,7 @@ extern GtkWidget *window;
 extern GtkTreeModel *model;
 
 extern GtkWidget *mb_file_menu_items[];
+extern GtkWidget *mb_view_and_options[];
 extern GtkToolItem *tb[];
 
 extern gchar *filename;
@@ -35,8 +36,15 @@ extern gboolean change_done;
 
 extern void create_file_dialog (GtkWidget **dialog, gchar *dialog_title);
 extern void free_elements_of_static_string_array (gchar **string_array, gint8 number_of_fields, gboolean set_to_NULL);
+extern gsize get_journal_size (void);
+extern gboolean get_next_row_in_preorder (GtkTreeModel *local_model, GtkTreeIter *local_iter, gint root_depth, 
+					  gboolean descend);
+extern void journal_menu_saved (gsize saved_journal_size);
+extern void remember_menu_file_content (void);
 extern void set_filename_and_window_title (gchar *new_filename);
 extern void show_errmsg (gchar *errmsg_raw_txt);
+extern void show_msg_in_statusbar (gchar *message);
+extern gboolean store_menu_version (const gchar *menu_filename, const gchar *menu_txt, gsize menu_txt_length);
 G_GNUC_NULL_TERMINATED extern gboolean streq_any (const gchar *string, ...);
 
 #endif
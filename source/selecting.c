@@ -21,6 +21,7 @@
 #include <stdbool.h>
 
 #include "general_header_files/enum__add_buttons.h"
+#include "general_header_files/enum__columns.h"
 #include "general_header_files/enum__entry_fields.h"
 #include "general_header_files/enum__find_entry_row_buttons.h"
 #include "general_header_files/enum__menu_bar_items.h"
@@ -29,8 +30,14 @@
 #include "general_header_files/enum__ts_elements.h"
 #include "general_header_files/enum__txt_fields.h"
 #include "general_header_files/struct__expansion_status_data.h"
+#include "general_header_files/struct__match_record.h"
 #include "selecting.h"
 
+// Source ID of the idle callback that processes the changes of the selection, 0 if none is pending.
+static guint selection_change_idle_id = 0;
+// The rows of the treeview are only set up as drag source again if this status changes.
+static gboolean drag_source_enabled = FALSE;
+
 void repopulate_txt_fields_array (void);
 static void all_options_have_been_set_msg (gchar *action_option);
 void create_source_paths_for_dnd (void);
@@ -38,9 +45,9 @@ static gboolean check_expansion_status_of_nodes (GtkTreeModel *local_model, GtkT
 						 GtkTreeIter *local_iter, 
 						 struct expansion_status_data *expansion_status_of_nodes);
 void set_status_of_expand_and_collapse_buttons_and_menu_items (void);
-static gboolean check_for_selected_dsct (GtkTreeModel *filter_model, GtkTreePath *filter_path, 
-					 GtkTreeIter G_GNUC_UNUSED *filter_iter, 
-					 gboolean *selected_row_has_selected_dsct);
+static gboolean process_selection_change (void);
+void selection_changed (void);
+void process_pending_selection_change (void);
 void row_selected (void);
 static gboolean avoid_overlapping (void);
 void set_entry_fields (void);
@@ -138,6 +145,7 @@ static gboolean check_expansion_status_of_nodes (GtkTreeModel                 *l
 
 void set_status_of_expand_and_collapse_buttons_and_menu_items (void)
 {
+  GtkTreeSelection *selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview));
   struct expansion_status_data expansion_status_of_nodes = { FALSE }; // Both elements are initialised with "false".
 
   gtk_tree_model_foreach (model, (GtkTreeModelForeachFunc) check_expansion_status_of_nodes, &expansion_status_of_nodes);
@@ -148,31 +156,53 @@ void set_status_of_expand_and_collapse_buttons_and_menu_items (void)
   gtk_widget_set_sensitive (mb_expand_all_nodes, expansion_status_of_nodes.at_least_one_is_collapsed);
   gtk_widget_set_sensitive ((GtkWidget *) tb[TB_EXPAND_ALL], 
 			    expansion_status_of_nodes.at_least_one_is_collapsed);
+  gtk_widget_set_sensitive (mb_expand_selected_subtrees, expansion_status_of_nodes.at_least_one_is_collapsed && 
+			    gtk_tree_selection_count_selected_rows (selection) > 0);
+  // There are no nodes at all if none of them is expanded or collapsed.
+  gtk_widget_set_sensitive (mb_expand_to_depth, expansion_status_of_nodes.at_least_one_is_expanded || 
+			    expansion_status_of_nodes.at_least_one_is_collapsed);
 }
 
 /* 
 
-   Checks if a selected node has a descendant that has also been selected.
+   Processes all changes of the selection that have been made since the last iteration of the main loop.
 
 */
 
-static gboolean check_for_selected_dsct (GtkTreeModel              *filter_model, 
-					 GtkTreePath               *filter_path, 
-					 GtkTreeIter G_GNUC_UNUSED *filter_iter, 
-					 gboolean                  *selected_row_has_selected_dsct)
+static gboolean process_selection_change (void)
 {
-  GtkTreeSelection *selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview));
-  // The path of the model, not filter model, is needed to check whether the row is selected.
-  GtkTreePath *model_path = gtk_tree_model_filter_convert_path_to_child_path ((GtkTreeModelFilter *) filter_model, 
-									      filter_path);
+  selection_change_idle_id = 0;
+  row_selected ();
 
-  if (gtk_tree_selection_path_is_selected (selection, model_path))
-    *selected_row_has_selected_dsct = TRUE;
+  return G_SOURCE_REMOVE;
+}
 
-  // Cleanup
-  gtk_tree_path_free (model_path);
+/* 
+
+   Called for every change of the selection. Selecting a range of rows or all rows changes the selection 
+   many times in a row, so the changes are processed only once inside an idle callback. 
+   Its priority is higher than the one of redrawing, so the widgets are up to date when the window is redrawn.
 
-  return *selected_row_has_selected_dsct;
+*/
+
+void selection_changed (void)
+{
+  if (!selection_change_idle_id)
+    selection_change_idle_id = g_idle_add_full (G_PRIORITY_HIGH_IDLE, (GSourceFunc) process_selection_change, 
+						NULL, NULL);
+}
+
+/* 
+
+   Processes a change of the selection immediately if its idle callback hasn't run yet, 
+   so txt_fields, iter and the status of the menu and toolbar items refer to the current selection.
+
+*/
+
+void process_pending_selection_change (void)
+{
+  if (selection_change_idle_id)
+    row_selected ();
 }
 
 /* 
@@ -181,6 +211,7 @@ static gboolean check_for_selected_dsct (GtkTreeModel              *filter_model
    are (de)activated according to the type and status of the rows and their number.
    If there is currently no selected row left after an unselection, 
    all actions that would be eligible in case of a selection are deactivated.
+   A pending processing of the selection inside an idle callback is dropped, since it would do the same.
 
 */
 
@@ -196,6 +227,8 @@ void row_selected (void)
   // Defaults
   gboolean at_least_one_selected_row_has_no_children = FALSE;
   gboolean at_least_one_descendant_is_invisible = FALSE;
+  gboolean sorting_possible;
+  gboolean selected_rows_can_be_moved_up = FALSE, selected_rows_can_be_moved_down = FALSE;
 
   gchar *menu_element_txt_loop, *type_txt_loop, *element_visibility_txt_loop;
   GList *g_list_loop;
@@ -205,9 +238,13 @@ void row_selected (void)
 
   gboolean treestore_is_not_empty = gtk_tree_model_get_iter_first (model, &iter_loop); // using iter_loop spares one v.
 
-  // Resets
+  if (selection_change_idle_id) {
+    g_source_remove (selection_change_idle_id);
+    selection_change_idle_id = 0;
+  }
+
+  // Reset
   show_msg_in_statusbar ("");
-  gtk_tree_view_enable_model_drag_source (GTK_TREE_VIEW (treeview), GDK_BUTTON1_MASK, enable_list, 1, GDK_ACTION_MOVE);
 
   // Check if dragging has to be blocked.
   if (number_of_selected_rows > 1) {
@@ -232,11 +269,24 @@ void row_selected (void)
 			  TS_MENU_ELEMENT, &menu_element_txt_loop,
 			  TS_TYPE, &type_txt_loop, 
 			  -1);
-      // Don't allow dragging if a selected row has a selected child.
-      if (gtk_tree_model_iter_has_child (model, &iter_loop)) {
-	filter_model = gtk_tree_model_filter_new (model, g_list_loop->data);
-	gtk_tree_model_foreach (filter_model, (GtkTreeModelForeachFunc) check_for_selected_dsct, 
-				&selected_row_has_selected_dsct);
+      /* Don't allow dragging if a selected row has a selected child. 
+	 (Note: The selected rows are sorted in tree order, so a selected descendant of a row would be 
+	 the next selected row.) */
+      if (g_list_loop->next && gtk_tree_path_is_descendant (g_list_loop->next->data, g_list_loop->data))
+	selected_row_has_selected_dsct = TRUE;
+      /* The selected rows can be moved as long as at least one of them has an unselected sibling 
+	 in the direction of the move. */
+      if (!selected_rows_can_be_moved_up) {
+	GtkTreeIter iter_previous = iter_loop;
+
+	selected_rows_can_be_moved_up = gtk_tree_model_iter_previous (model, &iter_previous) && 
+	  !gtk_tree_selection_iter_is_selected (selection, &iter_previous);
+      }
+      if (!selected_rows_can_be_moved_down) {
+	GtkTreeIter iter_next = iter_loop;
+
+	selected_rows_can_be_moved_down = gtk_tree_model_iter_next (model, &iter_next) && 
+	  !gtk_tree_selection_iter_is_selected (selection, &iter_next);
       }
       if (streq_any (type_txt_loop, "menu", "pipe menu", "item", "separator", NULL))
 	menu_pipemenu_item_separator_selected = TRUE;
@@ -261,6 +311,10 @@ void row_selected (void)
       g_free (type_txt_loop);
     }
     
+    // Options are kept in a fixed order if autosorting is activated.
+    if (autosort_options && option_selected)
+      selected_rows_can_be_moved_up = selected_rows_can_be_moved_down = FALSE;
+
     if (selected_row_has_selected_dsct || 
 	(menu_pipemenu_item_separator_selected && (action_selected || option_selected)) || 
 	(action_selected && option_selected) || 
@@ -283,9 +337,17 @@ void row_selected (void)
 
       // Cleanup
       g_string_free (statusbar_msg, TRUE);
+    }
+  }
 
-      gtk_tree_view_unset_rows_drag_source (GTK_TREE_VIEW (treeview));
+  if (dragging_enabled != drag_source_enabled) {
+    if (dragging_enabled) {
+      gtk_tree_view_enable_model_drag_source (GTK_TREE_VIEW (treeview), GDK_BUTTON1_MASK, 
+					      enable_list, 1, GDK_ACTION_MOVE);
     }
+    else
+      gtk_tree_view_unset_rows_drag_source (GTK_TREE_VIEW (treeview));
+    drag_source_enabled = dragging_enabled;
   }
 
   if (dragging_enabled)
@@ -316,22 +378,30 @@ void row_selected (void)
       at_least_one_selected_row_has_no_children = TRUE;
     if (!element_visibility_txt_loop || streq (element_visibility_txt_loop, "visible"))
       gtk_widget_set_sensitive (mb_edit_menu_items[MB_VISUALISE], FALSE);
-    else if (gtk_tree_model_iter_has_child (model, &iter_loop)) {
+    // (Note: Once an invisible descendant has been found, the descendants of other rows don't have to be checked.)
+    else if (!at_least_one_descendant_is_invisible && gtk_tree_model_iter_has_child (model, &iter_loop)) {
       filter_model = gtk_tree_model_filter_new (model, g_list_loop->data);
       gtk_tree_model_foreach (filter_model, (GtkTreeModelForeachFunc) check_if_invisible_descendant_exists, 
 			      &at_least_one_descendant_is_invisible);
+
+      // Cleanup
+      g_object_unref (filter_model);
     }
 
     // Cleanup
     g_free (element_visibility_txt_loop);
   }
   gtk_widget_set_sensitive (mb_edit_menu_items[MB_REMOVE_ALL_CHILDREN], !at_least_one_selected_row_has_no_children);
+  sorting_possible = children_of_selection_can_be_sorted ();
+  gtk_widget_set_sensitive (mb_edit_menu_items[MB_SORT_CHILDREN], sorting_possible);
+  gtk_widget_set_sensitive (mb_edit_menu_items[MB_SORT_CHILDREN_RECURSIVELY], sorting_possible);
   gtk_widget_set_sensitive (mb_edit_menu_items[MB_VISUALISE_RECURSIVELY], 
  			    (gtk_widget_get_sensitive (mb_edit_menu_items[MB_VISUALISE]) && 
   			     at_least_one_descendant_is_invisible));
 
   gtk_widget_set_sensitive (mb_file_menu_items[MB_SAVE], (change_done && filename));
   gtk_widget_set_sensitive ((GtkWidget *) tb[TB_SAVE], (change_done && filename));
+  gtk_widget_set_sensitive (mb_file_menu_items[MB_VERSION_HISTORY], (filename != NULL));
 
   set_status_of_expand_and_collapse_buttons_and_menu_items ();
 
@@ -341,15 +411,17 @@ void row_selected (void)
   // Activate or deactivate certain buttons depending on if there is no or more than one selection.
   if (number_of_selected_rows != 1) {
     free_elements_of_static_string_array (txt_fields, NUMBER_OF_TXT_FIELDS, TRUE);
-    gtk_widget_set_sensitive ((GtkWidget *) tb[TB_MOVE_UP], FALSE);
-    gtk_widget_set_sensitive ((GtkWidget *) tb[TB_MOVE_DOWN], FALSE);
+    for (mb_menu_items_cnt = MB_MOVE_TOP; mb_menu_items_cnt <= MB_MOVE_BOTTOM; mb_menu_items_cnt++)
+      gtk_widget_set_sensitive (mb_edit_menu_items[mb_menu_items_cnt], 
+				(mb_menu_items_cnt < MB_MOVE_DOWN) ? selected_rows_can_be_moved_up : 
+				selected_rows_can_be_moved_down);
+    gtk_widget_set_sensitive ((GtkWidget *) tb[TB_MOVE_UP], selected_rows_can_be_moved_up);
+    gtk_widget_set_sensitive ((GtkWidget *) tb[TB_MOVE_DOWN], selected_rows_can_be_moved_down);
     if (number_of_selected_rows == 0) {
       gtk_widget_set_sensitive (mb_edit, FALSE);
       gtk_widget_set_sensitive ((GtkWidget *) tb[TB_REMOVE], FALSE);
     }
     else {
-      for (mb_menu_items_cnt = MB_MOVE_TOP; mb_menu_items_cnt <= MB_MOVE_BOTTOM; mb_menu_items_cnt++)
-	gtk_widget_set_sensitive (mb_edit_menu_items[mb_menu_items_cnt], FALSE);
       gtk_widget_hide (add_image);
       for (buttons_cnt = 0; buttons_cnt < NUMBER_OF_ADD_BUTTONS; buttons_cnt++)
 	gtk_widget_hide (bt_add[buttons_cnt]);
@@ -400,9 +472,12 @@ void row_selected (void)
 
   if (rows_with_found_occurrences) {
     gtk_widget_set_sensitive (find_button_entry_row[BACK], 
-			      gtk_tree_path_compare (path, g_list_first (rows_with_found_occurrences)->data) > 0);
+			      gtk_tree_path_compare (path, g_array_index (rows_with_found_occurrences, 
+									  struct match_record, 0).path) > 0);
     gtk_widget_set_sensitive (find_button_entry_row[FORWARD], 
-			      gtk_tree_path_compare (path, g_list_last (rows_with_found_occurrences)->data) < 0);
+			      gtk_tree_path_compare (path, g_array_index (rows_with_found_occurrences, 
+									  struct match_record, 
+									  rows_with_found_occurrences->len - 1).path) < 0);
   }
 
   // (Note: Has to be placed here, since the "path" veriable used above is based on the data of "selected_rows".)
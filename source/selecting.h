@@ -39,7 +39,7 @@ extern GtkWidget *mb_file_menu_items[];
 extern GtkWidget *mb_edit;
 extern GtkWidget *mb_edit_menu_items[];
 extern GtkWidget *mb_search;
-extern GtkWidget *mb_expand_all_nodes, *mb_collapse_all_nodes;
+extern GtkWidget *mb_expand_all_nodes, *mb_collapse_all_nodes, *mb_expand_selected_subtrees, *mb_expand_to_depth;
 
 extern GtkToolItem *tb[];
 
@@ -51,7 +51,7 @@ extern GtkWidget *bt_add_action_option_label;
 extern GtkWidget *action_option_grid;
 
 extern GtkWidget *find_button_entry_row[];
-extern GList *rows_with_found_occurrences;
+extern GArray *rows_with_found_occurrences;
 
 extern GtkWidget *entry_grid;
 extern GtkWidget *entry_labels[], *entry_fields[];
@@ -76,6 +76,7 @@ extern gboolean check_if_invisible_descendant_exists (GtkTreeModel *filter_model
 						      GtkTreePath G_GNUC_UNUSED *filter_path,
 						      GtkTreeIter *filter_iter, 
 						      gboolean *at_least_one_descendant_is_invisible);
+extern gboolean children_of_selection_can_be_sorted (void);
 extern void free_elements_of_static_string_array (gchar **string_array, gint8 number_of_fields, gboolean set_to_NULL);
 extern void generate_action_option_combo_box (gchar *preset_choice);
 extern void show_msg_in_statusbar (gchar *message);
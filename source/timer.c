@@ -17,6 +17,7 @@
    with Kickshaw. If not, see http://www.gnu.org/licenses/.
 */
 
+
 #include <gtk/gtk.h>
 
 #include "general_header_files/enum__entry_fields.h"
@@ -25,121 +26,587 @@
 #include "general_header_files/enum__ts_elements.h"
 #include "timer.h"
 
-void stop_timer (void);
-gboolean check_for_external_file_and_settings_changes (gpointer G_GNUC_UNUSED identifier);
+// Key: path of a directory that contains at least one icon, value: file monitor of this directory.
+static GHashTable *icon_dir_monitors = NULL;
+// Key: canonical icon path, value: array of the icon_rows that use this icon.
+static GHashTable *rows_by_icon_path = NULL;
+// Key: icon path, value: icon image in its original size, so it can be rescaled without reading the file again.
+static GHashTable *original_icons = NULL;
+// Key: node of a row with an icon (iter.user_data), value: its icon_row.
+static GHashTable *icon_rows = NULL;
+// Set if rows have been deleted; the icon rows among them are removed from the lists by update_list_of_icon_occurrences.
+static gboolean icon_rows_deleted = FALSE;
+
+struct icon_row {
+  gpointer node;
+  GList *link; // Link of the row inside rows_with_icons, so it can be removed without searching the list.
+  GtkTreeRowReference *reference; // (Note: Owned by rows_with_icons.)
+  gchar *canonical_icon_path;
+  guint index_in_rows_with_same_icon;
+};
+
+struct icon_rescaling {
+  GdkPixbuf *icon_in_original_size;
+  GdkPixbuf *icon;
+};
+
+void stop_icon_monitoring (void);
+static gchar *get_canonical_path (const gchar *path);
+static void free_icon_row (struct icon_row *row);
+static void check_icon_file_of_row (GtkTreeIter *icon_iter);
+static void icon_file_changed (GFileMonitor G_GNUC_UNUSED *monitor, GFile *file, 
+			       GFile G_GNUC_UNUSED *other_file, GFileMonitorEvent event_type);
+static void monitor_icon_of_row (GList *link, GtkTreeIter *icon_iter, 
+				 GHashTable *previous_icon_dir_monitors);
+void start_icon_monitoring (void);
+static void unlink_icon_row (struct icon_row *row);
+static void remove_icon_row (struct icon_row *row);
+void icon_row_changed (GtkTreeModel G_GNUC_UNUSED *local_model, GtkTreePath *local_path, GtkTreeIter *local_iter);
+void icon_row_deleted (void);
+void update_list_of_icon_occurrences (void);
+void store_original_icon (const gchar *icon_path, GdkPixbuf *icon_in_original_size);
+void clear_original_icons (void);
+static void free_icon_rescaling (struct icon_rescaling *rescaling);
+static void rescale_icon (struct icon_rescaling *rescaling, gpointer G_GNUC_UNUSED user_data);
+void font_size_changed (void);
 
 /* 
 
-   Stops the timer and erases the list of icon occourrences.
+   Erases the lists of icon occourrences.
+   The directory monitors are kept, so the next call of start_icon_monitoring can reuse them.
 
 */
 
-void stop_timer (void)
+void stop_icon_monitoring (void)
 {
-  g_source_remove_by_user_data ("timer");
-  g_slist_free_full (rows_with_icons, (GDestroyNotify) gtk_tree_row_reference_free);
+  if (icon_rows) {
+    g_hash_table_destroy (icon_rows);
+    icon_rows = NULL;
+  }
+  if (rows_by_icon_path) {
+    g_hash_table_destroy (rows_by_icon_path);
+    rows_by_icon_path = NULL;
+  }
+  icon_rows_deleted = FALSE;
+  g_list_free_full (rows_with_icons, (GDestroyNotify) gtk_tree_row_reference_free);
   rows_with_icons = NULL;
 }
 
+/* 
+
+   Returns the path in the form it is reported by file monitors, e.g. without double slashes.
+
+*/
+
+static gchar *get_canonical_path (const gchar *path)
+{
+  GFile *file = g_file_new_for_path (path);
+  gchar *canonical_path = g_file_get_path (file);
+
+  // Cleanup
+  g_object_unref (file);
+
+  return canonical_path;
+}
+
+/* 
+
+   Frees the data of a row with an icon; its row reference is freed together with rows_with_icons.
+
+*/
+
+static void free_icon_row (struct icon_row *row)
+{
+  g_free (row->canonical_icon_path);
+  g_free (row);
+}
+
 /* 
 
    Checks if...
    ...a valid icon file path has become invalid, if so, changes the icon to a broken one.
    ...an invalid icon file path has become valid, if so, replaces the broken icon with the icon image,
       if it is a proper image file.
-   ...the font size has been changed, if so, changes the size of icons according to the new font size.
+   ...the icon image file has been replaced with another one.
 
 */
 
-// The identifier is not used by the function, but to switch the timer on and off.
-gboolean check_for_external_file_and_settings_changes (gpointer G_GNUC_UNUSED identifier) {
-  gboolean recreate_icon_images;
-  guint font_size_updated;
-
+static void check_icon_file_of_row (GtkTreeIter *icon_iter)
+{
   GtkTreeSelection *selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview));
-  gint number_of_selected_rows = gtk_tree_selection_count_selected_rows (selection);
+  gboolean single_selected_row = (gtk_tree_selection_count_selected_rows (selection) == 1 && 
+				  gtk_tree_selection_iter_is_selected (selection, icon_iter));
+
+  guint icon_img_status;
+  gchar *icon_modified_txt;
+  gchar *icon_path_txt;
+
+  gtk_tree_model_get (model, icon_iter,
+		      TS_ICON_IMG_STATUS, &icon_img_status, 
+		      TS_ICON_MODIFIED, &icon_modified_txt,
+		      TS_ICON_PATH, &icon_path_txt, 
+		      -1);
+
+  /* Case 1: Stored path no longer points to a valid icon image, so icon has to replaced with broken icon.
+     Case 2: Invalid path to an icon image has become valid.
+     Case 3: Icon image file is replaced with another one. */
+  if (icon_img_status != INVALID_PATH && !g_file_test (icon_path_txt, G_FILE_TEST_EXISTS)) {
+    gtk_tree_store_set (treestore, icon_iter, 
+			TS_ICON_IMG, invalid_icon_imgs[INVALID_PATH_ICON], 
+			TS_ICON_IMG_STATUS, INVALID_PATH, 
+			TS_ICON_MODIFIED, NULL, 
+			-1);
+
+    if (single_selected_row)
+      gtk_widget_override_background_color (entry_fields[ICON_PATH_ENTRY], GTK_STATE_NORMAL, 
+					    &((GdkRGBA) { 0.92, 0.73, 0.73, 1.0 } ));
+  }
+  else if (g_file_test (icon_path_txt, G_FILE_TEST_EXISTS)) {
+    gchar *time_stamp = get_modified_date_for_icon (icon_path_txt);
+
+    if (icon_img_status == INVALID_PATH || !streq (time_stamp, icon_modified_txt)) {
+      if (!set_icon (icon_path_txt, icon_iter, TRUE)) {
+	gtk_tree_store_set (treestore, icon_iter, 
+			    TS_ICON_IMG, invalid_icon_imgs[INVALID_FILE_ICON],
+			    TS_ICON_IMG_STATUS, INVALID_FILE, 
+			    TS_ICON_MODIFIED, time_stamp,
+			    -1);
+      }
+
+      if (single_selected_row)
+	gtk_widget_override_background_color (entry_fields[ICON_PATH_ENTRY], GTK_STATE_NORMAL, NULL);
+    }
+
+    // Cleanup
+    g_free (time_stamp);
+  }
+
+  // Cleanup
+  g_free (icon_modified_txt);
+  g_free (icon_path_txt);
+}
+
+/* 
+
+   Called by a directory monitor if a file inside the directory has been created, deleted or changed. 
+   Only the rows that use this file as their icon are checked.
+
+*/
+
+static void icon_file_changed (GFileMonitor      G_GNUC_UNUSED *monitor, 
+			       GFile                           *file, 
+			       GFile             G_GNUC_UNUSED *other_file, 
+			       GFileMonitorEvent                event_type)
+{
+  gchar *changed_file_path;
+  GPtrArray *rows_with_changed_icon;
 
   GtkTreeIter iter_loop;
   GtkTreePath *path_loop;
 
-  GdkPixbuf *icon_pixbuf_loop;
-  guint icon_img_status_uint_loop;
-  gchar *icon_modified_txt_loop;
-  gchar *icon_path_txt_loop;
+  /* (Note: While a file is written, G_FILE_MONITOR_EVENT_CHANGED is sent several times; 
+     G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT follows after the writing has been finished.) */
+  if (!rows_by_icon_path || 
+      (event_type != G_FILE_MONITOR_EVENT_CREATED && event_type != G_FILE_MONITOR_EVENT_DELETED && 
+       event_type != G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT && event_type != G_FILE_MONITOR_EVENT_ATTRIBUTE_CHANGED))
+    return;
+
+  changed_file_path = g_file_get_path (file);
+  rows_with_changed_icon = g_hash_table_lookup (rows_by_icon_path, changed_file_path);
+
+  // Cleanup
+  g_free (changed_file_path);
+
+  if (!rows_with_changed_icon)
+    return;
+
+  // The icon images are no changes of the menu, so they aren't recorded by the journal.
+  g_signal_handlers_block_by_func (model, journal_row_changed, NULL);
+  for (guint rows_cnt = 0; rows_cnt < rows_with_changed_icon->len; rows_cnt++) {
+    if (!(path_loop = gtk_tree_row_reference_get_path (((struct icon_row *) 
+							  g_ptr_array_index (rows_with_changed_icon, rows_cnt))->reference)))
+      continue;
+    gtk_tree_model_get_iter (model, &iter_loop, path_loop);
+    check_icon_file_of_row (&iter_loop);
+
+    // Cleanup
+    gtk_tree_path_free (path_loop);
+  }
+  g_signal_handlers_unblock_by_func (model, journal_row_changed, NULL);
+}
+
+/* 
+
+   Adds a row with an icon to the lists of icon rows and monitors the directory of its icon, 
+   if this isn't done already. A monitor of the directory is taken over from the previous monitors if possible.
+
+*/
+
+static void monitor_icon_of_row (GList       *link, 
+				 GtkTreeIter *icon_iter, 
+				 GHashTable  *previous_icon_dir_monitors)
+{
+  struct icon_row *row = g_new (struct icon_row, 1);
+  gchar *icon_path_txt, *icon_dir_path;
+  GPtrArray *rows_with_same_icon;
+  GFileMonitor *icon_dir_monitor;
+  GFile *icon_dir;
+
+  gtk_tree_model_get (model, icon_iter, TS_ICON_PATH, &icon_path_txt, -1);
+
+  row->node = icon_iter->user_data;
+  row->link = link;
+  row->reference = link->data;
+  row->canonical_icon_path = get_canonical_path (icon_path_txt);
+  g_hash_table_insert (icon_rows, icon_iter->user_data, row);
+
+  if (!(rows_with_same_icon = g_hash_table_lookup (rows_by_icon_path, row->canonical_icon_path))) {
+    rows_with_same_icon = g_ptr_array_new ();
+    g_hash_table_insert (rows_by_icon_path, g_strdup (row->canonical_icon_path), rows_with_same_icon);
+  }
+  row->index_in_rows_with_same_icon = rows_with_same_icon->len;
+  g_ptr_array_add (rows_with_same_icon, row);
 
-  GSList *rows_with_icons_loop;
+  icon_dir_path = g_path_get_dirname (row->canonical_icon_path);
+  if (g_hash_table_contains (icon_dir_monitors, icon_dir_path))
+    g_free (icon_dir_path);
+  else if (previous_icon_dir_monitors && 
+	   (icon_dir_monitor = g_hash_table_lookup (previous_icon_dir_monitors, icon_dir_path))) {
+    g_hash_table_steal (previous_icon_dir_monitors, icon_dir_path);
+    g_hash_table_insert (icon_dir_monitors, icon_dir_path, icon_dir_monitor);
+  }
+  else {
+    icon_dir = g_file_new_for_path (icon_dir_path);
+    // (Note: Directories that don't exist yet are monitored, too, so a created directory is recognised.)
+    if ((icon_dir_monitor = g_file_monitor_directory (icon_dir, G_FILE_MONITOR_NONE, NULL, NULL))) {
+      g_signal_connect (icon_dir_monitor, "changed", G_CALLBACK (icon_file_changed), NULL);
+      g_hash_table_insert (icon_dir_monitors, icon_dir_path, icon_dir_monitor);
+    }
+    else
+      g_free (icon_dir_path);
 
-  if ((recreate_icon_images = (font_size != (font_size_updated = get_font_size ())))) {
-    font_size = font_size_updated;
-    create_invalid_icon_imgs ();
+    // Cleanup
+    g_object_unref (icon_dir);
   }
 
+  // Cleanup
+  g_free (icon_path_txt);
+}
+
+/* 
+
+   Monitors the directories of all icons, each directory only once. 
+   Monitors of directories that are still needed are taken over from the previous call, 
+   the monitors of all other directories are cancelled.
+
+*/
+
+void start_icon_monitoring (void)
+{
+  GHashTable *previous_icon_dir_monitors = icon_dir_monitors;
+
+  GtkTreeIter iter_loop;
+  GtkTreePath *path_loop;
+
+  GList *rows_with_icons_loop;
+
+  icon_dir_monitors = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+  rows_by_icon_path = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_ptr_array_unref);
+  icon_rows = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) free_icon_row);
+
   for (rows_with_icons_loop = rows_with_icons; 
        rows_with_icons_loop; 
        rows_with_icons_loop = rows_with_icons_loop->next) {
     path_loop = gtk_tree_row_reference_get_path (rows_with_icons_loop->data);
     gtk_tree_model_get_iter (model, &iter_loop, path_loop);
- 
+    monitor_icon_of_row (rows_with_icons_loop, &iter_loop, previous_icon_dir_monitors);
+
+    // Cleanup
+    gtk_tree_path_free (path_loop);
+  }
+
+  // Cancels the monitors of the directories that are no longer needed.
+  if (previous_icon_dir_monitors)
+    g_hash_table_destroy (previous_icon_dir_monitors);
+}
+
+/* 
+
+   Removes a row from rows_with_icons and the rows with the same icon in constant time; 
+   the row itself is left inside icon_rows. The monitor of the icon directory is kept until 
+   the lists are created again, since other rows might still use it.
+
+*/
+
+static void unlink_icon_row (struct icon_row *row)
+{
+  GPtrArray *rows_with_same_icon = g_hash_table_lookup (rows_by_icon_path, row->canonical_icon_path);
+  guint index = row->index_in_rows_with_same_icon;
+
+  // (Note: The last row of the array is moved to the place of the removed one.)
+  g_ptr_array_remove_index_fast (rows_with_same_icon, index);
+  if (index < rows_with_same_icon->len)
+    ((struct icon_row *) g_ptr_array_index (rows_with_same_icon, index))->index_in_rows_with_same_icon = index;
+  if (!rows_with_same_icon->len)
+    g_hash_table_remove (rows_by_icon_path, row->canonical_icon_path);
+  rows_with_icons = g_list_delete_link (rows_with_icons, row->link);
+  gtk_tree_row_reference_free (row->reference);
+}
+
+/* 
+
+   Removes a row from the lists of icon rows.
+
+*/
+
+static void remove_icon_row (struct icon_row *row)
+{
+  unlink_icon_row (row);
+  g_hash_table_remove (icon_rows, row->node); // Frees row.
+}
+
+/* 
+
+   Called for every inserted or changed row of the treestore. Only this row is added to, moved inside or 
+   removed from the lists of icon rows, so an edit doesn't require the whole menu to be searched for icons again.
+
+*/
+
+void icon_row_changed (GtkTreeModel G_GNUC_UNUSED *local_model, 
+		       GtkTreePath                *local_path, 
+		       GtkTreeIter                *local_iter)
+{
+  if (!icon_rows) // The lists are created completely by update_list_of_icon_occurrences.
+    return;
+
+  struct icon_row *row = g_hash_table_lookup (icon_rows, local_iter->user_data);
+  GdkPixbuf *icon;
+  gchar *icon_path_txt, *canonical_icon_path = NULL;
+
+  // (Note: The node of a deleted row might have been reused for this row.)
+  if (row && !gtk_tree_row_reference_valid (row->reference)) {
+    remove_icon_row (row);
+    row = NULL;
+  }
+
+  gtk_tree_model_get (model, local_iter, 
+		      TS_ICON_IMG, &icon, 
+		      TS_ICON_PATH, &icon_path_txt, 
+		      -1);
+
+  if (icon)
+    canonical_icon_path = get_canonical_path (icon_path_txt);
+
+  if (!row || !streq (row->canonical_icon_path, canonical_icon_path)) {
+    if (row)
+      remove_icon_row (row);
+    if (icon) {
+      rows_with_icons = g_list_prepend (rows_with_icons, gtk_tree_row_reference_new (model, local_path));
+      monitor_icon_of_row (rows_with_icons, local_iter, NULL);
+    }
+  }
+
+  // Cleanup
+  if (icon)
+    unref_icon (&icon, FALSE);
+  g_free (icon_path_txt);
+  g_free (canonical_icon_path);
+}
+
+/* 
+
+   Called for every deleted row of the treestore. The row references of the deleted rows have become invalid; 
+   they are removed later at once instead of searching for them after every single deletion.
+
+*/
+
+void icon_row_deleted (void)
+{
+  icon_rows_deleted = TRUE;
+}
+
+/* 
+
+   Creates the lists of icon rows if this hasn't been done yet for the current menu, 
+   otherwise removes the rows that have been deleted since the last call.
+
+*/
+
+void update_list_of_icon_occurrences (void)
+{
+  GHashTableIter icon_rows_iter;
+  gpointer row_loop;
+
+  if (!icon_rows) {
+    create_list_of_icon_occurrences ();
+    return;
+  }
+
+  if (!icon_rows_deleted)
+    return;
+
+  g_hash_table_iter_init (&icon_rows_iter, icon_rows);
+  while (g_hash_table_iter_next (&icon_rows_iter, NULL, &row_loop)) {
+    if (gtk_tree_row_reference_valid (((struct icon_row *) row_loop)->reference))
+      continue;
+    unlink_icon_row (row_loop);
+    g_hash_table_iter_remove (&icon_rows_iter); // Frees row.
+  }
+
+  icon_rows_deleted = FALSE;
+}
+
+/* 
+
+   Keeps the icon image in its original size for later rescaling.
+
+*/
+
+void store_original_icon (const gchar *icon_path, 
+			  GdkPixbuf   *icon_in_original_size)
+{
+  if (!original_icons)
+    original_icons = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+
+  g_hash_table_insert (original_icons, g_strdup (icon_path), g_object_ref (icon_in_original_size));
+}
+
+/* 
+
+   Frees all icon images in their original size; done if another menu is loaded or a new one is created.
+
+*/
+
+void clear_original_icons (void)
+{
+  if (original_icons) {
+    g_hash_table_destroy (original_icons);
+    original_icons = NULL;
+  }
+}
+
+/* 
+
+   Frees an icon rescaling job and its result.
+
+*/
+
+static void free_icon_rescaling (struct icon_rescaling *rescaling)
+{
+  if (rescaling->icon)
+    g_object_unref (rescaling->icon);
+  g_free (rescaling);
+}
+
+/* 
+
+   Rescales an icon image to the current font size; run by the worker threads of the thread pool.
+   (Note: Every job has its own original, so no pixbuf is accessed by more than one thread.)
+
+*/
+
+static void rescale_icon (struct icon_rescaling *rescaling, 
+			  gpointer               G_GNUC_UNUSED user_data)
+{
+  rescaling->icon = gdk_pixbuf_scale_simple (rescaling->icon_in_original_size, font_size + 10, font_size + 10, 
+					     GDK_INTERP_BILINEAR);
+}
+
+/* 
+
+   Called if the font of the GTK settings has been changed. If the font size differs, all icons are adjusted to it.
+   The stored originals of the icons are rescaled in parallel by a pool of worker threads, each distinct icon once; 
+   afterwards the rescaled icons are set inside the treestore by the main thread. 
+   Only icons without a stored original are read from their file again.
+
+*/
+
+void font_size_changed (void)
+{
+  guint font_size_updated = get_font_size ();
+  GHashTable *rescaled_icons;
+  GThreadPool *rescaling_pool;
+  struct icon_rescaling *rescaling;
+
+  GtkTreeIter iter_loop;
+  GtkTreePath *path_loop;
+  guint icon_img_status_uint_loop;
+  gchar *icon_path_txt_loop;
+  GdkPixbuf *icon_in_original_size_loop;
+
+  GList *rows_with_icons_loop;
+
+  if (font_size == font_size_updated)
+    return;
+
+  font_size = font_size_updated;
+  create_invalid_icon_imgs ();
+
+  // Key: icon path, value: rescaling job.
+  rescaled_icons = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) free_icon_rescaling);
+  rescaling_pool = g_thread_pool_new ((GFunc) rescale_icon, NULL, g_get_num_processors (), TRUE, NULL);
+
+  for (rows_with_icons_loop = rows_with_icons; 
+       rows_with_icons_loop; 
+       rows_with_icons_loop = rows_with_icons_loop->next) {
+    // (Note: Deleted rows might not have been removed from the list yet.)
+    if (!(path_loop = gtk_tree_row_reference_get_path (rows_with_icons_loop->data)))
+      continue;
+    gtk_tree_model_get_iter (model, &iter_loop, path_loop);
     gtk_tree_model_get (model, &iter_loop,
-			TS_ICON_IMG, &icon_pixbuf_loop, 
 			TS_ICON_IMG_STATUS, &icon_img_status_uint_loop, 
-			TS_ICON_MODIFIED, &icon_modified_txt_loop,
 			TS_ICON_PATH, &icon_path_txt_loop, 
 			-1);
 
-    /* Case 1: Stored path no longer points to a valid icon image, so icon has to replaced with broken icon.
-       Case 2: Invalid path to an icon image has become valid.
-       Case 3: Icon image file is replaced with another one. */
-    if (icon_img_status_uint_loop != INVALID_PATH && !g_file_test (icon_path_txt_loop, G_FILE_TEST_EXISTS)) {
-      gtk_tree_store_set (treestore, &iter_loop, 
-			  TS_ICON_IMG, invalid_icon_imgs[INVALID_PATH_ICON], 
-			  TS_ICON_IMG_STATUS, INVALID_PATH, 
-			  TS_ICON_MODIFIED, NULL, 
-			  -1);
-
-      if (number_of_selected_rows == 1 && gtk_tree_selection_iter_is_selected (selection, &iter_loop))
-	gtk_widget_override_background_color (entry_fields[ICON_PATH_ENTRY], GTK_STATE_NORMAL, 
-					      &((GdkRGBA) { 0.92, 0.73, 0.73, 1.0 } ));
+    if (!icon_img_status_uint_loop && original_icons && 
+	!g_hash_table_contains (rescaled_icons, icon_path_txt_loop) && 
+	(icon_in_original_size_loop = g_hash_table_lookup (original_icons, icon_path_txt_loop))) {
+      rescaling = g_new0 (struct icon_rescaling, 1);
+      rescaling->icon_in_original_size = icon_in_original_size_loop;
+      g_hash_table_insert (rescaled_icons, icon_path_txt_loop, rescaling);
+      g_thread_pool_push (rescaling_pool, rescaling, NULL);
     }
-    else if (g_file_test (icon_path_txt_loop, G_FILE_TEST_EXISTS)) {
-      gchar *time_stamp = get_modified_date_for_icon (icon_path_txt_loop);
-
-      if (icon_img_status_uint_loop == INVALID_PATH || !streq (time_stamp, icon_modified_txt_loop)) {
-	if (!set_icon (icon_path_txt_loop, &iter_loop, TRUE)) {
-	  gtk_tree_store_set (treestore, &iter_loop, 
-			      TS_ICON_IMG, invalid_icon_imgs[INVALID_FILE_ICON],
-			      TS_ICON_IMG_STATUS, INVALID_FILE, 
-			      TS_ICON_MODIFIED, g_strdup (time_stamp),
-			      -1);
-	}
-
-	if (number_of_selected_rows == 1 && gtk_tree_selection_iter_is_selected (selection, &iter_loop))
-	  gtk_widget_override_background_color (entry_fields[ICON_PATH_ENTRY], GTK_STATE_NORMAL, NULL);
-      }
+    else
+      g_free (icon_path_txt_loop);
 
-      // Cleanup
-      g_free (time_stamp);
-    }
+    // Cleanup
+    gtk_tree_path_free (path_loop);
+  }
 
-    // Font size has changed, so reload the icon images to adjust them to the new font size.
-    if (recreate_icon_images) {
-      if (!icon_img_status_uint_loop)
-	set_icon (icon_path_txt_loop, &iter_loop, TRUE);
-      else {
-	gtk_tree_store_set (treestore, &iter_loop, TS_ICON_IMG, 
-			    invalid_icon_imgs[(icon_img_status_uint_loop == INVALID_PATH) ? INVALID_PATH_ICON : 
-					      INVALID_FILE_ICON], -1);
-      }
+  g_thread_pool_free (rescaling_pool, FALSE, TRUE); // Waits until all icons have been rescaled.
+
+  g_signal_handlers_block_by_func (model, journal_row_changed, NULL); // Rescaled icons are no changes of the menu.
 
-      gtk_tree_view_columns_autosize (GTK_TREE_VIEW (treeview)); // In case that font size is reduced.
+  for (rows_with_icons_loop = rows_with_icons; 
+       rows_with_icons_loop; 
+       rows_with_icons_loop = rows_with_icons_loop->next) {
+    if (!(path_loop = gtk_tree_row_reference_get_path (rows_with_icons_loop->data)))
+      continue;
+    gtk_tree_model_get_iter (model, &iter_loop, path_loop);
+    gtk_tree_model_get (model, &iter_loop,
+			TS_ICON_IMG_STATUS, &icon_img_status_uint_loop, 
+			TS_ICON_PATH, &icon_path_txt_loop, 
+			-1);
+
+    if (icon_img_status_uint_loop) {
+      gtk_tree_store_set (treestore, &iter_loop, TS_ICON_IMG, 
+			  invalid_icon_imgs[(icon_img_status_uint_loop == INVALID_PATH) ? INVALID_PATH_ICON : 
+					    INVALID_FILE_ICON], -1);
     }
+    else if ((rescaling = g_hash_table_lookup (rescaled_icons, icon_path_txt_loop)))
+      gtk_tree_store_set (treestore, &iter_loop, TS_ICON_IMG, rescaling->icon, -1);
+    else
+      set_icon (icon_path_txt_loop, &iter_loop, TRUE);
 
     // Cleanup
     gtk_tree_path_free (path_loop);
-    g_object_unref (icon_pixbuf_loop);
-    g_free (icon_modified_txt_loop);
     g_free (icon_path_txt_loop);
   }
 
-  return TRUE;
+  g_signal_handlers_unblock_by_func (model, journal_row_changed, NULL);
+
+  gtk_tree_view_columns_autosize (GTK_TREE_VIEW (treeview)); // In case that font size is reduced.
+
+  // Cleanup
+  g_hash_table_destroy (rescaled_icons);
 }
@@ -32,11 +32,14 @@ extern GtkWidget *entry_fields[];
 
 extern guint font_size;
 
-extern GSList *rows_with_icons;
+extern GList *rows_with_icons;
 
 extern void create_invalid_icon_imgs (void);
+extern void create_list_of_icon_occurrences (void);
 extern guint get_font_size (void);
 extern gboolean set_icon (gchar *icon_path, GtkTreeIter *icon_iter, gboolean automated);
 extern gchar *get_modified_date_for_icon (gchar *icon_path);
+extern void journal_row_changed (GtkTreeModel *local_model, GtkTreePath *local_path, GtkTreeIter *local_iter);
+extern void unref_icon (GdkPixbuf **icon, gboolean set_to_NULL);
 
 #endif
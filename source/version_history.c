@@ -0,0 +1,446 @@
+/*
+   Kickshaw - A Menu Editor for Openbox
+
+   Copyright (c) 2010-2013        Marcus Schaetzle
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along 
+   with Kickshaw. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <gtk/gtk.h>
+#include <glib/gstdio.h>
+#include <string.h>
+
+#include "version_history.h"
+
+/* 
+   Every saved menu is stored as a version inside ~/.local/share/kickshaw. 
+   The versions are content-addressed: each menu that contains other elements is stored as an object of its own, 
+   named after the SHA-1 checksum of its content, and is referenced by its parent with a line that consists of 
+   VERSION_REFERENCE_MARK followed by this checksum. The mark can't appear inside a saved menu, 
+   since all control characters inside values are escaped. 
+   This way a menu that hasn't been changed is stored only once, no matter how many versions contain it. 
+   For each menu file there is a list of its versions, with one line per version: 
+   the time of the save and the checksum of the object of the whole menu file, separated by a tab.
+*/
+#define VERSION_REFERENCE_MARK '\x01'
+#define CHECKSUM_LENGTH 40
+// Protects against endless recursion when reading damaged objects.
+#define MAX_NESTING_DEPTH 1000
+
+enum { VERSION_DATE, VERSION_CHECKSUM, NUMBER_OF_VERSION_COLUMNS };
+// Enumeration for the dialog.
+enum { RESTORE = 1, CANCEL };
+
+static gchar *get_object_filename (const gchar *checksum);
+static gchar *get_version_list_filename (const gchar *menu_filename);
+static gchar *store_object (const gchar *object_txt, gsize object_length);
+static gboolean is_opening_menu_line (const gchar *line, const gchar *line_end, gsize *indentation);
+static const gchar *find_closing_menu_line (const gchar *line, const gchar *end, gsize indentation);
+static gchar *store_menu_section (const gchar *section_start, const gchar *section_end);
+gboolean store_menu_version (const gchar *menu_filename, const gchar *menu_txt, gsize menu_txt_length);
+static gboolean load_menu_section (const gchar *checksum, GString *menu_txt, guint nesting_depth);
+void show_version_history (void);
+
+/* 
+
+   Returns the file name of a stored object.
+
+*/
+
+static gchar *get_object_filename (const gchar *checksum)
+{
+  gchar folder_name[3] = { checksum[0], checksum[1], '\0' };
+
+  return g_build_filename (g_get_user_data_dir (), "kickshaw", "objects", folder_name, checksum + 2, NULL);
+}
+
+/* 
+
+   Returns the file name of the list of versions of a menu file.
+
+*/
+
+static gchar *get_version_list_filename (const gchar *menu_filename)
+{
+  gchar *menu_filename_checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, menu_filename, -1);
+  gchar *version_list_filename = g_build_filename (g_get_user_data_dir (), "kickshaw", "versions", 
+						   menu_filename_checksum, NULL);
+
+  // Cleanup
+  g_free (menu_filename_checksum);
+
+  return version_list_filename;
+}
+
+/* 
+
+   Stores an object, if it doesn't exist already. Returns its checksum or NULL if it couldn't be stored.
+
+*/
+
+static gchar *store_object (const gchar *object_txt, 
+			    gsize        object_length)
+{
+  gchar *checksum = g_compute_checksum_for_data (G_CHECKSUM_SHA1, (const guchar *) object_txt, object_length);
+  gchar *object_filename = get_object_filename (checksum);
+
+  if (!g_file_test (object_filename, G_FILE_TEST_EXISTS)) {
+    gchar *object_folder = g_path_get_dirname (object_filename);
+
+    if (g_mkdir_with_parents (object_folder, 0700) != 0 || 
+	!g_file_set_contents (object_filename, object_txt, object_length, NULL))
+      free_and_reassign (checksum, NULL);
+
+    // Cleanup
+    g_free (object_folder);
+  }
+
+  // Cleanup
+  g_free (object_filename);
+
+  return checksum;
+}
+
+/* 
+
+   Checks if a line of a saved menu opens a menu that contains other elements and returns its indentation.
+
+*/
+
+static gboolean is_opening_menu_line (const gchar *line, 
+				      const gchar *line_end, 
+				      gsize       *indentation)
+{
+  const gchar *line_content = line;
+
+  while (line_content < line_end && *line_content == ' ')
+    line_content++;
+  *indentation = line_content - line;
+
+  if (line_end > line && *(line_end - 1) == '\n')
+    line_end--;
+
+  return (line_end - line_content > 7 && strncmp (line_content, "<menu ", 6) == 0 && 
+	  !(*(line_end - 2) == '/' && *(line_end - 1) == '>'));
+}
+
+/* 
+
+   Returns the end of the line that closes a menu with the given indentation, 
+   or NULL if there is no such line. Menus inside this menu are indented further, 
+   and their values can't contain "<", so the first line with this indentation and a closing tag is the right one.
+
+*/
+
+static const gchar *find_closing_menu_line (const gchar *line, 
+					    const gchar *end, 
+					    gsize        indentation)
+{
+  const gchar *line_end;
+  gsize line_cnt;
+
+  while (line < end) {
+    if (!(line_end = memchr (line, '\n', end - line)))
+      return NULL;
+    line_end++;
+
+    if ((gsize) (line_end - line) == indentation + sizeof ("</menu>\n") - 1) {
+      for (line_cnt = 0; line_cnt < indentation && line[line_cnt] == ' '; line_cnt++);
+      if (line_cnt == indentation && strncmp (line + indentation, "</menu>\n", sizeof ("</menu>\n") - 1) == 0)
+	return line_end;
+    }
+
+    line = line_end;
+  }
+
+  return NULL;
+}
+
+/* 
+
+   Stores a part of a saved menu. Menus with content inside this part are stored as separate objects 
+   and replaced by a reference. Returns the checksum of the object or NULL if it couldn't be stored.
+
+*/
+
+static gchar *store_menu_section (const gchar *section_start, 
+				  const gchar *section_end)
+{
+  GString *object = g_string_sized_new (section_end - section_start);
+  const gchar *line = section_start;
+  const gchar *copied_up_to = section_start;
+  const gchar *line_end, *menu_end;
+  gchar *checksum = NULL, *menu_checksum;
+  gsize indentation;
+
+  while (line < section_end) {
+    line_end = memchr (line, '\n', section_end - line);
+    line_end = (line_end) ? line_end + 1 : section_end;
+
+    // The opening line of the section itself belongs to this object.
+    if (line != section_start && is_opening_menu_line (line, line_end, &indentation) && 
+	(menu_end = find_closing_menu_line (line_end, section_end, indentation))) {
+      if (!(menu_checksum = store_menu_section (line, menu_end)))
+	goto cleanup;
+
+      g_string_append_len (object, copied_up_to, line - copied_up_to);
+      g_string_append_c (object, VERSION_REFERENCE_MARK);
+      g_string_append (object, menu_checksum);
+      g_string_append_c (object, '\n');
+
+      // Cleanup
+      g_free (menu_checksum);
+
+      copied_up_to = line = menu_end;
+    }
+    else
+      line = line_end;
+  }
+
+  g_string_append_len (object, copied_up_to, section_end - copied_up_to);
+  checksum = store_object (object->str, object->len);
+
+ cleanup:
+  g_string_free (object, TRUE);
+
+  return checksum;
+}
+
+/* 
+
+   Stores a saved menu as a new version of a menu file. 
+   This is done by the saving thread, so it doesn't access any widgets. 
+   Returns FALSE if the version couldn't be stored.
+
+*/
+
+gboolean store_menu_version (const gchar *menu_filename, 
+			     const gchar *menu_txt, 
+			     gsize        menu_txt_length)
+{
+  gchar *version_list_filename, *version_list_folder;
+  gchar *version_list, *last_version;
+  gchar *checksum;
+  FILE *version_list_file;
+  gboolean version_stored = FALSE;
+
+  if (!(checksum = store_menu_section (menu_txt, menu_txt + menu_txt_length)))
+    return FALSE;
+
+  version_list_filename = get_version_list_filename (menu_filename);
+  version_list_folder = g_path_get_dirname (version_list_filename);
+
+  // A save without any changes doesn't create a new version.
+  if (g_file_get_contents (version_list_filename, &version_list, NULL, NULL)) {
+    last_version = g_strrstr (version_list, "\t");
+    version_stored = (last_version && strncmp (last_version + 1, checksum, CHECKSUM_LENGTH) == 0);
+
+    // Cleanup
+    g_free (version_list);
+  }
+
+  if (!version_stored && g_mkdir_with_parents (version_list_folder, 0700) == 0 && 
+      (version_list_file = g_fopen (version_list_filename, "a"))) {
+    version_stored = (fprintf (version_list_file, "%" G_GINT64_FORMAT "\t%s\n", 
+			       g_get_real_time () / G_USEC_PER_SEC, checksum) > 0);
+    version_stored = (fclose (version_list_file) == 0) && version_stored;
+  }
+
+  // Cleanup
+  g_free (checksum);
+  g_free (version_list_filename);
+  g_free (version_list_folder);
+
+  return version_stored;
+}
+
+/* 
+
+   Appends a stored part of a menu to a text, including all parts it refers to.
+
+*/
+
+static gboolean load_menu_section (const gchar *checksum, 
+				   GString     *menu_txt, 
+				   guint        nesting_depth)
+{
+  gchar *object_filename, *object_txt;
+  gsize object_length;
+  const gchar *line, *line_end;
+  gchar referenced_checksum[CHECKSUM_LENGTH + 1];
+  gboolean section_loaded = TRUE;
+
+  // Checksums are read from files, so they are checked before they are used as a part of a file name.
+  if (nesting_depth > MAX_NESTING_DEPTH || strlen (checksum) != CHECKSUM_LENGTH || 
+      strspn (checksum, "0123456789abcdef") != CHECKSUM_LENGTH)
+    return FALSE;
+
+  object_filename = get_object_filename (checksum);
+
+  if (!g_file_get_contents (object_filename, &object_txt, &object_length, NULL)) {
+    // Cleanup
+    g_free (object_filename);
+
+    return FALSE;
+  }
+
+  for (line = object_txt; line < object_txt + object_length && section_loaded; line = line_end) {
+    line_end = memchr (line, '\n', object_txt + object_length - line);
+    line_end = (line_end) ? line_end + 1 : object_txt + object_length;
+
+    if (*line == VERSION_REFERENCE_MARK) {
+      if (line_end - line != CHECKSUM_LENGTH + 2) {
+	section_loaded = FALSE;
+	break;
+      }
+      memcpy (referenced_checksum, line + 1, CHECKSUM_LENGTH);
+      referenced_checksum[CHECKSUM_LENGTH] = '\0';
+      section_loaded = load_menu_section (referenced_checksum, menu_txt, nesting_depth + 1);
+    }
+    else
+      g_string_append_len (menu_txt, line, line_end - line);
+  }
+
+  // Cleanup
+  g_free (object_filename);
+  g_free (object_txt);
+
+  return section_loaded;
+}
+
+/* 
+
+   Shows the versions of the current menu file, of which one can be restored. 
+   A restored version replaces the edited menu, but is only written into the menu file if the menu is saved.
+
+*/
+
+void show_version_history (void)
+{
+  gchar *version_list_filename = get_version_list_filename (filename);
+  gchar *version_list;
+  gchar **versions;
+
+  GtkListStore *versions_liststore;
+  GtkWidget *dialog, *content_area, *scrolled_window, *versions_treeview;
+  GtkTreeSelection *selection;
+  GtkTreeIter iter_loop;
+  gint result;
+
+  gchar *version_date_txt, *checksum = NULL;
+  gchar **version_fields;
+  GDateTime *version_date;
+  gint64 version_time;
+  guint versions_cnt;
+
+  if (!g_file_get_contents (version_list_filename, &version_list, NULL, NULL)) {
+    show_msg_in_statusbar ("There are no saved versions of this menu yet.");
+
+    // Cleanup
+    g_free (version_list_filename);
+
+    return;
+  }
+
+  versions_liststore = gtk_list_store_new (NUMBER_OF_VERSION_COLUMNS, G_TYPE_STRING, G_TYPE_STRING);
+
+  // The newest version is shown first.
+  versions = g_strsplit (version_list, "\n", -1);
+  for (versions_cnt = 0; versions[versions_cnt]; versions_cnt++) {
+    version_fields = g_strsplit (versions[versions_cnt], "\t", 2);
+    if (g_strv_length (version_fields) == 2) {
+      version_time = g_ascii_strtoll (version_fields[0], NULL, 10);
+      if ((version_date = g_date_time_new_from_unix_local (version_time))) {
+	version_date_txt = g_date_time_format (version_date, "%Y-%m-%d  %H:%M:%S");
+	gtk_list_store_insert_with_values (versions_liststore, &iter_loop, 0, 
+					   VERSION_DATE, version_date_txt, 
+					   VERSION_CHECKSUM, version_fields[1], 
+					   -1);
+
+	// Cleanup
+	g_date_time_unref (version_date);
+	g_free (version_date_txt);
+      }
+    }
+
+    // Cleanup
+    g_strfreev (version_fields);
+  }
+
+  // Cleanup
+  g_strfreev (versions);
+  g_free (version_list);
+  g_free (version_list_filename);
+
+  content_area = create_dialog (&dialog, "Version History", GTK_STOCK_DIALOG_INFO, "Restore", GTK_STOCK_CANCEL, NULL, 
+				"Choose a saved version of this menu to restore.\n"
+				"The restored version replaces the current menu; "
+				"it is written into the menu file when the menu is saved.", FALSE);
+
+  versions_treeview = gtk_tree_view_new_with_model (GTK_TREE_MODEL (versions_liststore));
+  gtk_tree_view_append_column (GTK_TREE_VIEW (versions_treeview), 
+			       gtk_tree_view_column_new_with_attributes ("Saved at", gtk_cell_renderer_text_new (), 
+									 "text", VERSION_DATE, NULL));
+  selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (versions_treeview));
+  if (gtk_tree_model_get_iter_first (GTK_TREE_MODEL (versions_liststore), &iter_loop))
+    gtk_tree_selection_select_iter (selection, &iter_loop);
+
+  scrolled_window = gtk_scrolled_window_new (NULL, NULL);
+  gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (scrolled_window), GTK_POLICY_NEVER, GTK_POLICY_AUTOMATIC);
+  gtk_widget_set_size_request (scrolled_window, -1, 250);
+  gtk_container_add (GTK_CONTAINER (scrolled_window), versions_treeview);
+  gtk_container_add (GTK_CONTAINER (content_area), scrolled_window);
+
+  gtk_widget_show_all (dialog);
+
+  result = gtk_dialog_run (GTK_DIALOG (dialog));
+  if (result == RESTORE && gtk_tree_selection_get_selected (selection, NULL, &iter_loop))
+    gtk_tree_model_get (GTK_TREE_MODEL (versions_liststore), &iter_loop, 
+			VERSION_DATE, &version_date_txt, 
+			VERSION_CHECKSUM, &checksum, 
+			-1);
+
+  gtk_widget_destroy (dialog);
+
+  // Cleanup
+  g_object_unref (versions_liststore);
+
+  if (!checksum || (change_done && !unsaved_changes ())) {
+    // Cleanup
+    if (checksum) {
+      g_free (version_date_txt);
+      g_free (checksum);
+    }
+
+    return;
+  }
+
+  GString *menu_txt = g_string_new (NULL);
+
+  if (!load_menu_section (checksum, menu_txt, 0) || !replace_menu_with_content (menu_txt->str))
+    show_errmsg ("The version could not be restored, its stored data is incomplete or damaged.");
+  else {
+    gchar *statusbar_msg = g_strdup_printf ("The version saved at %s has been restored.", version_date_txt);
+
+    show_msg_in_statusbar (statusbar_msg);
+
+    // Cleanup
+    g_free (statusbar_msg);
+  }
+
+  // Cleanup
+  g_string_free (menu_txt, TRUE);
+  g_free (version_date_txt);
+  g_free (checksum);
+}